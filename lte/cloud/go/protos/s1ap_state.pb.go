@@ -30,7 +30,7 @@ func (m *S1ApTimer) Reset()         { *m = S1ApTimer{} }
 func (m *S1ApTimer) String() string { return proto.CompactTextString(m) }
 func (*S1ApTimer) ProtoMessage()    {}
 func (*S1ApTimer) Descriptor() ([]byte, []int) {
-	return fileDescriptor_s1ap_state_ca83a955c413608c, []int{0}
+	return fileDescriptor_s1ap_state_fb9033fdc12d3ba8, []int{0}
 }
 func (m *S1ApTimer) XXX_Unmarshal(b []byte) error {
 	return xxx_messageInfo_S1ApTimer.Unmarshal(m, b)
@@ -76,6 +76,7 @@ type EnbDescription struct {
 	Instreams                uint32                    `protobuf:"varint,9,opt,name=instreams,proto3" json:"instreams,omitempty"`
 	Outstreams               uint32                    `protobuf:"varint,10,opt,name=outstreams,proto3" json:"outstreams,omitempty"`
 	Ues                      map[uint32]*UeDescription `protobuf:"bytes,11,rep,name=ues,proto3" json:"ues,omitempty" protobuf_key:"varint,1,opt,name=key,proto3" protobuf_val:"bytes,2,opt,name=value,proto3"`
+	SupportedTacs            []uint32                  `protobuf:"varint,12,rep,packed,name=supported_tacs,json=supportedTacs,proto3" json:"supported_tacs,omitempty"`
 	XXX_NoUnkeyedLiteral     struct{}                  `json:"-"`
 	XXX_unrecognized         []byte                    `json:"-"`
 	XXX_sizecache            int32                     `json:"-"`
@@ -85,7 +86,7 @@ func (m *EnbDescription) Reset()         { *m = EnbDescription{} }
 func (m *EnbDescription) String() string { return proto.CompactTextString(m) }
 func (*EnbDescription) ProtoMessage()    {}
 func (*EnbDescription) Descriptor() ([]byte, []int) {
-	return fileDescriptor_s1ap_state_ca83a955c413608c, []int{1}
+	return fileDescriptor_s1ap_state_fb9033fdc12d3ba8, []int{1}
 }
 func (m *EnbDescription) XXX_Unmarshal(b []byte) error {
 	return xxx_messageInfo_EnbDescription.Unmarshal(m, b)
@@ -182,6 +183,13 @@ func (m *EnbDescription) GetUes() map[uint32]*UeDescription {
 	return nil
 }
 
+func (m *EnbDescription) GetSupportedTacs() []uint32 {
+	if m != nil {
+		return m.SupportedTacs
+	}
+	return nil
+}
+
 type UeDescription struct {
 	S1UeState             int32      `protobuf:"varint,2,opt,name=s1_ue_state,json=s1UeState,proto3" json:"s1_ue_state,omitempty"`
 	EnbUeS1ApId           uint32     `protobuf:"varint,3,opt,name=enb_ue_s1ap_id,json=enbUeS1apId,proto3" json:"enb_ue_s1ap_id,omitempty"`
@@ -198,7 +206,7 @@ func (m *UeDescription) Reset()         { *m = UeDescription{} }
 func (m *UeDescription) String() string { return proto.CompactTextString(m) }
 func (*UeDescription) ProtoMessage()    {}
 func (*UeDescription) Descriptor() ([]byte, []int) {
-	return fileDescriptor_s1ap_state_ca83a955c413608c, []int{2}
+	return fileDescriptor_s1ap_state_fb9033fdc12d3ba8, []int{2}
 }
 func (m *UeDescription) XXX_Unmarshal(b []byte) error {
 	return xxx_messageInfo_UeDescription.Unmarshal(m, b)
@@ -273,7 +281,7 @@ func (m *S1ApState) Reset()         { *m = S1ApState{} }
 func (m *S1ApState) String() string { return proto.CompactTextString(m) }
 func (*S1ApState) ProtoMessage()    {}
 func (*S1ApState) Descriptor() ([]byte, []int) {
-	return fileDescriptor_s1ap_state_ca83a955c413608c, []int{3}
+	return fileDescriptor_s1ap_state_fb9033fdc12d3ba8, []int{3}
 }
 func (m *S1ApState) XXX_Unmarshal(b []byte) error {
 	return xxx_messageInfo_S1ApState.Unmarshal(m, b)
@@ -325,51 +333,52 @@ func init() {
 }
 
 func init() {
-	proto.RegisterFile("lte/protos/s1ap_state.proto", fileDescriptor_s1ap_state_ca83a955c413608c)
-}
-
-var fileDescriptor_s1ap_state_ca83a955c413608c = []byte{
-	// 661 bytes of a gzipped FileDescriptorProto
-	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x8c, 0x54, 0xd1, 0x6e, 0xd3, 0x4a,
-	0x10, 0x55, 0x9c, 0xa6, 0x69, 0xd6, 0x37, 0x51, 0xb4, 0xba, 0x45, 0x6e, 0x0b, 0x55, 0x08, 0x02,
-	0x45, 0x02, 0x1c, 0x25, 0xf0, 0x80, 0x00, 0x09, 0x4a, 0xdb, 0x87, 0x3e, 0x80, 0x90, 0x43, 0x5e,
-	0x8a, 0xd0, 0x6a, 0xed, 0x1d, 0x22, 0x0b, 0xef, 0xda, 0xf2, 0xae, 0x4b, 0xfa, 0x4b, 0xfc, 0x08,
-	0x7f, 0xc2, 0x77, 0xa0, 0x1d, 0xbb, 0xc1, 0x81, 0x14, 0xfa, 0x64, 0xef, 0xcc, 0x99, 0x33, 0xe3,
-	0x39, 0x67, 0x4d, 0x0e, 0x12, 0x03, 0xe3, 0x2c, 0x4f, 0x4d, 0xaa, 0xc7, 0x7a, 0xc2, 0x33, 0xa6,
-	0x0d, 0x37, 0xe0, 0x63, 0x84, 0xde, 0x92, 0x7c, 0x21, 0xb9, 0x9f, 0x18, 0xf0, 0x17, 0xdc, 0xc0,
-	0x57, 0x7e, 0xe9, 0x5b, 0xcc, 0xf0, 0x31, 0xe9, 0xcc, 0x26, 0x3c, 0xfb, 0x10, 0x4b, 0xc8, 0x69,
-	0x8f, 0x38, 0xb1, 0xf0, 0x1a, 0x83, 0xc6, 0xa8, 0x15, 0x38, 0xb1, 0xa0, 0x7d, 0xd2, 0xd4, 0x10,
-	0x79, 0x0e, 0x06, 0xec, 0xeb, 0xf0, 0xfb, 0x16, 0xe9, 0x9d, 0xaa, 0xf0, 0x04, 0x74, 0x94, 0xc7,
-	0x99, 0x89, 0x53, 0x45, 0x77, 0xc9, 0x36, 0xa8, 0x90, 0x55, 0x85, 0xdd, 0xa0, 0x05, 0x2a, 0x3c,
-	0x13, 0x74, 0x8f, 0xec, 0xe8, 0x49, 0x39, 0x42, 0x45, 0xd0, 0xd6, 0x93, 0x99, 0x3d, 0xda, 0x94,
-	0xad, 0x50, 0x5c, 0x82, 0xd7, 0x1c, 0x34, 0x46, 0xff, 0x05, 0x6d, 0x50, 0xe1, 0x3b, 0x2e, 0x81,
-	0x3e, 0x22, 0x54, 0xc0, 0x67, 0x5e, 0x24, 0x86, 0x65, 0x7c, 0x11, 0xab, 0x05, 0x13, 0xf9, 0xd2,
-	0xdb, 0x42, 0xe2, 0x7e, 0x95, 0x79, 0x8f, 0x89, 0x93, 0x7c, 0x49, 0x47, 0xa4, 0xaf, 0x42, 0x56,
-	0x00, 0xe3, 0x5a, 0xa7, 0x51, 0xcc, 0x0d, 0x08, 0xaf, 0x85, 0xd8, 0x9e, 0x0a, 0xe7, 0x70, 0xb4,
-	0x8a, 0xd2, 0x90, 0xdc, 0xc1, 0x95, 0xd8, 0xbe, 0x08, 0x66, 0x51, 0x02, 0x5c, 0xb1, 0x22, 0x63,
-	0xc6, 0x7e, 0xba, 0xb7, 0x3d, 0x68, 0x8c, 0xdc, 0xe9, 0x5d, 0x7f, 0xf3, 0x9a, 0xfc, 0xd5, 0x8e,
-	0x02, 0xcf, 0x9e, 0x4f, 0x55, 0x88, 0xe4, 0xc7, 0x96, 0x64, 0x5e, 0x6d, 0x6f, 0x48, 0xba, 0x3a,
-	0x32, 0x59, 0xc5, 0x1f, 0x0b, 0xaf, 0x8d, 0xa3, 0xb8, 0x36, 0x88, 0xe8, 0x33, 0x81, 0x13, 0xc3,
-	0xd2, 0x30, 0x04, 0x6a, 0x93, 0x03, 0x97, 0xde, 0x4e, 0x35, 0x31, 0x2c, 0xcd, 0x2c, 0x32, 0xd9,
-	0x0c, 0xa3, 0xf4, 0x36, 0xe9, 0xc4, 0xaa, 0x44, 0x68, 0xaf, 0x83, 0x90, 0x5f, 0x01, 0x7a, 0x48,
-	0x48, 0x5a, 0x98, 0xab, 0x34, 0xc1, 0x74, 0x2d, 0x42, 0x8f, 0x48, 0xb3, 0x00, 0xed, 0xb9, 0x83,
-	0xe6, 0xc8, 0x9d, 0x8e, 0xaf, 0xfb, 0xaa, 0x75, 0x25, 0xfd, 0x39, 0xe8, 0x53, 0x65, 0xf2, 0xcb,
-	0xc0, 0xd6, 0xee, 0x7f, 0x22, 0x3b, 0x57, 0x01, 0x6b, 0x84, 0x2f, 0x70, 0x59, 0x09, 0x6c, 0x5f,
-	0xe9, 0x0b, 0xd2, 0xba, 0xe0, 0x49, 0x51, 0x6a, 0xeb, 0x4e, 0xef, 0x5f, 0xd7, 0x62, 0x0e, 0xb5,
-	0x0e, 0x41, 0x59, 0xf3, 0xdc, 0x79, 0xd6, 0x18, 0x7e, 0x73, 0x48, 0x77, 0x2d, 0x49, 0x0f, 0x89,
-	0xab, 0x27, 0x56, 0xcd, 0xba, 0x69, 0x3a, 0x7a, 0x32, 0x87, 0xd2, 0x36, 0xf7, 0x48, 0x0f, 0x4a,
-	0xb9, 0x51, 0xca, 0x58, 0xa0, 0x79, 0xba, 0x81, 0x0b, 0x56, 0x6c, 0xab, 0xd0, 0x99, 0xb0, 0x20,
-	0x29, 0xa1, 0x0e, 0x2a, 0xcd, 0xe3, 0x4a, 0x09, 0x2b, 0xd0, 0x88, 0xf4, 0x6b, 0x02, 0xb0, 0x1c,
-	0xa2, 0x8b, 0x2b, 0xdf, 0xe8, 0x95, 0x02, 0x01, 0x44, 0x17, 0xbf, 0x23, 0x35, 0x28, 0x81, 0x56,
-	0x59, 0x43, 0xce, 0x40, 0x09, 0xfa, 0x91, 0xec, 0x61, 0xc7, 0x02, 0x58, 0x94, 0x2a, 0x63, 0x45,
-	0xce, 0x21, 0xa9, 0xdc, 0xd5, 0xbe, 0xa9, 0xbb, 0x76, 0xed, 0x79, 0x0e, 0xc7, 0x25, 0x43, 0x00,
-	0x09, 0x86, 0x87, 0x3f, 0x9c, 0xf2, 0x9a, 0x96, 0x8b, 0x78, 0x45, 0xb6, 0x40, 0x85, 0xda, 0x6b,
-	0xa0, 0xba, 0x0f, 0xff, 0xc6, 0x8a, 0x05, 0x56, 0xe7, 0x4a, 0x59, 0x2c, 0xa4, 0xe7, 0xa4, 0x2b,
-	0x25, 0xc4, 0x62, 0x5a, 0xde, 0x1b, 0xe1, 0x39, 0xc8, 0xf4, 0xf4, 0xdf, 0x4c, 0x6f, 0xeb, 0x65,
-	0x25, 0xe5, 0x3a, 0x95, 0xbd, 0xdc, 0xaa, 0x90, 0x0c, 0x07, 0x2c, 0xf5, 0x69, 0xab, 0x42, 0xda,
-	0x09, 0xf6, 0x19, 0xe9, 0xac, 0x26, 0xd9, 0x60, 0xa9, 0x97, 0xeb, 0x96, 0x7a, 0x70, 0x33, 0xd7,
-	0xd6, 0x3c, 0xb5, 0xff, 0x9a, 0xd0, 0x3f, 0x07, 0xdc, 0xd0, 0xe9, 0xff, 0x7a, 0xa7, 0x6e, 0x8d,
-	0xe1, 0xcd, 0xc1, 0xf9, 0x1e, 0x76, 0x1d, 0xdb, 0x7f, 0x69, 0x94, 0xa4, 0x85, 0x18, 0x2f, 0xd2,
-	0xea, 0xa7, 0x1a, 0x6e, 0xe3, 0xf3, 0xc9, 0xcf, 0x00, 0x00, 0x00, 0xff, 0xff, 0x60, 0x7e, 0xc8,
-	0xce, 0x69, 0x05, 0x00, 0x00,
+	proto.RegisterFile("lte/protos/s1ap_state.proto", fileDescriptor_s1ap_state_fb9033fdc12d3ba8)
+}
+
+var fileDescriptor_s1ap_state_fb9033fdc12d3ba8 = []byte{
+	// 687 bytes of a gzipped FileDescriptorProto
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x8c, 0x94, 0x51, 0x6f, 0xd3, 0x3a,
+	0x14, 0xc7, 0xd5, 0x76, 0x5d, 0xd7, 0x93, 0xa5, 0xaa, 0xac, 0xbb, 0xab, 0x6c, 0xbb, 0x77, 0x2a,
+	0x45, 0x43, 0x95, 0x80, 0x54, 0x2d, 0x3c, 0x20, 0x40, 0x82, 0xb1, 0xed, 0x61, 0x0f, 0x20, 0x94,
+	0xae, 0x2f, 0x43, 0xc8, 0x72, 0xe2, 0x43, 0x15, 0x11, 0x3b, 0x51, 0xec, 0x8c, 0xee, 0x2b, 0xf1,
+	0xc1, 0x78, 0xe4, 0x33, 0x20, 0x3b, 0x59, 0x49, 0x61, 0x83, 0x3d, 0x25, 0x3e, 0xe7, 0x7f, 0xfe,
+	0x3e, 0xf1, 0xf9, 0xc5, 0xb0, 0x9f, 0x68, 0x1c, 0x67, 0x79, 0xaa, 0x53, 0x35, 0x56, 0x13, 0x96,
+	0x51, 0xa5, 0x99, 0x46, 0xdf, 0x46, 0xc8, 0xbf, 0x82, 0x2d, 0x04, 0xf3, 0x13, 0x8d, 0xfe, 0x82,
+	0x69, 0xfc, 0xc2, 0xae, 0x7c, 0xa3, 0x19, 0x3e, 0x86, 0xee, 0x6c, 0xc2, 0xb2, 0xf3, 0x58, 0x60,
+	0x4e, 0x7a, 0xd0, 0x8c, 0xb9, 0xd7, 0x18, 0x34, 0x46, 0xed, 0xa0, 0x19, 0x73, 0xd2, 0x87, 0x96,
+	0xc2, 0xc8, 0x6b, 0xda, 0x80, 0x79, 0x1d, 0x7e, 0xdf, 0x80, 0xde, 0xa9, 0x0c, 0x4f, 0x50, 0x45,
+	0x79, 0x9c, 0xe9, 0x38, 0x95, 0x64, 0x07, 0x36, 0x51, 0x86, 0xb4, 0x2a, 0x74, 0x83, 0x36, 0xca,
+	0xf0, 0x8c, 0x93, 0x5d, 0xd8, 0x52, 0x93, 0xb2, 0x85, 0xca, 0xa0, 0xa3, 0x26, 0x33, 0xb3, 0x34,
+	0x29, 0x53, 0x21, 0x99, 0x40, 0xaf, 0x35, 0x68, 0x8c, 0xb6, 0x83, 0x0e, 0xca, 0xf0, 0x1d, 0x13,
+	0x48, 0x1e, 0x01, 0xe1, 0xf8, 0x89, 0x15, 0x89, 0xa6, 0x19, 0x5b, 0xc4, 0x72, 0x41, 0x79, 0xbe,
+	0xf4, 0x36, 0xac, 0x71, 0xbf, 0xca, 0xbc, 0xb7, 0x89, 0x93, 0x7c, 0x49, 0x46, 0xd0, 0x97, 0x21,
+	0x2d, 0x90, 0x32, 0xa5, 0xd2, 0x28, 0x66, 0x1a, 0xb9, 0xd7, 0xb6, 0xda, 0x9e, 0x0c, 0xe7, 0x78,
+	0xb4, 0x8a, 0x92, 0x10, 0xfe, 0xb7, 0x47, 0x62, 0xf6, 0xb5, 0x62, 0x1a, 0x25, 0xc8, 0x24, 0x2d,
+	0x32, 0xaa, 0xcd, 0xa7, 0x7b, 0x9b, 0x83, 0xc6, 0xc8, 0x99, 0xde, 0xf3, 0x6f, 0x3e, 0x26, 0x7f,
+	0x75, 0x46, 0x81, 0x67, 0xd6, 0xa7, 0x32, 0xb4, 0xe6, 0xc7, 0xc6, 0x64, 0x5e, 0x9d, 0xde, 0x10,
+	0x5c, 0x15, 0xe9, 0xac, 0xf2, 0x8f, 0xb9, 0xd7, 0xb1, 0xad, 0x38, 0x26, 0x68, 0xd5, 0x67, 0xdc,
+	0x76, 0x8c, 0x4b, 0x4d, 0xad, 0x50, 0xe9, 0x1c, 0x99, 0xf0, 0xb6, 0xaa, 0x8e, 0x71, 0xa9, 0x67,
+	0x91, 0xce, 0x66, 0x36, 0x4a, 0xfe, 0x83, 0x6e, 0x2c, 0x4b, 0x85, 0xf2, 0xba, 0x56, 0xf2, 0x33,
+	0x40, 0x0e, 0x00, 0xd2, 0x42, 0x5f, 0xa7, 0xc1, 0xa6, 0x6b, 0x11, 0x72, 0x04, 0xad, 0x02, 0x95,
+	0xe7, 0x0c, 0x5a, 0x23, 0x67, 0x3a, 0xbe, 0xed, 0xab, 0xd6, 0x27, 0xe9, 0xcf, 0x51, 0x9d, 0x4a,
+	0x9d, 0x5f, 0x05, 0xa6, 0x96, 0x1c, 0x42, 0x4f, 0x15, 0x59, 0x96, 0xe6, 0x1a, 0x39, 0xd5, 0x2c,
+	0x52, 0xde, 0xf6, 0xa0, 0x35, 0x72, 0x03, 0x77, 0x15, 0x3d, 0x67, 0x91, 0xda, 0xfb, 0x08, 0x5b,
+	0xd7, 0x75, 0x86, 0x97, 0xcf, 0x78, 0x55, 0x71, 0x60, 0x5e, 0xc9, 0x0b, 0x68, 0x5f, 0xb2, 0xa4,
+	0x28, 0x11, 0x70, 0xa6, 0x87, 0xb7, 0x75, 0x32, 0xc7, 0x5a, 0x23, 0x41, 0x59, 0xf3, 0xbc, 0xf9,
+	0xac, 0x31, 0xfc, 0xda, 0x04, 0x77, 0x2d, 0x49, 0x0e, 0xc0, 0x51, 0x13, 0x33, 0xf4, 0x3a, 0x5b,
+	0x5d, 0x35, 0x99, 0x63, 0x49, 0xd7, 0x7d, 0xe8, 0x61, 0x49, 0x85, 0x9d, 0x78, 0xcc, 0x2d, 0x63,
+	0x6e, 0xe0, 0xa0, 0x61, 0xc2, 0x0c, 0xf2, 0x8c, 0x1b, 0x91, 0x10, 0x58, 0x17, 0x95, 0x8c, 0x39,
+	0x42, 0xe0, 0x4a, 0x34, 0x82, 0x7e, 0x6d, 0x4e, 0x34, 0xc7, 0xe8, 0xf2, 0x1a, 0x2f, 0xb5, 0x1a,
+	0x54, 0x80, 0xd1, 0xe5, 0xaf, 0x4a, 0x85, 0x92, 0x5b, 0xa2, 0xd6, 0x94, 0x33, 0x94, 0x9c, 0x7c,
+	0x80, 0x5d, 0xbb, 0x63, 0x81, 0x34, 0x4a, 0xa5, 0x36, 0x2c, 0xe4, 0x98, 0x54, 0x10, 0x76, 0xee,
+	0x0a, 0xe1, 0x8e, 0x59, 0xcf, 0xf1, 0xb8, 0x74, 0x08, 0x30, 0xb1, 0xe1, 0xe1, 0xb7, 0x66, 0xf9,
+	0x37, 0x97, 0x07, 0xf1, 0x0a, 0x36, 0x50, 0x86, 0xca, 0x6b, 0x58, 0x08, 0x1e, 0xfe, 0xc9, 0xd5,
+	0x16, 0x18, 0x1c, 0x2a, 0x00, 0x6c, 0x21, 0xb9, 0x00, 0x57, 0x08, 0x8c, 0xf9, 0xb4, 0xfc, 0xbd,
+	0xb8, 0xd7, 0xb4, 0x4e, 0x4f, 0xff, 0xee, 0xf4, 0xb6, 0x5e, 0x56, 0x5a, 0xae, 0x5b, 0x99, 0x3b,
+	0x40, 0x16, 0x82, 0xda, 0x06, 0xcb, 0xf9, 0x74, 0x64, 0x21, 0x4c, 0x07, 0x7b, 0x14, 0xba, 0xab,
+	0x4e, 0x6e, 0x40, 0xea, 0xe5, 0x3a, 0x52, 0x0f, 0xee, 0x06, 0x77, 0x8d, 0xa9, 0xbd, 0xd7, 0x40,
+	0x7e, 0x6f, 0xf0, 0x86, 0x9d, 0xfe, 0xa9, 0xef, 0xe4, 0xd6, 0x1c, 0xde, 0xec, 0x5f, 0xec, 0xda,
+	0x5d, 0xc7, 0xe6, 0xca, 0x8d, 0x92, 0xb4, 0xe0, 0xe3, 0x45, 0x5a, 0xdd, 0xbd, 0xe1, 0xa6, 0x7d,
+	0x3e, 0xf9, 0x11, 0x00, 0x00, 0xff, 0xff, 0x6d, 0x87, 0x16, 0x7d, 0x90, 0x05, 0x00, 0x00,
 }
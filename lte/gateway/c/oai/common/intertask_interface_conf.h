@@ -47,4 +47,11 @@
 #define ITTI_QUEUE_MAX_ELEMENTS (64 * 1024)
 #define ITTI_DUMP_MAX_CON (5) /* Max connections in parallel */
 
+/* Maximum number of threads serving a single task */
+#define ITTI_TASK_WORKERS_MAX (16)
+
+/* Default pending messages starting and ending the overload of a task */
+#define ITTI_QUEUE_HIGH_WATERMARK (10000)
+#define ITTI_QUEUE_LOW_WATERMARK (2000)
+
 #endif /* FILE_INTERTASK_INTERFACE_CONF_SEEN */
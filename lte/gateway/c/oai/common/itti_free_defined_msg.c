@@ -42,6 +42,12 @@
 //------------------------------------------------------------------------------
 void itti_free_msg_content(MessageDef *const message_p)
 {
+  /*
+   * Other tasks may still read a broadcast message, ITTI frees its content
+   * when the last task releases it
+   */
+  if (ITTI_MSG_SHARED(message_p)) return;
+
   switch (ITTI_MSG_ID(message_p)) {
     case ASYNC_SYSTEM_COMMAND: {
       if (ASYNC_SYSTEM_COMMAND(message_p).system_command) {
@@ -234,3 +240,12 @@ void itti_free_msg_content(MessageDef *const message_p)
     default:;
   }
 }
+
+//------------------------------------------------------------------------------
+void itti_free_msgs(MessageDef **const messages, size_t nb_messages)
+{
+  for (size_t i = 0; i < nb_messages; i++) {
+    itti_free_msg_content(messages[i]);
+    itti_free(ITTI_MSG_ORIGIN_ID(messages[i]), messages[i]);
+  }
+}
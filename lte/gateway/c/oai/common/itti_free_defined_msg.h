@@ -37,8 +37,15 @@
 #ifndef FILE_ITTI_FREE_DEFINED_MSG_SEEN
 #define FILE_ITTI_FREE_DEFINED_MSG_SEEN
 
+#include <stddef.h>
+
 #include "intertask_interface_types.h"
 
 void itti_free_msg_content(MessageDef *const message_p);
+/*
+ * Frees the messages and their content, for the rest of a received batch
+ * that a terminating task leaves unhandled
+ */
+void itti_free_msgs(MessageDef **const messages, size_t nb_messages);
 
 #endif /* FILE_ITTI_FREE_DEFINED_MSG_SEEN */
@@ -24,10 +24,34 @@
 #pragma once
 
 #include <stdint.h>
-#include <pthread.h>
 
 #include "mme_app_ue_context.h"
 
+/*
+ * Statistics are counted by the MME_APP workers and the S1AP task without a
+ * common lock: every thread adds to a shard of its own and the values are
+ * summed when they are read. Each statistic is a pair of monotonic counters,
+ * its current value being their difference. That value is clamped at zero
+ * when it is read: a removal without its addition, or read in a shard before
+ * its addition in another one, never makes it wrap.
+ */
+#define MME_APP_STATS_SHARDS 16
+
+typedef enum {
+  MME_APP_STAT_ENB_CONNECTED = 0,
+  MME_APP_STAT_UE_ATTACHED,
+  MME_APP_STAT_UE_CONNECTED,
+  MME_APP_STAT_DEFAULT_EPS_BEARERS,
+  MME_APP_STAT_S1U_BEARERS,
+  MME_APP_STAT_MAX,
+} mme_app_stat_t;
+
+// Counters of the threads mapped to a shard, alone on their cache lines
+typedef struct mme_app_stats_shard_s {
+  uint64_t added[MME_APP_STAT_MAX];
+  uint64_t removed[MME_APP_STAT_MAX];
+} __attribute__((aligned(64))) mme_app_stats_shard_t;
+
 typedef struct mme_app_desc_s {
   /* UE contexts + some statistics variables */
   mme_ue_context_t mme_ue_contexts;
@@ -35,33 +59,12 @@ typedef struct mme_app_desc_s {
   long statistic_timer_id;
   uint32_t statistic_timer_period;
 
-  /* Reader/writer lock */
-  pthread_rwlock_t rw_lock;
-
   /* ***************Statistics*************
    * number of attached UE,number of connected UE,
-   * number of idle UE,number of default bearers,
-   * number of S1_U bearers,number of PDN sessions
+   * number of default bearers, number of S1_U bearers,
+   * number of connected eNBs
    */
-
-  uint32_t nb_enb_connected;
-  uint32_t nb_ue_attached;
-  uint32_t nb_ue_connected;
-  uint32_t nb_default_eps_bearers;
-  uint32_t nb_s1u_bearers;
-
-  /* ***************Changes in Statistics**************/
-
-  uint32_t nb_ue_attached_since_last_stat;
-  uint32_t nb_ue_detached_since_last_stat;
-  uint32_t nb_ue_connected_since_last_stat;
-  uint32_t nb_ue_disconnected_since_last_stat;
-  uint32_t nb_eps_bearers_established_since_last_stat;
-  uint32_t nb_eps_bearers_released_since_last_stat;
-  uint32_t nb_enb_connected_since_last_stat;
-  uint32_t nb_enb_released_since_last_stat;
-  uint32_t nb_s1u_bearers_released_since_last_stat;
-  uint32_t nb_s1u_bearers_established_since_last_stat;
+  mme_app_stats_shard_t stats[MME_APP_STATS_SHARDS];
 } mme_app_desc_t;
 
 extern mme_app_desc_t mme_app_desc;
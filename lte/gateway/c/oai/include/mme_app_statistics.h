@@ -22,8 +22,26 @@
 #ifndef FILE_MME_APP_STATISTICS_SEEN
 #define FILE_MME_APP_STATISTICS_SEEN
 
+#include <stdint.h>
+
+#include "mme_app_desc.h"
+
+// Sum of the statistics shards, indexed by mme_app_stat_t
+typedef struct mme_app_stats_snapshot_s {
+  uint32_t current[MME_APP_STAT_MAX];
+  uint64_t added[MME_APP_STAT_MAX];   // since the start
+  uint64_t removed[MME_APP_STAT_MAX]; // since the start
+} mme_app_stats_snapshot_t;
+
 int mme_app_statistics_display(void);
 
+/*
+ * Reads the statistics without blocking their writers, from any thread. The
+ * shards are not read at once, a value may lag behind another one by the
+ * updates made during the read.
+ */
+void mme_app_statistics_snapshot(mme_app_stats_snapshot_t *const snapshot);
+
 /*********************************** Utility Functions to update Statistics**************************************/
 void update_mme_app_stats_connected_enb_add(void);
 void update_mme_app_stats_connected_enb_sub(void);
@@ -49,6 +49,7 @@
 #include "security_types.h"
 #include "sgw_ie_defs.h"
 #include "mme_app_sgs_fsm.h"
+#include "mme_app_ue_lock.h"
 #include "intertask_interface_types.h"
 #include "emm_data.h"
 #include "esm_data.h"
@@ -330,13 +331,63 @@ typedef struct sgs_context_s {
   bool is_emergency_call; /* True - if the call is of type Emergency call */
 } sgs_context_t;
 
+/* Indexes of the UE registry, see mme_ue_context_t */
+typedef enum {
+  MME_UE_COLL_KEY_IMSI = 0,
+  MME_UE_COLL_KEY_S11_TEID,
+  MME_UE_COLL_KEY_ENB_S1AP_ID,
+  MME_UE_COLL_KEY_GUTI,
+  MME_UE_COLL_KEY_MAX
+} mme_ue_coll_key_t;
+
+/*
+ * GUTI packed in a UE registry key: the MME group id, MME code and M-TMSI,
+ * that identify the UE in the MME pool. The PLMN does not fit in the key,
+ * mme_ue_context_exists_guti() checks it on the context found.
+ */
+#define MME_APP_GUTI_KEY(gUtI)                                                 \
+  ((((hash_key_t)(gUtI)->gummei.mme_gid) << 40) |                              \
+   (((hash_key_t)(gUtI)->gummei.mme_code) << 32) | (gUtI)->m_tmsi)
+
+/* Slot of a UE context in the UE registry, only changed by the registry */
+typedef struct mme_ue_registry_slot_s {
+  // INVALID_MME_UE_S1AP_ID while the context is not registered
+  mme_ue_s1ap_id_t mme_ue_s1ap_id;
+  // Keys the context is indexed by, bit (1 << coll_key) of indexed is set
+  // when keys[coll_key] is in the index
+  hash_key_t keys[MME_UE_COLL_KEY_MAX];
+  uint8_t indexed;
+} mme_ue_registry_slot_t;
+
 /** @struct ue_mm_context_t
  *  @brief Useful parameters to know in MME application layer. They are set
  * according to 3GPP TS.23.401 #5.7.2
  */
 typedef struct ue_mm_context_s {
-  pthread_mutex_t
-    recmutex; // mutex on the ue_mm_context_t + emm_context_s + esm_context_t
+  mme_app_ue_lock_t
+    lock; // lock on the ue_mm_context_t + emm_context_s + esm_context_t
+  // One reference from the creation to the removal of the context, plus one
+  // per lock level held. The last one retires the context, so that a thread
+  // waiting for the lock never wakes up on freed memory.
+  uint32_t refcount;
+  // Next context of the walk of worker 0, see mme_ue_context_walk_start()
+  struct ue_mm_context_s *walk_next;
+
+  /* The identifiers used by the registry lookups and the S1AP procedures are
+   * kept next to the lock so that finding a UE touches a single cache line.
+   */
+  // MME UE S1AP ID, Unique identity of the UE within MME.
+  mme_ue_s1ap_id_t mme_ue_s1ap_id;
+
+  // eNB UE S1AP ID,  Unique identity of the UE within eNodeB.
+  enb_ue_s1ap_id_t enb_ue_s1ap_id : 24;
+  enb_s1ap_id_key_t enb_s1ap_id_key; // key uniq among all connected eNBs
+
+  // eNodeB Address in Use for S1-MME // The IP address of the eNodeB currently used for S1-MME.
+  // implicit with use of SCTP through the use of sctp_assoc_id_key
+  sctp_assoc_id_t sctp_assoc_id_key; // link with eNB id
+
+  mme_ue_registry_slot_t registry_slot;
 
   /* Basic identifier for ue. IMSI is encoded on maximum of 15 digits of 4 bits,
    * so usage of an unsigned integer on 64 bits is necessary.
@@ -369,7 +420,6 @@ typedef struct ue_mm_context_s {
 
   /* TODO: Add TAI list */
   tai_t serving_cell_tai;
-  tai_list_t tail_list; // Current Tracking area list
 
   tai_t
     tai_last_tau; // TAI of the TA in which the last Tracking Area Update was initiated.
@@ -406,7 +456,10 @@ typedef struct ue_mm_context_s {
   // eKSI                         // Key Set Identifier for the main key K ASME . Also indicates whether the UE is using
   // security keys derived from UTRAN or E-UTRAN security association.
 
-  apn_config_profile_t apn_config_profile; // set by S6A UPDATE LOCATION ANSWER
+  /* Only read when selecting an APN, allocated on the first S6A UPDATE
+   * LOCATION ANSWER rather than carried by every idle UE.
+   */
+  apn_config_profile_t *apn_config_profile;
   subscriber_status_t sub_status;   // set by S6A UPDATE LOCATION ANSWER
 
   // K ASME                       // Main key for E-UTRAN key hierarchy based on CK, IK and Serving network identity
@@ -445,17 +498,6 @@ typedef struct ue_mm_context_s {
 
   // SGSN TEID for S3             // SGSN Tunnel Endpoint Identifier for S3 interface (used if ISR is activated for the E-UTRAN capable UE)
 
-  // eNodeB Address in Use for S1-MME // The IP address of the eNodeB currently used for S1-MME.
-  // implicit with use of SCTP through the use of sctp_assoc_id_key
-  sctp_assoc_id_t sctp_assoc_id_key; // link with eNB id
-
-  // eNB UE S1AP ID,  Unique identity of the UE within eNodeB.
-  enb_ue_s1ap_id_t enb_ue_s1ap_id : 24;
-  enb_s1ap_id_key_t enb_s1ap_id_key; // key uniq among all connected eNBs
-
-  // MME UE S1AP ID, Unique identity of the UE within MME.
-  mme_ue_s1ap_id_t mme_ue_s1ap_id;
-
   // Subscribed UE-AMBR: The Maximum Aggregated uplink and downlink MBR values to be shared across all Non-GBR bearers according to the subscription of the user.
   ambr_t subscribed_ue_ambr; // set by S6A UPDATE LOCATION ANSWER
   // UE-AMBR: The currently used Maximum Aggregated uplink and downlink MBR values to be shared across all Non-GBR bearers.
@@ -548,11 +590,18 @@ typedef struct mme_ue_context_s {
   uint32_t nb_ue_since_last_stat;
   uint32_t nb_bearers_since_last_stat;
 
-  hash_table_uint64_ts_t *imsi_ue_context_htbl;  // data is mme_ue_s1ap_id_t
-  hash_table_uint64_ts_t *tun11_ue_context_htbl; // data is mme_ue_s1ap_id_t
+  /*
+   * UE registry
+   * Every UE context has one slot, registered by its mme_ue_s1ap_id, and is
+   * indexed by its IMSI, S11 TEID, eNB key and GUTI. The indexes map to the
+   * mme_ue_s1ap_id, they are all updated under registry_mutex from the keys
+   * recorded in the slot so an UE never leaves a stale key behind. Lookups
+   * do not take the mutex.
+   */
   hash_table_ts_t *mme_ue_s1ap_id_ue_context_htbl;
-  hash_table_uint64_ts_t *enb_ue_s1ap_id_ue_context_htbl;
-  obj_hash_table_uint64_t *guti_ue_context_htbl; // data is mme_ue_s1ap_id_t
+  // data is mme_ue_s1ap_id_t
+  hash_table_uint64_ts_t *coll_key_htbl[MME_UE_COLL_KEY_MAX];
+  pthread_mutex_t registry_mutex;
 } mme_ue_context_t;
 
 /** \brief Retrieve an UE context by selecting the provided IMSI
@@ -579,6 +628,23 @@ ue_mm_context_t *mme_ue_context_exists_mme_ue_s1ap_id(
   mme_ue_context_t *const mme_ue_context,
   const mme_ue_s1ap_id_t mme_ue_s1ap_id);
 
+/** \brief Collect the registered UE contexts, for worker 0 to act on them
+ * without holding any table lock. The registry is walked with a cursor, each
+ * context gets a reference and is chained through its walk_next field.
+ * \param mme_ue_context The UE registry
+ * @returns the walk, to go through with mme_ue_context_walk_next() up to its
+ * end, NULL if there is no UE context
+ **/
+ue_mm_context_t *mme_ue_context_walk_start(
+  mme_ue_context_t *const mme_ue_context);
+
+/** \brief Next UE context of a walk, the ones removed since its start are
+ * skipped
+ * \param walk_p The walk, updated
+ * @returns the UE context locked, or NULL at the end of the walk
+ **/
+ue_mm_context_t *mme_ue_context_walk_next(ue_mm_context_t **const walk_p);
+
 /** \brief Retrieve an UE context by selecting the provided enb_ue_s1ap_id
  * \param enb_ue_s1ap_id The UE id identifier used in S1AP MME
  * @returns an UE context matching the enb_ue_s1ap_id or NULL if the context doesn't exists
@@ -632,6 +698,29 @@ void mme_ue_context_update_coll_keys(
   const s11_teid_t mme_s11_teid,
   const guti_t *const guti_p);
 
+/** \brief Update one key of an UE context in the UE registry
+ * \param mme_ue_context_p The MME context
+ * \param ue_context_p The UE context
+ * \param coll_key The index to update
+ * \param key The new key of the UE in the index
+ * @returns RETURNok if the UE is indexed by key, RETURNerror otherwise
+ **/
+int mme_ue_context_update_coll_key(
+  mme_ue_context_t *const mme_ue_context_p,
+  ue_mm_context_t *const ue_context_p,
+  const mme_ue_coll_key_t coll_key,
+  const hash_key_t key);
+
+/** \brief Remove an UE context from one index of the UE registry
+ * \param mme_ue_context_p The MME context
+ * \param ue_context_p The UE context
+ * \param coll_key The index to remove the UE from
+ **/
+void mme_ue_context_remove_coll_key(
+  mme_ue_context_t *const mme_ue_context_p,
+  ue_mm_context_t *const ue_context_p,
+  const mme_ue_coll_key_t coll_key);
+
 /** \brief dump MME associative collections
  **/
 
@@ -644,7 +733,7 @@ void mme_ue_context_dump_coll_keys(void);
  **/
 int mme_insert_ue_context(
   mme_ue_context_t *const mme_ue_context,
-  const struct ue_mm_context_s *const ue_context_p);
+  struct ue_mm_context_s *const ue_context_p);
 
 /** \brief TODO WORK HERE Remove UE context unnecessary information.
  *  mark it as released. It is necessary to keep track of the association (s_tmsi (guti), mme_ue_s1ap_id)
@@ -655,6 +744,8 @@ void mme_notify_ue_context_released(
   struct ue_mm_context_s *ue_context_p);
 
 /** \brief Remove a UE context of the tree of known UEs.
+ * Releases every level of its lock held by the calling thread, the context
+ * must not be used afterwards.
  * \param ue_context_p The UE context to remove
  **/
 void mme_remove_ue_context(
@@ -674,6 +765,12 @@ void mme_app_free_pdn_connection(pdn_context_t **const pdn_connection);
 
 void mme_app_ue_context_free_content(ue_mm_context_t *const mme_ue_context_p);
 
+/** \brief Bytes of heap held by a UE context, including the out of line
+ * subscription, PDN, bearer and SGS sections
+ * \param ue_context_p The UE context to measure
+ **/
+size_t mme_app_ue_context_size(const ue_mm_context_t *const ue_context_p);
+
 /** \brief Dump the UE contexts present in the tree
  **/
 void mme_app_dump_ue_contexts(const mme_ue_context_t *const mme_ue_context);
@@ -58,6 +58,7 @@
 #define MME_CONFIG_STRING_MAXUE "MAXUE"
 #define MME_CONFIG_STRING_RELATIVE_CAPACITY "RELATIVE_CAPACITY"
 #define MME_CONFIG_STRING_STATISTIC_TIMER "MME_STATISTIC_TIMER"
+#define MME_CONFIG_STRING_HASHTABLE_METRICS "HASHTABLE_METRICS"
 
 #define MME_CONFIG_STRING_IP_CAPABILITY "IP_CAPABILITY"
 #define MME_CONFIG_STRING_USE_STATELESS "USE_STATELESS"
@@ -83,6 +84,16 @@
 
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG "INTERTASK_INTERFACE"
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE "ITTI_QUEUE_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_METRICS "ITTI_METRICS"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_MME_APP_WORKERS "MME_APP_WORKERS"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_MME_APP_HIGH_WATERMARK           \
+  "MME_APP_HIGH_WATERMARK"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_MME_APP_LOW_WATERMARK            \
+  "MME_APP_LOW_WATERMARK"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_S1AP_HIGH_WATERMARK              \
+  "S1AP_HIGH_WATERMARK"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_S1AP_LOW_WATERMARK               \
+  "S1AP_LOW_WATERMARK"
 
 #define MME_CONFIG_STRING_S6A_CONFIG "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH "S6A_CONF"
@@ -95,6 +106,7 @@
 #define MME_CONFIG_STRING_S1AP_CONFIG "S1AP"
 #define MME_CONFIG_STRING_S1AP_OUTCOME_TIMER "S1AP_OUTCOME_TIMER"
 #define MME_CONFIG_STRING_S1AP_PORT "S1AP_PORT"
+#define MME_CONFIG_STRING_S1AP_STATE_COMMIT_WINDOW "S1AP_STATE_COMMIT_WINDOW"
 
 #define MME_CONFIG_STRING_GUMMEI_LIST "GUMMEI_LIST"
 #define MME_CONFIG_STRING_MME_CODE "MME_CODE"
@@ -120,6 +132,7 @@
 #define MME_CONFIG_STRING_NAS_SUPPORTED_CIPHERING_ALGORITHM_LIST               \
   "ORDERED_SUPPORTED_CIPHERING_ALGORITHM_LIST"
 
+#define MME_CONFIG_STRING_NAS_T3346_TIMER "T3346"
 #define MME_CONFIG_STRING_NAS_T3402_TIMER "T3402"
 #define MME_CONFIG_STRING_NAS_T3412_TIMER "T3412"
 #define MME_CONFIG_STRING_NAS_T3422_TIMER "T3422"
@@ -188,6 +201,8 @@ typedef struct sctp_config_s {
 typedef struct s1ap_config_s {
   uint16_t port_number;
   uint8_t outcome_drop_timer_sec;
+  // stateless mode, the state is committed to redis at most once per window
+  uint32_t state_commit_window_ms;
 } s1ap_config_t;
 
 typedef struct ipv4_s {
@@ -206,14 +221,25 @@ typedef struct s6a_config_s {
   bstring hss_host_name;
 } s6a_config_t;
 
+// Pending messages starting and ending the overload of a task, high 0 is off
+typedef struct queue_watermarks_s {
+  uint32_t high;
+  uint32_t low;
+} queue_watermarks_t;
+
 typedef struct itti_config_s {
   uint32_t queue_size;
+  bool metrics;
+  uint32_t mme_app_workers;
+  queue_watermarks_t mme_app_watermarks;
+  queue_watermarks_t s1ap_watermarks;
   bstring log_file;
 } itti_config_t;
 
 typedef struct nas_config_s {
   uint8_t prefered_integrity_algorithm[8];
   uint8_t prefered_ciphering_algorithm[8];
+  uint32_t t3346_min;
   uint32_t t3402_min;
   uint32_t t3412_min;
   uint32_t t3422_sec;
@@ -269,6 +295,7 @@ typedef struct mme_config_s {
   uint8_t relative_capacity;
 
   uint32_t mme_statistic_timer;
+  bool hashtable_metrics;
 
   bstring ip_capability;
   bstring non_eps_service_control;
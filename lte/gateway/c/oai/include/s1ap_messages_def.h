@@ -211,3 +211,9 @@ MESSAGE_DEF(
   MESSAGE_PRIORITY_MED,
   itti_s1ap_path_switch_request_failure_t,
   s1ap_path_switch_request_failure)
+/* Sent on any MME_APP or S1AP queue overload start or stop */
+MESSAGE_DEF(
+  S1AP_QUEUE_OVERLOAD_IND,
+  MESSAGE_PRIORITY_MAX,
+  IttiMsgEmpty,
+  s1ap_queue_overload_ind)
@@ -46,7 +46,7 @@ MESSAGE_DEF(
   sctp_new_peer)
 MESSAGE_DEF(
   SCTP_CLOSE_ASSOCIATION,
-  MESSAGE_PRIORITY_MAX,
+  MESSAGE_PRIORITY_MED,
   sctp_close_association_t,
   sctp_close_association)
 MESSAGE_DEF(
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <stdbool.h>
+
 #include "bstrlib.h"
 #define SERVICE303_MME_PACKAGE_NAME "mme"
 #define SERVICE303_MME_PACKAGE_VERSION "1.0"
@@ -33,6 +35,12 @@
 
 void service303_statistics_read(void);
 
+// Export ITTI per message latency, queue depth and handler time histograms
+void service303_itti_metrics_enable(bool enable);
+
+// Export the resizes of the thread safe hash tables and their sizes
+void service303_hashtable_metrics_enable(bool enable);
+
 // service303 conf type added to be able to use same task interface for MME and
 // SPGW while passing configs from mme_config and spgw_config types
 typedef struct {
@@ -79,27 +79,15 @@ class StateConverter {
     std::function<void(NodeType *, ProtoMessage *)> conversion_callable,
     log_proto_t log_task_level)
   {
-    hashtable_key_array_t *ht_keys = hashtable_ts_get_keys(state_ht);
-    hashtable_rc_t ht_rc;
-    if (ht_keys == nullptr) {
-      return;
-    }
-
-    for (uint32_t i = 0; i < ht_keys->num_keys; i++) {
-      NodeType *node;
-      ht_rc = hashtable_ts_get(
-        state_ht, (hash_key_t) ht_keys->keys[i], (void **) &node);
-      if (ht_rc == HASH_TABLE_OK) {
-        ProtoMessage proto;
-        conversion_callable((NodeType *) node, &proto);
-        (*proto_map)[ht_keys->keys[i]] = proto;
-      } else {
-        OAILOG_ERROR(
-          log_task_level,
-          "Key %u not found on %s hashtable",
-          ht_keys->keys[i],
-          state_ht->name->data);
-      }
+    hashtable_ts_cursor_t cursor;
+    hash_key_t key;
+    void *node;
+
+    hashtable_ts_cursor_init(&cursor, state_ht, HASH_TABLE_CURSOR_STRIPED);
+    while (hashtable_ts_cursor_next(&cursor, &key, &node)) {
+      ProtoMessage proto;
+      conversion_callable((NodeType *) node, &proto);
+      (*proto_map)[key] = proto;
     }
   }
 
@@ -272,6 +272,7 @@ typedef struct ue_security_capability_s {
 #define T3423_DEFAULT_VALUE 0 // value provided by network
 #define T3440_DEFAULT_VALUE 10
 #define T3442_DEFAULT_VALUE 0 // value provided by network
+#define T3346_DEFAULT_VALUE 15 // value provided by network, in minutes
 
 //..............................................................................
 // Table 10.2.2: EPS mobility management timers – network side
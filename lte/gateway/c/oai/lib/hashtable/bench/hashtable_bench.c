@@ -0,0 +1,1052 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*
+ * Single thread benchmark of the backends of the thread safe uint64 hash
+ * tables, at the sizes of the MME UE tables.
+ *
+ * For each backend and number of keys, a table sized for all the keys (as
+ * mme_app does with max_ues) is filled, then looked up with present and absent
+ * keys, and emptied. Keys are either sequential, like mme_ue_s1ap_id or TEIDs,
+ * or random like IMSIs. Every run is done in its own process so the RSS growth
+ * only accounts for the table.
+ *
+ * Then BENCH_READERS threads look up the keys of a filled table while 0 to
+ * BENCH_MAX_WRITERS threads insert and remove other keys, resizing it. The
+ * lookups taking no lock, their CPU cost should not depend on the writers.
+ *
+ * Next, BENCH_CHURN_THREADS threads attach and detach UEs as mme_app does: a
+ * context is indexed by its mme_ue_s1ap_id and its IMSI string, and detached
+ * once BENCH_CHURN_UES newer UEs attached. The malloc() calls per attach and
+ * detach, and the free heap left once the UEs churned, show the cost of the
+ * node and key allocations. The churn runs with the nodes allocated by
+ * malloc(), then from the slabs unless built with HASHTABLE_SLAB=0.
+ *
+ * Last, 1 to BENCH_MAX_THREADS threads share a table of every variant
+ * (hash_table_t behind a mutex, as its users do, hash_table_ts_t,
+ * hash_table_uint64_ts_t and obj_hash_table_t keyed by IMSI), looking up
+ * and re-inserting its BENCH_MIXED_KEYS keys. The keys are picked either
+ * sequentially or along a Zipf distribution, a few UEs being much more
+ * active than the others. A thread only re-inserts its own keys, so any
+ * lost or wrong result fails the run. The throughput, the 99th percentile
+ * of the latency of one operation and the peak RSS are reported.
+ *
+ * Usage: hashtable_bench [--smoke]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <malloc.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+#include "hashtable_slab.h"
+#include "obj_hashtable.h"
+
+#define BENCH_SMOKE_DIVIDER 100
+#define BENCH_READERS 4
+#define BENCH_MAX_WRITERS 2
+#define BENCH_READ_KEYS 100000
+#define BENCH_READ_DURATION_NS 1000000000ULL
+#define BENCH_CHURN_THREADS 4
+#define BENCH_CHURN_UES 20000
+#define BENCH_CHURN_OPS 1000000
+#define BENCH_MIXED_KEYS 100000
+#define BENCH_MIXED_DURATION_NS 200000000ULL
+#define BENCH_MAX_THREADS 32
+#define BENCH_SMOKE_MAX_THREADS 4
+#define BENCH_ZIPF_THETA 0.99
+// One operation out of BENCH_LATENCY_SAMPLING is timed
+#define BENCH_LATENCY_SAMPLING 8
+#define BENCH_HISTOGRAM_SUB_BITS 3
+#define BENCH_HISTOGRAM_SIZE (64 << BENCH_HISTOGRAM_SUB_BITS)
+#define BENCH_IMSI_LENGTH 15
+
+typedef struct bench_backend_s {
+  const char *name;
+  hashtable_backend_t backend;
+} bench_backend_t;
+
+static const bench_backend_t bench_backends[] = {
+  {"chained", HASH_TABLE_BACKEND_CHAINED},
+  {"open", HASH_TABLE_BACKEND_OPEN_ADDRESSING},
+};
+
+static const size_t bench_sizes[] = {100000, 1000000};
+
+typedef enum bench_variant_e {
+  BENCH_HASH_TABLE = 0,
+  BENCH_HASH_TABLE_TS,
+  BENCH_HASH_TABLE_UINT64_TS,
+  BENCH_OBJ_HASH_TABLE,
+  BENCH_VARIANT_MAX,
+} bench_variant_t;
+
+static const char *const bench_variant_names[BENCH_VARIANT_MAX] = {
+  "hash_table_t",
+  "hash_table_ts_t",
+  "hash_table_uint64_ts_t",
+  "obj_hash_table_t",
+};
+
+// Percentage of lookups, the other operations re-insert a key
+static const int bench_read_ratios[] = {95, 50};
+
+/*
+ * Counts the allocations of the whole process, the hash tables included.
+ * glibc exports its allocator under the __libc_ names.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static uint64_t bench_nb_allocs = 0;
+
+void *malloc(size_t size)
+{
+  __atomic_fetch_add(&bench_nb_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+  __atomic_fetch_add(&bench_nb_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  __atomic_fetch_add(&bench_nb_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_realloc(ptr, size);
+}
+
+static uint64_t _bench_clock_ns(clockid_t clock)
+{
+  struct timespec ts;
+
+  clock_gettime(clock, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t _bench_now_ns(void)
+{
+  return _bench_clock_ns(CLOCK_MONOTONIC);
+}
+
+// Field of /proc/self/status in kB, VmRSS or VmHWM for the peak RSS
+static long _bench_status_kb(const char *field)
+{
+  char line[128];
+  size_t length = strlen(field);
+  long kb = -1;
+  FILE *status = fopen("/proc/self/status", "r");
+
+  if (!status) return -1;
+  while (fgets(line, sizeof(line), status)) {
+    if (strncmp(line, field, length) == 0 && line[length] == ':') {
+      kb = strtol(line + length + 1, NULL, 10);
+      break;
+    }
+  }
+  fclose(status);
+  return kb;
+}
+
+// xorshift64*, the keys must differ from HASHTABLE_NOT_A_KEY_VALUE
+static uint64_t _bench_random_key(uint64_t *state)
+{
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (*state * 0x2545f4914f6cdd1dULL) >> 1;
+}
+
+static void _bench_fill_keys(uint64_t *keys, size_t nb_keys, bool sequential)
+{
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+  for (size_t i = 0; i < nb_keys; i++) {
+    keys[i] = sequential ? i + 1 : _bench_random_key(&state);
+  }
+}
+
+static double _bench_mops(size_t nb_ops, uint64_t ns)
+{
+  return ns ? (double) nb_ops * 1000.0 / (double) ns : 0.0;
+}
+
+static void _bench_run(
+  const bench_backend_t *backend,
+  size_t nb_keys,
+  bool sequential)
+{
+  uint64_t *keys = malloc(2 * nb_keys * sizeof(uint64_t));
+  uint64_t *absent_keys = keys + nb_keys;
+  hash_table_uint64_ts_t *table = NULL;
+  bstring name = bfromcstr("bench");
+  uint64_t t0, t_insert, t_hit, t_miss, t_remove;
+  uint64_t data = 0;
+  size_t errors = 0;
+  long rss_before, rss_after;
+
+  if (!keys) {
+    fprintf(stderr, "Cannot allocate %zu keys\n", nb_keys);
+    exit(EXIT_FAILURE);
+  }
+  _bench_fill_keys(keys, 2 * nb_keys, sequential);
+
+  rss_before = _bench_status_kb("VmRSS");
+  table = hashtable_uint64_ts_create_backend(
+    nb_keys, NULL, name, backend->backend);
+  t0 = _bench_now_ns();
+  for (size_t i = 0; i < nb_keys; i++) {
+    errors += hashtable_uint64_ts_insert(table, keys[i], i) != HASH_TABLE_OK;
+  }
+  t_insert = _bench_now_ns() - t0;
+  rss_after = _bench_status_kb("VmRSS");
+
+  t0 = _bench_now_ns();
+  for (size_t i = 0; i < nb_keys; i++) {
+    errors += hashtable_uint64_ts_get(table, keys[i], &data) != HASH_TABLE_OK ||
+              data != i;
+  }
+  t_hit = _bench_now_ns() - t0;
+
+  t0 = _bench_now_ns();
+  for (size_t i = 0; i < nb_keys; i++) {
+    errors += hashtable_uint64_ts_get(table, absent_keys[i], &data) !=
+              HASH_TABLE_KEY_NOT_EXISTS;
+  }
+  t_miss = _bench_now_ns() - t0;
+
+  t0 = _bench_now_ns();
+  for (size_t i = 0; i < nb_keys; i++) {
+    errors += hashtable_uint64_ts_remove(table, keys[i]) != HASH_TABLE_OK;
+  }
+  t_remove = _bench_now_ns() - t0;
+
+  printf(
+    "%-8s %-10s %8zu %9.2f %9.2f %9.2f %9.2f %9.1f\n",
+    backend->name,
+    sequential ? "sequential" : "random",
+    nb_keys,
+    _bench_mops(nb_keys, t_insert),
+    _bench_mops(nb_keys, t_hit),
+    _bench_mops(nb_keys, t_miss),
+    _bench_mops(nb_keys, t_remove),
+    (double) (rss_after - rss_before) / 1024.0);
+  hashtable_uint64_ts_destroy(table);
+  bdestroy(name);
+  free(keys);
+  if (errors) {
+    fprintf(stderr, "%s: %zu unexpected results\n", backend->name, errors);
+    exit(EXIT_FAILURE);
+  }
+}
+
+typedef struct bench_thread_s {
+  pthread_t thread;
+  hash_table_uint64_ts_t *table;
+  const uint64_t *keys;
+  size_t nb_keys;
+  uint64_t seed;
+  volatile bool *stop;
+  size_t nb_ops;
+  uint64_t ns;
+  size_t errors;
+} bench_thread_t;
+
+static void *_bench_reader(void *arg)
+{
+  bench_thread_t *reader = (bench_thread_t *) arg;
+  uint64_t state = reader->seed;
+  uint64_t data = 0;
+  // CPU time, the threads may outnumber the cores
+  uint64_t t0 = _bench_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+  while (!__atomic_load_n(reader->stop, __ATOMIC_RELAXED)) {
+    for (int n = 0; n < 1000; n++) {
+      size_t i = _bench_random_key(&state) % reader->nb_keys;
+
+      reader->errors +=
+        hashtable_uint64_ts_get(reader->table, reader->keys[i], &data) !=
+          HASH_TABLE_OK ||
+        data != i;
+    }
+    reader->nb_ops += 1000;
+  }
+  reader->ns = _bench_clock_ns(CLOCK_THREAD_CPUTIME_ID) - t0;
+  return NULL;
+}
+
+// Inserts and removes its own keys, growing and shrinking the table
+static void *_bench_writer(void *arg)
+{
+  bench_thread_t *writer = (bench_thread_t *) arg;
+
+  while (!__atomic_load_n(writer->stop, __ATOMIC_RELAXED)) {
+    for (size_t i = 0; i < writer->nb_keys; i++) {
+      writer->errors += hashtable_uint64_ts_insert(
+                          writer->table, writer->keys[i], i) != HASH_TABLE_OK;
+    }
+    for (size_t i = 0; i < writer->nb_keys; i++) {
+      writer->errors += hashtable_uint64_ts_remove(
+                          writer->table, writer->keys[i]) != HASH_TABLE_OK;
+    }
+    writer->nb_ops += 2 * writer->nb_keys;
+  }
+  return NULL;
+}
+
+static void _bench_run_readers(
+  const bench_backend_t *backend,
+  int nb_writers,
+  uint64_t duration_ns)
+{
+  const size_t nb_keys = BENCH_READ_KEYS;
+  uint64_t *keys = malloc((1 + BENCH_MAX_WRITERS) * nb_keys * sizeof(uint64_t));
+  bench_thread_t threads[BENCH_READERS + BENCH_MAX_WRITERS];
+  hash_table_uint64_ts_t *table = NULL;
+  bstring name = bfromcstr("bench");
+  volatile bool stop = false;
+  struct timespec duration = {duration_ns / 1000000000,
+                              duration_ns % 1000000000};
+  size_t nb_lookups = 0, nb_writes = 0, errors = 0;
+  uint64_t ns = 0, t0 = 0;
+
+  if (!keys) {
+    fprintf(stderr, "Cannot allocate %zu keys\n", nb_keys);
+    exit(EXIT_FAILURE);
+  }
+  _bench_fill_keys(keys, (1 + BENCH_MAX_WRITERS) * nb_keys, false);
+  table = hashtable_uint64_ts_create_backend(
+    nb_keys, NULL, name, backend->backend);
+  for (size_t i = 0; i < nb_keys; i++) {
+    errors += hashtable_uint64_ts_insert(table, keys[i], i) != HASH_TABLE_OK;
+  }
+
+  memset(threads, 0, sizeof(threads));
+  t0 = _bench_now_ns();
+  for (int t = 0; t < BENCH_READERS + nb_writers; t++) {
+    threads[t].table = table;
+    threads[t].stop = &stop;
+    threads[t].seed = 0x9e3779b97f4a7c15ULL * (t + 1);
+    if (t < BENCH_READERS) {
+      threads[t].keys = keys;
+      threads[t].nb_keys = nb_keys;
+      pthread_create(&threads[t].thread, NULL, _bench_reader, &threads[t]);
+    } else {
+      // Each writer churns as many keys as the table holds
+      threads[t].keys = keys + (1 + t - BENCH_READERS) * nb_keys;
+      threads[t].nb_keys = nb_keys;
+      pthread_create(&threads[t].thread, NULL, _bench_writer, &threads[t]);
+    }
+  }
+  nanosleep(&duration, NULL);
+  __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+  duration_ns = _bench_now_ns() - t0;
+  for (int t = 0; t < BENCH_READERS + nb_writers; t++) {
+    pthread_join(threads[t].thread, NULL);
+    errors += threads[t].errors;
+    if (t < BENCH_READERS) {
+      nb_lookups += threads[t].nb_ops;
+      ns += threads[t].ns;
+    } else {
+      nb_writes += threads[t].nb_ops;
+    }
+  }
+
+  printf(
+    "%-8s %7d %7d %9.1f %9.2f %9.2f\n",
+    backend->name,
+    BENCH_READERS,
+    nb_writers,
+    nb_lookups ? (double) ns / (double) nb_lookups : 0.0,
+    _bench_mops(nb_lookups, duration_ns),
+    _bench_mops(nb_writes, duration_ns));
+  hashtable_uint64_ts_destroy(table);
+  bdestroy(name);
+  free(keys);
+  if (errors) {
+    fprintf(stderr, "%s: %zu unexpected results\n", backend->name, errors);
+    exit(EXIT_FAILURE);
+  }
+}
+
+typedef struct bench_churn_s {
+  pthread_t thread;
+  hash_table_uint64_ts_t *ids;
+  obj_hash_table_t *imsis;
+  uint64_t first_id;
+  size_t nb_ops;
+  size_t errors;
+} bench_churn_t;
+
+static int _bench_imsi(char *imsi, size_t size, uint64_t id)
+{
+  return snprintf(imsi, size, "00101%010" PRIu64, id);
+}
+
+// Attaches a UE and detaches the one attached BENCH_CHURN_UES before
+static void *_bench_churner(void *arg)
+{
+  bench_churn_t *churn = (bench_churn_t *) arg;
+  char imsi[32];
+  void *context = NULL;
+  uint64_t data = 0;
+  int imsi_size = 0;
+
+  for (size_t i = 0; i < churn->nb_ops + BENCH_CHURN_UES; i++) {
+    uint64_t id = churn->first_id + i;
+
+    if (i >= BENCH_CHURN_UES) {
+      id -= BENCH_CHURN_UES;
+      imsi_size = _bench_imsi(imsi, sizeof(imsi), id);
+      churn->errors +=
+        hashtable_uint64_ts_get(churn->ids, id, &data) != HASH_TABLE_OK ||
+        obj_hashtable_ts_remove(churn->imsis, imsi, imsi_size, &context) !=
+          HASH_TABLE_OK ||
+        (uint64_t)(uintptr_t) context != data ||
+        hashtable_uint64_ts_remove(churn->ids, id) != HASH_TABLE_OK;
+      free(context);
+      id += BENCH_CHURN_UES;
+    }
+    if (i < churn->nb_ops) {
+      // The contexts sizes vary as the messages and timers interleaved
+      context = malloc(256 + (id % 16) * 64);
+      imsi_size = _bench_imsi(imsi, sizeof(imsi), id);
+      churn->errors +=
+        !context ||
+        hashtable_uint64_ts_insert(
+          churn->ids, id, (uint64_t)(uintptr_t) context) != HASH_TABLE_OK ||
+        obj_hashtable_ts_insert(churn->imsis, imsi, imsi_size, context) !=
+          HASH_TABLE_OK;
+    }
+  }
+  return NULL;
+}
+
+static void _bench_run_churn(bool slab, size_t nb_ops)
+{
+  bench_churn_t threads[BENCH_CHURN_THREADS];
+  bstring name = NULL;
+  hash_table_uint64_ts_t *ids = NULL;
+  obj_hash_table_t *imsis = NULL;
+  hashtable_slab_stats_t stats[HASHTABLE_SLAB_MAX];
+  struct mallinfo2 heap;
+  uint64_t nb_allocs = 0, t0 = 0, ns = 0;
+  size_t errors = 0;
+
+  // Before the tables allocate their first nodes
+  if (!slab) {
+    hashtable_slab_disable();
+  }
+  name = bfromcstr("bench");
+  ids = hashtable_uint64_ts_create(
+    BENCH_CHURN_THREADS * BENCH_CHURN_UES, NULL, name);
+  imsis = obj_hashtable_ts_create(
+    BENCH_CHURN_THREADS * BENCH_CHURN_UES, NULL, NULL, NULL, name);
+  memset(threads, 0, sizeof(threads));
+  nb_allocs = __atomic_load_n(&bench_nb_allocs, __ATOMIC_RELAXED);
+  t0 = _bench_now_ns();
+  for (int t = 0; t < BENCH_CHURN_THREADS; t++) {
+    threads[t].ids = ids;
+    threads[t].imsis = imsis;
+    threads[t].first_id = (uint64_t) t << 32;
+    threads[t].nb_ops = nb_ops;
+    pthread_create(&threads[t].thread, NULL, _bench_churner, &threads[t]);
+  }
+  for (int t = 0; t < BENCH_CHURN_THREADS; t++) {
+    pthread_join(threads[t].thread, NULL);
+    errors += threads[t].errors;
+  }
+  ns = _bench_now_ns() - t0;
+  nb_allocs = __atomic_load_n(&bench_nb_allocs, __ATOMIC_RELAXED) - nb_allocs;
+  // All the UEs detached, what the heap did not give back is fragmentation
+  heap = mallinfo2();
+  for (int i = 0; i < HASHTABLE_SLAB_MAX; i++) {
+    hashtable_slab_get_stats(i, &stats[i]);
+  }
+
+  printf(
+    "%-8s %7d %9.2f %9.2f %9.1f %9.1f %9zu %9zu\n",
+    hashtable_slab_is_enabled() ? "slab" : "malloc",
+    BENCH_CHURN_THREADS,
+    _bench_mops(BENCH_CHURN_THREADS * nb_ops, ns),
+    (double) nb_allocs / (double) (BENCH_CHURN_THREADS * nb_ops),
+    (double) (heap.arena + heap.hblkhd) / (1024.0 * 1024.0),
+    (double) heap.fordblks / (1024.0 * 1024.0),
+    stats[HASHTABLE_SLAB_NODE].num_chunks,
+    stats[HASHTABLE_SLAB_OBJ_NODE].num_chunks);
+  hashtable_uint64_ts_destroy(ids);
+  obj_hashtable_ts_destroy(imsis);
+  bdestroy(name);
+  if (errors) {
+    fprintf(stderr, "churn: %zu unexpected results\n", errors);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Uniform in [0, 1)
+static double _bench_random_unit(uint64_t *state)
+{
+  return (double) (_bench_random_key(state) >> 10) * 0x1.0p-53;
+}
+
+/*
+ * Zipf distribution of the ranks 0 to nb_items - 1, rank 0 being the most
+ * frequent, with the rejection free method of Gray et al. "Quickly
+ * generating billion-record synthetic databases".
+ */
+typedef struct bench_zipf_s {
+  size_t nb_items;
+  double theta;
+  double alpha;
+  double zetan;
+  double eta;
+} bench_zipf_t;
+
+static void _bench_zipf_init(bench_zipf_t *zipf, size_t nb_items, double theta)
+{
+  double zeta2 = 1.0 + pow(0.5, theta);
+
+  zipf->nb_items = nb_items;
+  zipf->theta = theta;
+  zipf->zetan = 0.0;
+  for (size_t i = 1; i <= nb_items; i++) {
+    zipf->zetan += 1.0 / pow((double) i, theta);
+  }
+  zipf->alpha = 1.0 / (1.0 - theta);
+  zipf->eta = (1.0 - pow(2.0 / (double) nb_items, 1.0 - theta)) /
+              (1.0 - zeta2 / zipf->zetan);
+}
+
+static size_t _bench_zipf_next(const bench_zipf_t *zipf, uint64_t *state)
+{
+  double u = _bench_random_unit(state);
+  double uz = u * zipf->zetan;
+  double scale = pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha);
+  size_t rank = 0;
+
+  if (uz < 1.0) return 0;
+  if (uz < 1.0 + pow(0.5, zipf->theta)) return 1;
+  rank = (size_t)((double) zipf->nb_items * scale);
+  return rank < zipf->nb_items ? rank : zipf->nb_items - 1;
+}
+
+/*
+ * Latencies in ns, in buckets of 2^BENCH_HISTOGRAM_SUB_BITS per power of two
+ * so the percentiles are within 12.5%.
+ */
+static int _bench_histogram_index(uint64_t ns)
+{
+  int msb = 0;
+
+  if (ns < (1 << BENCH_HISTOGRAM_SUB_BITS)) return (int) ns;
+  msb = 63 - __builtin_clzll(ns);
+  return ((msb - BENCH_HISTOGRAM_SUB_BITS + 1) << BENCH_HISTOGRAM_SUB_BITS) |
+         (int) ((ns >> (msb - BENCH_HISTOGRAM_SUB_BITS)) &
+                ((1 << BENCH_HISTOGRAM_SUB_BITS) - 1));
+}
+
+static uint64_t _bench_histogram_value(int index)
+{
+  int group = index >> BENCH_HISTOGRAM_SUB_BITS;
+  uint64_t mantissa = index & ((1 << BENCH_HISTOGRAM_SUB_BITS) - 1);
+
+  if (group == 0) return mantissa;
+  return ((1 << BENCH_HISTOGRAM_SUB_BITS) | mantissa) << (group - 1);
+}
+
+static uint64_t _bench_histogram_percentile(
+  const uint64_t *histogram,
+  double percentile)
+{
+  uint64_t total = 0, count = 0, target = 0;
+
+  for (int i = 0; i < BENCH_HISTOGRAM_SIZE; i++) {
+    total += histogram[i];
+  }
+  target = (uint64_t) ceil((double) total * percentile / 100.0);
+  for (int i = 0; i < BENCH_HISTOGRAM_SIZE; i++) {
+    count += histogram[i];
+    if (count && count >= target) return _bench_histogram_value(i);
+  }
+  return 0;
+}
+
+// The tables of the variant run, all holding the keys 1 to nb_keys
+typedef struct bench_mixed_s {
+  bench_variant_t variant;
+  size_t nb_keys;
+  hash_table_t *table;
+  pthread_mutex_t table_lock;
+  hash_table_ts_t *ts_table;
+  hash_table_uint64_ts_t *uint64_table;
+  obj_hash_table_t *obj_table;
+  char (*imsis)[BENCH_IMSI_LENGTH + 1];
+} bench_mixed_t;
+
+// Looks up the key i + 1
+static hashtable_rc_t _bench_mixed_get(
+  bench_mixed_t *mixed,
+  size_t i,
+  uint64_t *data)
+{
+  hashtable_rc_t rc = HASH_TABLE_OK;
+  void *element = NULL;
+
+  switch (mixed->variant) {
+    case BENCH_HASH_TABLE:
+      pthread_mutex_lock(&mixed->table_lock);
+      rc = hashtable_get(mixed->table, i + 1, &element);
+      pthread_mutex_unlock(&mixed->table_lock);
+      *data = (uintptr_t) element;
+      break;
+    case BENCH_HASH_TABLE_TS:
+      rc = hashtable_ts_get(mixed->ts_table, i + 1, &element);
+      *data = (uintptr_t) element;
+      break;
+    case BENCH_HASH_TABLE_UINT64_TS:
+      rc = hashtable_uint64_ts_get(mixed->uint64_table, i + 1, data);
+      break;
+    case BENCH_OBJ_HASH_TABLE:
+      rc = obj_hashtable_ts_get(
+        mixed->obj_table, mixed->imsis[i], BENCH_IMSI_LENGTH, &element);
+      *data = (uintptr_t) element;
+      break;
+    default:
+      rc = HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+      break;
+  }
+  return rc;
+}
+
+// Removes and inserts back the key i + 1, as a UE context being replaced
+static bool _bench_mixed_update(bench_mixed_t *mixed, size_t i)
+{
+  void *element = NULL;
+  bool ok = false;
+
+  switch (mixed->variant) {
+    case BENCH_HASH_TABLE:
+      pthread_mutex_lock(&mixed->table_lock);
+      ok = hashtable_remove(mixed->table, i + 1, &element) == HASH_TABLE_OK &&
+           hashtable_insert(mixed->table, i + 1, element) == HASH_TABLE_OK;
+      pthread_mutex_unlock(&mixed->table_lock);
+      break;
+    case BENCH_HASH_TABLE_TS:
+      ok =
+        hashtable_ts_remove(mixed->ts_table, i + 1, &element) ==
+          HASH_TABLE_OK &&
+        hashtable_ts_insert(mixed->ts_table, i + 1, element) == HASH_TABLE_OK;
+      break;
+    case BENCH_HASH_TABLE_UINT64_TS:
+      // The uint64 tables do not return the data removed
+      element = (void *) (uintptr_t)(i + 1);
+      ok = hashtable_uint64_ts_remove(mixed->uint64_table, i + 1) ==
+             HASH_TABLE_OK &&
+           hashtable_uint64_ts_insert(mixed->uint64_table, i + 1, i + 1) ==
+             HASH_TABLE_OK;
+      break;
+    case BENCH_OBJ_HASH_TABLE:
+      ok = obj_hashtable_ts_remove(
+             mixed->obj_table,
+             mixed->imsis[i],
+             BENCH_IMSI_LENGTH,
+             &element) == HASH_TABLE_OK &&
+           obj_hashtable_ts_insert(
+             mixed->obj_table, mixed->imsis[i], BENCH_IMSI_LENGTH, element) ==
+             HASH_TABLE_OK;
+      break;
+    default:
+      break;
+  }
+  return ok && (uintptr_t) element == i + 1;
+}
+
+static void _bench_mixed_init(
+  bench_mixed_t *mixed,
+  bench_variant_t variant,
+  size_t nb_keys)
+{
+  bstring name = bfromcstr("bench");
+  size_t errors = 0;
+
+  memset(mixed, 0, sizeof(*mixed));
+  mixed->variant = variant;
+  mixed->nb_keys = nb_keys;
+  pthread_mutex_init(&mixed->table_lock, NULL);
+  // The data are the keys, hash_free_int_func() does not free them
+  switch (variant) {
+    case BENCH_HASH_TABLE:
+      mixed->table =
+        hashtable_create(nb_keys, NULL, hash_free_int_func, name);
+      break;
+    case BENCH_HASH_TABLE_TS:
+      mixed->ts_table =
+        hashtable_ts_create(nb_keys, NULL, hash_free_int_func, name);
+      break;
+    case BENCH_HASH_TABLE_UINT64_TS:
+      mixed->uint64_table = hashtable_uint64_ts_create(nb_keys, NULL, name);
+      break;
+    case BENCH_OBJ_HASH_TABLE:
+      mixed->obj_table = obj_hashtable_ts_create(
+        nb_keys, NULL, NULL, hash_free_int_func, name);
+      mixed->imsis = malloc(nb_keys * sizeof(*mixed->imsis));
+      if (!mixed->imsis) {
+        fprintf(stderr, "Cannot allocate %zu keys\n", nb_keys);
+        exit(EXIT_FAILURE);
+      }
+      for (size_t i = 0; i < nb_keys; i++) {
+        _bench_imsi(mixed->imsis[i], sizeof(mixed->imsis[i]), i + 1);
+      }
+      break;
+    default:
+      break;
+  }
+  bdestroy(name);
+
+  for (size_t i = 0; i < nb_keys; i++) {
+    void *element = (void *) (uintptr_t)(i + 1);
+
+    switch (variant) {
+      case BENCH_HASH_TABLE:
+        errors += hashtable_insert(mixed->table, i + 1, element) !=
+                  HASH_TABLE_OK;
+        break;
+      case BENCH_HASH_TABLE_TS:
+        errors += hashtable_ts_insert(mixed->ts_table, i + 1, element) !=
+                  HASH_TABLE_OK;
+        break;
+      case BENCH_HASH_TABLE_UINT64_TS:
+        errors += hashtable_uint64_ts_insert(
+                    mixed->uint64_table, i + 1, i + 1) != HASH_TABLE_OK;
+        break;
+      case BENCH_OBJ_HASH_TABLE:
+        errors += obj_hashtable_ts_insert(
+                    mixed->obj_table,
+                    mixed->imsis[i],
+                    BENCH_IMSI_LENGTH,
+                    element) != HASH_TABLE_OK;
+        break;
+      default:
+        break;
+    }
+  }
+  if (errors) {
+    fprintf(stderr, "%zu keys not inserted\n", errors);
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void _bench_mixed_destroy(bench_mixed_t *mixed)
+{
+  switch (mixed->variant) {
+    case BENCH_HASH_TABLE:
+      hashtable_destroy(mixed->table);
+      break;
+    case BENCH_HASH_TABLE_TS:
+      hashtable_ts_destroy(mixed->ts_table);
+      break;
+    case BENCH_HASH_TABLE_UINT64_TS:
+      hashtable_uint64_ts_destroy(mixed->uint64_table);
+      break;
+    case BENCH_OBJ_HASH_TABLE:
+      obj_hashtable_ts_destroy(mixed->obj_table);
+      free(mixed->imsis);
+      break;
+    default:
+      break;
+  }
+  pthread_mutex_destroy(&mixed->table_lock);
+}
+
+typedef struct bench_mixed_thread_s {
+  pthread_t thread;
+  bench_mixed_t *mixed;
+  const bench_zipf_t *zipf;
+  int index;
+  int nb_threads;
+  int read_ratio;
+  volatile bool *stop;
+  size_t nb_ops;
+  size_t errors;
+  uint64_t histogram[BENCH_HISTOGRAM_SIZE];
+} bench_mixed_thread_t;
+
+static void *_bench_mixed_worker(void *arg)
+{
+  bench_mixed_thread_t *worker = (bench_mixed_thread_t *) arg;
+  bench_mixed_t *mixed = worker->mixed;
+  uint64_t state = 0x9e3779b97f4a7c15ULL * (worker->index + 1);
+  // The sequential threads start evenly spread over the keys
+  size_t next = mixed->nb_keys * worker->index / worker->nb_threads;
+  size_t nb_ops = 0;
+  uint64_t data = 0;
+
+  while (!__atomic_load_n(worker->stop, __ATOMIC_RELAXED)) {
+    for (int n = 0; n < 1000; n++, nb_ops++) {
+      size_t i = worker->zipf ? _bench_zipf_next(worker->zipf, &state) :
+                                next++ % mixed->nb_keys;
+      bool read = (int) (_bench_random_key(&state) % 100) < worker->read_ratio;
+      bool sampled = nb_ops % BENCH_LATENCY_SAMPLING == 0;
+      uint64_t t0 = sampled ? _bench_now_ns() : 0;
+
+      if (read) {
+        hashtable_rc_t rc = _bench_mixed_get(mixed, i, &data);
+
+        // The key may be seen missing while its owner re-inserts it
+        worker->errors += rc == HASH_TABLE_OK ?
+                            data != i + 1 :
+                            rc != HASH_TABLE_KEY_NOT_EXISTS;
+      } else {
+        // Only the keys i such as i % nb_threads == index are written
+        i = i - i % worker->nb_threads + worker->index;
+        if (i >= mixed->nb_keys) i -= worker->nb_threads;
+        worker->errors += !_bench_mixed_update(mixed, i);
+      }
+      if (sampled) {
+        worker->histogram[_bench_histogram_index(_bench_now_ns() - t0)]++;
+      }
+    }
+  }
+  worker->nb_ops = nb_ops;
+  return NULL;
+}
+
+static void _bench_run_mixed(
+  bench_variant_t variant,
+  bool zipfian,
+  int read_ratio,
+  int nb_threads,
+  uint64_t duration_ns)
+{
+  const size_t nb_keys = BENCH_MIXED_KEYS;
+  bench_mixed_thread_t *threads = calloc(nb_threads, sizeof(*threads));
+  uint64_t histogram[BENCH_HISTOGRAM_SIZE];
+  bench_mixed_t mixed;
+  bench_zipf_t zipf;
+  volatile bool stop = false;
+  struct timespec duration = {duration_ns / 1000000000,
+                              duration_ns % 1000000000};
+  size_t nb_ops = 0, errors = 0;
+  uint64_t t0 = 0, data = 0;
+
+  if (!threads) {
+    fprintf(stderr, "Cannot allocate %d threads\n", nb_threads);
+    exit(EXIT_FAILURE);
+  }
+  _bench_mixed_init(&mixed, variant, nb_keys);
+  _bench_zipf_init(&zipf, nb_keys, BENCH_ZIPF_THETA);
+
+  t0 = _bench_now_ns();
+  for (int t = 0; t < nb_threads; t++) {
+    threads[t].mixed = &mixed;
+    threads[t].zipf = zipfian ? &zipf : NULL;
+    threads[t].index = t;
+    threads[t].nb_threads = nb_threads;
+    threads[t].read_ratio = read_ratio;
+    threads[t].stop = &stop;
+    pthread_create(
+      &threads[t].thread, NULL, _bench_mixed_worker, &threads[t]);
+  }
+  nanosleep(&duration, NULL);
+  __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+  memset(histogram, 0, sizeof(histogram));
+  for (int t = 0; t < nb_threads; t++) {
+    pthread_join(threads[t].thread, NULL);
+    nb_ops += threads[t].nb_ops;
+    errors += threads[t].errors;
+    for (int i = 0; i < BENCH_HISTOGRAM_SIZE; i++) {
+      histogram[i] += threads[t].histogram[i];
+    }
+  }
+  duration_ns = _bench_now_ns() - t0;
+  // Every key must be back once the writers stopped
+  for (size_t i = 0; i < nb_keys; i++) {
+    errors += _bench_mixed_get(&mixed, i, &data) != HASH_TABLE_OK ||
+              data != i + 1;
+  }
+
+  printf(
+    "%-22s %-10s %5d %7d %9.2f %9" PRIu64 " %9.1f\n",
+    bench_variant_names[variant],
+    zipfian ? "zipf" : "sequential",
+    read_ratio,
+    nb_threads,
+    _bench_mops(nb_ops, duration_ns),
+    _bench_histogram_percentile(histogram, 99.0),
+    (double) _bench_status_kb("VmHWM") / 1024.0);
+  _bench_mixed_destroy(&mixed);
+  free(threads);
+  if (errors) {
+    fprintf(
+      stderr,
+      "%s: %zu unexpected results\n",
+      bench_variant_names[variant],
+      errors);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Returns true if the child process pid exited successfully
+static bool _bench_wait(pid_t pid)
+{
+  int status = 0;
+
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+         WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+  bool smoke = argc > 1 && strcmp(argv[1], "--smoke") == 0;
+  int failures = 0;
+  pid_t pid = 0;
+
+  printf(
+    "%-8s %-10s %8s %9s %9s %9s %9s %9s\n",
+    "backend",
+    "keys",
+    "size",
+    "insert",
+    "hit",
+    "miss",
+    "remove",
+    "rss");
+  printf("%39s (Mops/s) %28s\n", "", "(MB)");
+  for (size_t s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]); s++) {
+    for (int sequential = 1; sequential >= 0; sequential--) {
+      for (size_t b = 0; b < sizeof(bench_backends) / sizeof(bench_backends[0]);
+           b++) {
+        size_t nb_keys =
+          smoke ? bench_sizes[s] / BENCH_SMOKE_DIVIDER : bench_sizes[s];
+
+        fflush(stdout);
+        if ((pid = fork()) == 0) {
+          _bench_run(&bench_backends[b], nb_keys, sequential);
+          exit(EXIT_SUCCESS);
+        }
+        failures += !_bench_wait(pid);
+      }
+    }
+  }
+
+  printf(
+    "\n%-8s %7s %7s %9s %9s %9s\n",
+    "backend",
+    "readers",
+    "writers",
+    "lookup",
+    "lookups",
+    "writes");
+  printf("%24s (ns/op) %9s (Mops/s)\n", "", "");
+  for (size_t b = 0; b < sizeof(bench_backends) / sizeof(bench_backends[0]);
+       b++) {
+    for (int writers = 0; writers <= BENCH_MAX_WRITERS; writers++) {
+      fflush(stdout);
+      if ((pid = fork()) == 0) {
+        _bench_run_readers(
+          &bench_backends[b],
+          writers,
+          smoke ? BENCH_READ_DURATION_NS / BENCH_SMOKE_DIVIDER :
+                  BENCH_READ_DURATION_NS);
+        exit(EXIT_SUCCESS);
+      }
+      failures += !_bench_wait(pid);
+    }
+  }
+
+  printf(
+    "\n%-8s %7s %9s %9s %9s %9s %9s %9s\n",
+    "nodes",
+    "threads",
+    "churn",
+    "allocs",
+    "heap",
+    "free",
+    "chunks",
+    "obj");
+  printf("%16s %9s %9s %9s %9s\n", "", "(Mops/s)", "(/op)", "(MB)", "(MB)");
+  for (int slab = 0; slab <= HASHTABLE_SLAB; slab++) {
+    fflush(stdout);
+    if ((pid = fork()) == 0) {
+      _bench_run_churn(
+        slab, smoke ? BENCH_CHURN_OPS / BENCH_SMOKE_DIVIDER : BENCH_CHURN_OPS);
+      exit(EXIT_SUCCESS);
+    }
+    failures += !_bench_wait(pid);
+  }
+
+  printf(
+    "\n%-22s %-10s %5s %7s %9s %9s %9s\n",
+    "variant",
+    "keys",
+    "reads",
+    "threads",
+    "ops",
+    "p99",
+    "peak rss");
+  printf("%39s %7s %9s %9s %9s\n", "(%)", "", "(Mops/s)", "(ns)", "(MB)");
+  for (int v = 0; v < BENCH_VARIANT_MAX; v++) {
+    for (int zipfian = 0; zipfian <= 1; zipfian++) {
+      for (size_t r = 0;
+           r < sizeof(bench_read_ratios) / sizeof(bench_read_ratios[0]);
+           r++) {
+        for (int threads = 1;
+             threads <= (smoke ? BENCH_SMOKE_MAX_THREADS : BENCH_MAX_THREADS);
+             threads *= 2) {
+          fflush(stdout);
+          if ((pid = fork()) == 0) {
+            _bench_run_mixed(
+              v,
+              zipfian,
+              bench_read_ratios[r],
+              threads,
+              smoke ? BENCH_MIXED_DURATION_NS / BENCH_SMOKE_DIVIDER :
+                      BENCH_MIXED_DURATION_NS);
+            exit(EXIT_SUCCESS);
+          }
+          failures += !_bench_wait(pid);
+        }
+      }
+    }
+  }
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
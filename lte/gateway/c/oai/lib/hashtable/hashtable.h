@@ -60,6 +60,44 @@ typedef enum hashtable_return_code_e {
   HASH_TABLE_CODE_MAX
 } hashtable_rc_t;
 
+/*
+ * Storage of a thread safe hash table, fixed at its creation.
+ * CHAINED: one malloc'ed node per element and one mutex per bucket.
+ * OPEN_ADDRESSING: elements stored inline in linear probing stripes, each
+ * stripe having its own lock. HASHTABLE_NOT_A_KEY_VALUE cannot be inserted and
+ * the callbacks iterating the table must not modify it.
+ */
+typedef enum hashtable_backend_e {
+  HASH_TABLE_BACKEND_CHAINED = 0,
+  HASH_TABLE_BACKEND_OPEN_ADDRESSING
+} hashtable_backend_t;
+
+/*
+ * Chained thread safe tables resize themselves: they double when they hold
+ * more elements than buckets and halve under one element per 8 buckets, never
+ * going below their number of locks. The buckets are copied to the new array
+ * HASH_TABLE_TS_REHASH_BUCKETS at a time by the operations on the table, the
+ * locks being shared by the old and new buckets of a key. The size given at
+ * creation is the initial size, it also sets the number of locks up to
+ * HASH_TABLE_TS_MAX_LOCKS. The locks are recursive so that the callbacks
+ * iterating a table can look it up.
+ *
+ * The lookups (get, is_key_exists) of both backends take no lock, the
+ * writers publishing their changes with release stores and freeing what they
+ * unlink through hashtable_epoch_retire(). A lookup sees the table as it was
+ * at some point of the call, while resizing an old bucket being kept intact
+ * once copied. The data of an element removed by another thread may still be
+ * returned, as with the locks it may be freed as soon as the lookup returns.
+ */
+#define HASH_TABLE_TS_MAX_LOCKS 1024
+#define HASH_TABLE_TS_REHASH_BUCKETS 16
+
+// Called once a resize of a thread safe table is complete
+typedef void (*hashtable_resize_cb_t)(
+  const char *name,
+  hash_size_t old_size,
+  hash_size_t new_size);
+
 #define HASH_TABLE_DEFAULT_HASH_FUNC NULL
 #define HASH_TABLE_DEFAULT_free_wrapper_FUNC NULL
 #define FREE_HASHTABLE_KEY_ARRAY(key_array_ptr)                                \
@@ -82,6 +120,24 @@ typedef struct hash_node_uint64_s {
   struct hash_node_uint64_s *next;
 } hash_node_uint64_t;
 
+/*
+ * Bucket array of a chained thread safe table, replaced as a whole by a
+ * resize so that the lookups read its size and nodes consistently
+ */
+typedef struct hash_buckets_s {
+  hash_size_t size;
+  // Buckets of the previous array copied in, while resizing to this one
+  hash_size_t rehash_index;
+  struct hash_node_s *nodes[];
+} hash_buckets_t;
+
+typedef struct hash_buckets_uint64_s {
+  hash_size_t size;
+  // Buckets of the previous array copied in, while resizing to this one
+  hash_size_t rehash_index;
+  struct hash_node_uint64_s *nodes[];
+} hash_buckets_uint64_t;
+
 typedef struct hash_table_s {
   hash_size_t size;
   hash_size_t num_elements;
@@ -94,16 +150,24 @@ typedef struct hash_table_s {
 } hash_table_t;
 
 typedef struct hash_table_ts_s {
+  // Held by the thread moving buckets during a resize
   pthread_mutex_t mutex;
   hash_size_t size;
   hash_size_t num_elements;
-  struct hash_node_s **nodes;
+  // Read without lock by the lookups
+  struct hash_buckets_s *buckets;
+  // Set while resizing, see rehash_index
+  struct hash_buckets_s *new_buckets;
+  // Bucket i is protected by lock_nodes[i % num_locks], in both arrays
   pthread_mutex_t *lock_nodes;
+  hash_size_t num_locks;
   hash_size_t (*hashfunc)(const hash_key_t);
   void (*freefunc)(void **);
   bstring name;
   bool is_allocated_by_malloc;
   bool log_enabled;
+  // Set for HASH_TABLE_BACKEND_OPEN_ADDRESSING, buckets are unused then
+  struct hash_table_open_s *open_table;
 } hash_table_ts_t;
 typedef struct hash_table_uint64_s {
   hash_size_t size;
@@ -116,17 +180,73 @@ typedef struct hash_table_uint64_s {
 } hash_table_uint64_t;
 
 typedef struct hash_table_uint64_ts_s {
+  // Held by the thread moving buckets during a resize
   pthread_mutex_t mutex;
   hash_size_t size;
   hash_size_t num_elements;
-  struct hash_node_uint64_s **nodes;
+  // Read without lock by the lookups
+  struct hash_buckets_uint64_s *buckets;
+  // Set while resizing, see rehash_index
+  struct hash_buckets_uint64_s *new_buckets;
+  // Bucket i is protected by lock_nodes[i % num_locks], in both arrays
   pthread_mutex_t *lock_nodes;
+  hash_size_t num_locks;
   hash_size_t (*hashfunc)(const hash_key_t);
   bstring name;
   bool is_allocated_by_malloc;
   bool log_enabled;
+  // Set for HASH_TABLE_BACKEND_OPEN_ADDRESSING, buckets are unused then
+  struct hash_table_open_s *open_table;
 } hash_table_uint64_ts_t;
 
+/*
+ * Cursors iterate a thread safe table without allocating anything, lock by
+ * lock (stripe by stripe for the open addressing backend), the lock being
+ * held from one hashtable_ts_cursor_next() call to the next while its
+ * buckets are walked. The elements present during the whole iteration are
+ * returned once, the ones inserted or removed meanwhile may be missed.
+ * HASH_TABLE_CURSOR_SNAPSHOT takes all the locks when the cursor starts
+ * instead: the writers then wait for its end, and it returns the elements of
+ * the table as they were at one point.
+ *
+ * A cursor must be ended with hashtable_ts_cursor_end() unless next returned
+ * false. As for the callbacks of hashtable_ts_apply_callback_on_elements(),
+ * a chained table may be looked up and its returned element removed while
+ * iterating, an open addressing one must not be modified.
+ */
+typedef enum hashtable_cursor_mode_e {
+  HASH_TABLE_CURSOR_STRIPED = 0,
+  HASH_TABLE_CURSOR_SNAPSHOT
+} hashtable_cursor_mode_t;
+
+typedef struct hashtable_ts_cursor_s {
+  // NULL once ended
+  hash_table_ts_t *table;
+  hashtable_cursor_mode_t mode;
+  // Lock, or stripe, walked and number of them
+  hash_size_t lock;
+  hash_size_t num_locks;
+  // Next bucket, or slot, of the lock to walk
+  hash_size_t index;
+  bool in_new_buckets;
+  // Next node of the bucket walked
+  struct hash_node_s *node;
+} hashtable_ts_cursor_t;
+
+typedef struct hashtable_uint64_ts_cursor_s {
+  // NULL once ended
+  hash_table_uint64_ts_t *table;
+  hashtable_cursor_mode_t mode;
+  // Lock, or stripe, walked and number of them
+  hash_size_t lock;
+  hash_size_t num_locks;
+  // Next bucket, or slot, of the lock to walk
+  hash_size_t index;
+  bool in_new_buckets;
+  // Next node of the bucket walked
+  struct hash_node_uint64_s *node;
+} hashtable_uint64_ts_cursor_t;
+
 typedef struct hashtable_key_array_s {
   int num_keys;
   hash_key_t *keys;
@@ -144,6 +264,11 @@ typedef struct hashtable_uint64_element_array_s {
 
 char *hashtable_rc_code2string(hashtable_rc_t rc);
 void hash_free_int_func(void **memory);
+void hashtable_set_resize_callback(hashtable_resize_cb_t callback);
+void hashtable_notify_resize(
+  const bstring name,
+  hash_size_t old_size,
+  hash_size_t new_size);
 hash_table_t *hashtable_init(
   hash_table_t *const hashtbl,
   const hash_size_t size,
@@ -198,6 +323,19 @@ __attribute__((malloc)) hash_table_ts_t *hashtable_ts_create(
   hash_size_t (*hashfunc)(const hash_key_t),
   void (*freefunc)(void **),
   bstring name_p);
+hash_table_ts_t *hashtable_ts_init_backend(
+  hash_table_ts_t *const hashtbl,
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t),
+  void (*freefunc)(void **),
+  bstring display_name_p,
+  hashtable_backend_t backend);
+__attribute__((malloc)) hash_table_ts_t *hashtable_ts_create_backend(
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t),
+  void (*freefunc)(void **),
+  bstring name_p,
+  hashtable_backend_t backend);
 hashtable_rc_t hashtable_ts_destroy(hash_table_ts_t *hashtbl);
 hashtable_rc_t hashtable_ts_is_key_exists(
   const hash_table_ts_t *const hashtbl,
@@ -214,6 +352,15 @@ hashtable_rc_t hashtable_ts_apply_callback_on_elements(
     void **result),
   void *parameter,
   void **result);
+void hashtable_ts_cursor_init(
+  hashtable_ts_cursor_t *const cursor,
+  hash_table_ts_t *const hashtbl,
+  const hashtable_cursor_mode_t mode);
+bool hashtable_ts_cursor_next(
+  hashtable_ts_cursor_t *const cursor,
+  hash_key_t *const key,
+  void **const element);
+void hashtable_ts_cursor_end(hashtable_ts_cursor_t *const cursor);
 hashtable_rc_t hashtable_ts_dump_content(
   const hash_table_ts_t *const hashtbl,
   bstring str);
@@ -244,6 +391,18 @@ __attribute__((malloc)) hash_table_uint64_ts_t *hashtable_uint64_ts_create(
   const hash_size_t size,
   hash_size_t (*hashfunc)(const hash_key_t),
   bstring name_p);
+hash_table_uint64_ts_t *hashtable_uint64_ts_init_backend(
+  hash_table_uint64_ts_t *const hashtbl,
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t),
+  bstring display_name_p,
+  hashtable_backend_t backend);
+__attribute__((malloc)) hash_table_uint64_ts_t *
+hashtable_uint64_ts_create_backend(
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t),
+  bstring name_p,
+  hashtable_backend_t backend);
 hashtable_rc_t hashtable_uint64_ts_destroy(hash_table_uint64_ts_t *hashtbl);
 hashtable_rc_t hashtable_uint64_ts_is_key_exists(
   const hash_table_uint64_ts_t *const hashtbl,
@@ -261,6 +420,16 @@ hashtable_rc_t hashtable_uint64_ts_apply_callback_on_elements(
     void **result),
   void *parameter,
   void **result);
+void hashtable_uint64_ts_cursor_init(
+  hashtable_uint64_ts_cursor_t *const cursor,
+  hash_table_uint64_ts_t *const hashtbl,
+  const hashtable_cursor_mode_t mode);
+bool hashtable_uint64_ts_cursor_next(
+  hashtable_uint64_ts_cursor_t *const cursor,
+  hash_key_t *const key,
+  uint64_t *const element);
+void hashtable_uint64_ts_cursor_end(
+  hashtable_uint64_ts_cursor_t *const cursor);
 hashtable_rc_t hashtable_uint64_ts_dump_content(
   const hash_table_uint64_ts_t *const hashtbl,
   bstring str);
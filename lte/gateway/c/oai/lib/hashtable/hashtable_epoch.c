@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+
+/*! \file hashtable_epoch.c
+  \brief Epoch based reclamation of the memory read without locks by the
+  lookups of the thread safe hash tables
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "hashtable_epoch.h"
+
+typedef struct hashtable_epoch_retired_s {
+  void *ptr;
+  void (*freefunc)(void *);
+  // Global epoch when ptr was retired, or a later one
+  uint64_t epoch;
+} hashtable_epoch_retired_t;
+
+typedef struct hashtable_epoch_list_s {
+  hashtable_epoch_retired_t *items;
+  size_t num_items;
+  size_t max_items;
+  // The items from num_tagged on have no epoch yet
+  size_t num_tagged;
+} hashtable_epoch_list_t;
+
+// One per thread, never freed: the records of the exited threads are reused
+typedef struct hashtable_epoch_record_s {
+  // Epoch announced by the running lookup, 0 outside of the lookups
+  uint64_t epoch;
+  bool in_use;
+  struct hashtable_epoch_record_s *next;
+  // Only accessed by the thread owning the record
+  int nesting;
+  size_t reclaim_at;
+  hashtable_epoch_list_t retired;
+} __attribute__((aligned(64))) hashtable_epoch_record_t;
+
+static uint64_t hashtable_epoch_global = 1;
+static hashtable_epoch_record_t *hashtable_epoch_records = NULL;
+static __thread hashtable_epoch_record_t *hashtable_epoch_self = NULL;
+static pthread_once_t hashtable_epoch_once = PTHREAD_ONCE_INIT;
+static pthread_key_t hashtable_epoch_key;
+// Memory retired by the threads that exited before it could be freed
+static pthread_mutex_t hashtable_epoch_orphans_mutex =
+  PTHREAD_MUTEX_INITIALIZER;
+static hashtable_epoch_list_t hashtable_epoch_orphans = {NULL, 0, 0, 0};
+
+//------------------------------------------------------------------------------
+static bool hashtable_epoch_list_add(
+  hashtable_epoch_list_t *const listP,
+  void *ptrP,
+  void (*freefuncP)(void *),
+  const uint64_t epochP)
+{
+  if (listP->num_items == listP->max_items) {
+    size_t max_items = listP->max_items ? 2 * listP->max_items :
+                                          HASHTABLE_EPOCH_RECLAIM_THRESHOLD;
+    hashtable_epoch_retired_t *items =
+      realloc(listP->items, max_items * sizeof(hashtable_epoch_retired_t));
+
+    if (!items) {
+      return false;
+    }
+    listP->items = items;
+    listP->max_items = max_items;
+  }
+  listP->items[listP->num_items].ptr = ptrP;
+  listP->items[listP->num_items].freefunc = freefuncP;
+  listP->items[listP->num_items].epoch = epochP;
+  listP->num_items++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Tags the items retired since the last call with the current epoch: it is
+ * read once for all of them, after their unlinks, instead of on each retire.
+ */
+static void hashtable_epoch_list_tag(hashtable_epoch_list_t *const listP)
+{
+  uint64_t epoch = 0;
+
+  if (listP->num_tagged == listP->num_items) {
+    return;
+  }
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  epoch = __atomic_load_n(&hashtable_epoch_global, __ATOMIC_ACQUIRE);
+  for (size_t i = listP->num_tagged; i < listP->num_items; i++) {
+    listP->items[i].epoch = epoch;
+  }
+  listP->num_tagged = listP->num_items;
+}
+
+//------------------------------------------------------------------------------
+// Frees the tagged items retired two epochs or more before epochP
+static size_t hashtable_epoch_list_free(
+  hashtable_epoch_list_t *const listP,
+  const uint64_t epochP)
+{
+  size_t kept = 0;
+  size_t num_freed = 0;
+
+  for (size_t i = 0; i < listP->num_tagged; i++) {
+    if (listP->items[i].epoch + 2 <= epochP) {
+      listP->items[i].freefunc(listP->items[i].ptr);
+    } else {
+      listP->items[kept++] = listP->items[i];
+    }
+  }
+  num_freed = listP->num_tagged - kept;
+  for (size_t i = listP->num_tagged; i < listP->num_items; i++) {
+    listP->items[i - num_freed] = listP->items[i];
+  }
+  listP->num_tagged = kept;
+  listP->num_items -= num_freed;
+  return num_freed;
+}
+
+//------------------------------------------------------------------------------
+// Destructor of hashtable_epoch_key, gives the record back
+static void hashtable_epoch_thread_exit(void *recordP)
+{
+  hashtable_epoch_record_t *record = (hashtable_epoch_record_t *) recordP;
+
+  hashtable_epoch_list_tag(&record->retired);
+  pthread_mutex_lock(&hashtable_epoch_orphans_mutex);
+  for (size_t i = 0; i < record->retired.num_items; i++) {
+    hashtable_epoch_retired_t *item = &record->retired.items[i];
+
+    if (!hashtable_epoch_list_add(
+          &hashtable_epoch_orphans, item->ptr, item->freefunc, item->epoch)) {
+      // Leaked rather than freed under a lookup
+      break;
+    }
+  }
+  hashtable_epoch_orphans.num_tagged = hashtable_epoch_orphans.num_items;
+  pthread_mutex_unlock(&hashtable_epoch_orphans_mutex);
+  free(record->retired.items);
+  memset(&record->retired, 0, sizeof(record->retired));
+  record->nesting = 0;
+  hashtable_epoch_self = NULL;
+  __atomic_store_n(&record->epoch, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&record->in_use, false, __ATOMIC_RELEASE);
+}
+
+static void hashtable_epoch_init_key(void)
+{
+  pthread_key_create(&hashtable_epoch_key, hashtable_epoch_thread_exit);
+}
+
+//------------------------------------------------------------------------------
+static hashtable_epoch_record_t *hashtable_epoch_register(void)
+{
+  hashtable_epoch_record_t *record = NULL;
+
+  pthread_once(&hashtable_epoch_once, hashtable_epoch_init_key);
+  for (record = __atomic_load_n(&hashtable_epoch_records, __ATOMIC_ACQUIRE);
+       record;
+       record = record->next) {
+    bool in_use = false;
+
+    if (
+      !__atomic_load_n(&record->in_use, __ATOMIC_RELAXED) &&
+      __atomic_compare_exchange_n(
+        &record->in_use,
+        &in_use,
+        true,
+        false,
+        __ATOMIC_ACQUIRE,
+        __ATOMIC_RELAXED)) {
+      break;
+    }
+  }
+  if (!record) {
+    // The lookups cannot run safely without a record
+    if (posix_memalign((void **) &record, 64, sizeof(*record))) {
+      abort();
+    }
+    memset(record, 0, sizeof(*record));
+    record->in_use = true;
+    record->next = __atomic_load_n(&hashtable_epoch_records, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(
+      &hashtable_epoch_records,
+      &record->next,
+      record,
+      false,
+      __ATOMIC_RELEASE,
+      __ATOMIC_RELAXED)) {
+    }
+  }
+  record->reclaim_at = HASHTABLE_EPOCH_RECLAIM_THRESHOLD;
+  pthread_setspecific(hashtable_epoch_key, record);
+  hashtable_epoch_self = record;
+  return record;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Lookups
+   hashtable_epoch_enter() and hashtable_epoch_exit() delimit a lookup, the
+   memory it reads cannot be freed until it exits. They nest, only the
+   outermost pair announces an epoch.
+*/
+void hashtable_epoch_enter(void)
+{
+  hashtable_epoch_record_t *record =
+    hashtable_epoch_self ? hashtable_epoch_self : hashtable_epoch_register();
+
+  if (record->nesting++) {
+    return;
+  }
+  __atomic_store_n(
+    &record->epoch,
+    __atomic_load_n(&hashtable_epoch_global, __ATOMIC_RELAXED),
+    __ATOMIC_RELEASE);
+  // The announce must be visible before the lookup reads the table
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+//------------------------------------------------------------------------------
+void hashtable_epoch_exit(void)
+{
+  hashtable_epoch_record_t *record = hashtable_epoch_self;
+
+  if (--record->nesting) {
+    return;
+  }
+  __atomic_store_n(&record->epoch, 0, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+// Moves the global epoch forward if every thread in a lookup announced it
+static uint64_t hashtable_epoch_try_advance(void)
+{
+  uint64_t epoch = __atomic_load_n(&hashtable_epoch_global, __ATOMIC_ACQUIRE);
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  for (hashtable_epoch_record_t *record =
+         __atomic_load_n(&hashtable_epoch_records, __ATOMIC_ACQUIRE);
+       record;
+       record = record->next) {
+    uint64_t announced = __atomic_load_n(&record->epoch, __ATOMIC_ACQUIRE);
+
+    if (announced && announced != epoch) {
+      return epoch;
+    }
+  }
+  if (__atomic_compare_exchange_n(
+        &hashtable_epoch_global,
+        &epoch,
+        epoch + 1,
+        false,
+        __ATOMIC_ACQ_REL,
+        __ATOMIC_ACQUIRE)) {
+    return epoch + 1;
+  }
+  return epoch;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Reclamation
+   hashtable_epoch_retire() frees ptr with freefunc once no lookup can read it
+   anymore. It must be called after ptr was unlinked, out of any lookup.
+*/
+void hashtable_epoch_retire(void *ptrP, void (*freefuncP)(void *))
+{
+  hashtable_epoch_record_t *record =
+    hashtable_epoch_self ? hashtable_epoch_self : hashtable_epoch_register();
+  uint64_t epoch = 0;
+
+  // Tagged by the next reclaim, a later epoch than the unlink one is safe
+  if (!hashtable_epoch_list_add(&record->retired, ptrP, freefuncP, 0)) {
+    // Out of memory, wait for the lookups that may read ptr instead
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n(&hashtable_epoch_global, __ATOMIC_ACQUIRE);
+    while (hashtable_epoch_try_advance() < epoch + 2) {
+      sched_yield();
+    }
+    freefuncP(ptrP);
+    return;
+  }
+  if (record->retired.num_items >= record->reclaim_at) {
+    hashtable_epoch_reclaim();
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   hashtable_epoch_reclaim() tries to move the global epoch forward and frees
+   what the calling thread, and the exited ones, retired long enough ago.
+   Returns the number of items freed.
+*/
+size_t hashtable_epoch_reclaim(void)
+{
+  hashtable_epoch_record_t *record =
+    hashtable_epoch_self ? hashtable_epoch_self : hashtable_epoch_register();
+  uint64_t epoch = 0;
+  size_t num_freed = 0;
+
+  hashtable_epoch_list_tag(&record->retired);
+  epoch = hashtable_epoch_try_advance();
+  num_freed = hashtable_epoch_list_free(&record->retired, epoch);
+
+  if (!pthread_mutex_trylock(&hashtable_epoch_orphans_mutex)) {
+    num_freed += hashtable_epoch_list_free(&hashtable_epoch_orphans, epoch);
+    pthread_mutex_unlock(&hashtable_epoch_orphans_mutex);
+  }
+  record->reclaim_at =
+    record->retired.num_items + HASHTABLE_EPOCH_RECLAIM_THRESHOLD;
+  return num_freed;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+
+/*! \file hashtable_epoch.h
+  \brief Epoch based reclamation of the memory read without locks by the
+  lookups of the thread safe hash tables
+*/
+#ifndef FILE_HASH_TABLE_EPOCH_SEEN
+#define FILE_HASH_TABLE_EPOCH_SEEN
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * The lookups of the thread safe hash tables take no lock: they run between
+ * hashtable_epoch_enter() and hashtable_epoch_exit(), announcing the global
+ * epoch they started in. The writers unlink the nodes, bucket arrays and
+ * slots under their locks and hand them to hashtable_epoch_retire(), they are
+ * freed once the global epoch moved twice, when no lookup can still read them.
+ * The global epoch only moves when every thread inside a lookup announced it.
+ *
+ * Retired memory is kept per thread and reclaimed every
+ * HASHTABLE_EPOCH_RECLAIM_THRESHOLD retirements, what is left by a thread
+ * that exits is reclaimed by the others.
+ */
+#define HASHTABLE_EPOCH_RECLAIM_THRESHOLD 64
+
+void hashtable_epoch_enter(void);
+void hashtable_epoch_exit(void);
+void hashtable_epoch_retire(void *ptr, void (*freefunc)(void *));
+size_t hashtable_epoch_reclaim(void);
+
+#endif
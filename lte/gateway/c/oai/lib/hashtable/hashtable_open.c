@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file hashtable_open.c
+  \brief Open addressing backend of the thread safe hash tables
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "hashtable_open.h"
+#include "hashtable_epoch.h"
+
+//------------------------------------------------------------------------------
+static inline uint64_t hashtable_open_hash(
+  const hash_table_open_t *const table,
+  const hash_key_t key)
+{
+  return hashtable_mix64(table->hashfunc(key));
+}
+
+//------------------------------------------------------------------------------
+static inline hash_stripe_t *hashtable_open_stripe(
+  hash_table_open_t *const table,
+  const uint64_t hash)
+{
+  return &table->stripes[hash >> (64 - HASH_TABLE_OPEN_STRIPES_BITS)];
+}
+
+//------------------------------------------------------------------------------
+static hash_slot_t *hashtable_open_alloc_slots(const hash_size_t size)
+{
+  hash_slot_t *slots = malloc(size * sizeof(hash_slot_t));
+
+  if (slots) {
+    // All bits set is HASH_TABLE_OPEN_FREE_KEY
+    memset(slots, 0xff, size * sizeof(hash_slot_t));
+  }
+  return slots;
+}
+
+//------------------------------------------------------------------------------
+// Index of key in slots, or of the free slot ending its probe sequence
+static inline hash_size_t hashtable_open_probe_slots(
+  const hash_slot_t *const slots,
+  const hash_size_t size,
+  const uint64_t hash,
+  const hash_key_t key)
+{
+  const hash_size_t mask = size - 1;
+  hash_size_t i = hash & mask;
+
+  while (slots[i].key != key && slots[i].key != HASH_TABLE_OPEN_FREE_KEY) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+// Must be called with the stripe locked
+static inline hash_size_t hashtable_open_probe(
+  const hash_stripe_t *const stripe,
+  const uint64_t hash,
+  const hash_key_t key)
+{
+  return hashtable_open_probe_slots(stripe->slots, stripe->size, hash, key);
+}
+
+//------------------------------------------------------------------------------
+// The slots are written with atomic stores, the lookups reading them unlocked
+static inline void hashtable_open_set_slot(
+  hash_slot_t *const slot,
+  const hash_key_t key,
+  const uint64_t data)
+{
+  __atomic_store_n(&slot->data, data, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot->key, key, __ATOMIC_RELEASE);
+}
+
+// Brackets the moves of elements of a locked stripe
+static inline void hashtable_open_write_begin(hash_stripe_t *const stripe)
+{
+  __atomic_store_n(&stripe->seq, stripe->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void hashtable_open_write_end(hash_stripe_t *const stripe)
+{
+  __atomic_store_n(&stripe->seq, stripe->seq + 1, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Double the size of a locked stripe, reinsert its elements in the new slots
+ * and publish them. The old slots are retired, a lookup reading them retries.
+ */
+static hashtable_rc_t hashtable_open_grow(
+  const hash_table_open_t *const table,
+  hash_stripe_t *const stripe)
+{
+  hash_slot_t *old_slots = stripe->slots;
+  const hash_size_t old_size = stripe->size;
+  const hash_size_t size = old_size << 1;
+  hash_slot_t *slots = hashtable_open_alloc_slots(size);
+
+  if (!slots) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  for (hash_size_t n = 0; n < old_size; n++) {
+    if (old_slots[n].key != HASH_TABLE_OPEN_FREE_KEY) {
+      hash_size_t i = hashtable_open_probe_slots(
+        slots,
+        size,
+        hashtable_open_hash(table, old_slots[n].key),
+        old_slots[n].key);
+      slots[i] = old_slots[n];
+    }
+  }
+  hashtable_open_write_begin(stripe);
+  // A lookup reading the new size reads the new slots
+  __atomic_store_n(&stripe->slots, slots, __ATOMIC_RELEASE);
+  __atomic_store_n(&stripe->size, size, __ATOMIC_RELEASE);
+  hashtable_open_write_end(stripe);
+  hashtable_epoch_retire(old_slots, free);
+  return HASH_TABLE_OK;
+}
+
+/*
+ * Lock free probe of slots, must be called between hashtable_epoch_enter()
+ * and hashtable_epoch_exit(). Returns HASH_TABLE_SEARCH_NO_RESULT if no free
+ * slot was met, the slots having changed under it.
+ */
+static inline hashtable_rc_t hashtable_open_find(
+  const hash_slot_t *const slots,
+  const hash_size_t size,
+  const uint64_t hash,
+  const hash_key_t keyP,
+  uint64_t *const dataP)
+{
+  const hash_size_t mask = size - 1;
+  hash_size_t i = hash & mask;
+  hash_key_t key = 0;
+
+  for (hash_size_t n = 0; n < size; n++, i = (i + 1) & mask) {
+    key = __atomic_load_n(&slots[i].key, __ATOMIC_ACQUIRE);
+    if (key == keyP) {
+      *dataP = __atomic_load_n(&slots[i].data, __ATOMIC_RELAXED);
+      return HASH_TABLE_OK;
+    }
+    if (key == HASH_TABLE_OPEN_FREE_KEY) {
+      return HASH_TABLE_KEY_NOT_EXISTS;
+    }
+  }
+  return HASH_TABLE_SEARCH_NO_RESULT;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_open_create() spreads size elements over the stripes, leaving
+   enough free slots to keep the probe sequences short.
+*/
+hash_table_open_t *hashtable_open_create(
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP)(const hash_key_t))
+{
+  hash_table_open_t *table = NULL;
+  hash_size_t stripe_size = HASH_TABLE_OPEN_MIN_STRIPE_SIZE;
+  const hash_size_t stripe_elements =
+    (sizeP + HASH_TABLE_OPEN_STRIPES - 1) / HASH_TABLE_OPEN_STRIPES;
+
+  while (HASH_TABLE_OPEN_MAX_LOAD(stripe_size) < stripe_elements) {
+    stripe_size <<= 1;
+  }
+
+  if (posix_memalign((void **) &table, 64, sizeof(hash_table_open_t))) {
+    return NULL;
+  }
+  memset(table, 0, sizeof(hash_table_open_t));
+  table->hashfunc = hashfuncP;
+  for (int s = 0; s < HASH_TABLE_OPEN_STRIPES; s++) {
+    hash_stripe_t *stripe = &table->stripes[s];
+
+    pthread_mutex_init(&stripe->mutex, NULL);
+    stripe->size = stripe_size;
+    if (!(stripe->slots = hashtable_open_alloc_slots(stripe_size))) {
+      hashtable_open_destroy(table, NULL);
+      return NULL;
+    }
+  }
+  return table;
+}
+
+//------------------------------------------------------------------------------
+void hashtable_open_destroy(
+  hash_table_open_t *const table,
+  void (*freefuncP)(void **))
+{
+  for (int s = 0; s < HASH_TABLE_OPEN_STRIPES; s++) {
+    hash_stripe_t *stripe = &table->stripes[s];
+
+    if (!stripe->slots) continue;
+    pthread_mutex_lock(&stripe->mutex);
+    for (hash_size_t n = 0; freefuncP && n < stripe->size; n++) {
+      void *data = (void *) (uintptr_t) stripe->slots[n].data;
+
+      if (stripe->slots[n].key != HASH_TABLE_OPEN_FREE_KEY && data) {
+        freefuncP(&data);
+      }
+    }
+    free_wrapper((void **) &stripe->slots);
+    pthread_mutex_unlock(&stripe->mutex);
+    pthread_mutex_destroy(&stripe->mutex);
+  }
+  free(table);
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t hashtable_open_get(
+  hash_table_open_t *const table,
+  const hash_key_t keyP,
+  uint64_t *const dataP)
+{
+  const uint64_t hash = hashtable_open_hash(table, keyP);
+  hash_stripe_t *stripe = hashtable_open_stripe(table, hash);
+  hashtable_rc_t rc = HASH_TABLE_SEARCH_NO_RESULT;
+  hash_slot_t *slots = NULL;
+  hash_size_t size = 0;
+  uint32_t seq = 0;
+  uint64_t data = 0;
+
+  if (keyP == HASH_TABLE_OPEN_FREE_KEY) {
+    return HASH_TABLE_BAD_PARAMETER_KEY;
+  }
+  hashtable_epoch_enter();
+  while (rc == HASH_TABLE_SEARCH_NO_RESULT) {
+    if ((seq = __atomic_load_n(&stripe->seq, __ATOMIC_ACQUIRE)) & 1) {
+      continue;
+    }
+    size = __atomic_load_n(&stripe->size, __ATOMIC_ACQUIRE);
+    slots = __atomic_load_n(&stripe->slots, __ATOMIC_ACQUIRE);
+    rc = hashtable_open_find(slots, size, hash, keyP, &data);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&stripe->seq, __ATOMIC_RELAXED) != seq) {
+      rc = HASH_TABLE_SEARCH_NO_RESULT;
+    }
+  }
+  hashtable_epoch_exit();
+  if (rc == HASH_TABLE_OK && dataP) *dataP = data;
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Adding a new element
+   Returns HASH_TABLE_INSERT_OVERWRITTEN_DATA with the previous data of the key
+   in old_dataP if the key was already present.
+*/
+hashtable_rc_t hashtable_open_insert(
+  hash_table_open_t *const table,
+  const hash_key_t keyP,
+  const uint64_t dataP,
+  uint64_t *const old_dataP)
+{
+  const uint64_t hash = hashtable_open_hash(table, keyP);
+  hash_stripe_t *stripe = hashtable_open_stripe(table, hash);
+  hashtable_rc_t rc = HASH_TABLE_OK;
+  hash_size_t i = 0;
+
+  if (keyP == HASH_TABLE_OPEN_FREE_KEY) {
+    return HASH_TABLE_BAD_PARAMETER_KEY;
+  }
+  pthread_mutex_lock(&stripe->mutex);
+  i = hashtable_open_probe(stripe, hash, keyP);
+  if (stripe->slots[i].key == keyP) {
+    *old_dataP = stripe->slots[i].data;
+    __atomic_store_n(&stripe->slots[i].data, dataP, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&stripe->mutex);
+    return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+  }
+  if (stripe->num_elements + 1 > HASH_TABLE_OPEN_MAX_LOAD(stripe->size)) {
+    if ((rc = hashtable_open_grow(table, stripe)) != HASH_TABLE_OK) {
+      pthread_mutex_unlock(&stripe->mutex);
+      return rc;
+    }
+    i = hashtable_open_probe(stripe, hash, keyP);
+  }
+  hashtable_open_set_slot(&stripe->slots[i], keyP, dataP);
+  stripe->num_elements++;
+  pthread_mutex_unlock(&stripe->mutex);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Removing an element
+   The elements following the removed one in its probe sequence are shifted
+   back into the hole, so no tombstone is left behind and lookups of missing
+   keys stop at the first free slot.
+*/
+hashtable_rc_t hashtable_open_remove(
+  hash_table_open_t *const table,
+  const hash_key_t keyP,
+  uint64_t *const dataP)
+{
+  const uint64_t hash = hashtable_open_hash(table, keyP);
+  hash_stripe_t *stripe = hashtable_open_stripe(table, hash);
+  hash_size_t mask = 0;
+  hash_size_t hole = 0;
+  hash_size_t i = 0;
+
+  if (keyP == HASH_TABLE_OPEN_FREE_KEY) {
+    return HASH_TABLE_BAD_PARAMETER_KEY;
+  }
+  pthread_mutex_lock(&stripe->mutex);
+  hole = hashtable_open_probe(stripe, hash, keyP);
+  if (stripe->slots[hole].key != keyP) {
+    pthread_mutex_unlock(&stripe->mutex);
+    return HASH_TABLE_KEY_NOT_EXISTS;
+  }
+  if (dataP) *dataP = stripe->slots[hole].data;
+
+  mask = stripe->size - 1;
+  hashtable_open_write_begin(stripe);
+  for (i = (hole + 1) & mask; stripe->slots[i].key != HASH_TABLE_OPEN_FREE_KEY;
+       i = (i + 1) & mask) {
+    const hash_size_t home =
+      hashtable_open_hash(table, stripe->slots[i].key) & mask;
+
+    // Move the element unless its home slot lies cyclically in (hole, i]
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      hashtable_open_set_slot(
+        &stripe->slots[hole], stripe->slots[i].key, stripe->slots[i].data);
+      hole = i;
+    }
+  }
+  hashtable_open_set_slot(
+    &stripe->slots[hole], HASH_TABLE_OPEN_FREE_KEY, (uint64_t) -1);
+  hashtable_open_write_end(stripe);
+  stripe->num_elements--;
+  pthread_mutex_unlock(&stripe->mutex);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Iterating
+   The stripes are visited one at a time with their lock held, func_cb must
+   not modify the table.
+*/
+void hashtable_open_apply(
+  hash_table_open_t *const table,
+  hashtable_open_cb_t func_cb,
+  void *parameterP)
+{
+  for (int s = 0; s < HASH_TABLE_OPEN_STRIPES; s++) {
+    hash_stripe_t *stripe = &table->stripes[s];
+
+    pthread_mutex_lock(&stripe->mutex);
+    for (hash_size_t n = 0; n < stripe->size; n++) {
+      if (
+        stripe->slots[n].key != HASH_TABLE_OPEN_FREE_KEY &&
+        func_cb(stripe->slots[n].key, stripe->slots[n].data, parameterP)) {
+        pthread_mutex_unlock(&stripe->mutex);
+        return;
+      }
+    }
+    pthread_mutex_unlock(&stripe->mutex);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Cursors
+   The cursors of the thread safe tables walk the stripes one at a time,
+   hashtable_open_stripe_next() being called with the stripe locked. It
+   returns the element in the first used slot from *slotP on, and moves *slotP
+   past it.
+*/
+void hashtable_open_lock_stripe(
+  hash_table_open_t *const table,
+  const hash_size_t stripeP)
+{
+  pthread_mutex_lock(&table->stripes[stripeP].mutex);
+}
+
+void hashtable_open_unlock_stripe(
+  hash_table_open_t *const table,
+  const hash_size_t stripeP)
+{
+  pthread_mutex_unlock(&table->stripes[stripeP].mutex);
+}
+
+bool hashtable_open_stripe_next(
+  hash_table_open_t *const table,
+  const hash_size_t stripeP,
+  hash_size_t *const slotP,
+  hash_key_t *const keyP,
+  uint64_t *const dataP)
+{
+  hash_stripe_t *stripe = &table->stripes[stripeP];
+
+  while (*slotP < stripe->size) {
+    hash_slot_t *slot = &stripe->slots[(*slotP)++];
+
+    if (slot->key != HASH_TABLE_OPEN_FREE_KEY) {
+      *keyP = slot->key;
+      *dataP = slot->data;
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Number of slots of the table, in use or not
+hash_size_t hashtable_open_size(const hash_table_open_t *const table)
+{
+  hash_size_t size = 0;
+
+  for (int s = 0; s < HASH_TABLE_OPEN_STRIPES; s++) {
+    size += __atomic_load_n(&table->stripes[s].size, __ATOMIC_RELAXED);
+  }
+  return size;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file hashtable_open.h
+  \brief Open addressing backend of the thread safe hash tables
+*/
+#ifndef FILE_HASH_TABLE_OPEN_SEEN
+#define FILE_HASH_TABLE_OPEN_SEEN
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "hashtable.h"
+
+/*
+ * The table is split in a fixed number of stripes, each one being a linear
+ * probing table with its own lock. The top bits of the mixed hash select the
+ * stripe, the low bits the slot, so a probe never leaves its stripe.
+ */
+#define HASH_TABLE_OPEN_STRIPES_BITS 6
+#define HASH_TABLE_OPEN_STRIPES (1 << HASH_TABLE_OPEN_STRIPES_BITS)
+#define HASH_TABLE_OPEN_MIN_STRIPE_SIZE 8
+/* A stripe grows when more than 3/4 of its slots are in use */
+#define HASH_TABLE_OPEN_MAX_LOAD(sIZE) (((sIZE) >> 1) + ((sIZE) >> 2))
+/* Key of the free slots, it cannot be inserted in an open addressing table */
+#define HASH_TABLE_OPEN_FREE_KEY HASHTABLE_NOT_A_KEY_VALUE
+
+typedef struct hash_slot_s {
+  hash_key_t key;
+  uint64_t data;
+} hash_slot_t;
+
+/*
+ * The lookups take no lock. A removal, shifting elements back, or a growth
+ * makes the sequence number of its stripe odd while it runs, the lookups
+ * retrying when it changed under them. The slots of a grown stripe are
+ * retired, see hashtable_epoch.h.
+ */
+typedef struct hash_stripe_s {
+  pthread_mutex_t mutex;
+  uint32_t seq;
+  hash_size_t size; // power of 2
+  hash_size_t num_elements;
+  hash_slot_t *slots;
+} __attribute__((aligned(64))) hash_stripe_t;
+
+typedef struct hash_table_open_s {
+  hash_stripe_t stripes[HASH_TABLE_OPEN_STRIPES];
+  hash_size_t (*hashfunc)(const hash_key_t);
+} hash_table_open_t;
+
+/* Visits an element of a stripe, the stripe is locked, returns true to stop */
+typedef bool (*hashtable_open_cb_t)(
+  const hash_key_t key,
+  const uint64_t data,
+  void *parameter);
+
+/*
+ * Finalizer of MurmurHash3, spreads sequential keys (UE ids, TEIDs) over the
+ * whole 64 bits
+ */
+static inline uint64_t hashtable_mix64(uint64_t key)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+hash_table_open_t *hashtable_open_create(
+  const hash_size_t size,
+  hash_size_t (*hashfunc)(const hash_key_t));
+void hashtable_open_destroy(
+  hash_table_open_t *const table,
+  void (*freefunc)(void **));
+hashtable_rc_t hashtable_open_get(
+  hash_table_open_t *const table,
+  const hash_key_t key,
+  uint64_t *const data) __attribute__((hot));
+hashtable_rc_t hashtable_open_insert(
+  hash_table_open_t *const table,
+  const hash_key_t key,
+  const uint64_t data,
+  uint64_t *const old_data);
+hashtable_rc_t hashtable_open_remove(
+  hash_table_open_t *const table,
+  const hash_key_t key,
+  uint64_t *const data);
+void hashtable_open_apply(
+  hash_table_open_t *const table,
+  hashtable_open_cb_t func_cb,
+  void *parameter);
+void hashtable_open_lock_stripe(
+  hash_table_open_t *const table,
+  const hash_size_t stripe);
+void hashtable_open_unlock_stripe(
+  hash_table_open_t *const table,
+  const hash_size_t stripe);
+bool hashtable_open_stripe_next(
+  hash_table_open_t *const table,
+  const hash_size_t stripe,
+  hash_size_t *const slot,
+  hash_key_t *const key,
+  uint64_t *const data);
+hash_size_t hashtable_open_size(const hash_table_open_t *const table);
+
+#endif
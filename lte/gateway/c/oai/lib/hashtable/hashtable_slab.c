@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+
+/*! \file hashtable_slab.c
+  \brief Slab allocator of the hash table nodes
+*/
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "hashtable_slab.h"
+#include "hashtable.h"
+#include "obj_hashtable.h"
+
+#define HASHTABLE_SLAB_MAX_SIZE(a, b) ((a) > (b) ? (a) : (b))
+#define HASHTABLE_SLAB_ROUND_SIZE(s)                                           \
+  (((s) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+// The chunk header keeps the objects 16 bytes aligned, as malloc() does
+#define HASHTABLE_SLAB_CHUNK_HEADER_SIZE 16
+
+typedef struct hashtable_slab_object_s {
+  struct hashtable_slab_object_s *next;
+} hashtable_slab_object_t;
+
+typedef struct hashtable_slab_chunk_s {
+  struct hashtable_slab_chunk_s *next;
+} hashtable_slab_chunk_t;
+
+typedef struct hashtable_slab_s {
+  pthread_mutex_t mutex;
+  size_t object_size;
+  hashtable_slab_object_t *free_objects;
+  size_t num_free;
+  // Objects handed to the thread caches, in use or still cached there
+  size_t num_handed;
+  // Only kept to account for the chunks, they are never freed
+  hashtable_slab_chunk_t *chunks;
+  size_t num_chunks;
+  size_t num_objects;
+} hashtable_slab_t;
+
+typedef struct hashtable_slab_cache_s {
+  hashtable_slab_object_t *objects;
+  size_t num_objects;
+} hashtable_slab_cache_t;
+
+static hashtable_slab_t hashtable_slabs[HASHTABLE_SLAB_MAX] = {
+  [HASHTABLE_SLAB_NODE] =
+    {.mutex = PTHREAD_MUTEX_INITIALIZER,
+     .object_size = HASHTABLE_SLAB_ROUND_SIZE(HASHTABLE_SLAB_MAX_SIZE(
+       sizeof(hash_node_t), sizeof(hash_node_uint64_t)))},
+  [HASHTABLE_SLAB_OBJ_NODE] =
+    {.mutex = PTHREAD_MUTEX_INITIALIZER,
+     .object_size = HASHTABLE_SLAB_ROUND_SIZE(HASHTABLE_SLAB_MAX_SIZE(
+       sizeof(obj_hash_node_t), sizeof(obj_hash_node_uint64_t)))},
+};
+
+#if HASHTABLE_SLAB
+// Only set before any node is allocated, the objects are then never mixed
+static bool hashtable_slab_disabled = false;
+static __thread hashtable_slab_cache_t
+  hashtable_slab_caches[HASHTABLE_SLAB_MAX];
+static __thread bool hashtable_slab_registered = false;
+static pthread_once_t hashtable_slab_once = PTHREAD_ONCE_INIT;
+static pthread_key_t hashtable_slab_key;
+
+//------------------------------------------------------------------------------
+// Gives count objects of the calling thread cache back to the slab
+static void hashtable_slab_flush(
+  const hashtable_slab_id_t slab_idP,
+  size_t count)
+{
+  hashtable_slab_t *slab = &hashtable_slabs[slab_idP];
+  hashtable_slab_cache_t *cache = &hashtable_slab_caches[slab_idP];
+  hashtable_slab_object_t *first = cache->objects;
+  hashtable_slab_object_t *last = first;
+
+  if (!first || !count) {
+    return;
+  }
+  if (count > cache->num_objects) {
+    count = cache->num_objects;
+  }
+  for (size_t i = 1; i < count; i++) {
+    last = last->next;
+  }
+  cache->objects = last->next;
+  cache->num_objects -= count;
+
+  pthread_mutex_lock(&slab->mutex);
+  last->next = slab->free_objects;
+  slab->free_objects = first;
+  slab->num_free += count;
+  slab->num_handed -= count;
+  pthread_mutex_unlock(&slab->mutex);
+}
+
+//------------------------------------------------------------------------------
+// Destructor of hashtable_slab_key, empties the caches of the exiting thread
+static void hashtable_slab_thread_exit(void *unusedP)
+{
+  for (int i = 0; i < HASHTABLE_SLAB_MAX; i++) {
+    hashtable_slab_flush(i, hashtable_slab_caches[i].num_objects);
+  }
+  hashtable_slab_registered = false;
+}
+
+static void hashtable_slab_init_key(void)
+{
+  pthread_key_create(&hashtable_slab_key, hashtable_slab_thread_exit);
+}
+
+static void hashtable_slab_register(void)
+{
+  pthread_once(&hashtable_slab_once, hashtable_slab_init_key);
+  pthread_setspecific(hashtable_slab_key, hashtable_slab_caches);
+  hashtable_slab_registered = true;
+}
+
+//------------------------------------------------------------------------------
+// Carves a new chunk into free objects, called with the slab mutex held
+static bool hashtable_slab_grow(hashtable_slab_t *const slabP)
+{
+  hashtable_slab_chunk_t *chunk = malloc(HASHTABLE_SLAB_CHUNK_SIZE);
+  uint8_t *object = NULL;
+  size_t num_objects = 0;
+
+  if (!chunk) {
+    return false;
+  }
+  chunk->next = slabP->chunks;
+  slabP->chunks = chunk;
+  slabP->num_chunks++;
+
+  num_objects = (HASHTABLE_SLAB_CHUNK_SIZE - HASHTABLE_SLAB_CHUNK_HEADER_SIZE) /
+                slabP->object_size;
+  object = (uint8_t *) chunk + HASHTABLE_SLAB_CHUNK_HEADER_SIZE;
+  for (size_t i = 0; i < num_objects; i++) {
+    hashtable_slab_object_t *free_object = (hashtable_slab_object_t *) object;
+
+    free_object->next = slabP->free_objects;
+    slabP->free_objects = free_object;
+    object += slabP->object_size;
+  }
+  slabP->num_objects += num_objects;
+  slabP->num_free += num_objects;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Moves a batch of free objects of the slab to the calling thread cache
+static void hashtable_slab_refill(const hashtable_slab_id_t slab_idP)
+{
+  hashtable_slab_t *slab = &hashtable_slabs[slab_idP];
+  hashtable_slab_cache_t *cache = &hashtable_slab_caches[slab_idP];
+  size_t count = 0;
+
+  if (!hashtable_slab_registered) {
+    hashtable_slab_register();
+  }
+  pthread_mutex_lock(&slab->mutex);
+  if (!slab->free_objects && !hashtable_slab_grow(slab)) {
+    pthread_mutex_unlock(&slab->mutex);
+    return;
+  }
+  while (slab->free_objects && count < HASHTABLE_SLAB_BATCH_SIZE) {
+    hashtable_slab_object_t *object = slab->free_objects;
+
+    slab->free_objects = object->next;
+    object->next = cache->objects;
+    cache->objects = object;
+    count++;
+  }
+  slab->num_free -= count;
+  slab->num_handed += count;
+  pthread_mutex_unlock(&slab->mutex);
+  cache->num_objects += count;
+}
+#endif
+
+//------------------------------------------------------------------------------
+/*
+   hashtable_slab_alloc() returns an uninitialized object of the slab, or NULL
+   when out of memory. hashtable_slab_free() gives it back, NULL is ignored.
+*/
+void *hashtable_slab_alloc(const hashtable_slab_id_t slab_idP)
+{
+#if HASHTABLE_SLAB
+  hashtable_slab_cache_t *cache = &hashtable_slab_caches[slab_idP];
+  hashtable_slab_object_t *object = NULL;
+
+  if (hashtable_slab_disabled) {
+    return malloc(hashtable_slabs[slab_idP].object_size);
+  }
+  if (!cache->objects) {
+    hashtable_slab_refill(slab_idP);
+    if (!cache->objects) {
+      return NULL;
+    }
+  }
+  object = cache->objects;
+  cache->objects = object->next;
+  cache->num_objects--;
+  return object;
+#else
+  return malloc(hashtable_slabs[slab_idP].object_size);
+#endif
+}
+
+void hashtable_slab_free(const hashtable_slab_id_t slab_idP, void *ptrP)
+{
+#if HASHTABLE_SLAB
+  hashtable_slab_cache_t *cache = &hashtable_slab_caches[slab_idP];
+  hashtable_slab_object_t *object = (hashtable_slab_object_t *) ptrP;
+
+  if (hashtable_slab_disabled) {
+    free(ptrP);
+    return;
+  }
+  if (!object) {
+    return;
+  }
+  if (!hashtable_slab_registered) {
+    hashtable_slab_register();
+  }
+  object->next = cache->objects;
+  cache->objects = object;
+  cache->num_objects++;
+  if (cache->num_objects > HASHTABLE_SLAB_CACHE_SIZE) {
+    hashtable_slab_flush(slab_idP, HASHTABLE_SLAB_BATCH_SIZE);
+  }
+#else
+  free(ptrP);
+#endif
+}
+
+void hashtable_slab_free_node(void *ptrP)
+{
+  hashtable_slab_free(HASHTABLE_SLAB_NODE, ptrP);
+}
+
+void hashtable_slab_free_obj_node(void *ptrP)
+{
+  hashtable_slab_free(HASHTABLE_SLAB_OBJ_NODE, ptrP);
+}
+
+//------------------------------------------------------------------------------
+void hashtable_slab_disable(void)
+{
+#if HASHTABLE_SLAB
+  hashtable_slab_disabled = true;
+#endif
+}
+
+bool hashtable_slab_is_enabled(void)
+{
+#if HASHTABLE_SLAB
+  return !hashtable_slab_disabled;
+#else
+  return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+void hashtable_slab_get_stats(
+  const hashtable_slab_id_t slab_idP,
+  hashtable_slab_stats_t *const statsP)
+{
+  hashtable_slab_t *slab = &hashtable_slabs[slab_idP];
+
+  pthread_mutex_lock(&slab->mutex);
+  statsP->object_size = slab->object_size;
+  statsP->num_chunks = slab->num_chunks;
+  statsP->num_objects = slab->num_objects;
+  statsP->num_free = slab->num_free;
+  statsP->num_handed = slab->num_handed;
+  pthread_mutex_unlock(&slab->mutex);
+}
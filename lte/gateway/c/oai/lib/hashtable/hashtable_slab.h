@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+
+/*! \file hashtable_slab.h
+  \brief Slab allocator of the hash table nodes
+*/
+#ifndef FILE_HASH_TABLE_SLAB_SEEN
+#define FILE_HASH_TABLE_SLAB_SEEN
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The nodes of all the hash tables come from a few slabs, one per node size,
+ * instead of a malloc() per insert. A slab carves its objects out of
+ * HASHTABLE_SLAB_CHUNK_SIZE chunks that are never given back, so the UE churn
+ * reuses the same memory instead of fragmenting the heap.
+ *
+ * Each thread caches up to HASHTABLE_SLAB_CACHE_SIZE free objects per slab and
+ * only takes the slab lock to move HASHTABLE_SLAB_BATCH_SIZE of them at once.
+ * The slabs are shared by the tables because the nodes retired by the thread
+ * safe tables may be freed after their table was destroyed.
+ *
+ * Define HASHTABLE_SLAB to 0 to allocate the nodes with malloc() again, it is
+ * the default under AddressSanitizer so that it keeps tracking the nodes.
+ * hashtable_slab_disable() does the same at run time, for comparisons.
+ */
+#ifndef HASHTABLE_SLAB
+#if defined(__SANITIZE_ADDRESS__)
+#define HASHTABLE_SLAB 0
+#else
+#define HASHTABLE_SLAB 1
+#endif
+#endif
+
+#define HASHTABLE_SLAB_CHUNK_SIZE (64 * 1024)
+#define HASHTABLE_SLAB_CACHE_SIZE 256
+#define HASHTABLE_SLAB_BATCH_SIZE 64
+
+typedef enum hashtable_slab_id_e {
+  // hash_node_t and hash_node_uint64_t
+  HASHTABLE_SLAB_NODE = 0,
+  // obj_hash_node_t and obj_hash_node_uint64_t
+  HASHTABLE_SLAB_OBJ_NODE,
+  HASHTABLE_SLAB_MAX
+} hashtable_slab_id_t;
+
+typedef struct hashtable_slab_stats_s {
+  size_t object_size;
+  size_t num_chunks;
+  // Objects carved out of the chunks
+  size_t num_objects;
+  // Free objects held by the slab
+  size_t num_free;
+  // Objects handed to the thread caches, in use or still cached there
+  size_t num_handed;
+} hashtable_slab_stats_t;
+
+void *hashtable_slab_alloc(const hashtable_slab_id_t slab_idP);
+void hashtable_slab_free(const hashtable_slab_id_t slab_idP, void *ptrP);
+// Free functions for hashtable_epoch_retire()
+void hashtable_slab_free_node(void *ptrP);
+void hashtable_slab_free_obj_node(void *ptrP);
+// Allocates the nodes with malloc() from now on, before any node is allocated
+void hashtable_slab_disable(void);
+bool hashtable_slab_is_enabled(void);
+void hashtable_slab_get_stats(
+  const hashtable_slab_id_t slab_idP,
+  hashtable_slab_stats_t *const statsP);
+
+#endif
@@ -43,6 +43,9 @@
 #include "bstrlib.h"
 #include "dynamic_memory_check.h"
 #include "hashtable.h"
+#include "hashtable_open.h"
+#include "hashtable_epoch.h"
+#include "hashtable_slab.h"
 
 #if TRACE_HASHTABLE
 #define PRINT_HASHTABLE(hTbLe, ...)                                            \
@@ -65,6 +68,309 @@ static inline hash_size_t def_hashfunc(const uint64_t keyP)
   return (hash_size_t) keyP;
 }
 
+//------------------------------------------------------------------------------
+// Set while the thread iterates a table, buckets must not move under it then
+static __thread int hashtable_uint64_ts_iterating = 0;
+
+static void hashtable_uint64_ts_init_locks(
+  pthread_mutex_t *const locksP,
+  const hash_size_t num_locksP)
+{
+  pthread_mutexattr_t attr;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  for (hash_size_t i = 0; i < num_locksP; i++) {
+    pthread_mutex_init(&locksP[i], &attr);
+  }
+  pthread_mutexattr_destroy(&attr);
+}
+
+static inline pthread_mutex_t *hashtable_uint64_ts_lock(
+  const hash_table_uint64_ts_t *const hashtblP,
+  const hash_size_t hashP)
+{
+  return &hashtblP->lock_nodes[hashP & (hashtblP->num_locks - 1)];
+}
+
+static hash_buckets_uint64_t *hashtable_uint64_ts_alloc_buckets(
+  const hash_size_t sizeP)
+{
+  hash_buckets_uint64_t *buckets = calloc(
+    1, sizeof(hash_buckets_uint64_t) + sizeP * sizeof(hash_node_uint64_t *));
+
+  if (buckets) {
+    buckets->size = sizeP;
+  }
+  return buckets;
+}
+
+// Frees a retired bucket array and the nodes left in it
+static void hashtable_uint64_ts_free_buckets(void *bucketsP)
+{
+  hash_buckets_uint64_t *buckets = (hash_buckets_uint64_t *) bucketsP;
+  hash_node_uint64_t *node = NULL, *next = NULL;
+
+  for (hash_size_t i = 0; i < buckets->size; i++) {
+    for (node = buckets->nodes[i]; node; node = next) {
+      next = node->next;
+      hashtable_slab_free(HASHTABLE_SLAB_NODE, node);
+    }
+  }
+  free(buckets);
+}
+
+// Must be called with the lock of hashP held
+static inline hash_node_uint64_t **hashtable_uint64_ts_bucket(
+  const hash_table_uint64_ts_t *const hashtblP,
+  const hash_size_t hashP)
+{
+  hash_buckets_uint64_t *buckets = hashtblP->buckets;
+
+  if (
+    hashtblP->new_buckets &&
+    (hashP & (buckets->size - 1)) <
+      __atomic_load_n(&hashtblP->new_buckets->rehash_index, __ATOMIC_RELAXED)) {
+    buckets = hashtblP->new_buckets;
+  }
+  return &buckets->nodes[hashP & (buckets->size - 1)];
+}
+
+/*
+ * Lock free lookup, must be called between hashtable_epoch_enter() and
+ * hashtable_epoch_exit(). new_buckets is read first: if it is NULL, buckets
+ * is the current array or one whose buckets were copied after the lookup
+ * started. An old bucket is current until copied, then kept as it was.
+ */
+static inline hash_node_uint64_t *hashtable_uint64_ts_find(
+  const hash_table_uint64_ts_t *const hashtblP,
+  const hash_size_t hashP,
+  const hash_key_t keyP)
+{
+  hash_buckets_uint64_t *new_buckets =
+    __atomic_load_n(&hashtblP->new_buckets, __ATOMIC_ACQUIRE);
+  hash_buckets_uint64_t *buckets =
+    __atomic_load_n(&hashtblP->buckets, __ATOMIC_ACQUIRE);
+  hash_node_uint64_t *node = NULL;
+
+  if (
+    new_buckets && (new_buckets != buckets) &&
+    (hashP & (buckets->size - 1)) <
+      __atomic_load_n(&new_buckets->rehash_index, __ATOMIC_ACQUIRE)) {
+    buckets = new_buckets;
+  }
+  node = __atomic_load_n(
+    &buckets->nodes[hashP & (buckets->size - 1)], __ATOMIC_ACQUIRE);
+  while (node && (node->key != keyP)) {
+    node = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+  }
+  return node;
+}
+
+// Never waits: a thread holding a lock may be waiting on another table
+static bool hashtable_uint64_ts_trylock_all(
+  hash_table_uint64_ts_t *const hashtblP)
+{
+  for (hash_size_t i = 0; i < hashtblP->num_locks; i++) {
+    if (pthread_mutex_trylock(&hashtblP->lock_nodes[i])) {
+      while (i--) {
+        pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+static void hashtable_uint64_ts_unlock_all(
+  hash_table_uint64_ts_t *const hashtblP)
+{
+  for (hash_size_t i = 0; i < hashtblP->num_locks; i++) {
+    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
+  }
+}
+
+// Must be called with hashtblP->mutex held
+static void hashtable_uint64_ts_start_resize(
+  hash_table_uint64_ts_t *const hashtblP,
+  hash_size_t new_sizeP)
+{
+  hash_buckets_uint64_t *new_buckets = NULL;
+
+  if (new_sizeP < hashtblP->num_locks) {
+    new_sizeP = hashtblP->num_locks;
+  }
+  if (hashtblP->new_buckets || new_sizeP == hashtblP->buckets->size) {
+    return;
+  }
+  if (!(new_buckets = hashtable_uint64_ts_alloc_buckets(new_sizeP))) {
+    return;
+  }
+  if (!hashtable_uint64_ts_trylock_all(hashtblP)) {
+    free_wrapper((void **) &new_buckets);
+    return;
+  }
+  __atomic_store_n(&hashtblP->new_buckets, new_buckets, __ATOMIC_RELEASE);
+  hashtable_uint64_ts_unlock_all(hashtblP);
+}
+
+/*
+ * Must be called with hashtblP->mutex held. Copies the next buckets to the
+ * new array, the elements of an old bucket and their new buckets sharing the
+ * same lock, and swaps the arrays once they have all been copied. The old
+ * array is left intact for the lookups and retired with its nodes. Returns
+ * the old size if the resize completed, 0 otherwise.
+ */
+static hash_size_t hashtable_uint64_ts_move_buckets(
+  hash_table_uint64_ts_t *const hashtblP)
+{
+  hash_buckets_uint64_t *buckets = hashtblP->buckets;
+  hash_buckets_uint64_t *new_buckets = hashtblP->new_buckets;
+  hash_node_uint64_t **bucket = NULL;
+  hash_node_uint64_t *node = NULL, *copies = NULL, *copy = NULL;
+  hash_size_t index = new_buckets->rehash_index;
+  hash_size_t old_size = buckets->size;
+  pthread_mutex_t *lock = NULL;
+
+  for (int n = 0; n < HASH_TABLE_TS_REHASH_BUCKETS && index < old_size;
+       n++, index++) {
+    lock = hashtable_uint64_ts_lock(hashtblP, index);
+    pthread_mutex_lock(lock);
+    for (node = buckets->nodes[index], copies = NULL; node; node = node->next) {
+      copy = hashtable_slab_alloc(HASHTABLE_SLAB_NODE);
+      if (!copy) break;
+      copy->key = node->key;
+      copy->data = node->data;
+      copy->next = copies;
+      copies = copy;
+    }
+    for (; node && copies; copies = copy) {
+      // Out of memory, the bucket is copied again by the next step
+      copy = copies->next;
+      hashtable_slab_free(HASHTABLE_SLAB_NODE, copies);
+    }
+    for (; copies; copies = copy) {
+      copy = copies->next;
+      bucket = &new_buckets->nodes
+                  [hashtblP->hashfunc(copies->key) & (new_buckets->size - 1)];
+      copies->next = *bucket;
+      __atomic_store_n(bucket, copies, __ATOMIC_RELEASE);
+    }
+    if (!node) {
+      __atomic_store_n(&new_buckets->rehash_index, index + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(lock);
+    if (node) {
+      return 0;
+    }
+  }
+  if ((index < old_size) || !hashtable_uint64_ts_trylock_all(hashtblP)) {
+    return 0;
+  }
+  __atomic_store_n(&hashtblP->buckets, new_buckets, __ATOMIC_RELEASE);
+  __atomic_store_n(&hashtblP->new_buckets, NULL, __ATOMIC_RELEASE);
+  __atomic_store_n(&hashtblP->size, new_buckets->size, __ATOMIC_RELAXED);
+  hashtable_uint64_ts_unlock_all(hashtblP);
+  hashtable_epoch_retire(buckets, hashtable_uint64_ts_free_buckets);
+  return old_size;
+}
+
+// Called with no lock of the table held, see hashtable_uint64_ts_maintain()
+static void hashtable_uint64_ts_resize_step(
+  hash_table_uint64_ts_t *const hashtblP,
+  const bool may_shrinkP)
+{
+  hash_size_t num_elements =
+    __atomic_load_n(&hashtblP->num_elements, __ATOMIC_RELAXED);
+  hash_size_t old_size = 0;
+
+  if (
+    hashtable_uint64_ts_iterating ||
+    pthread_mutex_trylock(&hashtblP->mutex)) {
+    return;
+  }
+  if (!hashtblP->new_buckets) {
+    if (num_elements > hashtblP->size) {
+      hashtable_uint64_ts_start_resize(hashtblP, hashtblP->size * 2);
+    } else if (may_shrinkP && (num_elements < hashtblP->size / 8)) {
+      hashtable_uint64_ts_start_resize(hashtblP, hashtblP->size / 2);
+    }
+  }
+  if (hashtblP->new_buckets) {
+    old_size = hashtable_uint64_ts_move_buckets(hashtblP);
+  }
+  pthread_mutex_unlock(&hashtblP->mutex);
+  if (old_size) {
+    hashtable_notify_resize(hashtblP->name, old_size, hashtblP->size);
+  }
+}
+
+/*
+ * Called by the operations once they released their lock: starts a resize
+ * when the load factor is out of bounds and takes part in the current one.
+ * Only removals shrink the table, a table sized ahead is kept as it fills.
+ */
+static inline void hashtable_uint64_ts_maintain(
+  hash_table_uint64_ts_t *const hashtblP,
+  const bool may_shrinkP)
+{
+  hash_size_t size = __atomic_load_n(&hashtblP->size, __ATOMIC_RELAXED);
+  hash_size_t num_elements =
+    __atomic_load_n(&hashtblP->num_elements, __ATOMIC_RELAXED);
+
+  if (
+    __atomic_load_n(&hashtblP->new_buckets, __ATOMIC_RELAXED) ||
+    (num_elements > size) ||
+    (may_shrinkP && (num_elements < size / 8) &&
+     (size > hashtblP->num_locks))) {
+    hashtable_uint64_ts_resize_step(hashtblP, may_shrinkP);
+  }
+}
+
+/*
+ * Iterates the chained table lock by lock, each bucket being either in the
+ * old or in the new array while resizing, until funct_cb returns true. The
+ * callbacks may look the table up or remove the element they are given.
+ */
+static bool hashtable_uint64_ts_walk(
+  hash_table_uint64_ts_t *const hashtblP,
+  hashtable_open_cb_t funct_cb,
+  void *parameterP)
+{
+  hash_buckets_uint64_t *buckets = NULL, *new_buckets = NULL;
+  hash_node_uint64_t *node = NULL, *next = NULL;
+  hash_size_t i = 0;
+  bool stop = false;
+
+  hashtable_uint64_ts_iterating++;
+  for (hash_size_t l = 0; (l < hashtblP->num_locks) && !stop; l++) {
+    pthread_mutex_lock(&hashtblP->lock_nodes[l]);
+    buckets = hashtblP->buckets;
+    new_buckets = hashtblP->new_buckets;
+    for (i = l; (i < buckets->size) && !stop; i += hashtblP->num_locks) {
+      if (
+        new_buckets &&
+        (i < __atomic_load_n(&new_buckets->rehash_index, __ATOMIC_RELAXED))) {
+        continue;
+      }
+      for (node = buckets->nodes[i]; node && !stop; node = next) {
+        next = node->next;
+        stop = funct_cb(node->key, node->data, parameterP);
+      }
+    }
+    for (i = l; new_buckets && (i < new_buckets->size) && !stop;
+         i += hashtblP->num_locks) {
+      for (node = new_buckets->nodes[i]; node && !stop; node = next) {
+        next = node->next;
+        stop = funct_cb(node->key, node->data, parameterP);
+      }
+    }
+    pthread_mutex_unlock(&hashtblP->lock_nodes[l]);
+  }
+  hashtable_uint64_ts_iterating--;
+  return stop;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
@@ -176,22 +482,23 @@ hash_table_uint64_ts_t *hashtable_uint64_ts_init(
 
   memset(hashtblP, 0, sizeof(*hashtblP));
 
-  if (!(hashtblP->nodes = calloc(size, sizeof(hash_node_uint64_t *)))) {
+  if (!(hashtblP->buckets = hashtable_uint64_ts_alloc_buckets(size))) {
     free_wrapper((void **) &hashtblP);
     return NULL;
   }
 
-  if (!(hashtblP->lock_nodes = calloc(size, sizeof(pthread_mutex_t)))) {
-    free_wrapper((void **) &hashtblP->nodes);
+  hashtblP->num_locks =
+    (size < HASH_TABLE_TS_MAX_LOCKS) ? size : HASH_TABLE_TS_MAX_LOCKS;
+  if (!(hashtblP->lock_nodes =
+          calloc(hashtblP->num_locks, sizeof(pthread_mutex_t)))) {
+    free_wrapper((void **) &hashtblP->buckets);
     free_wrapper((void **) &hashtblP->name);
     free_wrapper((void **) &hashtblP);
     return NULL;
   }
 
   pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
+  hashtable_uint64_ts_init_locks(hashtblP->lock_nodes, hashtblP->num_locks);
 
   hashtblP->size = size;
 
@@ -232,6 +539,64 @@ hash_table_uint64_ts_t *hashtable_uint64_ts_create(
   return hashtbl;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_uint64_ts_init_backend() is hashtable_uint64_ts_init() with the
+   choice of the storage of the elements.
+*/
+hash_table_uint64_ts_t *hashtable_uint64_ts_init_backend(
+  hash_table_uint64_ts_t *const hashtblP,
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP)(const hash_key_t),
+  bstring display_name_pP,
+  hashtable_backend_t backendP)
+{
+  if (backendP == HASH_TABLE_BACKEND_CHAINED) {
+    return hashtable_uint64_ts_init(
+      hashtblP, sizeP, hashfuncP, display_name_pP);
+  }
+
+  memset(hashtblP, 0, sizeof(*hashtblP));
+  pthread_mutex_init(&hashtblP->mutex, NULL);
+  hashtblP->hashfunc = hashfuncP ? hashfuncP : def_hashfunc;
+  if (!(hashtblP->open_table =
+          hashtable_open_create(sizeP, hashtblP->hashfunc))) {
+    return NULL;
+  }
+  hashtblP->size = hashtable_open_size(hashtblP->open_table);
+
+  if (display_name_pP) {
+    hashtblP->name = bstrcpy(display_name_pP);
+  } else {
+    hashtblP->name = bformat("hashtable@%p", hashtblP);
+  }
+  hashtblP->is_allocated_by_malloc = false;
+  hashtblP->log_enabled = true;
+  return hashtblP;
+}
+
+//------------------------------------------------------------------------------
+hash_table_uint64_ts_t *hashtable_uint64_ts_create_backend(
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP)(const hash_key_t),
+  bstring display_name_pP,
+  hashtable_backend_t backendP)
+{
+  hash_table_uint64_ts_t *hashtbl = NULL;
+
+  if (!(hashtbl = calloc(1, sizeof(hash_table_uint64_ts_t)))) {
+    return NULL;
+  }
+  if (!hashtable_uint64_ts_init_backend(
+        hashtbl, sizeP, hashfuncP, display_name_pP, backendP)) {
+    free_wrapper((void **) &hashtbl);
+    return NULL;
+  }
+  hashtbl->is_allocated_by_malloc = true;
+  return hashtbl;
+}
+
 //------------------------------------------------------------------------------
 /*
    Cleanup
@@ -252,7 +617,7 @@ hashtable_rc_t hashtable_uint64_destroy(hash_table_uint64_t *hashtblP)
     while (node) {
       oldnode = node;
       node = node->next;
-      free_wrapper((void **) &oldnode);
+      hashtable_slab_free(HASHTABLE_SLAB_NODE, oldnode);
     }
   }
 
@@ -272,27 +637,31 @@ hashtable_rc_t hashtable_uint64_destroy(hash_table_uint64_t *hashtblP)
 hashtable_rc_t hashtable_uint64_ts_destroy(hash_table_uint64_ts_t *hashtblP)
 {
   hash_size_t n = 0;
-  hash_node_uint64_t *node = NULL, *oldnode = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-      free_wrapper((void **) &oldnode);
+  if (hashtblP->open_table) {
+    hashtable_open_destroy(hashtblP->open_table, NULL);
+    hashtblP->open_table = NULL;
+    bdestroy_wrapper(&hashtblP->name);
+    if (hashtblP->is_allocated_by_malloc) {
+      free_wrapper((void **) &hashtblP);
     }
+    return HASH_TABLE_OK;
+  }
 
-    pthread_mutex_unlock(&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy(&hashtblP->lock_nodes[n]);
+  // The old buckets still hold the elements copied while resizing
+  hashtable_uint64_ts_free_buckets(hashtblP->buckets);
+  if (hashtblP->new_buckets) {
+    hashtable_uint64_ts_free_buckets(hashtblP->new_buckets);
   }
 
-  free_wrapper((void **) &hashtblP->nodes);
+  for (n = 0; n < hashtblP->num_locks; ++n) {
+    pthread_mutex_destroy(&hashtblP->lock_nodes[n]);
+  }
+  pthread_mutex_destroy(&hashtblP->mutex);
   bdestroy_wrapper(&hashtblP->name);
   free_wrapper((void **) &hashtblP->lock_nodes);
   if (hashtblP->is_allocated_by_malloc) {
@@ -350,25 +719,24 @@ hashtable_rc_t hashtable_uint64_ts_is_key_exists(
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 ") return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP);
-      return HASH_TABLE_OK;
-    }
+  if (hashtblP->open_table) {
+    return hashtable_open_get(hashtblP->open_table, keyP, NULL);
+  }
 
-    node = node->next;
+  hash = hashtblP->hashfunc(keyP);
+  hashtable_epoch_enter();
+  node = hashtable_uint64_ts_find(hashtblP, hash, keyP);
+  hashtable_epoch_exit();
+
+  if (node) {
+    PRINT_HASHTABLE(
+      hashtblP,
+      "%s(%s,key 0x%" PRIx64 ") return OK\n",
+      __FUNCTION__,
+      bdata(hashtblP->name),
+      keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE(
     hashtblP,
     "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
@@ -415,13 +783,81 @@ hashtable_rc_t hashtable_uint64_apply_callback_on_elements(
   return HASH_TABLE_OK;
 }
 
+//------------------------------------------------------------------------------
+typedef struct hashtable_uint64_ts_apply_s {
+  bool (*funct_cb)(
+    const hash_key_t keyP,
+    const uint64_t dataP,
+    void *parameterP,
+    void **resultP);
+  void *parameter;
+  void **result;
+} hashtable_uint64_ts_apply_t;
+
+static bool hashtable_uint64_ts_apply_cb(
+  const hash_key_t keyP,
+  const uint64_t dataP,
+  void *parameterP)
+{
+  hashtable_uint64_ts_apply_t *apply =
+    (hashtable_uint64_ts_apply_t *) parameterP;
+
+  return apply->funct_cb(keyP, dataP, apply->parameter, apply->result);
+}
+
+// Arrays are sized before iterating, elements inserted meanwhile are left out
+typedef struct hashtable_uint64_ts_array_s {
+  union {
+    hashtable_key_array_t *ka;
+    hashtable_uint64_element_array_t *ea;
+  };
+  int max_elements;
+} hashtable_uint64_ts_array_t;
+
+static bool hashtable_uint64_ts_get_key_cb(
+  const hash_key_t keyP,
+  __attribute__((unused)) const uint64_t dataP,
+  void *parameterP)
+{
+  hashtable_uint64_ts_array_t *array =
+    (hashtable_uint64_ts_array_t *) parameterP;
+
+  array->ka->keys[array->ka->num_keys++] = keyP;
+  return array->ka->num_keys >= array->max_elements;
+}
+
+static bool hashtable_uint64_ts_get_element_cb(
+  __attribute__((unused)) const hash_key_t keyP,
+  const uint64_t dataP,
+  void *parameterP)
+{
+  hashtable_uint64_ts_array_t *array =
+    (hashtable_uint64_ts_array_t *) parameterP;
+
+  array->ea->elements[array->ea->num_elements++] = dataP;
+  return array->ea->num_elements >= array->max_elements;
+}
+
+static bool hashtable_uint64_ts_dump_cb(
+  const hash_key_t keyP,
+  const uint64_t dataP,
+  void *parameterP)
+{
+  bstring b0 =
+    bformat("Key 0x%" PRIx64 " Element 0x%" PRIx64 "\n", keyP, dataP);
+
+  if (b0) {
+    bconcat((bstring) parameterP, b0);
+    bdestroy_wrapper(&b0);
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 // may cost a lot CPU...
 hashtable_key_array_t *hashtable_uint64_ts_get_keys(
   hash_table_uint64_ts_t *const hashtblP)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
   hashtable_key_array_t *ka = NULL;
 
   if ((!hashtblP) || !(hashtblP->num_elements)) {
@@ -430,17 +866,13 @@ hashtable_key_array_t *hashtable_uint64_ts_get_keys(
   ka = calloc(1, sizeof(hashtable_key_array_t));
   ka->keys = calloc(hashtblP->num_elements, sizeof(hash_key_t *));
 
-  while ((ka->num_keys < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ka->keys[ka->num_keys++] = node->key;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+  hashtable_uint64_ts_array_t array = {
+    .ka = ka, .max_elements = hashtblP->num_elements};
+  if (hashtblP->open_table) {
+    hashtable_open_apply(
+      hashtblP->open_table, hashtable_uint64_ts_get_key_cb, &array);
+  } else {
+    hashtable_uint64_ts_walk(hashtblP, hashtable_uint64_ts_get_key_cb, &array);
   }
   return ka;
 }
@@ -450,8 +882,6 @@ hashtable_key_array_t *hashtable_uint64_ts_get_keys(
 hashtable_uint64_element_array_t *hashtable_uint64_ts_get_elements(
   hash_table_uint64_ts_t *const hashtblP)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
   hashtable_uint64_element_array_t *ea = NULL;
 
   if ((!hashtblP) || !(hashtblP->num_elements)) {
@@ -461,17 +891,14 @@ hashtable_uint64_element_array_t *hashtable_uint64_ts_get_elements(
   ea = calloc(1, sizeof(hashtable_uint64_element_array_t));
   ea->elements = calloc(hashtblP->num_elements, sizeof(uint64_t *));
 
-  while ((ea->num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ea->elements[ea->num_elements++] = node->data;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+  hashtable_uint64_ts_array_t array = {
+    .ea = ea, .max_elements = hashtblP->num_elements};
+  if (hashtblP->open_table) {
+    hashtable_open_apply(
+      hashtblP->open_table, hashtable_uint64_ts_get_element_cb, &array);
+  } else {
+    hashtable_uint64_ts_walk(
+      hashtblP, hashtable_uint64_ts_get_element_cb, &array);
   }
   return ea;
 }
@@ -490,32 +917,19 @@ hashtable_rc_t hashtable_uint64_ts_apply_callback_on_elements(
   void *parameterP,
   void **resultP)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
-  unsigned int num_elements = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb(node->key, node->data, parameterP, resultP)) {
-          pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-          return HASH_TABLE_OK;
-        }
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+  hashtable_uint64_ts_apply_t apply = {
+    .funct_cb = funct_cb, .parameter = parameterP, .result = resultP};
+  if (hashtblP->open_table) {
+    hashtable_open_apply(
+      hashtblP->open_table, hashtable_uint64_ts_apply_cb, &apply);
+  } else {
+    hashtable_uint64_ts_walk(hashtblP, hashtable_uint64_ts_apply_cb, &apply);
   }
-
   return HASH_TABLE_OK;
 }
 
@@ -556,42 +970,172 @@ hashtable_rc_t hashtable_uint64_dump_content(
   return HASH_TABLE_OK;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Cursors
+   See hashtable.h. The locks of a chained table are walked in the order
+   of hashtable_uint64_ts_walk(): for each lock, the old buckets not yet
+   copied, then the new ones while resizing. A thread iterating does not take part in the
+   resizes, so that the arrays do not change under its cursor.
+*/
+static void hashtable_uint64_ts_cursor_lock(
+  hashtable_uint64_ts_cursor_t *const cursorP,
+  const hash_size_t lockP)
+{
+  if (cursorP->table->open_table) {
+    hashtable_open_lock_stripe(cursorP->table->open_table, lockP);
+  } else {
+    pthread_mutex_lock(&cursorP->table->lock_nodes[lockP]);
+  }
+}
+
+static void hashtable_uint64_ts_cursor_unlock(
+  hashtable_uint64_ts_cursor_t *const cursorP,
+  const hash_size_t lockP)
+{
+  if (cursorP->table->open_table) {
+    hashtable_open_unlock_stripe(cursorP->table->open_table, lockP);
+  } else {
+    pthread_mutex_unlock(&cursorP->table->lock_nodes[lockP]);
+  }
+}
+
+// Finds the next node of the chained table under the current lock
+static bool hashtable_uint64_ts_cursor_find(
+  hashtable_uint64_ts_cursor_t *const cursorP)
+{
+  hash_table_uint64_ts_t *hashtblP = cursorP->table;
+  hash_buckets_uint64_t *new_buckets = hashtblP->new_buckets;
+  hash_buckets_uint64_t *buckets =
+    cursorP->in_new_buckets ? new_buckets : hashtblP->buckets;
+
+  while (!cursorP->node) {
+    if (cursorP->index >= buckets->size) {
+      if (cursorP->in_new_buckets || !new_buckets) {
+        return false;
+      }
+      cursorP->in_new_buckets = true;
+      cursorP->index = cursorP->lock;
+      buckets = new_buckets;
+      continue;
+    }
+    if (
+      cursorP->in_new_buckets || !new_buckets ||
+      (cursorP->index >=
+       __atomic_load_n(&new_buckets->rehash_index, __ATOMIC_RELAXED))) {
+      cursorP->node = buckets->nodes[cursorP->index];
+    }
+    cursorP->index += hashtblP->num_locks;
+  }
+  return true;
+}
+
+void hashtable_uint64_ts_cursor_init(
+  hashtable_uint64_ts_cursor_t *const cursorP,
+  hash_table_uint64_ts_t *const hashtblP,
+  const hashtable_cursor_mode_t modeP)
+{
+  memset(cursorP, 0, sizeof(*cursorP));
+  if (!hashtblP) {
+    return;
+  }
+  cursorP->table = hashtblP;
+  cursorP->mode = modeP;
+  cursorP->num_locks =
+    hashtblP->open_table ? HASH_TABLE_OPEN_STRIPES : hashtblP->num_locks;
+  hashtable_uint64_ts_iterating++;
+  if (modeP == HASH_TABLE_CURSOR_SNAPSHOT) {
+    for (hash_size_t l = 0; l < cursorP->num_locks; l++) {
+      hashtable_uint64_ts_cursor_lock(cursorP, l);
+    }
+  } else {
+    hashtable_uint64_ts_cursor_lock(cursorP, 0);
+  }
+}
+
+/*
+ * Returns the next element in keyP and elementP, false once the whole table
+ * was walked, the cursor being ended then
+ */
+bool hashtable_uint64_ts_cursor_next(
+  hashtable_uint64_ts_cursor_t *const cursorP,
+  hash_key_t *const keyP,
+  uint64_t *const elementP)
+{
+  hash_table_uint64_ts_t *hashtblP = cursorP->table;
+  hash_node_uint64_t *node = NULL;
+
+  if (!hashtblP) {
+    return false;
+  }
+  for (;;) {
+    if (hashtblP->open_table) {
+      if (hashtable_open_stripe_next(
+            hashtblP->open_table,
+            cursorP->lock,
+            &cursorP->index,
+            keyP,
+            elementP)) {
+        return true;
+      }
+    } else if (hashtable_uint64_ts_cursor_find(cursorP)) {
+      // The caller may remove the element returned
+      node = cursorP->node;
+      cursorP->node = node->next;
+      *keyP = node->key;
+      *elementP = node->data;
+      return true;
+    }
+    if (cursorP->lock + 1 >= cursorP->num_locks) {
+      hashtable_uint64_ts_cursor_end(cursorP);
+      return false;
+    }
+    if (cursorP->mode != HASH_TABLE_CURSOR_SNAPSHOT) {
+      hashtable_uint64_ts_cursor_unlock(cursorP, cursorP->lock);
+    }
+    cursorP->lock++;
+    cursorP->index = hashtblP->open_table ? 0 : cursorP->lock;
+    cursorP->in_new_buckets = false;
+    if (cursorP->mode != HASH_TABLE_CURSOR_SNAPSHOT) {
+      hashtable_uint64_ts_cursor_lock(cursorP, cursorP->lock);
+    }
+  }
+}
+
+// Releases the locks held by the cursor, may be called more than once
+void hashtable_uint64_ts_cursor_end(hashtable_uint64_ts_cursor_t *const cursorP)
+{
+  if (!cursorP->table) {
+    return;
+  }
+  if (cursorP->mode == HASH_TABLE_CURSOR_SNAPSHOT) {
+    for (hash_size_t l = 0; l < cursorP->num_locks; l++) {
+      hashtable_uint64_ts_cursor_unlock(cursorP, l);
+    }
+  } else {
+    hashtable_uint64_ts_cursor_unlock(cursorP, cursorP->lock);
+  }
+  hashtable_uint64_ts_iterating--;
+  cursorP->table = NULL;
+}
+
 //------------------------------------------------------------------------------
 hashtable_rc_t hashtable_uint64_ts_dump_content(
   const hash_table_uint64_ts_t *const hashtblP,
   bstring str)
 {
-  hash_node_uint64_t *node = NULL;
-  unsigned int i = 0;
 
   if (!hashtblP) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat(
-          "Key 0x%" PRIx64 " Element %" PRIx64 " Node %p Next %p\n",
-          node->key,
-          node->data,
-          node,
-          node->next);
-        if (!b0) {
-          PRINT_HASHTABLE(hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy_wrapper(&b0);
-        }
-        node = node->next;
-      }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    }
-    i += 1;
+  if (hashtblP->open_table) {
+    hashtable_open_apply(
+      hashtblP->open_table, hashtable_uint64_ts_dump_cb, str);
+  } else {
+    hashtable_uint64_ts_walk(
+      (hash_table_uint64_ts_t *) hashtblP, hashtable_uint64_ts_dump_cb, str);
   }
   return HASH_TABLE_OK;
 }
@@ -644,7 +1188,7 @@ hashtable_rc_t hashtable_uint64_insert(
     node = node->next;
   }
 
-  if (!(node = malloc(sizeof(hash_node_uint64_t)))) return -1;
+  if (!(node = hashtable_slab_alloc(HASHTABLE_SLAB_NODE))) return -1;
 
   node->key = keyP;
   node->data = dataP;
@@ -679,21 +1223,36 @@ hashtable_rc_t hashtable_uint64_ts_insert(
   const uint64_t dataP)
 {
   hash_node_uint64_t *node = NULL;
+  hash_node_uint64_t **bucket = NULL;
   hash_size_t hash = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  if (hashtblP->open_table) {
+    uint64_t old_data = 0;
+    hashtable_rc_t rc =
+      hashtable_open_insert(hashtblP->open_table, keyP, dataP, &old_data);
+
+    if (rc == HASH_TABLE_OK) {
+      __sync_fetch_and_add(&hashtblP->num_elements, 1);
+    } else if (rc == HASH_TABLE_INSERT_OVERWRITTEN_DATA && old_data == dataP) {
+      rc = HASH_TABLE_OK;
+    }
+    return rc;
+  }
+
+  hash = hashtblP->hashfunc(keyP);
+  pthread_mutex_lock(hashtable_uint64_ts_lock(hashtblP, hash));
+  bucket = hashtable_uint64_ts_bucket(hashtblP, hash);
+  node = *bucket;
 
   while (node) {
     if (node->key == keyP) {
       if (node->data != dataP) {
-        node->data = dataP;
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+        __atomic_store_n(&node->data, dataP, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
         PRINT_HASHTABLE(
           hashtblP,
           "%s(%s,key 0x%" PRIx64 " data %" PRIx64
@@ -704,8 +1263,7 @@ hashtable_rc_t hashtable_uint64_ts_insert(
           dataP);
         return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
       }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
       PRINT_HASHTABLE(
         hashtblP,
         "%s(%s,key 0x%" PRIx64 " data %" PRIx64 ") return OK\n",
@@ -719,20 +1277,14 @@ hashtable_rc_t hashtable_uint64_ts_insert(
     node = node->next;
   }
 
-  if (!(node = malloc(sizeof(hash_node_uint64_t)))) return -1;
+  if (!(node = hashtable_slab_alloc(HASHTABLE_SLAB_NODE))) return -1;
 
   node->key = keyP;
   node->data = dataP;
 
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
-  hashtblP->nodes[hash] = node;
+  node->next = *bucket;
+  __atomic_store_n(bucket, node, __ATOMIC_RELEASE);
   __sync_fetch_and_add(&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE(
     hashtblP,
     "%s(%s,key 0x%" PRIx64 " data %p) next %p return OK\n",
@@ -741,6 +1293,8 @@ hashtable_rc_t hashtable_uint64_ts_insert(
     keyP,
     dataP,
     node->next);
+  pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
+  hashtable_uint64_ts_maintain(hashtblP, false);
   return HASH_TABLE_OK;
 }
 
@@ -770,7 +1324,7 @@ hashtable_rc_t hashtable_uint64_free(
       else
         hashtblP->nodes[hash] = node->next;
 
-      free_wrapper((void **) &node);
+      hashtable_slab_free(HASHTABLE_SLAB_NODE, node);
       __sync_fetch_and_sub(&hashtblP->num_elements, 1);
       PRINT_HASHTABLE(
         hashtblP,
@@ -804,32 +1358,41 @@ hashtable_rc_t hashtable_uint64_ts_free(
   const hash_key_t keyP)
 {
   hash_node_uint64_t *node, *prevnode = NULL;
+  hash_node_uint64_t **bucket = NULL;
   hash_size_t hash = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  if (hashtblP->open_table) {
+    hashtable_rc_t rc = hashtable_open_remove(hashtblP->open_table, keyP, NULL);
+
+    if (rc == HASH_TABLE_OK) {
+      __sync_fetch_and_sub(&hashtblP->num_elements, 1);
+    }
+    return rc;
+  }
+
+  hash = hashtblP->hashfunc(keyP);
+  pthread_mutex_lock(hashtable_uint64_ts_lock(hashtblP, hash));
+  bucket = hashtable_uint64_ts_bucket(hashtblP, hash);
+  node = *bucket;
 
   while (node) {
     if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper((void **) &node);
+      __atomic_store_n(
+        prevnode ? &prevnode->next : bucket, node->next, __ATOMIC_RELEASE);
+      hashtable_epoch_retire(node, hashtable_slab_free_node);
       __sync_fetch_and_sub(&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
       PRINT_HASHTABLE(
         hashtblP,
         "%s(%s,key 0x%" PRIx64 ") return OK\n",
         __FUNCTION__,
         bdata(hashtblP->name),
         keyP);
+      hashtable_uint64_ts_maintain(hashtblP, true);
       return HASH_TABLE_OK;
     }
 
@@ -837,7 +1400,7 @@ hashtable_rc_t hashtable_uint64_ts_free(
     node = node->next;
   }
 
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
   PRINT_HASHTABLE(
     hashtblP,
     "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
@@ -873,7 +1436,7 @@ hashtable_rc_t hashtable_uint64_remove(
       else
         hashtblP->nodes[hash] = node->next;
 
-      free_wrapper((void **) &node);
+      hashtable_slab_free(HASHTABLE_SLAB_NODE, node);
       __sync_fetch_and_sub(&hashtblP->num_elements, 1);
       PRINT_HASHTABLE(
         hashtblP,
@@ -907,39 +1470,48 @@ hashtable_rc_t hashtable_uint64_ts_remove(
   const hash_key_t keyP)
 {
   hash_node_uint64_t *node, *prevnode = NULL;
+  hash_node_uint64_t **bucket = NULL;
   hash_size_t hash = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  if (hashtblP->open_table) {
+    hashtable_rc_t rc = hashtable_open_remove(hashtblP->open_table, keyP, NULL);
+
+    if (rc == HASH_TABLE_OK) {
+      __sync_fetch_and_sub(&hashtblP->num_elements, 1);
+    }
+    return rc;
+  }
+
+  hash = hashtblP->hashfunc(keyP);
+  pthread_mutex_lock(hashtable_uint64_ts_lock(hashtblP, hash));
+  bucket = hashtable_uint64_ts_bucket(hashtblP, hash);
+  node = *bucket;
 
   while (node) {
     if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper((void **) &node);
+      __atomic_store_n(
+        prevnode ? &prevnode->next : bucket, node->next, __ATOMIC_RELEASE);
+      hashtable_epoch_retire(node, hashtable_slab_free_node);
       __sync_fetch_and_sub(&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+      pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
       PRINT_HASHTABLE(
         hashtblP,
         "%s(%s,key 0x%" PRIx64 ") return OK\n",
         __FUNCTION__,
         bdata(hashtblP->name),
         keyP);
+      hashtable_uint64_ts_maintain(hashtblP, true);
       return HASH_TABLE_OK;
     }
 
     prevnode = node;
     node = node->next;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(hashtable_uint64_ts_lock(hashtblP, hash));
 
   PRINT_HASHTABLE(
     hashtblP,
@@ -1012,28 +1584,29 @@ hashtable_rc_t hashtable_uint64_ts_get(
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc(keyP) % hashtblP->size;
-
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  if (hashtblP->open_table) {
+    return hashtable_open_get(hashtblP->open_table, keyP, dataP);
+  }
 
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE(
-        hashtblP,
-        "%s(%s,key 0x%" PRIx64 " data %p) return OK\n",
-        __FUNCTION__,
-        bdata(hashtblP->name),
-        keyP,
-        *dataP);
-      return HASH_TABLE_OK;
-    }
+  hash = hashtblP->hashfunc(keyP);
 
-    node = node->next;
+  hashtable_epoch_enter();
+  if ((node = hashtable_uint64_ts_find(hashtblP, hash, keyP))) {
+    *dataP = __atomic_load_n(&node->data, __ATOMIC_ACQUIRE);
+  }
+  hashtable_epoch_exit();
+
+  if (node) {
+    PRINT_HASHTABLE(
+      hashtblP,
+      "%s(%s,key 0x%" PRIx64 " data %p) return OK\n",
+      __FUNCTION__,
+      bdata(hashtblP->name),
+      keyP,
+      *dataP);
+    hashtable_uint64_ts_maintain((hash_table_uint64_ts_t *) hashtblP, false);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE(
     hashtblP,
     "%s(%s,key 0x%" PRIx64 ") return KEY_NOT_EXISTS\n",
@@ -1061,6 +1634,7 @@ hashtable_rc_t hashtable_uint64_resize(
 {
   hash_table_uint64_t newtbl;
   hash_size_t n;
+  hash_size_t hash;
   hash_node_uint64_t *node, *next;
 
   if (!hashtblP) {
@@ -1090,11 +1664,13 @@ hashtable_rc_t hashtable_uint64_resize(
 
   if (!(newtbl.nodes = calloc(size, sizeof(hash_node_uint64_t *)))) return -1;
 
+  // The nodes are moved, a removed node may already be reused by the slab
   for (n = 0; n < hashtblP->size; ++n) {
     for (node = hashtblP->nodes[n]; node; node = next) {
       next = node->next;
-      hashtable_uint64_remove(hashtblP, node->key);
-      hashtable_uint64_insert(&newtbl, node->key, node->data);
+      hash = newtbl.hashfunc(node->key) % newtbl.size;
+      node->next = newtbl.nodes[hash];
+      newtbl.nodes[hash] = node;
     }
   }
 
@@ -1107,27 +1683,28 @@ hashtable_rc_t hashtable_uint64_resize(
 //------------------------------------------------------------------------------
 /*
    Resizing
-   The number of elements in a hash table is not always known when creating the table.
-   If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
-   If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
-   Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_uint64_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_uint64_insert() and hashtable_uint64_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
-   Dangerous not really thread safe.
+   The thread safe hash tables resize themselves on their load factor, see
+   hashtable_uint64_ts_maintain(). hashtable_uint64_ts_resize() starts a resize
+   to the given size, or its number of locks if greater, unless one is already
+   in progress. The buckets are then copied by the following operations on the
+   table, that may later resize it again on their own.
 */
 
 hashtable_rc_t hashtable_uint64_ts_resize(
   hash_table_uint64_ts_t *const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_uint64_ts_t newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t n = 0;
-  hash_node_uint64_t *node = NULL, *next = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
+
+  // Open addressing stripes grow by themselves
+  if (hashtblP->open_table) {
+    return HASH_TABLE_OK;
+  }
+  if (hashtable_uint64_ts_iterating) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
   hash_size_t size = sizeP;
   // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
   //  By Sean Eron Anderson
@@ -1147,34 +1724,8 @@ hashtable_rc_t hashtable_uint64_ts_resize(
   size |= size >> 16;
   size++;
 
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc(size, sizeof(hash_node_uint64_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc(size, sizeof(pthread_mutex_t)))) {
-    free_wrapper((void **) &newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
   pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_uint64_ts_remove(hashtblP, node->key);
-      hashtable_uint64_ts_insert(&newtbl, node->key, node->data);
-    }
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  free_wrapper((void **) &hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
+  hashtable_uint64_ts_start_resize(hashtblP, size);
   pthread_mutex_unlock(&hashtblP->mutex);
   return HASH_TABLE_OK;
 }
@@ -50,11 +50,19 @@
     free(key_array_ptr);                                                       \
   } while(0) /*Free the list of keys of an object hash table */
 
+/*
+ * Keys of up to OBJ_HASHTABLE_INLINE_KEY_SIZE bytes, as the IMSI and GUTI
+ * strings or most APNs, are copied in the node itself: key then points to
+ * key_inline and is not given to freekeyfunc.
+ */
+#define OBJ_HASHTABLE_INLINE_KEY_SIZE 16
+
 typedef struct obj_hash_node_s {
   int key_size;
   void *key;
   void *data;
   struct obj_hash_node_s *next;
+  uint8_t key_inline[OBJ_HASHTABLE_INLINE_KEY_SIZE];
 } obj_hash_node_t;
 
 typedef struct obj_hash_node_uint64_s {
@@ -62,6 +70,7 @@ typedef struct obj_hash_node_uint64_s {
   void *key;
   uint64_t data;
   struct obj_hash_node_uint64_s *next;
+  uint8_t key_inline[OBJ_HASHTABLE_INLINE_KEY_SIZE];
 } obj_hash_node_uint64_t;
 
 typedef struct obj_hash_table_s {
@@ -46,6 +46,7 @@
 #include "bstrlib.h"
 #include "obj_hashtable.h"
 #include "dynamic_memory_check.h"
+#include "hashtable_slab.h"
 #include "hashtable.h"
 
 #if TRACE_HASHTABLE
@@ -85,6 +86,39 @@ static hash_size_t def_hashfunc(const void *const keyP, const int key_sizeP)
   return hash;
 }
 
+//------------------------------------------------------------------------------
+// Allocates a node from the slab, holding a copy of keyP
+static obj_hash_node_uint64_t *obj_hashtable_uint64_alloc_node(
+  const void *const keyP,
+  const int key_sizeP)
+{
+  obj_hash_node_uint64_t *node = hashtable_slab_alloc(HASHTABLE_SLAB_OBJ_NODE);
+
+  if (!node) {
+    return NULL;
+  }
+  if ((key_sizeP >= 0) && (key_sizeP <= OBJ_HASHTABLE_INLINE_KEY_SIZE)) {
+    node->key = node->key_inline;
+  } else if (!(node->key = malloc(key_sizeP))) {
+    hashtable_slab_free(HASHTABLE_SLAB_OBJ_NODE, node);
+    return NULL;
+  }
+  memcpy(node->key, keyP, key_sizeP);
+  node->key_size = key_sizeP;
+  return node;
+}
+
+// Frees the node and its key, but not its data
+static void obj_hashtable_uint64_free_node(
+  obj_hash_table_uint64_t *const hashtblP,
+  obj_hash_node_uint64_t *nodeP)
+{
+  if (nodeP->key != nodeP->key_inline) {
+    hashtblP->freekeyfunc(&nodeP->key);
+  }
+  hashtable_slab_free(HASHTABLE_SLAB_OBJ_NODE, nodeP);
+}
+
 //------------------------------------------------------------------------------
 /*
  *    Initialization
@@ -280,8 +314,7 @@ hashtable_rc_t obj_hashtable_uint64_destroy(
     while (node) {
       oldnode = node;
       node = node->next;
-      hashtblP->freekeyfunc(&oldnode->key);
-      free_wrapper((void **) &oldnode);
+      obj_hashtable_uint64_free_node(hashtblP, oldnode);
     }
   }
 
@@ -309,8 +342,7 @@ hashtable_rc_t obj_hashtable_uint64_ts_destroy(
     while (node) {
       oldnode = node;
       node = node->next;
-      hashtblP->freekeyfunc(&oldnode->key);
-      free_wrapper((void **) &oldnode);
+      obj_hashtable_uint64_free_node(hashtblP, oldnode);
     }
     pthread_mutex_unlock(&hashtblP->lock_nodes[n]);
     pthread_mutex_destroy(&hashtblP->lock_nodes[n]);
@@ -570,7 +602,7 @@ hashtable_rc_t obj_hashtable_uint64_insert(
     node = node->next;
   }
 
-  if (!(node = malloc(sizeof(obj_hash_node_uint64_t)))) {
+  if (!(node = obj_hashtable_uint64_alloc_node(keyP, key_sizeP))) {
     PRINT_HASHTABLE(
       hashtblP,
       "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n",
@@ -581,21 +613,7 @@ hashtable_rc_t obj_hashtable_uint64_insert(
     return HASH_TABLE_SYSTEM_ERROR;
   }
 
-  if (!(node->key = malloc(key_sizeP))) {
-    PRINT_HASHTABLE(
-      hashtblP,
-      "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n",
-      __FUNCTION__,
-      bdata(hashtblP->name),
-      keyP,
-      hash);
-    free_wrapper((void **) &node);
-    return -1;
-  }
-
-  memcpy(node->key, keyP, key_sizeP);
   node->data = dataP;
-  node->key_size = key_sizeP;
 
   if (hashtblP->nodes[hash]) {
     node->next = hashtblP->nodes[hash];
@@ -677,20 +695,7 @@ hashtable_rc_t obj_hashtable_uint64_ts_insert(
     node = node->next;
   }
 
-  if (!(node = calloc(1, sizeof(obj_hash_node_uint64_t)))) {
-    pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-    PRINT_HASHTABLE(
-      hashtblP,
-      "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n",
-      __FUNCTION__,
-      bdata(hashtblP->name),
-      keyP,
-      hash);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-
-  if (!(node->key = calloc(1, key_sizeP))) {
-    free_wrapper((void **) &node);
+  if (!(node = obj_hashtable_uint64_alloc_node(keyP, key_sizeP))) {
     pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
     PRINT_HASHTABLE(
       hashtblP,
@@ -702,9 +707,7 @@ hashtable_rc_t obj_hashtable_uint64_ts_insert(
     return HASH_TABLE_SYSTEM_ERROR;
   }
 
-  memcpy(node->key, keyP, key_sizeP);
   node->data = dataP;
-  node->key_size = key_sizeP;
 
   if (hashtblP->nodes[hash]) {
     node->next = hashtblP->nodes[hash];
@@ -762,8 +765,7 @@ hashtable_rc_t obj_hashtable_uint64_free(
         hashtblP->nodes[hash] = node->next;
       }
 
-      hashtblP->freekeyfunc(&node->key);
-      free_wrapper((void **) &node);
+      obj_hashtable_uint64_free_node(hashtblP, node);
       hashtblP->num_elements -= 1;
       PRINT_HASHTABLE(
         hashtblP,
@@ -818,8 +820,7 @@ hashtable_rc_t obj_hashtable_uint64_ts_free(
         hashtblP->nodes[hash] = node->next;
       }
 
-      hashtblP->freekeyfunc(&node->key);
-      free_wrapper((void **) &node);
+      obj_hashtable_uint64_free_node(hashtblP, node);
       __sync_fetch_and_sub(&hashtblP->num_elements, 1);
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
       PRINT_HASHTABLE(
@@ -875,8 +876,7 @@ hashtable_rc_t obj_hashtable_uint64_remove(
         hashtblP->nodes[hash] = node->next;
       }
 
-      hashtblP->freekeyfunc(&node->key);
-      free_wrapper((void **) &node);
+      obj_hashtable_uint64_free_node(hashtblP, node);
       hashtblP->num_elements -= 1;
       PRINT_HASHTABLE(
         hashtblP,
@@ -931,8 +931,7 @@ hashtable_rc_t obj_hashtable_uint64_ts_remove(
         hashtblP->nodes[hash] = node->next;
       }
 
-      hashtblP->freekeyfunc(&node->key);
-      free_wrapper((void **) &node);
+      obj_hashtable_uint64_free_node(hashtblP, node);
       __sync_fetch_and_sub(&hashtblP->num_elements, 1);
       pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
       PRINT_HASHTABLE(
@@ -1185,6 +1184,7 @@ hashtable_rc_t obj_hashtable_uint64_resize(
 {
   obj_hash_table_uint64_t newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
   hash_size_t n;
+  hash_size_t hash;
   obj_hash_node_uint64_t *node, *next;
 
   if (hashtblP == NULL) {
@@ -1216,12 +1216,13 @@ hashtable_rc_t obj_hashtable_uint64_resize(
   if (!(newtbl.nodes = calloc(size, sizeof(obj_hash_node_uint64_t *))))
     return HASH_TABLE_SYSTEM_ERROR;
 
+  // The nodes are moved, a removed node may already be reused by the slab
   for (n = 0; n < hashtblP->size; ++n) {
     for (node = hashtblP->nodes[n]; node; node = next) {
       next = node->next;
-      obj_hashtable_uint64_remove(hashtblP, node->key, node->key_size);
-      obj_hashtable_uint64_insert(
-        &newtbl, node->key, node->key_size, node->data);
+      hash = newtbl.hashfunc(node->key, node->key_size) % newtbl.size;
+      node->next = newtbl.nodes[hash];
+      newtbl.nodes[hash] = node;
     }
   }
 
@@ -1249,6 +1250,7 @@ hashtable_rc_t obj_hashtable_uint64_ts_resize(
 {
   obj_hash_table_uint64_t newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
   hash_size_t n;
+  hash_size_t hash;
   obj_hash_node_uint64_t *node, *next;
 
   if (hashtblP == NULL) {
@@ -1284,17 +1286,18 @@ hashtable_rc_t obj_hashtable_uint64_ts_resize(
     free_wrapper((void **) &newtbl.nodes);
     return HASH_TABLE_SYSTEM_ERROR;
   }
-  for (n = 0; n < hashtblP->size; ++n) {
+  for (n = 0; n < size; ++n) {
     pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
   }
 
   pthread_mutex_lock(&hashtblP->mutex);
+  // The nodes are moved, a removed node may already be reused by the slab
   for (n = 0; n < hashtblP->size; ++n) {
     for (node = hashtblP->nodes[n]; node; node = next) {
       next = node->next;
-      obj_hashtable_uint64_ts_remove(hashtblP, node->key, node->key_size);
-      obj_hashtable_uint64_insert(
-        &newtbl, node->key, node->key_size, node->data);
+      hash = newtbl.hashfunc(node->key, node->key_size) % newtbl.size;
+      node->next = newtbl.nodes[hash];
+      newtbl.nodes[hash] = node;
     }
   }
 
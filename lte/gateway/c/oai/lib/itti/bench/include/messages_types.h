@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#ifndef FILE_BENCH_MESSAGES_TYPES_SEEN
+#define FILE_BENCH_MESSAGES_TYPES_SEEN
+
+// Benchmarks run ITTI standalone, on the generic message types and their own
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "intertask_messages_types.h"
+#include "timer_messages_types.h"
+
+#define BENCH_UE_MESSAGE(mSGpTR) (mSGpTR)->ittiMsg.bench_ue_message
+#define BENCH_PING_MESSAGE(mSGpTR) (mSGpTR)->ittiMsg.bench_ping_message
+
+typedef struct itti_bench_ue_message_s {
+  uint32_t ue_id;
+  uint32_t step;
+} itti_bench_ue_message_t;
+
+typedef struct itti_bench_ping_message_s {
+  uint64_t sent_ns;
+  uint32_t sequence;
+  // The receiver sends the message back to its origin
+  bool echo;
+} itti_bench_ping_message_t;
+
+#endif /* FILE_BENCH_MESSAGES_TYPES_SEEN */
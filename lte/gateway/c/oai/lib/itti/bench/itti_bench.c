@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*
+ * Standalone benchmark and stress suite of the ITTI message bus, run on the
+ * example task and message definitions:
+ *  - ping-pong: round trip latency between two tasks
+ *  - fan-in:    throughput of BENCH_FANIN_PRODUCERS threads sending to a task
+ *  - broadcast: cost of a broadcast received by the workers of a task
+ *  - pools:     memory pools behaviour when they run out of items
+ *
+ * Every scenario runs in its own process, ITTI tasks cannot be restarted, and
+ * fails on a lost, unexpected or late message. With --smoke every scenario is
+ * shortened so that the suite runs in CI.
+ *
+ * Usage: itti_bench [--smoke] [ping-pong|fan-in|broadcast|pools]
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "memory_pools.h"
+#include "common_defs.h"
+
+#define BENCH_PING_PONGS 200000
+#define BENCH_FANIN_PRODUCERS 4
+#define BENCH_FANIN_MSGS 250000
+// Messages in flight in fan-in, keeps the producers within the memory pools
+#define BENCH_FANIN_WINDOW 4096
+#define BENCH_BROADCAST_WORKERS 4
+#define BENCH_BROADCASTS 50000
+#define BENCH_POOL_ITEMS 65536
+// Pool items a thread may keep cached, see MEMORY_POOL_MAGAZINE_SIZE
+#define BENCH_POOL_MAGAZINE_SIZE 32
+#define BENCH_SMOKE_DIVIDER 50
+#define BENCH_TIMEOUT_S 300
+// Sequence of the ping telling the peer that every fan-in message arrived
+#define BENCH_DONE_SEQUENCE UINT32_MAX
+
+typedef struct bench_scenario_s {
+  const char *name;
+  int (*run)(void);
+} bench_scenario_t;
+
+static size_t bench_divider = 1;
+static pthread_barrier_t bench_barrier;
+// Fan-in latencies, written by TASK_BENCH_APP only
+static uint64_t *bench_latencies;
+static size_t bench_expected;
+static volatile uint32_t bench_in_flight;
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int _bench_compare(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a;
+  uint64_t y = *(const uint64_t *) b;
+
+  return (x > y) - (x < y);
+}
+
+static double _bench_percentile_us(
+  const uint64_t *sorted,
+  size_t nb_samples,
+  double percentile)
+{
+  size_t index = (size_t)(nb_samples * percentile / 100.);
+
+  if (index >= nb_samples) index = nb_samples - 1;
+  return sorted[index] / 1e3;
+}
+
+static void _bench_report(
+  const char *name,
+  size_t nb_msgs,
+  uint64_t ns,
+  uint64_t *latencies,
+  size_t nb_latencies)
+{
+  qsort(latencies, nb_latencies, sizeof(uint64_t), _bench_compare);
+  printf(
+    "%-10s %10zu msgs %10.0f msgs/s   latency us p50 %8.2f p99 %8.2f "
+    "p999 %8.2f\n",
+    name,
+    nb_msgs,
+    nb_msgs / (ns / 1e9),
+    _bench_percentile_us(latencies, nb_latencies, 50.),
+    _bench_percentile_us(latencies, nb_latencies, 99.),
+    _bench_percentile_us(latencies, nb_latencies, 99.9));
+}
+
+static void _bench_report_ops(const char *name, size_t nb_ops, uint64_t ns)
+{
+  printf(
+    "%-28s %10zu ops %10.1f ms %8.1f ns/op\n",
+    name,
+    nb_ops,
+    ns / 1e6,
+    nb_ops ? (double) ns / nb_ops : 0.);
+}
+
+static int _bench_itti_init(void)
+{
+  return itti_init(
+    TASK_MAX,
+    THREAD_MAX,
+    MESSAGES_ID_MAX,
+    tasks_info,
+    messages_info,
+    NULL,
+    NULL);
+}
+
+static void _bench_send_ping(
+  task_id_t origin,
+  task_id_t destination,
+  uint64_t sent_ns,
+  uint32_t sequence,
+  bool echo)
+{
+  MessageDef *message_p = itti_alloc_new_message(origin, BENCH_PING_MESSAGE);
+
+  BENCH_PING_MESSAGE(message_p).sent_ns = sent_ns;
+  BENCH_PING_MESSAGE(message_p).sequence = sequence;
+  BENCH_PING_MESSAGE(message_p).echo = echo;
+  itti_send_msg_to_task(destination, INSTANCE_DEFAULT, message_p);
+}
+
+// Receive one message of the calling peer, false if it is not the expected one
+static bool _bench_receive_ping(
+  uint32_t sequence,
+  itti_bench_ping_message_t *ping)
+{
+  MessageDef *message_p;
+  bool expected;
+
+  itti_receive_msg(TASK_BENCH_PEER, &message_p);
+  expected = ITTI_MSG_ID(message_p) == BENCH_PING_MESSAGE &&
+             BENCH_PING_MESSAGE(message_p).sequence == sequence;
+  if (expected) {
+    *ping = BENCH_PING_MESSAGE(message_p);
+  } else {
+    fprintf(
+      stderr,
+      "Unexpected %s while waiting for ping %u\n",
+      ITTI_MSG_NAME(message_p),
+      sequence);
+  }
+  itti_free(ITTI_MSG_ORIGIN_ID(message_p), message_p);
+  return expected;
+}
+
+// Broadcast messages are shared by the workers, the shard is not used
+static uint32_t _bench_shard(const MessageDef *message_p)
+{
+  if (ITTI_MSG_ID(message_p) != BENCH_PING_MESSAGE) return 0;
+  return BENCH_PING_MESSAGE(message_p).sequence;
+}
+
+/*
+ * Sends back the pings asking for it, records the latency of the others and
+ * tells the peer once bench_expected of them have been received
+ */
+static void *_bench_app_thread(void *args_p)
+{
+  size_t nb_received = 0;
+
+  itti_mark_task_ready(TASK_BENCH_APP);
+
+  while (1) {
+    MessageDef *messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_messages;
+    uint64_t now;
+
+    nb_messages =
+      itti_receive_msgs(TASK_BENCH_APP, messages, ITTI_RECEIVE_BATCH_SIZE);
+    now = _bench_now_ns();
+    for (size_t i = 0; i < nb_messages; i++) {
+      MessageDef *message_p = messages[i];
+
+      if (ITTI_MSG_ID(message_p) == BENCH_PING_MESSAGE) {
+        itti_bench_ping_message_t ping = BENCH_PING_MESSAGE(message_p);
+
+        if (ping.echo) {
+          _bench_send_ping(
+            TASK_BENCH_APP,
+            ITTI_MSG_ORIGIN_ID(message_p),
+            ping.sent_ns,
+            ping.sequence,
+            false);
+        } else {
+          bench_latencies[ping.sequence] = now - ping.sent_ns;
+          __atomic_sub_fetch(&bench_in_flight, 1, __ATOMIC_RELEASE);
+          if (++nb_received == bench_expected) {
+            _bench_send_ping(
+              TASK_BENCH_APP, TASK_BENCH_PEER, now, BENCH_DONE_SEQUENCE, false);
+          }
+        }
+      }
+      itti_free(ITTI_MSG_ORIGIN_ID(message_p), message_p);
+    }
+  }
+  return NULL;
+}
+
+static int _bench_ping_pong(void)
+{
+  size_t nb_round_trips = BENCH_PING_PONGS / bench_divider;
+  uint64_t *latencies = calloc(nb_round_trips, sizeof(uint64_t));
+  uint64_t start;
+
+  if (latencies == NULL || _bench_itti_init() != RETURNok) {
+    return EXIT_FAILURE;
+  }
+  // The calling thread plays the peer
+  itti_mark_task_ready(TASK_BENCH_PEER);
+  itti_create_task(TASK_BENCH_APP, _bench_app_thread, NULL);
+
+  start = _bench_now_ns();
+  for (uint32_t i = 0; i < nb_round_trips; i++) {
+    itti_bench_ping_message_t ping;
+
+    _bench_send_ping(
+      TASK_BENCH_PEER, TASK_BENCH_APP, _bench_now_ns(), i, true);
+    if (!_bench_receive_ping(i, &ping)) return EXIT_FAILURE;
+    latencies[i] = _bench_now_ns() - ping.sent_ns;
+  }
+  _bench_report(
+    "ping-pong",
+    2 * nb_round_trips,
+    _bench_now_ns() - start,
+    latencies,
+    nb_round_trips);
+  return EXIT_SUCCESS;
+}
+
+static void *_bench_producer_thread(void *args_p)
+{
+  uint32_t first = (uintptr_t) args_p;
+  size_t nb_msgs = BENCH_FANIN_MSGS / bench_divider;
+
+  pthread_barrier_wait(&bench_barrier);
+  for (uint32_t i = 0; i < nb_msgs; i++) {
+    while (__atomic_load_n(&bench_in_flight, __ATOMIC_ACQUIRE) >=
+           BENCH_FANIN_WINDOW) {
+      sched_yield();
+    }
+    __atomic_add_fetch(&bench_in_flight, 1, __ATOMIC_RELAXED);
+    _bench_send_ping(
+      TASK_BENCH_PEER, TASK_BENCH_APP, _bench_now_ns(), first + i, false);
+  }
+  return NULL;
+}
+
+static int _bench_fan_in(void)
+{
+  size_t nb_msgs = BENCH_FANIN_MSGS / bench_divider;
+  pthread_t producers[BENCH_FANIN_PRODUCERS];
+  itti_bench_ping_message_t ping;
+  uint64_t start;
+
+  bench_expected = BENCH_FANIN_PRODUCERS * nb_msgs;
+  bench_latencies = calloc(bench_expected, sizeof(uint64_t));
+  if (bench_latencies == NULL || _bench_itti_init() != RETURNok) {
+    return EXIT_FAILURE;
+  }
+  itti_mark_task_ready(TASK_BENCH_PEER);
+  itti_create_task(TASK_BENCH_APP, _bench_app_thread, NULL);
+
+  pthread_barrier_init(&bench_barrier, NULL, BENCH_FANIN_PRODUCERS + 1);
+  for (uintptr_t i = 0; i < BENCH_FANIN_PRODUCERS; i++) {
+    pthread_create(
+      &producers[i], NULL, _bench_producer_thread, (void *) (i * nb_msgs));
+  }
+  pthread_barrier_wait(&bench_barrier);
+  start = _bench_now_ns();
+  if (!_bench_receive_ping(BENCH_DONE_SEQUENCE, &ping)) return EXIT_FAILURE;
+  _bench_report(
+    "fan-in",
+    bench_expected,
+    ping.sent_ns - start,
+    bench_latencies,
+    bench_expected);
+  for (int i = 0; i < BENCH_FANIN_PRODUCERS; i++) {
+    pthread_join(producers[i], NULL);
+  }
+  return EXIT_SUCCESS;
+}
+
+static int _bench_broadcast(void)
+{
+  size_t nb_broadcasts = BENCH_BROADCASTS / bench_divider;
+  uint64_t *latencies = calloc(nb_broadcasts, sizeof(uint64_t));
+  uint64_t send_ns = 0;
+  uint64_t start;
+
+  if (latencies == NULL || _bench_itti_init() != RETURNok) {
+    return EXIT_FAILURE;
+  }
+  itti_mark_task_ready(TASK_BENCH_PEER);
+  itti_create_task_workers(
+    TASK_BENCH_APP,
+    _bench_app_thread,
+    NULL,
+    BENCH_BROADCAST_WORKERS,
+    _bench_shard);
+
+  /*
+   * Every worker of TASK_BENCH_APP sends the broadcast back, a broadcast is
+   * done when the last of them is received
+   */
+  start = _bench_now_ns();
+  for (uint32_t i = 0; i < nb_broadcasts; i++) {
+    MessageDef *message_p =
+      itti_alloc_new_message(TASK_BENCH_PEER, BENCH_PING_MESSAGE);
+    itti_bench_ping_message_t ping;
+    uint64_t sent_ns = _bench_now_ns();
+
+    BENCH_PING_MESSAGE(message_p).sent_ns = sent_ns;
+    BENCH_PING_MESSAGE(message_p).sequence = i;
+    BENCH_PING_MESSAGE(message_p).echo = true;
+    itti_send_broadcast_message(message_p);
+    send_ns += _bench_now_ns() - sent_ns;
+    for (int worker = 0; worker < BENCH_BROADCAST_WORKERS; worker++) {
+      if (!_bench_receive_ping(i, &ping)) return EXIT_FAILURE;
+    }
+    latencies[i] = _bench_now_ns() - sent_ns;
+  }
+  _bench_report(
+    "broadcast",
+    nb_broadcasts * BENCH_BROADCAST_WORKERS,
+    _bench_now_ns() - start,
+    latencies,
+    nb_broadcasts);
+  _bench_report_ops("itti_send_broadcast_message", nb_broadcasts, send_ns);
+  return EXIT_SUCCESS;
+}
+
+// Allocates items until the pools run out, returns the number allocated
+static size_t _bench_pools_fill(
+  memory_pools_handle_t pools,
+  memory_pool_item_handle_t *items,
+  size_t max)
+{
+  size_t nb_items = 0;
+
+  while (nb_items < max &&
+         (items[nb_items] = memory_pools_allocate(pools, 100, 0, 0)) != NULL) {
+    nb_items++;
+  }
+  return nb_items;
+}
+
+static void _bench_pools_release(
+  memory_pools_handle_t pools,
+  memory_pool_item_handle_t *items,
+  size_t nb_items)
+{
+  for (size_t i = 0; i < nb_items; i++) {
+    memory_pools_free(pools, items[i], 0);
+  }
+}
+
+typedef struct bench_pools_thread_s {
+  memory_pools_handle_t pools;
+  memory_pool_item_handle_t *items;
+  size_t max;
+  size_t nb_items;
+} bench_pools_thread_t;
+
+static void *_bench_pools_thread(void *args_p)
+{
+  bench_pools_thread_t *args = args_p;
+
+  args->nb_items = _bench_pools_fill(args->pools, args->items, args->max);
+  _bench_pools_release(args->pools, args->items, args->nb_items);
+  return NULL;
+}
+
+/*
+ * Small items spill over to the larger pool once their own pool is empty,
+ * allocations must then fail without side effects and every item must be
+ * usable again once released, from any thread
+ */
+static int _bench_pools(void)
+{
+  uint32_t nb_small = BENCH_POOL_ITEMS / bench_divider;
+  uint32_t nb_large = nb_small / 4;
+  size_t total = nb_small + nb_large;
+  memory_pools_handle_t pools = memory_pools_create(2);
+  memory_pool_item_handle_t *items =
+    calloc(total + 1, sizeof(memory_pool_item_handle_t));
+  bench_pools_thread_t thread_args = {
+    .pools = pools,
+    .items = items,
+    .max = total + 1,
+  };
+  pthread_t thread;
+  size_t nb_items;
+  uint64_t start;
+
+  if (items == NULL) return EXIT_FAILURE;
+  memory_pools_add_pool(pools, nb_small, 100);
+  memory_pools_add_pool(pools, nb_large, 400);
+
+  start = _bench_now_ns();
+  nb_items = _bench_pools_fill(pools, items, total + 1);
+  _bench_report_ops(
+    "allocate until exhausted", nb_items, _bench_now_ns() - start);
+  if (nb_items != total) {
+    fprintf(stderr, "Allocated %zu items out of %zu\n", nb_items, total);
+    return EXIT_FAILURE;
+  }
+
+  start = _bench_now_ns();
+  for (size_t i = 0; i < total; i++) {
+    if (memory_pools_allocate(pools, 100, 0, 0) != NULL) {
+      fprintf(stderr, "Allocated an item from exhausted pools\n");
+      return EXIT_FAILURE;
+    }
+  }
+  _bench_report_ops("allocate when exhausted", total, _bench_now_ns() - start);
+
+  start = _bench_now_ns();
+  _bench_pools_release(pools, items, nb_items);
+  _bench_report_ops("free", nb_items, _bench_now_ns() - start);
+
+  // Only the items cached by this thread are out of reach of another one
+  start = _bench_now_ns();
+  pthread_create(&thread, NULL, _bench_pools_thread, &thread_args);
+  pthread_join(thread, NULL);
+  _bench_report_ops(
+    "other thread refill+free", thread_args.nb_items, _bench_now_ns() - start);
+  if (thread_args.nb_items + 2 * BENCH_POOL_MAGAZINE_SIZE < total) {
+    fprintf(
+      stderr,
+      "Other thread allocated %zu items out of %zu\n",
+      thread_args.nb_items,
+      total);
+    return EXIT_FAILURE;
+  }
+
+  start = _bench_now_ns();
+  nb_items = _bench_pools_fill(pools, items, total + 1);
+  _bench_report_ops("refill", nb_items, _bench_now_ns() - start);
+  if (nb_items != total) {
+    fprintf(stderr, "Refilled %zu items out of %zu\n", nb_items, total);
+    return EXIT_FAILURE;
+  }
+  _bench_pools_release(pools, items, nb_items);
+  return EXIT_SUCCESS;
+}
+
+static const bench_scenario_t bench_scenarios[] = {
+  {"ping-pong", _bench_ping_pong},
+  {"fan-in", _bench_fan_in},
+  {"broadcast", _bench_broadcast},
+  {"pools", _bench_pools},
+};
+
+// Wait for a scenario, killing it if it does not complete in time
+static bool _bench_wait(pid_t pid)
+{
+  int status;
+
+  for (int i = 0; i < BENCH_TIMEOUT_S * 10; i++) {
+    pid_t result = waitpid(pid, &status, WNOHANG);
+
+    if (result == pid) {
+      return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    }
+    if (result < 0) return false;
+    usleep(100000);
+  }
+  fprintf(stderr, "Timed out after %d s\n", BENCH_TIMEOUT_S);
+  kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+  return false;
+}
+
+int main(int argc, char **argv)
+{
+  const char *only = NULL;
+  int result = EXIT_SUCCESS;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--smoke") == 0) {
+      bench_divider = BENCH_SMOKE_DIVIDER;
+    } else {
+      only = argv[i];
+    }
+  }
+
+  for (size_t i = 0; i < sizeof(bench_scenarios) / sizeof(bench_scenarios[0]);
+       i++) {
+    pid_t pid;
+
+    if (only && strcmp(only, bench_scenarios[i].name) != 0) continue;
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) return EXIT_FAILURE;
+    if (pid == 0) {
+      exit(bench_scenarios[i].run());
+    }
+    if (!_bench_wait(pid)) {
+      fprintf(stderr, "%s FAILED\n", bench_scenarios[i].name);
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}
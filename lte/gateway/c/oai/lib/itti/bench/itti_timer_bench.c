@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*
+ * Arms and cancels a large number of timers through timer_setup() and
+ * timer_remove(), and reports the cost per operation.
+ *
+ * Usage: itti_timer_bench [nb_timers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "timer.h"
+#include "common_defs.h"
+
+#define BENCH_DEFAULT_NB_TIMERS 1000000
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void _bench_report(const char *name, size_t nb_ops, uint64_t ns)
+{
+  printf(
+    "%-28s %10zu ops %10.1f ms %8.1f ns/op\n",
+    name,
+    nb_ops,
+    ns / 1e6,
+    (double) ns / nb_ops);
+}
+
+int main(int argc, char **argv)
+{
+  size_t nb_timers = BENCH_DEFAULT_NB_TIMERS;
+  long *timer_ids;
+  size_t nb_found = 0;
+  uint64_t start;
+
+  if (argc > 1) nb_timers = strtoul(argv[1], NULL, 10);
+
+  if (
+    itti_init(
+      TASK_MAX,
+      THREAD_MAX,
+      MESSAGES_ID_MAX,
+      tasks_info,
+      messages_info,
+      NULL,
+      NULL) != RETURNok) {
+    return EXIT_FAILURE;
+  }
+
+  timer_ids = calloc(nb_timers, sizeof(long));
+  if (timer_ids == NULL) return EXIT_FAILURE;
+
+  /*
+   * Timers are spread over one hour so that every wheel level is used, none
+   * of them expires during the run.
+   */
+  srand(42);
+  start = _bench_now_ns();
+  for (size_t i = 0; i < nb_timers; i++) {
+    if (
+      timer_setup(
+        60 + rand() % 3600,
+        rand() % 1000000,
+        TASK_TIMER,
+        INSTANCE_DEFAULT,
+        TIMER_ONE_SHOT,
+        NULL,
+        0,
+        &timer_ids[i]) < 0) {
+      fprintf(stderr, "timer_setup failed after %zu timers\n", i);
+      return EXIT_FAILURE;
+    }
+  }
+  _bench_report("timer_setup", nb_timers, _bench_now_ns() - start);
+
+  start = _bench_now_ns();
+  for (size_t i = 0; i < nb_timers; i++) {
+    nb_found += timer_exists(timer_ids[(i * 7919) % nb_timers]);
+  }
+  _bench_report("timer_exists", nb_timers, _bench_now_ns() - start);
+
+  // Cancel in an order unrelated to the arming order
+  start = _bench_now_ns();
+  for (size_t i = 0; i < nb_timers; i++) {
+    size_t j = nb_timers - 1 - i;
+
+    if (timer_remove(timer_ids[j], NULL) < 0) {
+      fprintf(stderr, "timer_remove failed for timer 0x%lx\n", timer_ids[j]);
+      return EXIT_FAILURE;
+    }
+  }
+  _bench_report("timer_remove", nb_timers, _bench_now_ns() - start);
+
+  start = _bench_now_ns();
+  for (size_t i = 0; i < nb_timers; i++) {
+    long timer_id;
+
+    timer_setup(
+      1, 0, TASK_TIMER, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, 0, &timer_id);
+    timer_remove(timer_id, NULL);
+  }
+  _bench_report("timer_setup+timer_remove", nb_timers, _bench_now_ns() - start);
+
+  free(timer_ids);
+  return nb_found == nb_timers ? EXIT_SUCCESS : EXIT_FAILURE;
+}
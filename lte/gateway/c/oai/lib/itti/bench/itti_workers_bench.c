@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*
+ * UE attach and detach throughput of a task served by 1 to max_workers
+ * workers, the way TASK_MME_APP runs with MME_APP_WORKERS.
+ *
+ * TASK_BENCH_APP plays MME_APP: it keeps one context per UE in a shared
+ * hashtable, locks it for every step of a procedure and spends handler_ns on
+ * it. TASK_BENCH_PEER plays the eNB, HSS and S-GW and answers every request
+ * at once. An attach takes BENCH_ATTACH_STEPS round trips and the following
+ * detach BENCH_DETACH_STEPS, BENCH_CONCURRENT_UES UEs run them concurrently.
+ *
+ * ITTI tasks cannot be restarted, every worker count runs in its own process.
+ *
+ * Usage: itti_workers_bench [max_workers] [nb_ues] [handler_ns]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "common_defs.h"
+
+#define BENCH_DEFAULT_MAX_WORKERS 8
+#define BENCH_DEFAULT_NB_UES 100000
+#define BENCH_DEFAULT_HANDLER_NS 2000
+#define BENCH_CONCURRENT_UES 1024
+
+/*
+ * Initial UE message, authentication, security mode, update location,
+ * create session and initial context setup
+ */
+#define BENCH_ATTACH_STEPS 6
+// Detach request, delete session and UE context release
+#define BENCH_DETACH_STEPS 3
+#define BENCH_LAST_STEP (BENCH_ATTACH_STEPS + BENCH_DETACH_STEPS - 1)
+
+typedef struct bench_ue_s {
+  pthread_mutex_t mutex;
+  uint32_t step;
+} bench_ue_t;
+
+static hash_table_ts_t *bench_ues;
+static uint64_t bench_handler_ns;
+static volatile uint32_t bench_errors;
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void _bench_send(
+  task_id_t origin,
+  task_id_t destination,
+  uint32_t ue_id,
+  uint32_t step)
+{
+  MessageDef *message_p = itti_alloc_new_message(origin, BENCH_UE_MESSAGE);
+
+  BENCH_UE_MESSAGE(message_p).ue_id = ue_id;
+  BENCH_UE_MESSAGE(message_p).step = step;
+  itti_send_msg_to_task(destination, INSTANCE_DEFAULT, message_p);
+}
+
+// The messages of a UE are handled by one worker, as MME_APP shards them
+static uint32_t _bench_shard(const MessageDef *message_p)
+{
+  if (ITTI_MSG_ID(message_p) != BENCH_UE_MESSAGE) return 0;
+  return BENCH_UE_MESSAGE(message_p).ue_id;
+}
+
+static void _bench_app_handle(uint32_t ue_id, uint32_t step)
+{
+  bench_ue_t *ue = NULL;
+  uint64_t end;
+
+  if (step == 0) {
+    ue = calloc(1, sizeof(bench_ue_t));
+    pthread_mutex_init(&ue->mutex, NULL);
+    hashtable_ts_insert(bench_ues, ue_id, ue);
+  } else if (
+    hashtable_ts_get(bench_ues, ue_id, (void **) &ue) != HASH_TABLE_OK) {
+    __sync_fetch_and_add(&bench_errors, 1);
+    return;
+  }
+
+  pthread_mutex_lock(&ue->mutex);
+  // Steps of a UE must be handled in order
+  if (ue->step != step) __sync_fetch_and_add(&bench_errors, 1);
+  ue->step = step + 1;
+  end = _bench_now_ns() + bench_handler_ns;
+  while (_bench_now_ns() < end)
+    ;
+  pthread_mutex_unlock(&ue->mutex);
+
+  if (step == BENCH_LAST_STEP) {
+    hashtable_ts_remove(bench_ues, ue_id, (void **) &ue);
+    pthread_mutex_destroy(&ue->mutex);
+    free(ue);
+  }
+  _bench_send(TASK_BENCH_APP, TASK_BENCH_PEER, ue_id, step);
+}
+
+static void *_bench_app_thread(void *args_p)
+{
+  itti_mark_task_ready(TASK_BENCH_APP);
+
+  while (1) {
+    MessageDef *messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_messages;
+
+    nb_messages =
+      itti_receive_msgs(TASK_BENCH_APP, messages, ITTI_RECEIVE_BATCH_SIZE);
+    for (size_t i = 0; i < nb_messages; i++) {
+      if (ITTI_MSG_ID(messages[i]) == BENCH_UE_MESSAGE) {
+        _bench_app_handle(
+          BENCH_UE_MESSAGE(messages[i]).ue_id,
+          BENCH_UE_MESSAGE(messages[i]).step);
+      }
+      itti_free(ITTI_MSG_ORIGIN_ID(messages[i]), messages[i]);
+    }
+  }
+  return NULL;
+}
+
+static int _bench_run(uint32_t nb_workers, size_t nb_ues)
+{
+  bstring name = bfromcstr("bench_ues");
+  size_t nb_started = 0;
+  size_t nb_done = 0;
+  uint32_t nb_messages = 0;
+  uint64_t start;
+  uint64_t ns;
+
+  if (
+    itti_init(
+      TASK_MAX,
+      THREAD_MAX,
+      MESSAGES_ID_MAX,
+      tasks_info,
+      messages_info,
+      NULL,
+      NULL) != RETURNok) {
+    return EXIT_FAILURE;
+  }
+  bench_ues = hashtable_ts_create(2 * BENCH_CONCURRENT_UES, NULL, NULL, name);
+  bdestroy(name);
+
+  // The calling thread plays the peers
+  itti_mark_task_ready(TASK_BENCH_PEER);
+  itti_create_task_workers(
+    TASK_BENCH_APP, _bench_app_thread, NULL, nb_workers, _bench_shard);
+
+  start = _bench_now_ns();
+  while (nb_started < nb_ues && nb_started < BENCH_CONCURRENT_UES) {
+    _bench_send(TASK_BENCH_PEER, TASK_BENCH_APP, nb_started++, 0);
+  }
+  while (nb_done < nb_ues) {
+    MessageDef *messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_received;
+
+    nb_received =
+      itti_receive_msgs(TASK_BENCH_PEER, messages, ITTI_RECEIVE_BATCH_SIZE);
+    for (size_t i = 0; i < nb_received; i++) {
+      uint32_t ue_id = BENCH_UE_MESSAGE(messages[i]).ue_id;
+      uint32_t step = BENCH_UE_MESSAGE(messages[i]).step;
+
+      itti_free(ITTI_MSG_ORIGIN_ID(messages[i]), messages[i]);
+      nb_messages++;
+      if (step < BENCH_LAST_STEP) {
+        _bench_send(TASK_BENCH_PEER, TASK_BENCH_APP, ue_id, step + 1);
+        continue;
+      }
+      nb_done++;
+      if (nb_started < nb_ues) {
+        _bench_send(TASK_BENCH_PEER, TASK_BENCH_APP, nb_started++, 0);
+      }
+    }
+  }
+  ns = _bench_now_ns() - start;
+
+  printf(
+    "%2u workers %10zu attach+detach %10.1f ms %10.0f UEs/s %8.2f us/msg%s\n",
+    nb_workers,
+    nb_ues,
+    ns / 1e6,
+    nb_ues / (ns / 1e9),
+    ns / 1e3 / nb_messages,
+    bench_errors ? " OUT OF ORDER" : "");
+  return bench_errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t max_workers = BENCH_DEFAULT_MAX_WORKERS;
+  size_t nb_ues = BENCH_DEFAULT_NB_UES;
+  int result = EXIT_SUCCESS;
+
+  bench_handler_ns = BENCH_DEFAULT_HANDLER_NS;
+  if (argc > 1) max_workers = strtoul(argv[1], NULL, 10);
+  if (argc > 2) nb_ues = strtoul(argv[2], NULL, 10);
+  if (argc > 3) bench_handler_ns = strtoull(argv[3], NULL, 10);
+  if (max_workers > ITTI_TASK_WORKERS_MAX) max_workers = ITTI_TASK_WORKERS_MAX;
+
+  printf(
+    "%zu UEs, %d steps each, %lu ns per step, %d concurrent UEs\n",
+    nb_ues,
+    BENCH_LAST_STEP + 1,
+    bench_handler_ns,
+    BENCH_CONCURRENT_UES);
+  fflush(stdout);
+  for (uint32_t nb_workers = 1; nb_workers <= max_workers; nb_workers *= 2) {
+    pid_t pid = fork();
+    int status;
+
+    if (pid < 0) return EXIT_FAILURE;
+    if (pid == 0) {
+      exit(_bench_run(nb_workers, nb_ues));
+    }
+    if (
+      waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != EXIT_SUCCESS) {
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}
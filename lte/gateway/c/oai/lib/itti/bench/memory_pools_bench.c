@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*
+ * Multi-producer benchmark of the memory pools used by ITTI messages.
+ *
+ * Two patterns are run with 1 to max_threads threads:
+ *  - local:   each thread allocates a burst of items and frees them itself
+ *  - handoff: each thread allocates items and hands them to the next thread
+ *             which frees them, as ITTI senders and receivers do
+ *
+ * Usage: memory_pools_bench [max_threads] [ops_per_thread]
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "memory_pools.h"
+#include "intertask_interface_conf.h"
+
+#define BENCH_DEFAULT_MAX_THREADS 16
+#define BENCH_DEFAULT_OPS_PER_THREAD 2000000
+#define BENCH_BURST 8
+#define BENCH_RING_SIZE 256
+
+/* Single producer, single consumer ring linking two benchmark threads */
+typedef struct bench_ring_s {
+  volatile uint32_t head __attribute__((aligned(64)));
+  volatile uint32_t tail __attribute__((aligned(64)));
+  memory_pool_item_handle_t items[BENCH_RING_SIZE];
+} bench_ring_t;
+
+typedef struct bench_thread_s {
+  pthread_t thread;
+  int id;
+  bool handoff;
+  size_t nb_ops;
+  bench_ring_t *in;
+  bench_ring_t *out;
+  volatile bool done;
+  struct bench_thread_s *producer;
+} bench_thread_t;
+
+static memory_pools_handle_t bench_pools;
+static pthread_barrier_t bench_barrier;
+
+/* Message sizes in the range ITTI allocates most */
+static const uint32_t bench_sizes[] = {40, 90, 400, 900};
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static bool _bench_ring_push(
+  bench_ring_t *ring,
+  memory_pool_item_handle_t item)
+{
+  uint32_t head = ring->head;
+
+  if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == BENCH_RING_SIZE)
+    return false;
+  ring->items[head % BENCH_RING_SIZE] = item;
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+static memory_pool_item_handle_t _bench_ring_pop(bench_ring_t *ring)
+{
+  uint32_t tail = ring->tail;
+  memory_pool_item_handle_t item;
+
+  if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) return NULL;
+  item = ring->items[tail % BENCH_RING_SIZE];
+  __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+  return item;
+}
+
+static memory_pool_item_handle_t _bench_alloc(bench_thread_t *bench, size_t i)
+{
+  memory_pool_item_handle_t item = memory_pools_allocate(
+    bench_pools, bench_sizes[i % 4], bench->id, bench->id);
+
+  if (item == NULL) {
+    fprintf(stderr, "Thread %d: allocation %zu failed\n", bench->id, i);
+    exit(EXIT_FAILURE);
+  }
+  return item;
+}
+
+static void _bench_drain(bench_thread_t *bench)
+{
+  memory_pool_item_handle_t item;
+
+  while ((item = _bench_ring_pop(bench->in)) != NULL) {
+    memory_pools_free(bench_pools, item, bench->id);
+  }
+}
+
+static void *_bench_thread(void *arg)
+{
+  bench_thread_t *bench = arg;
+  memory_pool_item_handle_t burst[BENCH_BURST];
+
+  pthread_barrier_wait(&bench_barrier);
+  if (!bench->handoff) {
+    for (size_t i = 0; i < bench->nb_ops; i += BENCH_BURST) {
+      for (int j = 0; j < BENCH_BURST; j++) {
+        burst[j] = _bench_alloc(bench, i + j);
+      }
+      for (int j = 0; j < BENCH_BURST; j++) {
+        memory_pools_free(bench_pools, burst[j], bench->id);
+      }
+    }
+  } else {
+    for (size_t i = 0; i < bench->nb_ops; i++) {
+      memory_pool_item_handle_t item = _bench_alloc(bench, i);
+
+      while (!_bench_ring_push(bench->out, item)) {
+        _bench_drain(bench);
+        sched_yield();
+      }
+      _bench_drain(bench);
+    }
+    __atomic_store_n(&bench->done, true, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&bench->producer->done, __ATOMIC_ACQUIRE)) {
+      _bench_drain(bench);
+      sched_yield();
+    }
+    _bench_drain(bench);
+  }
+  pthread_barrier_wait(&bench_barrier);
+  return NULL;
+}
+
+static void _bench_run(int nb_threads, bool handoff, size_t nb_ops)
+{
+  bench_thread_t *threads = calloc(nb_threads, sizeof(bench_thread_t));
+  bench_ring_t *rings = NULL;
+  uint64_t start;
+  uint64_t ns;
+
+  if (
+    handoff &&
+    posix_memalign((void **) &rings, 64, nb_threads * sizeof(*rings)) != 0) {
+    exit(EXIT_FAILURE);
+  }
+  if (rings) memset(rings, 0, nb_threads * sizeof(*rings));
+  pthread_barrier_init(&bench_barrier, NULL, nb_threads + 1);
+  for (int i = 0; i < nb_threads; i++) {
+    threads[i].id = i;
+    threads[i].handoff = handoff;
+    threads[i].nb_ops = nb_ops;
+    if (handoff) {
+      // Thread i frees what thread i - 1 allocated
+      threads[i].out = &rings[i];
+      threads[i].in = &rings[(i + nb_threads - 1) % nb_threads];
+      threads[i].producer = &threads[(i + nb_threads - 1) % nb_threads];
+    }
+    pthread_create(&threads[i].thread, NULL, _bench_thread, &threads[i]);
+  }
+  pthread_barrier_wait(&bench_barrier);
+  start = _bench_now_ns();
+  pthread_barrier_wait(&bench_barrier);
+  ns = _bench_now_ns() - start;
+  for (int i = 0; i < nb_threads; i++) {
+    pthread_join(threads[i].thread, NULL);
+  }
+  pthread_barrier_destroy(&bench_barrier);
+  printf(
+    "%-8s %2d threads %10.2f Mops/s %8.1f ns/op\n",
+    handoff ? "handoff" : "local",
+    nb_threads,
+    (double) nb_ops * nb_threads * 1e3 / ns,
+    (double) ns / nb_ops);
+  free(rings);
+  free(threads);
+}
+
+int main(int argc, char **argv)
+{
+  int max_threads = BENCH_DEFAULT_MAX_THREADS;
+  size_t nb_ops = BENCH_DEFAULT_OPS_PER_THREAD;
+  char *statistics;
+
+  if (argc > 1) max_threads = atoi(argv[1]);
+  if (argc > 2) nb_ops = strtoul(argv[2], NULL, 10);
+  nb_ops -= nb_ops % BENCH_BURST;
+
+  // Same layout as the ITTI message pools
+  bench_pools = memory_pools_create(5);
+  memory_pools_add_pool(bench_pools, 1000 + ITTI_QUEUE_MAX_ELEMENTS, 50);
+  memory_pools_add_pool(bench_pools, 1000 + (2 * ITTI_QUEUE_MAX_ELEMENTS), 100);
+  memory_pools_add_pool(bench_pools, 10000, 1000);
+  memory_pools_add_pool(bench_pools, 400, 20050);
+  memory_pools_add_pool(bench_pools, 100, 30050);
+
+  for (int handoff = 0; handoff < 2; handoff++) {
+    for (int nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+      _bench_run(nb_threads, handoff, nb_ops);
+    }
+  }
+
+  statistics = memory_pools_statistics(bench_pools);
+  printf("%s", statistics);
+  free(statistics);
+  return EXIT_SUCCESS;
+}
@@ -41,6 +41,7 @@
 #include <malloc.h>
 #include <stdint.h>
 #include <sys/time.h>
+#include <poll.h>
 
 #include "assertions.h"
 #include "intertask_interface.h"
@@ -57,6 +58,7 @@
 
 #include "signals.h"
 #include "timer.h"
+#include "itti_free_defined_msg.h"
 #include "dynamic_memory_check.h"
 #include "shared_ts_log.h"
 #include "log.h"
@@ -89,13 +91,8 @@ typedef volatile enum task_state_s {
   TASK_STATE_MAX,
 } task_state_t;
 
-/* This list acts as a FIFO of messages received by tasks (RRC, NAS, ...) */
-typedef struct message_list_s {
-  MessageDef *msg; ///< Pointer to the message
-
-  message_number_t message_number; ///< Unique message number
-  uint32_t message_priority;       ///< Message priority
-} message_list_t;
+/* Task descriptors are written by every sender, keep them apart */
+#define ITTI_CACHE_LINE_SIZE 64
 
 typedef struct thread_desc_s {
   /*
@@ -112,20 +109,105 @@ typedef struct thread_desc_s {
    * The thread fd
    */
   int task_event_fd;
+
+  /*
+   * Metrics only, time the thread got its last messages and how many
+   */
+  uint64_t busy_since;
+  size_t busy_nb_msgs;
+
+  /*
+   * Only written by the thread itself, on a line of its own so that reading
+   * them from another thread does not slow it down
+   */
+  itti_task_counters_t counters __attribute__((aligned(ITTI_CACHE_LINE_SIZE)));
 } thread_desc_t;
 
+/* A pending priority level passed over that many times is served next */
+#define ITTI_PRIORITY_AGING_THRESHOLD 8
+
+typedef struct priority_queue_s {
+  /*
+   * FIFO of messages of one priority level, linked through
+   * MessageHeader.nextMessage so that enqueueing does not allocate
+   */
+  MessageDef *head;
+  MessageDef *tail;
+  uint32_t length;
+  /*
+   * Number of consecutive dequeues that skipped this non-empty level
+   */
+  uint32_t skipped;
+} priority_queue_t;
+
 typedef struct task_desc_s {
+  pthread_mutex_t queue_mutex;
   /*
-   * Queue of messages belonging to the task
+   * One FIFO per message priority level, index 0 is the highest priority
    */
-  struct lfds710_queue_bmm_state message_queue
-    __attribute__((aligned(LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
-  struct lfds710_queue_bmm_element *qbmme;
-} task_desc_t;
+  priority_queue_t queues[ITTI_PRIORITY_LEVELS];
+  uint32_t queue_length;
+} __attribute__((aligned(ITTI_CACHE_LINE_SIZE))) task_desc_t;
+
+/* Queue and thread of a worker other than the task thread */
+typedef struct task_worker_s {
+  task_desc_t task;
+  thread_desc_t thread;
+} __attribute__((aligned(ITTI_CACHE_LINE_SIZE))) task_worker_t;
+
+typedef struct task_workers_s {
+  /*
+   * Set once before the task is started, 0 or 1 for a single threaded task
+   */
+  uint32_t nb_workers;
+  itti_shard_fn_t shard;
+  /*
+   * Workers 1 to nb_workers - 1, worker 0 uses the task descriptors
+   */
+  task_worker_t *workers;
+  /*
+   * Index of the broadcast link of worker 1, following the links of the tasks
+   */
+  uint32_t first_link;
+} task_workers_t;
+
+/* Overload detection of a task, enabled by a non zero high watermark */
+typedef struct task_watermarks_s {
+  uint32_t high;
+  uint32_t low;
+  itti_overload_fn_t callback;
+  /*
+   * Messages pending in the queues of all the workers of the task, updated
+   * by every sender and receiver, may go below zero when messages queued
+   * before the watermarks were set are received
+   */
+  int32_t pending;
+  bool overloaded;
+} __attribute__((aligned(ITTI_CACHE_LINE_SIZE))) task_watermarks_t;
+
+/* Arguments of a worker thread, released by the worker once started */
+typedef struct worker_start_s {
+  task_id_t task_id;
+  uint32_t worker;
+  void *(*start_routine)(void *);
+  void *args_p;
+} worker_start_t;
+
+/*
+ * Shared part of a broadcast message: the same message is linked in the queue
+ * of every destination task, through its own link per task, and released by
+ * the last task that frees it.
+ */
+typedef struct itti_shared_msg_s {
+  uint32_t references;
+  MessageDef *next_message[];
+} itti_shared_msg_t;
 
 typedef struct itti_desc_s {
   thread_desc_t *threads;
   task_desc_t *tasks;
+  task_workers_t *task_workers;
+  task_watermarks_t *task_watermarks;
 
   /*
    * Current message number. Incremented every call to send_msg_to_task
@@ -135,6 +217,10 @@ typedef struct itti_desc_s {
   thread_id_t thread_max;
   task_id_t task_max;
   MessagesIds messages_id_max;
+  /*
+   * Number of broadcast links: one per task and one per extra worker
+   */
+  uint32_t link_max;
 
   bool thread_handling_signals;
   pthread_t thread_ref;
@@ -148,10 +234,29 @@ typedef struct itti_desc_s {
   volatile uint32_t ready_tasks;
 
   memory_pools_handle_t memory_pools_handle;
+
+  const itti_metrics_ops_t *metrics_ops;
 } itti_desc_t;
 
 static itti_desc_t itti_desc;
 
+/* Task and worker served by the calling thread, set when it gets ready */
+static __thread task_id_t itti_current_task_id = TASK_UNKNOWN;
+static __thread uint32_t itti_current_worker = 0;
+/* Counters of the calling thread, NULL on threads not serving a task */
+static __thread itti_task_counters_t *itti_current_counters = NULL;
+
+/* Counters are only written by their thread, readers load them relaxed */
+#define ITTI_COUNTER_ADD(cOUNTER, vALUE)                                       \
+  do {                                                                         \
+    if (itti_current_counters != NULL) {                                       \
+      __atomic_store_n(                                                        \
+        &itti_current_counters->cOUNTER,                                       \
+        itti_current_counters->cOUNTER + (vALUE),                              \
+        __ATOMIC_RELAXED);                                                     \
+    }                                                                          \
+  } while (0)
+
 /** \brief Alloc and memset(0) a new itti message.
  * \param origin_task_id Task ID of the sending task
  * \param message_id Message ID
@@ -163,12 +268,6 @@ MessageDef *itti_alloc_new_message_sized(
   MessagesIds message_id,
   MessageHeaderSize size);
 
-/** \brief Send a broadcast message to every task
- \param message_p Pointer to the message to send
- @returns < 0 on failure, 0 otherwise
- **/
-int itti_send_broadcast_message(MessageDef *message_p);
-
 void *itti_malloc(
   task_id_t origin_task_id,
   task_id_t destination_task_id,
@@ -178,6 +277,7 @@ void *itti_malloc(
 
   ptr = memory_pools_allocate(
     itti_desc.memory_pools_handle, size, origin_task_id, destination_task_id);
+  ITTI_COUNTER_ADD(bytes_allocated, size);
 
   if (ptr == NULL) {
     char *statistics = memory_pools_statistics(itti_desc.memory_pools_handle);
@@ -197,16 +297,106 @@ void *itti_malloc(
 
 void itti_free(task_id_t task_id, void *ptr)
 {
+  MessageDef *message = (MessageDef *) ptr;
+  itti_shared_msg_t *shared;
   int rc = EXIT_SUCCESS;
 
   if (ptr == NULL) return;
 
+  shared = message->ittiMsgHeader.shared;
+  if (shared != NULL) {
+    if (__atomic_sub_fetch(&shared->references, 1, __ATOMIC_ACQ_REL) > 0) {
+      return;
+    }
+    // Last reference, the message content can now be released too
+    message->ittiMsgHeader.shared = NULL;
+    free_wrapper((void **) &shared);
+    itti_free_msg_content(message);
+  }
+
   rc = memory_pools_free(itti_desc.memory_pools_handle, ptr, task_id);
 
   AssertFatal(
     rc == EXIT_SUCCESS, "Failed to free memory at %p (%d)\n", ptr, task_id);
 }
 
+// Queue link of message in the queue of the worker owning link
+static inline MessageDef *itti_get_next_msg(MessageDef *message, uint32_t link)
+{
+  itti_shared_msg_t *shared = message->ittiMsgHeader.shared;
+
+  return shared ? shared->next_message[link] :
+                  message->ittiMsgHeader.nextMessage;
+}
+
+static inline void itti_set_next_msg(
+  MessageDef *message,
+  uint32_t link,
+  MessageDef *next)
+{
+  itti_shared_msg_t *shared = message->ittiMsgHeader.shared;
+
+  if (shared) {
+    shared->next_message[link] = next;
+  } else {
+    message->ittiMsgHeader.nextMessage = next;
+  }
+}
+
+static inline uint32_t itti_get_nb_workers(task_id_t task_id)
+{
+  uint32_t nb_workers = __atomic_load_n(
+    &itti_desc.task_workers[task_id].nb_workers, __ATOMIC_ACQUIRE);
+
+  return nb_workers ? nb_workers : 1;
+}
+
+// Worker of task_id running on the calling thread, 0 if none
+static inline uint32_t itti_get_current_worker(task_id_t task_id)
+{
+  return (task_id == itti_current_task_id) ? itti_current_worker : 0;
+}
+
+static inline task_desc_t *itti_get_worker_task_desc(
+  task_id_t task_id,
+  uint32_t worker)
+{
+  if (worker == 0) return &itti_desc.tasks[task_id];
+  return &itti_desc.task_workers[task_id].workers[worker - 1].task;
+}
+
+static inline thread_desc_t *itti_get_worker_thread_desc(
+  task_id_t task_id,
+  uint32_t worker)
+{
+  if (worker == 0) return &itti_desc.threads[TASK_GET_THREAD_ID(task_id)];
+  return &itti_desc.task_workers[task_id].workers[worker - 1].thread;
+}
+
+static inline uint32_t itti_get_worker_link(task_id_t task_id, uint32_t worker)
+{
+  if (worker == 0) return task_id;
+  return itti_desc.task_workers[task_id].first_link + worker - 1;
+}
+
+static inline uint64_t itti_get_time_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline const itti_metrics_ops_t *itti_get_metrics_ops(void)
+{
+  return __atomic_load_n(&itti_desc.metrics_ops, __ATOMIC_ACQUIRE);
+}
+
+void itti_set_metrics_ops(const itti_metrics_ops_t *ops)
+{
+  __atomic_store_n(&itti_desc.metrics_ops, ops, __ATOMIC_RELEASE);
+}
+
 static inline message_number_t itti_increment_message_number(void)
 {
   /*
@@ -227,6 +417,31 @@ static inline uint32_t itti_get_message_priority(MessagesIds message_id)
   return (itti_desc.messages_info[message_id].priority);
 }
 
+// Map a message priority to a queue index, 0 being the highest priority
+static inline unsigned int itti_get_priority_level(uint32_t priority)
+{
+  if (priority >= MESSAGE_PRIORITY_MAX) return 0;
+  if (priority >= MESSAGE_PRIORITY_MAX_LEAST) return 1;
+  if (priority >= MESSAGE_PRIORITY_MED_PLUS) return 2;
+  if (priority >= MESSAGE_PRIORITY_MED) return 3;
+  if (priority >= MESSAGE_PRIORITY_MED_LEAST) return 4;
+  if (priority >= MESSAGE_PRIORITY_MIN_PLUS) return 5;
+  return 6;
+}
+
+const char *itti_get_priority_level_name(unsigned int level)
+{
+  static const char *const level_names[ITTI_PRIORITY_LEVELS] = {
+    "max", "max_least", "med_plus", "med", "med_least", "min_plus", "min"};
+
+  AssertFatal(
+    level < ITTI_PRIORITY_LEVELS,
+    "Priority level (%u) is out of range (%d)!\n",
+    level,
+    ITTI_PRIORITY_LEVELS);
+  return level_names[level];
+}
+
 const char *itti_get_message_name(MessagesIds message_id)
 {
   AssertFatal(
@@ -252,21 +467,9 @@ const char *itti_get_task_name(task_id_t task_id)
   return (itti_desc.tasks_info[task_id].name);
 }
 
-static task_id_t itti_get_current_task_id(void)
+task_id_t itti_get_current_task_id(void)
 {
-  task_id_t task_id;
-  thread_id_t thread_id;
-  pthread_t thread = pthread_self();
-
-  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
-    thread_id = TASK_GET_THREAD_ID(task_id);
-
-    if (itti_desc.threads[thread_id].task_thread == thread) {
-      return task_id;
-    }
-  }
-
-  return TASK_UNKNOWN;
+  return itti_current_task_id;
 }
 
 int itti_send_broadcast_message(MessageDef *message_p)
@@ -275,49 +478,65 @@ int itti_send_broadcast_message(MessageDef *message_p)
   task_id_t origin_task_id;
   thread_id_t origin_thread_id;
   uint32_t thread_id;
+  task_id_t destination_task_ids[THREAD_MAX];
+  uint32_t nb_destinations = 0;
+  uint32_t nb_references = 0;
+  itti_shared_msg_t *shared;
   int ret = 0;
   int result;
 
   AssertFatal(message_p != NULL, "Trying to broadcast a NULL message!\n");
+  AssertFatal(
+    !ITTI_MSG_SHARED(message_p), "Trying to broadcast a shared message!\n");
   origin_task_id = message_p->ittiMsgHeader.originTaskId;
   origin_thread_id = TASK_GET_THREAD_ID(origin_task_id);
   destination_task_id = TASK_FIRST;
 
   for (thread_id = THREAD_FIRST; thread_id < itti_desc.thread_max;
        thread_id++) {
-    MessageDef *new_message_p;
-
     while (thread_id != TASK_GET_THREAD_ID(destination_task_id)) {
       destination_task_id++;
     }
 
     /*
-     * Skip task that broadcast the message
+     * Skip task that broadcast the message and tasks which are not running
      */
-    if (thread_id != origin_thread_id) {
-      /*
-       * Skip tasks which are not running
-       */
-      if (itti_desc.threads[thread_id].task_state == TASK_STATE_READY) {
-        size_t size =
-          sizeof(MessageHeader) + message_p->ittiMsgHeader.ittiMsgSize;
-
-        new_message_p = itti_malloc(origin_task_id, destination_task_id, size);
-        AssertFatal(new_message_p != NULL, "New message allocation failed!\n");
-        memcpy(new_message_p, message_p, size);
-        result = itti_send_msg_to_task(
-          destination_task_id, INSTANCE_DEFAULT, new_message_p);
-        AssertFatal(
-          result >= 0,
-          "Failed to send message %d to thread %d (task %d)!\n",
-          message_p->ittiMsgHeader.messageId,
-          thread_id,
-          destination_task_id);
-      }
+    if (
+      thread_id != origin_thread_id &&
+      itti_desc.threads[thread_id].task_state == TASK_STATE_READY) {
+      destination_task_ids[nb_destinations++] = destination_task_id;
+      nb_references += itti_get_nb_workers(destination_task_id);
     }
   }
 
-  itti_free(ITTI_MSG_ORIGIN_ID(message_p), message_p);
+  if (nb_destinations == 0) {
+    itti_free(ITTI_MSG_ORIGIN_ID(message_p), message_p);
+    return ret;
+  }
+
+  /*
+   * Every destination worker gets the same message, the references are taken
+   * before the first send as the destination tasks may release it at once
+   */
+  shared = calloc(
+    1, sizeof(itti_shared_msg_t) + itti_desc.link_max * sizeof(MessageDef *));
+  AssertFatal(shared != NULL, "Shared message allocation failed!\n");
+  shared->references = nb_references;
+  message_p->ittiMsgHeader.destinationTaskId = TASK_UNKNOWN;
+  message_p->ittiMsgHeader.instance = INSTANCE_DEFAULT;
+  message_p->ittiMsgHeader.enqueueTime =
+    itti_get_metrics_ops() ? itti_get_time_ns() : 0;
+  message_p->ittiMsgHeader.shared = shared;
+
+  for (uint32_t i = 0; i < nb_destinations; i++) {
+    result = itti_send_msg_to_task(
+      destination_task_ids[i], INSTANCE_DEFAULT, message_p);
+    AssertFatal(
+      result >= 0,
+      "Failed to send message %d to task %d!\n",
+      ITTI_MSG_ID(message_p),
+      destination_task_ids[i]);
+  }
 
   return ret;
 }
@@ -363,6 +582,102 @@ MessageDef *itti_alloc_new_message(
     origin_task_id, message_id, itti_desc.messages_info[message_id].size);
 }
 
+// Worker of task_id handling message
+static inline uint32_t itti_route_msg(
+  task_id_t task_id,
+  const MessageDef *message)
+{
+  const task_workers_t *task_workers = &itti_desc.task_workers[task_id];
+  uint32_t nb_workers = itti_get_nb_workers(task_id);
+
+  if (nb_workers == 1) return 0;
+  return task_workers->shard(message) % nb_workers;
+}
+
+/*
+ * Account for nb_msgs messages queued for task_id, or dequeued when negative,
+ * and report the task overload transitions
+ */
+static void itti_account_pending_msgs(task_id_t task_id, int32_t nb_msgs)
+{
+  task_watermarks_t *watermarks = &itti_desc.task_watermarks[task_id];
+  int32_t pending;
+  bool overloaded;
+  bool expected;
+
+  if (__atomic_load_n(&watermarks->high, __ATOMIC_RELAXED) == 0) return;
+  pending =
+    __atomic_add_fetch(&watermarks->pending, nb_msgs, __ATOMIC_RELAXED);
+  if (pending >= (int32_t) watermarks->high) {
+    overloaded = true;
+  } else if (pending <= (int32_t) watermarks->low) {
+    overloaded = false;
+  } else {
+    return;
+  }
+  /*
+   * Only the thread switching the state reports it, callbacks of concurrent
+   * transitions may run in any order, the callback reads the current state
+   * with itti_is_task_overloaded()
+   */
+  expected = !overloaded;
+  if (
+    __atomic_load_n(&watermarks->overloaded, __ATOMIC_RELAXED) == expected &&
+    __atomic_compare_exchange_n(
+      &watermarks->overloaded,
+      &expected,
+      overloaded,
+      false,
+      __ATOMIC_ACQ_REL,
+      __ATOMIC_RELAXED)) {
+    watermarks->callback(task_id, overloaded);
+  }
+}
+
+// Append message to the queue of a worker of task_id and wake it up
+static void itti_enqueue_msg(
+  task_id_t task_id,
+  uint32_t worker,
+  uint32_t priority,
+  MessageDef *message)
+{
+  task_desc_t *task_desc = itti_get_worker_task_desc(task_id, worker);
+  priority_queue_t *queue =
+    &task_desc->queues[itti_get_priority_level(priority)];
+  uint32_t link = itti_get_worker_link(task_id, worker);
+  bool was_empty;
+
+  itti_set_next_msg(message, link, NULL);
+  pthread_mutex_lock(&task_desc->queue_mutex);
+  if (queue->tail == NULL) {
+    queue->head = message;
+  } else {
+    itti_set_next_msg(queue->tail, link, message);
+  }
+  queue->tail = message;
+  queue->length++;
+  was_empty = (task_desc->queue_length++ == 0);
+  pthread_mutex_unlock(&task_desc->queue_mutex);
+  itti_account_pending_msgs(task_id, 1);
+
+  /*
+   * Only use event fd for tasks, subtasks will pool the queue. The receiver
+   * drains the whole queue on each wake up, so it only needs to be woken up
+   * when the queue goes from empty to non-empty.
+   */
+  if (was_empty && TASK_GET_PARENT_TASK_ID(task_id) == TASK_UNKNOWN) {
+    int write_ret = eventfd_write(
+      itti_get_worker_thread_desc(task_id, worker)->task_event_fd, 1);
+
+    AssertFatal(
+      write_ret == 0,
+      "Write to task message FD (%d.%u) failed (%s)\n",
+      TASK_GET_THREAD_ID(task_id),
+      worker,
+      strerror(errno));
+  }
+}
+
 int itti_send_msg_to_task(
   task_id_t destination_task_id,
   instance_t instance,
@@ -370,7 +685,6 @@ int itti_send_msg_to_task(
 {
   thread_id_t destination_thread_id;
   task_id_t origin_task_id;
-  message_list_t *new;
   uint32_t priority;
   message_number_t message_number;
   uint32_t message_id;
@@ -382,8 +696,6 @@ int itti_send_msg_to_task(
     destination_task_id,
     itti_desc.task_max);
   destination_thread_id = TASK_GET_THREAD_ID(destination_task_id);
-  message->ittiMsgHeader.destinationTaskId = destination_task_id;
-  message->ittiMsgHeader.instance = instance;
   message_id = message->ittiMsgHeader.messageId;
   AssertFatal(
     message_id < itti_desc.messages_id_max,
@@ -392,6 +704,16 @@ int itti_send_msg_to_task(
     itti_desc.messages_id_max);
   origin_task_id = ITTI_MSG_ORIGIN_ID(message);
   priority = itti_get_message_priority(message_id);
+  /*
+   * A shared message may already be read by other destinations, its header
+   * is set once by itti_send_broadcast_message()
+   */
+  if (!ITTI_MSG_SHARED(message)) {
+    message->ittiMsgHeader.destinationTaskId = destination_task_id;
+    message->ittiMsgHeader.instance = instance;
+    message->ittiMsgHeader.enqueueTime =
+      itti_get_metrics_ops() ? itti_get_time_ns() : 0;
+  }
   /*
    * Increment the global message number
    */
@@ -413,9 +735,17 @@ int itti_send_msg_to_task(
         itti_get_task_name(origin_task_id),
         destination_task_id,
         itti_get_task_name(destination_task_id));
-      itti_free(
-        origin_task_id,
-        message); // In case of issues free the memory allocated for message
+      /*
+       * In case of issues free the memory allocated for message. A shared
+       * message holds a reference for each worker of the destination.
+       */
+      uint32_t nb_references =
+        ITTI_MSG_SHARED(message) ? itti_get_nb_workers(destination_task_id) :
+                                   1;
+
+      for (uint32_t i = 0; i < nb_references; i++) {
+        itti_free(origin_task_id, message);
+      }
     } else {
       /*
        * We cannot send a message if the task is not running
@@ -431,43 +761,23 @@ int itti_send_msg_to_task(
         destination_thread_id,
         itti_desc.threads[destination_thread_id].task_state);
       /*
-       * Allocate new list element
-       */
-      new = (message_list_t *) itti_malloc(
-        origin_task_id, destination_task_id, sizeof(struct message_list_s));
-      /*
-       * Fill in members
+       * A shared message is received by every worker of the task, any other
+       * message by the worker owning its shard
        */
-      new->msg = message;
-      new->message_number = message_number;
-      new->message_priority = priority;
-      /*
-       * Enqueue message in destination task queue
-       */
-      lfds710_queue_bmm_enqueue(
-        &itti_desc.tasks[destination_task_id].message_queue, NULL, new);
+      if (ITTI_MSG_SHARED(message)) {
+        uint32_t nb_workers = itti_get_nb_workers(destination_task_id);
 
-      /*
-        * Only use event fd for tasks, subtasks will pool the queue
-        */
-      if (TASK_GET_PARENT_TASK_ID(destination_task_id) == TASK_UNKNOWN) {
-        ssize_t write_ret;
-        eventfd_t sem_counter = 1;
-
-        /*
-          * Call to write for an event fd must be of 8 bytes
-          */
-        write_ret = write(
-          itti_desc.threads[destination_thread_id].task_event_fd,
-          &sem_counter,
-          sizeof(sem_counter));
-        AssertFatal(
-          write_ret == sizeof(sem_counter),
-          "Write to task message FD (%d) failed (%d/%d)\n",
-          destination_thread_id,
-          (int) write_ret,
-          (int) sizeof(sem_counter));
+        for (uint32_t worker = 0; worker < nb_workers; worker++) {
+          itti_enqueue_msg(destination_task_id, worker, priority, message);
+        }
+      } else {
+        itti_enqueue_msg(
+          destination_task_id,
+          itti_route_msg(destination_task_id, message),
+          priority,
+          message);
       }
+      ITTI_COUNTER_ADD(msgs_sent, 1);
 
       ITTI_DEBUG(
         ITTI_DEBUG_SEND,
@@ -490,49 +800,302 @@ int itti_send_msg_to_task(
   return 0;
 }
 
-void itti_receive_msg(task_id_t task_id, MessageDef **received_msg)
+/*
+ * Pick the queue to serve next: the highest non-empty priority level, unless a
+ * lower level has been passed over ITTI_PRIORITY_AGING_THRESHOLD times in a
+ * row, in which case the most starved one is served so that a steady flow of
+ * high priority messages cannot starve the others.
+ * Must be called with the task queue mutex held and a non-empty queue.
+ */
+static priority_queue_t *itti_select_queue(task_desc_t *task_desc)
 {
-  thread_id_t thread_id;
-  struct message_list_s *message = NULL;
+  priority_queue_t *selected = NULL;
+  priority_queue_t *starved = NULL;
+
+  for (int level = 0; level < ITTI_PRIORITY_LEVELS; level++) {
+    priority_queue_t *queue = &task_desc->queues[level];
+
+    if (queue->head == NULL) continue;
+    if (selected == NULL) {
+      selected = queue;
+    } else if (
+      queue->skipped >= ITTI_PRIORITY_AGING_THRESHOLD &&
+      (starved == NULL || queue->skipped > starved->skipped)) {
+      starved = queue;
+    }
+  }
+  if (starved != NULL) {
+    selected = starved;
+  }
+
+  for (int level = 0; level < ITTI_PRIORITY_LEVELS; level++) {
+    priority_queue_t *queue = &task_desc->queues[level];
+
+    if (queue == selected) {
+      queue->skipped = 0;
+    } else if (queue->head != NULL) {
+      queue->skipped++;
+    }
+  }
+  return selected;
+}
+
+// Dequeue up to max messages from the worker queues, without blocking
+static size_t itti_dequeue_msgs(
+  task_id_t task_id,
+  uint32_t worker,
+  MessageDef **received_msgs,
+  size_t max)
+{
+  task_desc_t *task_desc = itti_get_worker_task_desc(task_id, worker);
+  uint32_t link = itti_get_worker_link(task_id, worker);
+  const itti_metrics_ops_t *metrics_ops;
+  uint32_t queue_depth;
+  size_t nb_msgs = 0;
+
+  pthread_mutex_lock(&task_desc->queue_mutex);
+  queue_depth = task_desc->queue_length;
+  while (nb_msgs < max && task_desc->queue_length > 0) {
+    priority_queue_t *queue = itti_select_queue(task_desc);
+    MessageDef *message = queue->head;
+
+    queue->head = itti_get_next_msg(message, link);
+    if (queue->head == NULL) {
+      queue->tail = NULL;
+    }
+    queue->length--;
+    task_desc->queue_length--;
+    itti_set_next_msg(message, link, NULL);
+    received_msgs[nb_msgs++] = message;
+  }
+  pthread_mutex_unlock(&task_desc->queue_mutex);
+  ITTI_COUNTER_ADD(msgs_received, nb_msgs);
+  if (nb_msgs > 0) {
+    itti_account_pending_msgs(task_id, -(int32_t) nb_msgs);
+  }
+
+  metrics_ops = itti_get_metrics_ops();
+  if (metrics_ops && nb_msgs > 0) {
+    thread_desc_t *thread_desc = itti_get_worker_thread_desc(task_id, worker);
+    uint64_t now = itti_get_time_ns();
+
+    for (size_t i = 0; i < nb_msgs; i++) {
+      MessageDef *message = received_msgs[i];
+      uint64_t enqueue_time = message->ittiMsgHeader.enqueueTime;
+
+      // Messages queued before metrics were enabled are not stamped
+      if (enqueue_time != 0 && metrics_ops->msg_latency) {
+        metrics_ops->msg_latency(
+          task_id, ITTI_MSG_ID(message), (now - enqueue_time) / 1000.0);
+      }
+    }
+    if (metrics_ops->queue_depth) {
+      metrics_ops->queue_depth(task_id, queue_depth);
+    }
+    thread_desc->busy_since = now;
+    thread_desc->busy_nb_msgs = nb_msgs;
+  }
+  return nb_msgs;
+}
+
+/*
+ * Called when a task comes back for more messages: the time elapsed since it
+ * got its previous batch was spent in its handlers
+ */
+static void itti_account_handler_time(task_id_t task_id, uint32_t worker)
+{
+  thread_desc_t *thread_desc = itti_get_worker_thread_desc(task_id, worker);
+  const itti_metrics_ops_t *metrics_ops = itti_get_metrics_ops();
+
+  if (thread_desc->busy_since == 0) return;
+  if (metrics_ops && metrics_ops->handler_time) {
+    metrics_ops->handler_time(
+      task_id,
+      thread_desc->busy_nb_msgs,
+      (itti_get_time_ns() - thread_desc->busy_since) / 1000.0);
+  }
+  thread_desc->busy_since = 0;
+}
+
+size_t itti_receive_msgs(
+  task_id_t task_id,
+  MessageDef **received_msgs,
+  size_t max)
+{
+  uint32_t worker;
+  int event_fd;
+  size_t nb_msgs;
+
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(received_msgs != NULL, "Received messages array is NULL!\n");
+  AssertFatal(max > 0, "Cannot receive less than one message!\n");
+
+  worker = itti_get_current_worker(task_id);
+  event_fd = itti_get_worker_thread_desc(task_id, worker)->task_event_fd;
+  itti_account_handler_time(task_id, worker);
+
+  while ((nb_msgs = itti_dequeue_msgs(task_id, worker, received_msgs, max)) ==
+         0) {
+    struct pollfd pfd = {
+      .fd = event_fd,
+      .events = POLLIN,
+    };
+    eventfd_t sem_counter;
+
+    /*
+     * Queue is empty, wait for a sender to signal it is no longer empty
+     */
+    if (poll(&pfd, 1, -1) < 0) {
+      AssertFatal(
+        errno == EINTR,
+        "Poll on task message FD (%d.%u) failed (%s)!\n",
+        TASK_GET_THREAD_ID(task_id),
+        worker,
+        strerror(errno));
+      continue;
+    }
+    eventfd_read(pfd.fd, &sem_counter);
+  }
+  return nb_msgs;
+}
+
+size_t itti_poll_msgs(
+  task_id_t task_id,
+  MessageDef **received_msgs,
+  size_t max)
+{
+  uint32_t worker;
   eventfd_t sem_counter;
-  ssize_t n_read;
 
   AssertFatal(
     task_id < itti_desc.task_max,
     "Task id (%d) is out of range (%d)!\n",
     task_id,
     itti_desc.task_max);
+  AssertFatal(received_msgs != NULL, "Received messages array is NULL!\n");
+  worker = itti_get_current_worker(task_id);
+  itti_account_handler_time(task_id, worker);
+
+  /*
+   * Clear the event before looking at the queue, any message enqueued after
+   * the queue has been drained signals the event fd again
+   */
+  eventfd_read(
+    itti_get_worker_thread_desc(task_id, worker)->task_event_fd, &sem_counter);
+  return itti_dequeue_msgs(task_id, worker, received_msgs, max);
+}
+
+void itti_receive_msg(task_id_t task_id, MessageDef **received_msg)
+{
   AssertFatal(received_msg != NULL, "Received message is NULL!\n");
 
-  thread_id = TASK_GET_THREAD_ID(task_id);
-  *received_msg = NULL;
+  itti_receive_msgs(task_id, received_msg, 1);
+}
+
+void itti_get_queue_depths(
+  task_id_t task_id,
+  uint32_t depths[ITTI_PRIORITY_LEVELS])
+{
+  uint32_t nb_workers;
 
-  n_read = read(
-    itti_desc.threads[thread_id].task_event_fd,
-    &sem_counter,
-    sizeof(sem_counter));
   AssertFatal(
-    n_read == sizeof(sem_counter),
-    "Read from task message FD (%d) failed (%zu/%zu)!\n",
-    thread_id,
-    n_read,
-    sizeof(sem_counter));
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  memset(depths, 0, ITTI_PRIORITY_LEVELS * sizeof(depths[0]));
+  nb_workers = itti_get_nb_workers(task_id);
+  for (uint32_t worker = 0; worker < nb_workers; worker++) {
+    task_desc_t *task_desc = itti_get_worker_task_desc(task_id, worker);
+
+    pthread_mutex_lock(&task_desc->queue_mutex);
+    for (int level = 0; level < ITTI_PRIORITY_LEVELS; level++) {
+      depths[level] += task_desc->queues[level].length;
+    }
+    pthread_mutex_unlock(&task_desc->queue_mutex);
+  }
+}
 
-  if (
-    lfds710_queue_bmm_dequeue(
-      &itti_desc.tasks[task_id].message_queue, NULL, (void **) &message) == 0) {
-    OAILOG_WARNING(LOG_ITTI,
-      "No message in queue for task %d while there are %zu and some "
-      "for the messages queue!\n",
-      task_id,
-      sem_counter);
+void itti_get_task_counters(task_id_t task_id, itti_task_counters_t *counters)
+{
+  uint32_t nb_workers;
+
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(counters != NULL, "Counters are NULL!\n");
+  memset(counters, 0, sizeof(*counters));
+  nb_workers = itti_get_nb_workers(task_id);
+  for (uint32_t worker = 0; worker < nb_workers; worker++) {
+    const itti_task_counters_t *worker_counters =
+      &itti_get_worker_thread_desc(task_id, worker)->counters;
+
+    counters->msgs_sent +=
+      __atomic_load_n(&worker_counters->msgs_sent, __ATOMIC_RELAXED);
+    counters->msgs_received +=
+      __atomic_load_n(&worker_counters->msgs_received, __ATOMIC_RELAXED);
+    counters->bytes_allocated +=
+      __atomic_load_n(&worker_counters->bytes_allocated, __ATOMIC_RELAXED);
   }
+}
 
-  AssertFatal(message != NULL, "Message from message queue is NULL!\n");
+void itti_set_queue_watermarks(
+  task_id_t task_id,
+  uint32_t high,
+  uint32_t low,
+  itti_overload_fn_t callback)
+{
+  task_watermarks_t *watermarks;
 
-  *received_msg = message->msg;
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(
+    high == 0 || (low < high && callback != NULL),
+    "Task %s watermarks must have low (%u) < high (%u) and a callback!\n",
+    itti_get_task_name(task_id),
+    low,
+    high);
+  AssertFatal(
+    itti_desc.threads[TASK_GET_THREAD_ID(task_id)].task_state ==
+      TASK_STATE_NOT_CONFIGURED,
+    "Task %s watermarks must be set before the task is created!\n",
+    itti_get_task_name(task_id));
+
+  watermarks = &itti_desc.task_watermarks[task_id];
+  watermarks->low = low;
+  watermarks->callback = callback;
+  __atomic_store_n(&watermarks->high, high, __ATOMIC_RELEASE);
+}
+
+bool itti_is_task_overloaded(task_id_t task_id)
+{
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  return __atomic_load_n(
+    &itti_desc.task_watermarks[task_id].overloaded, __ATOMIC_ACQUIRE);
+}
 
-  itti_free(ITTI_MSG_ORIGIN_ID(message->msg), message);
+int itti_get_task_event_fd(task_id_t task_id)
+{
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  return itti_get_worker_thread_desc(task_id, itti_get_current_worker(task_id))
+    ->task_event_fd;
 }
 
 int itti_create_task(
@@ -588,9 +1151,143 @@ int itti_create_task(
   return 0;
 }
 
+static void *itti_worker_start(void *args_p)
+{
+  worker_start_t start = *(worker_start_t *) args_p;
+
+  free_wrapper(&args_p);
+  itti_current_task_id = start.task_id;
+  itti_current_worker = start.worker;
+  return start.start_routine(start.args_p);
+}
+
+int itti_create_task_workers(
+  task_id_t task_id,
+  void *(*start_routine)(void *),
+  void *args_p,
+  uint32_t nb_workers,
+  itti_shard_fn_t shard)
+{
+  task_workers_t *task_workers;
+  int result = 0;
+
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  AssertFatal(
+    nb_workers > 0 && nb_workers <= ITTI_TASK_WORKERS_MAX,
+    "Task %s cannot run %u workers (max %d)!\n",
+    itti_get_task_name(task_id),
+    nb_workers,
+    ITTI_TASK_WORKERS_MAX);
+  AssertFatal(
+    nb_workers == 1 || shard != NULL,
+    "Task %s needs a shard function to run %u workers!\n",
+    itti_get_task_name(task_id),
+    nb_workers);
+  AssertFatal(
+    TASK_GET_PARENT_TASK_ID(task_id) == TASK_UNKNOWN,
+    "Sub-task %s cannot run several workers!\n",
+    itti_get_task_name(task_id));
+
+  if (nb_workers == 1) {
+    return itti_create_task(task_id, start_routine, args_p);
+  }
+
+  /*
+   * The queues of all workers exist before the task is started: messages
+   * routed to a worker that is not running yet wait in its queue
+   */
+  task_workers = &itti_desc.task_workers[task_id];
+  AssertFatal(
+    task_workers->workers == NULL,
+    "Task %s workers already created!\n",
+    itti_get_task_name(task_id));
+  task_workers->workers = memalign(
+    ITTI_CACHE_LINE_SIZE, (nb_workers - 1) * sizeof(task_worker_t));
+  AssertFatal(
+    task_workers->workers != NULL,
+    "Task %s workers allocation failed!\n",
+    itti_get_task_name(task_id));
+  memset(task_workers->workers, 0, (nb_workers - 1) * sizeof(task_worker_t));
+  for (uint32_t worker = 1; worker < nb_workers; worker++) {
+    task_worker_t *task_worker = &task_workers->workers[worker - 1];
+
+    pthread_mutex_init(&task_worker->task.queue_mutex, NULL);
+    task_worker->thread.task_state = TASK_STATE_NOT_CONFIGURED;
+    task_worker->thread.task_event_fd = eventfd(0, EFD_NONBLOCK);
+    if (task_worker->thread.task_event_fd == -1) {
+      Fatal("eventfd failed: %s!\n", strerror(errno));
+    }
+  }
+  task_workers->shard = shard;
+  task_workers->first_link = itti_desc.link_max;
+  itti_desc.link_max += nb_workers - 1;
+  __atomic_store_n(&task_workers->nb_workers, nb_workers, __ATOMIC_RELEASE);
+
+  result = itti_create_task(task_id, start_routine, args_p);
+  if (result < 0) return result;
+
+  for (uint32_t worker = 1; worker < nb_workers; worker++) {
+    thread_desc_t *thread_desc = itti_get_worker_thread_desc(task_id, worker);
+    worker_start_t *start = calloc(1, sizeof(worker_start_t));
+    char name[16];
+
+    AssertFatal(start != NULL, "Worker start allocation failed!\n");
+    start->task_id = task_id;
+    start->worker = worker;
+    start->start_routine = start_routine;
+    start->args_p = args_p;
+    thread_desc->task_state = TASK_STATE_STARTING;
+
+    ITTI_DEBUG(
+      ITTI_DEBUG_INIT,
+      " Creating worker %u for task %s ...\n",
+      worker,
+      itti_get_task_name(task_id));
+
+    result = pthread_create(
+      &thread_desc->task_thread, NULL, itti_worker_start, start);
+    AssertFatal(
+      result == 0,
+      "Worker %u creation for task %d failed (%d)!\n",
+      worker,
+      task_id,
+      result);
+    // Worker 0 is joined on exit, the others are not waited for
+    pthread_detach(thread_desc->task_thread);
+    snprintf(
+      name, sizeof(name), "ITTI %d.%u", TASK_GET_THREAD_ID(task_id), worker);
+    pthread_setname_np(thread_desc->task_thread, name);
+
+    while (thread_desc->task_state != TASK_STATE_READY)
+      usleep(1000);
+  }
+
+  return 0;
+}
+
+uint32_t itti_get_task_nb_workers(task_id_t task_id)
+{
+  AssertFatal(
+    task_id < itti_desc.task_max,
+    "Task id (%d) is out of range (%d)!\n",
+    task_id,
+    itti_desc.task_max);
+  return itti_get_nb_workers(task_id);
+}
+
+uint32_t itti_get_task_worker(task_id_t task_id)
+{
+  return itti_get_current_worker(task_id);
+}
+
 void itti_mark_task_ready(task_id_t task_id)
 {
   thread_id_t thread_id = TASK_GET_THREAD_ID(task_id);
+  uint32_t worker = itti_get_current_worker(task_id);
 
   AssertFatal(
     thread_id < itti_desc.thread_max,
@@ -599,9 +1296,25 @@ void itti_mark_task_ready(task_id_t task_id)
     itti_desc.thread_max);
 
   /*
-   * Mark the thread as using LFDS queue
+   * Called by the task thread itself: from now on it is identified and counts
+   * its messages without looking up its descriptors
    */
-  LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
+  itti_current_task_id = task_id;
+  itti_current_worker = worker;
+  itti_current_counters =
+    &itti_get_worker_thread_desc(task_id, worker)->counters;
+
+  if (worker != 0) {
+    itti_get_worker_thread_desc(task_id, worker)->task_state =
+      TASK_STATE_READY;
+    ITTI_DEBUG(
+      ITTI_DEBUG_INIT,
+      " task %s worker %u started\n",
+      itti_get_task_name(task_id),
+      worker);
+    return;
+  }
+
   itti_desc.threads[thread_id].task_state = TASK_STATE_READY;
   itti_desc.ready_tasks++;
 
@@ -638,6 +1351,7 @@ int itti_init(
    * Saves threads and messages max values
    */
   itti_desc.task_max = task_max;
+  itti_desc.link_max = task_max;
   itti_desc.thread_max = thread_max;
   itti_desc.messages_id_max = messages_id_max;
   itti_desc.thread_handling_signals = false;
@@ -647,13 +1361,24 @@ int itti_init(
    * Allocates memory for tasks info
    */
   itti_desc.tasks = memalign(
-    LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES,
+    ITTI_CACHE_LINE_SIZE,
     itti_desc.task_max * sizeof(task_desc_t));
   memset(itti_desc.tasks, 0, itti_desc.task_max * sizeof(task_desc_t));
+  itti_desc.task_workers = calloc(itti_desc.task_max, sizeof(task_workers_t));
+  itti_desc.task_watermarks = memalign(
+    ITTI_CACHE_LINE_SIZE,
+    itti_desc.task_max * sizeof(task_watermarks_t));
+  memset(
+    itti_desc.task_watermarks,
+    0,
+    itti_desc.task_max * sizeof(task_watermarks_t));
   /*
    * Allocates memory for threads info
    */
-  itti_desc.threads = calloc(itti_desc.thread_max, sizeof(thread_desc_t));
+  itti_desc.threads = memalign(
+    ITTI_CACHE_LINE_SIZE,
+    itti_desc.thread_max * sizeof(thread_desc_t));
+  memset(itti_desc.threads, 0, itti_desc.thread_max * sizeof(thread_desc_t));
 
   /*
    * Initializing each queue and related stuff
@@ -670,22 +1395,7 @@ int itti_init(
       itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ?
         itti_get_task_name(itti_desc.tasks_info[task_id].parent_task) :
         "");
-    ITTI_DEBUG(
-      ITTI_DEBUG_INIT,
-      " Creating queue of message of size %u\n",
-      itti_desc.tasks_info[task_id].queue_size);
-    printf(
-      " Creating queue of message of size %u\n",
-      itti_desc.tasks_info[task_id].queue_size);
-
-    itti_desc.tasks[task_id].qbmme = calloc(
-      itti_desc.tasks_info[task_id].queue_size,
-      sizeof(struct lfds710_queue_bmm_element));
-    lfds710_queue_bmm_init_valid_on_current_logical_core(
-      &itti_desc.tasks[task_id].message_queue,
-      itti_desc.tasks[task_id].qbmme,
-      itti_desc.tasks_info[task_id].queue_size,
-      NULL);
+    pthread_mutex_init(&itti_desc.tasks[task_id].queue_mutex, NULL);
   }
 
   /*
@@ -695,7 +1405,7 @@ int itti_init(
        thread_id++) {
     itti_desc.threads[thread_id].task_state = TASK_STATE_NOT_CONFIGURED;
 
-    itti_desc.threads[thread_id].task_event_fd = eventfd(0, EFD_SEMAPHORE);
+    itti_desc.threads[thread_id].task_event_fd = eventfd(0, EFD_NONBLOCK);
 
     if (itti_desc.threads[thread_id].task_event_fd == -1) {
       Fatal("eventfd failed: %s!\n", strerror(errno));
@@ -808,10 +1518,6 @@ void itti_wait_tasks_end(void)
     free_wrapper((void **) &statistics);
   }
 
-  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
-    free_wrapper((void **) &itti_desc.tasks[task_id].qbmme);
-  }
-
   free_wrapper((void **) &itti_desc.tasks);
   free_wrapper((void **) &itti_desc.threads);
 
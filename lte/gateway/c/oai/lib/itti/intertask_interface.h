@@ -40,6 +40,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <sys/types.h>
 
 #include "intertask_interface_conf.h"
@@ -58,6 +59,9 @@ struct epoll_event;
   itti_get_task_name(ITTI_MSG_ORIGIN_ID(mSGpTR))
 #define ITTI_MSG_DESTINATION_NAME(mSGpTR)                                      \
   itti_get_task_name(ITTI_MSG_DESTINATION_ID(mSGpTR))
+/* Broadcast messages are shared, their content is released by the last
+   itti_free() */
+#define ITTI_MSG_SHARED(mSGpTR) ((mSGpTR)->ittiMsgHeader.shared != NULL)
 
 /* Make the message number platform specific */
 typedef unsigned long message_number_t;
@@ -73,6 +77,11 @@ typedef enum message_priorities_e {
   MESSAGE_PRIORITY_MIN = 10,
 } message_priorities_t;
 
+/* Each task queues messages in one FIFO per message priority. The messages
+   that must be handled in their send order, as all the ones about a UE or an
+   eNB, have to share a priority. */
+#define ITTI_PRIORITY_LEVELS 7
+
 typedef struct message_info_s {
   task_id_t id;
   message_priorities_t priority;
@@ -112,6 +121,17 @@ int itti_send_msg_to_task(
   instance_t instance,
   MessageDef *message);
 
+/** \brief Send a broadcast message to every running task but the sender.
+ * The message is not copied, every task receives the same read only message
+ * and its content is released by the last itti_free().
+ \param message_p Pointer to the message to send
+ @returns < 0 on failure, 0 otherwise
+ **/
+int itti_send_broadcast_message(MessageDef *message_p);
+
+/* Number of messages a task loop fetches per wake up */
+#define ITTI_RECEIVE_BATCH_SIZE 32
+
 /** \brief Retrieves a message in the queue associated to task_id.
  * If the queue is empty, the thread is blocked till a new message arrives.
  \param task_id Task ID of the receiving task
@@ -119,6 +139,118 @@ int itti_send_msg_to_task(
  **/
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg);
 
+/** \brief Retrieves up to max messages in the queue associated to task_id.
+ * If the queue is empty, the thread is blocked till a new message arrives.
+ * Higher priority messages are returned first, messages of the same priority
+ * in the order they were sent. Lower priorities are aged so that they are
+ * still served under a sustained flow of higher priority messages.
+ \param task_id Task ID of the receiving task
+ \param received_msgs Array receiving the messages
+ \param max Size of received_msgs
+ @returns the number of messages received, at least 1
+ **/
+size_t itti_receive_msgs(
+  task_id_t task_id,
+  MessageDef **received_msgs,
+  size_t max);
+
+/** \brief Non blocking variant of itti_receive_msgs().
+ * Meant for tasks waiting on itti_get_task_event_fd(), it consumes the event
+ * and must be called again as long as it returns max messages.
+ \param task_id Task ID of the receiving task
+ \param received_msgs Array receiving the messages
+ \param max Size of received_msgs
+ @returns the number of messages received, possibly 0
+ **/
+size_t itti_poll_msgs(
+  task_id_t task_id,
+  MessageDef **received_msgs,
+  size_t max);
+
+/** \brief Return the event fd signalled when a message is queued for task_id.
+ * Lets a task multiplex its ITTI queue with other fds, the messages are then
+ * fetched with itti_poll_msgs().
+ \param task_id Task ID of the receiving task
+ @returns the event fd of the calling worker of the task
+ **/
+int itti_get_task_event_fd(task_id_t task_id);
+
+/** \brief Snapshot the number of messages pending for task_id.
+ * The depths of a task served by several workers add up all their queues.
+ \param task_id Task ID of the queue to inspect
+ \param depths Filled with the depth of each priority level, highest first
+ **/
+void itti_get_queue_depths(
+  task_id_t task_id,
+  uint32_t depths[ITTI_PRIORITY_LEVELS]);
+
+/* Activity of a task, counted by the task threads themselves */
+typedef struct itti_task_counters_s {
+  uint64_t msgs_sent;
+  uint64_t msgs_received;
+  /* Size of the messages and buffers allocated with itti_malloc() */
+  uint64_t bytes_allocated;
+} itti_task_counters_t;
+
+/** \brief Read the counters of task_id, summed over its workers.
+ * Each thread updates its own counters, reading them takes no lock and the
+ * sum may be slightly behind the threads.
+ \param task_id Task ID of the counters to read
+ \param counters Filled with the counters of the task
+ **/
+void itti_get_task_counters(task_id_t task_id, itti_task_counters_t *counters);
+
+/* Called on a sender or receiver thread, outside of the ITTI locks, when the
+   number of messages pending for task_id crosses one of its watermarks */
+typedef void (*itti_overload_fn_t)(task_id_t task_id, bool overloaded);
+
+/** \brief Watch the number of messages pending for task_id.
+ * The task becomes overloaded once high messages are pending and stays so
+ * until they drop to low. Messages are still queued while the task is
+ * overloaded, slowing the senders down is up to the callback.
+ * Must be called before the task is created.
+ \param task_id Task ID of the queues to watch
+ \param high Pending messages starting the overload, 0 to stop watching
+ \param low Pending messages ending the overload, lower than high
+ \param callback Called on every overload start and stop
+ **/
+void itti_set_queue_watermarks(
+  task_id_t task_id,
+  uint32_t high,
+  uint32_t low,
+  itti_overload_fn_t callback);
+
+/** \brief Return whether task_id is between its high and low watermarks.
+ \param task_id Task ID to query
+ @returns true if the task is overloaded
+ **/
+bool itti_is_task_overloaded(task_id_t task_id);
+
+/** \brief Return a printable name for a priority level index.
+ \param level Priority level, 0 being the highest
+ @returns the lower case name of the matching message priority
+ **/
+const char *itti_get_priority_level_name(unsigned int level);
+
+/* Optional instrumentation hooks, all called on the receiving task thread */
+typedef struct itti_metrics_ops_s {
+  /* Time a message spent queued, from send to receive */
+  void (*msg_latency)(
+    task_id_t task_id,
+    MessagesIds message_id,
+    double latency_us);
+  /* Number of pending messages found by a receive that returned messages */
+  void (*queue_depth)(task_id_t task_id, uint32_t depth);
+  /* Time the task spent handling the previous batch of nb_msgs messages */
+  void (*handler_time)(task_id_t task_id, size_t nb_msgs, double run_time_us);
+} itti_metrics_ops_t;
+
+/** \brief Enable or disable ITTI instrumentation at run time.
+ * While disabled, the cost on the message path is a single branch.
+ \param ops Hooks to call, must stay valid while enabled. NULL disables
+ **/
+void itti_set_metrics_ops(const itti_metrics_ops_t *ops);
+
 /** \brief Start thread associated to the task
  * \param task_id task to start
  * \param start_routine entry point for the task
@@ -130,6 +262,40 @@ int itti_create_task(
   void *(*start_routine)(void *),
   void *args_p);
 
+/* Returns the shard key of a message sent to a task served by several
+   workers, messages with the same key are handled in order by one worker */
+typedef uint32_t (*itti_shard_fn_t)(const MessageDef *message);
+
+/** \brief Start nb_workers threads serving the same task.
+ * Every worker runs start_routine and has its own queue, a message is queued
+ * for worker shard(message) % nb_workers and broadcast messages are received
+ * by every worker. Worker 0 is the task thread, the one joined on exit.
+ * With nb_workers == 1 this is the same as itti_create_task().
+ * \param task_id task to start
+ * \param start_routine entry point of every worker
+ * \param args_p Optional argument to pass to the start routine
+ * \param nb_workers Number of workers, up to ITTI_TASK_WORKERS_MAX
+ * \param shard Shard key of the messages, called on the sending thread
+ * @returns -1 on failure, 0 otherwise
+ **/
+int itti_create_task_workers(
+  task_id_t task_id,
+  void *(*start_routine)(void *),
+  void *args_p,
+  uint32_t nb_workers,
+  itti_shard_fn_t shard);
+
+/** \brief Return the number of workers serving task_id, 1 for most tasks.
+ * \param task_id task to query
+ **/
+uint32_t itti_get_task_nb_workers(task_id_t task_id);
+
+/** \brief Return the index of the calling worker among the workers of task_id.
+ * \param task_id task served by the calling thread
+ * @returns the worker index, 0 if the thread is not a worker of task_id
+ **/
+uint32_t itti_get_task_worker(task_id_t task_id);
+
 /** \brief Mark the task as in ready state
  * \param task_id task to mark as ready
  **/
@@ -139,6 +305,12 @@ void itti_mark_task_ready(task_id_t task_id);
  **/
 void itti_exit_task(void);
 
+/** \brief Return the task served by the calling thread.
+ * The task is known once its thread called itti_mark_task_ready().
+ * @returns the task id, TASK_UNKNOWN on other threads
+ **/
+task_id_t itti_get_current_task_id(void);
+
 /** \brief Return the printable string associated with the message
  * \param message_id Id of the message
  **/
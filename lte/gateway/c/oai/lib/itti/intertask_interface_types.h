@@ -139,6 +139,14 @@ typedef struct MessageHeader_s {
 
   MessageHeaderSize
     ittiMsgSize; /**< Message size (not including header size) */
+
+  struct MessageDef_s
+    *nextMessage; /**< Link in the destination task queue, owned by ITTI */
+  uint64_t enqueueTime; /**< Monotonic time (ns) the message was queued,
+                             only set when ITTI metrics are enabled */
+  struct itti_shared_msg_s
+    *shared; /**< Set on broadcast messages, owned by ITTI: the message is
+                  queued to several tasks and must not be modified */
 } MessageHeader;
 
 /** @struct MessageDef
@@ -27,8 +27,10 @@
  * either expressed or implied, of the FreeBSD Project.
  */
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include "assertions.h"
@@ -49,23 +51,27 @@ const static int mp_debug = 0;
 
 #define MEMORY_POOL_ITEM_INFO_NUMBER 2
 
+/* Maximum number of free items a thread keeps per pool */
+#define MEMORY_POOL_MAGAZINE_SIZE 32
+/* Pool items a thread may keep cached, 1 out of MEMORY_POOL_MAGAZINE_RATIO */
+#define MEMORY_POOL_MAGAZINE_RATIO 256
+
 /*------------------------------------------------------------------------------*/
 typedef int32_t items_group_position_t;
 typedef int32_t items_group_index_t;
 
-typedef union items_group_positions_u {
-  uint64_t all;
-  struct {
-    items_group_position_t put;
-    items_group_position_t get;
-  } ind;
-} items_group_positions_t;
-
+/*
+ * Ring of the indexes of the free items of a pool. Threads only reach it when
+ * their magazine runs empty or full, and then move a whole batch of indexes
+ * under a single lock acquisition.
+ */
 typedef struct items_group_s {
+  pthread_mutex_t mutex;
   items_group_position_t number_plus_one;
-  volatile uint32_t minimum;
-  volatile items_group_positions_t positions;
-  volatile items_group_index_t *indexes;
+  uint32_t minimum;
+  items_group_position_t put;
+  items_group_position_t get;
+  items_group_index_t *indexes;
 } items_group_t;
 
 /*------------------------------------------------------------------------------*/
@@ -108,16 +114,53 @@ typedef struct memory_pool_s {
   pool_id_t pool_id;
   uint32_t item_data_number;
   uint32_t pool_item_size;
+  uint32_t magazine_size; /* 0 when the pool is too small to be cached */
   items_group_t items_group_free;
   memory_pool_item_t *items;
+  /*
+   * Counters of the threads that have exited, protected by caches_mutex
+   */
+  uint64_t retired_allocated;
+  uint64_t retired_freed;
 } memory_pool_t;
 
+/*
+ * Per thread LIFO of free items of one pool. Only the owner thread writes it,
+ * the counters are read by memory_pools_statistics().
+ */
+typedef struct memory_pool_magazine_s {
+  uint32_t number;
+  uint64_t allocated;
+  uint64_t freed;
+  items_group_index_t indexes[MEMORY_POOL_MAGAZINE_SIZE];
+} memory_pool_magazine_t;
+
+typedef struct memory_pools_cache_s {
+  struct memory_pools_cache_s *next;
+  struct memory_pools_s *memory_pools;
+  memory_pool_magazine_t magazines[];
+} memory_pools_cache_t;
+
 typedef struct memory_pools_s {
   pools_start_mark_t start_mark;
 
   uint32_t pools_number;
   uint32_t pools_defined;
   memory_pool_t *pools;
+
+  /*
+   * Smallest pool, in definition order, able to hold a given number of
+   * memory_pool_data_t
+   */
+  uint32_t size_classes_number;
+  pool_id_t *size_classes;
+
+  /*
+   * Per thread magazines, listed for statistics
+   */
+  pthread_key_t cache_key;
+  pthread_mutex_t caches_mutex;
+  memory_pools_cache_t *caches;
 } memory_pools_t;
 
 //------------------------------------------------------------------------------
@@ -133,6 +176,8 @@ static const pool_item_end_mark_t POOL_ITEM_END_MARK =
 static const item_status_t ITEM_STATUS_FREE = 'F';
 static const item_status_t ITEM_STATUS_ALLOCATED = 'a';
 
+static const pool_id_t POOL_ID_INVALID = UINT8_MAX;
+
 static const pool_start_mark_t POOL_START_MARK =
   CHARS_TO_UINT32('P', '_', 's', 't');
 
@@ -148,113 +193,71 @@ static inline uint32_t items_group_number_items(items_group_t *items_group)
 //------------------------------------------------------------------------------
 static inline uint32_t items_group_free_items(items_group_t *items_group)
 {
-  items_group_positions_t positions;
   uint32_t free_items;
 
-  positions.all = items_group->positions.all;
   free_items =
-    items_group->number_plus_one + positions.ind.put - positions.ind.get;
+    items_group->number_plus_one + items_group->put - items_group->get;
   free_items %= items_group->number_plus_one;
   return free_items;
 }
 
 //------------------------------------------------------------------------------
-static inline items_group_index_t items_group_get_free_item(
-  items_group_t *items_group)
+static uint32_t items_group_get_free_items(
+  items_group_t *items_group,
+  items_group_index_t *indexes,
+  uint32_t number)
 {
-  items_group_position_t get_raw;
-  items_group_position_t put;
-  items_group_position_t get;
-  items_group_position_t free_items;
-  items_group_index_t index = ITEMS_GROUP_INDEX_INVALID;
+  uint32_t free_items;
+  uint32_t got;
 
-  /*
-   * Get current put position
-   */
-  put = items_group->positions.ind.put % items_group->number_plus_one;
-  /*
-   * Get current get position and increase it
-   */
-  get_raw = __sync_fetch_and_add(&items_group->positions.ind.get, 1);
-  get = get_raw % items_group->number_plus_one;
+  pthread_mutex_lock(&items_group->mutex);
+  free_items = items_group_free_items(items_group);
+  got = number < free_items ? number : free_items;
 
-  if (put == get) {
-    /*
-     * No more item free, restore previous position
-     */
-    __sync_fetch_and_sub(&items_group->positions.ind.get, 1);
-  } else {
+  for (uint32_t i = 0; i < got; i++) {
+    indexes[i] = items_group->indexes[items_group->get];
     /*
-     * Get index at current get position
+     * Clear index at current get position to indicate that item is used
      */
-    index = items_group->indexes[get];
-
-    if (index <= ITEMS_GROUP_INDEX_INVALID) {
-      /*
-       * Index has not yet been completely freed, restore previous get position
-       */
-      __sync_fetch_and_sub(&items_group->positions.ind.get, 1);
-    } else {
-      if (get_raw == items_group->number_plus_one) {
-        /*
-         * Wrap get position
-         */
-        __sync_fetch_and_sub(
-          &items_group->positions.ind.get, items_group->number_plus_one);
-      }
-
-      free_items = items_group_free_items(items_group);
-
-      /*
-       * Updates minimum free items if needed
-       */
-      while (items_group->minimum > free_items) {
-        items_group->minimum = free_items;
-      }
-
-      /*
-       * Clear index at current get position to indicate that item is free
-       */
-      items_group->indexes[get] = ITEMS_GROUP_INDEX_INVALID;
-    }
+    items_group->indexes[items_group->get] = ITEMS_GROUP_INDEX_INVALID;
+    items_group->get = (items_group->get + 1) % items_group->number_plus_one;
   }
 
-  return (index);
+  /*
+   * Updates minimum free items if needed
+   */
+  if (items_group->minimum > free_items - got) {
+    items_group->minimum = free_items - got;
+  }
+  pthread_mutex_unlock(&items_group->mutex);
+  return got;
 }
 
 //------------------------------------------------------------------------------
-static inline int items_group_put_free_item(
+static int items_group_put_free_items(
   items_group_t *items_group,
-  items_group_index_t index)
+  const items_group_index_t *indexes,
+  uint32_t number)
 {
-  items_group_position_t put_raw;
-  items_group_position_t put;
-
-  /*
-   * Get current put position and increase it
-   */
-  put_raw = __sync_fetch_and_add(&items_group->positions.ind.put, 1);
-  put = put_raw % items_group->number_plus_one;
-
-  if (put_raw == items_group->number_plus_one) {
+  int result = EXIT_SUCCESS;
+
+  pthread_mutex_lock(&items_group->mutex);
+  for (uint32_t i = 0; i < number; i++) {
+    AssertError(
+      items_group->indexes[items_group->put] <= ITEMS_GROUP_INDEX_INVALID,
+      result = EXIT_FAILURE,
+      "Index at current put position (%d) is not marked as free (%d)!\n",
+      items_group->put,
+      items_group->number_plus_one);
+    if (result != EXIT_SUCCESS) break;
     /*
-     * Wrap position
+     * Save freed item index at current put position
      */
-    __sync_fetch_and_sub(
-      &items_group->positions.ind.put, items_group->number_plus_one);
+    items_group->indexes[items_group->put] = indexes[i];
+    items_group->put = (items_group->put + 1) % items_group->number_plus_one;
   }
-
-  AssertError(
-    items_group->indexes[put] <= ITEMS_GROUP_INDEX_INVALID,
-    return (EXIT_FAILURE),
-    "Index at current put position (%d) is not marked as free (%d)!\n",
-    put,
-    items_group->number_plus_one);
-  /*
-   * Save freed item index at current put position
-   */
-  items_group->indexes[put] = index;
-  return (EXIT_SUCCESS);
+  pthread_mutex_unlock(&items_group->mutex);
+  return result;
 }
 
 //------------------------------------------------------------------------------
@@ -314,6 +317,151 @@ static inline memory_pool_item_t *memory_pool_item_from_index(
   return (address);
 }
 
+//------------------------------------------------------------------------------
+static void memory_pools_cache_destroy(void *arg)
+{
+  memory_pools_cache_t *cache = (memory_pools_cache_t *) arg;
+  memory_pools_t *memory_pools = cache->memory_pools;
+  memory_pools_cache_t **cache_p;
+  pool_id_t pool;
+
+  /*
+   * The thread is exiting, give its cached items back and keep its counters
+   */
+  pthread_mutex_lock(&memory_pools->caches_mutex);
+  for (cache_p = &memory_pools->caches; *cache_p != cache;
+       cache_p = &(*cache_p)->next)
+    ;
+  *cache_p = cache->next;
+
+  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+    memory_pool_t *memory_pool = &memory_pools->pools[pool];
+    memory_pool_magazine_t *magazine = &cache->magazines[pool];
+
+    items_group_put_free_items(
+      &memory_pool->items_group_free, magazine->indexes, magazine->number);
+    memory_pool->retired_allocated += magazine->allocated;
+    memory_pool->retired_freed += magazine->freed;
+  }
+  pthread_mutex_unlock(&memory_pools->caches_mutex);
+  free(cache);
+}
+
+//------------------------------------------------------------------------------
+static memory_pools_cache_t *memory_pools_get_cache(
+  memory_pools_t *memory_pools)
+{
+  memory_pools_cache_t *cache;
+
+  cache = pthread_getspecific(memory_pools->cache_key);
+  if (cache == NULL) {
+    cache = calloc(
+      1,
+      sizeof(memory_pools_cache_t) +
+        memory_pools->pools_number * sizeof(memory_pool_magazine_t));
+    AssertFatal(cache != NULL, "Memory pools cache allocation failed!\n");
+    cache->memory_pools = memory_pools;
+    pthread_mutex_lock(&memory_pools->caches_mutex);
+    cache->next = memory_pools->caches;
+    memory_pools->caches = cache;
+    pthread_mutex_unlock(&memory_pools->caches_mutex);
+    pthread_setspecific(memory_pools->cache_key, cache);
+  }
+  return cache;
+}
+
+//------------------------------------------------------------------------------
+static items_group_index_t memory_pool_get_item(
+  memory_pool_t *memory_pool,
+  memory_pool_magazine_t *magazine)
+{
+  items_group_index_t index;
+
+  if (magazine->number == 0) {
+    if (memory_pool->magazine_size == 0) {
+      if (
+        items_group_get_free_items(&memory_pool->items_group_free, &index, 1) ==
+        0) {
+        return ITEMS_GROUP_INDEX_INVALID;
+      }
+      return index;
+    }
+    /*
+     * Magazine is empty, refill half of it from the pool
+     */
+    magazine->number = items_group_get_free_items(
+      &memory_pool->items_group_free,
+      magazine->indexes,
+      memory_pool->magazine_size / 2);
+    if (magazine->number == 0) {
+      return ITEMS_GROUP_INDEX_INVALID;
+    }
+  }
+  return magazine->indexes[--magazine->number];
+}
+
+//------------------------------------------------------------------------------
+static int memory_pool_put_item(
+  memory_pool_t *memory_pool,
+  memory_pool_magazine_t *magazine,
+  items_group_index_t index)
+{
+  uint32_t batch = memory_pool->magazine_size / 2;
+  int result;
+
+  if (memory_pool->magazine_size == 0) {
+    return items_group_put_free_items(
+      &memory_pool->items_group_free, &index, 1);
+  }
+  if (magazine->number == memory_pool->magazine_size) {
+    /*
+     * Magazine is full, give the least recently freed half back to the pool
+     */
+    result = items_group_put_free_items(
+      &memory_pool->items_group_free, magazine->indexes, batch);
+    if (result != EXIT_SUCCESS) {
+      return result;
+    }
+    memmove(
+      magazine->indexes,
+      &magazine->indexes[batch],
+      (magazine->number - batch) * sizeof(items_group_index_t));
+    magazine->number -= batch;
+  }
+  magazine->indexes[magazine->number++] = index;
+  return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static void memory_pools_update_size_classes(memory_pools_t *memory_pools)
+{
+  uint32_t size_classes_number = 0;
+  pool_id_t pool;
+
+  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+    if (memory_pools->pools[pool].item_data_number >= size_classes_number) {
+      size_classes_number = memory_pools->pools[pool].item_data_number + 1;
+    }
+  }
+  memory_pools->size_classes = realloc(
+    memory_pools->size_classes, size_classes_number * sizeof(pool_id_t));
+  AssertFatal(
+    memory_pools->size_classes != NULL,
+    "Memory pools size classes allocation failed!\n");
+  memory_pools->size_classes_number = size_classes_number;
+
+  for (uint32_t data_number = 0; data_number < size_classes_number;
+       data_number++) {
+    memory_pools->size_classes[data_number] = POOL_ID_INVALID;
+    for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+      if (memory_pools->pools[pool].item_data_number >= data_number) {
+        memory_pools->size_classes[data_number] = pool;
+        break;
+      }
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 memory_pools_handle_t memory_pools_create(uint32_t pools_number)
 {
@@ -338,6 +486,14 @@ memory_pools_handle_t memory_pools_create(uint32_t pools_number)
     memory_pools->start_mark = POOLS_START_MARK;
     memory_pools->pools_number = pools_number;
     memory_pools->pools_defined = 0;
+    memory_pools->size_classes_number = 0;
+    memory_pools->size_classes = NULL;
+    memory_pools->caches = NULL;
+    pthread_mutex_init(&memory_pools->caches_mutex, NULL);
+    AssertFatal(
+      pthread_key_create(
+        &memory_pools->cache_key, memory_pools_cache_destroy) == 0,
+      "Memory pools cache key creation failed!\n");
     /*
      * Allocate pools
      */
@@ -367,6 +523,9 @@ char *memory_pools_statistics(memory_pools_handle_t memory_pools_handle)
   uint32_t allocated_pools_memory = 0;
   items_group_t *items_group;
   uint32_t pool_items_size;
+  memory_pools_cache_t *cache;
+  uint64_t allocated;
+  uint64_t freed;
 
   /*
    * Recover memory_pools
@@ -376,13 +535,15 @@ char *memory_pools_statistics(memory_pools_handle_t memory_pools_handle)
     memory_pools != NULL,
     "Failed to retrieve memory pool for handle %p!\n",
     memory_pools_handle);
-  statistics_len = memory_pools->pools_defined * 200;
+  statistics_len = (memory_pools->pools_defined + 1) * 200;
   statistics = malloc(statistics_len);
   printed_chars = snprintf(
     &statistics[0],
     statistics_len,
     "Pool:   size, number, minimum,   free, address space and memory used in "
-    "Kbytes\n");
+    "Kbytes, allocations, frees\n");
+
+  pthread_mutex_lock(&memory_pools->caches_mutex);
 
   for (pool = 0; pool < memory_pools->pools_defined; pool++) {
     items_group = &memory_pools->pools[pool].items_group_free;
@@ -391,10 +552,17 @@ char *memory_pools_statistics(memory_pools_handle_t memory_pools_handle)
     allocated_pools_memory += allocated_pool_memory;
     pool_items_size =
       memory_pools->pools[pool].item_data_number * sizeof(memory_pool_data_t);
+    allocated = memory_pools->pools[pool].retired_allocated;
+    freed = memory_pools->pools[pool].retired_freed;
+    for (cache = memory_pools->caches; cache != NULL; cache = cache->next) {
+      allocated +=
+        __atomic_load_n(&cache->magazines[pool].allocated, __ATOMIC_RELAXED);
+      freed += __atomic_load_n(&cache->magazines[pool].freed, __ATOMIC_RELAXED);
+    }
     printed_chars += snprintf(
       &statistics[printed_chars],
       statistics_len - printed_chars,
-      "  %2u: %6u, %6u,  %6u, %6u, [%p-%p] %6u\n",
+      "  %2u: %6u, %6u,  %6u, %6u, [%p-%p] %6u, %10lu, %10lu\n",
       pool,
       pool_items_size,
       items_group_number_items(items_group),
@@ -402,8 +570,11 @@ char *memory_pools_statistics(memory_pools_handle_t memory_pools_handle)
       items_group_free_items(items_group),
       memory_pools->pools[pool].items,
       ((void *) memory_pools->pools[pool].items) + allocated_pool_memory,
-      allocated_pool_memory / (1024));
+      allocated_pool_memory / (1024),
+      allocated,
+      freed);
   }
+  pthread_mutex_unlock(&memory_pools->caches_mutex);
 
   printed_chars = snprintf(
     &statistics[printed_chars],
@@ -469,10 +640,18 @@ int memory_pools_add_pool(
     memory_pool->pool_item_size =
       (memory_pool->item_data_number * sizeof(memory_pool_data_t)) +
       sizeof(memory_pool_item_t);
+    memory_pool->magazine_size =
+      pool_items_number / MEMORY_POOL_MAGAZINE_RATIO;
+    if (memory_pool->magazine_size > MEMORY_POOL_MAGAZINE_SIZE) {
+      memory_pool->magazine_size = MEMORY_POOL_MAGAZINE_SIZE;
+    } else if (memory_pool->magazine_size < 2) {
+      memory_pool->magazine_size = 0;
+    }
+    pthread_mutex_init(&memory_pool->items_group_free.mutex, NULL);
     memory_pool->items_group_free.number_plus_one = pool_items_number + 1;
     memory_pool->items_group_free.minimum = pool_items_number;
-    memory_pool->items_group_free.positions.ind.put = pool_items_number;
-    memory_pool->items_group_free.positions.ind.get = 0;
+    memory_pool->items_group_free.put = pool_items_number;
+    memory_pool->items_group_free.get = 0;
     /*
      * Allocate free indexes
      */
@@ -515,6 +694,7 @@ int memory_pools_add_pool(
     }
   }
   memory_pools->pools_defined++;
+  memory_pools_update_size_classes(memory_pools);
   return (0);
 }
 
@@ -526,10 +706,12 @@ memory_pool_item_handle_t memory_pools_allocate(
   uint16_t info_1)
 {
   memory_pools_t *memory_pools;
+  memory_pools_cache_t *cache;
   memory_pool_item_t *memory_pool_item;
   memory_pool_item_handle_t memory_pool_item_handle = NULL;
-  pool_id_t pool;
+  pool_id_t pool = POOL_ID_INVALID;
   items_group_index_t item_index = ITEMS_GROUP_INDEX_INVALID;
+  uint32_t data_number;
 
   /*
    * Recover memory_pools
@@ -541,29 +723,40 @@ memory_pool_item_handle_t memory_pools_allocate(
     "Failed to retrieve memory pool for handle %p!\n",
     memory_pools_handle);
 
-  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
-    if (
-      (memory_pools->pools[pool].item_data_number *
-       sizeof(memory_pool_data_t)) < item_size) {
-      /*
-       * This memory pool has too small items, skip it
-       */
-      continue;
-    }
+  /*
+   * Item size in memory_pool_data_t items by excess, gives the first pool
+   * with large enough items
+   */
+  data_number = (item_size + sizeof(memory_pool_data_t) - 1) /
+                sizeof(memory_pool_data_t);
+  if (data_number < memory_pools->size_classes_number) {
+    pool = memory_pools->size_classes[data_number];
+  }
 
-    item_index =
-      items_group_get_free_item(&memory_pools->pools[pool].items_group_free);
-
-    if (item_index <= ITEMS_GROUP_INDEX_INVALID) {
-      /*
-       * Allocation failed, skip this pool
-       */
-      continue;
-    } else {
-      /*
-       * Allocation succeed, exit searching loop
-       */
-      break;
+  if (pool != POOL_ID_INVALID) {
+    cache = memory_pools_get_cache(memory_pools);
+
+    for (; pool < memory_pools->pools_defined; pool++) {
+      if (memory_pools->pools[pool].item_data_number < data_number) {
+        /*
+         * This memory pool has too small items, skip it
+         */
+        continue;
+      }
+
+      item_index = memory_pool_get_item(
+        &memory_pools->pools[pool], &cache->magazines[pool]);
+
+      if (item_index > ITEMS_GROUP_INDEX_INVALID) {
+        /*
+         * Allocation succeed, otherwise fall back on the next pools
+         */
+        __atomic_store_n(
+          &cache->magazines[pool].allocated,
+          cache->magazines[pool].allocated + 1,
+          __ATOMIC_RELAXED);
+        break;
+      }
     }
   }
 
@@ -615,6 +808,7 @@ int memory_pools_free(
   uint16_t info_0)
 {
   memory_pools_t *memory_pools;
+  memory_pools_cache_t *cache;
   memory_pool_item_t *memory_pool_item;
   pool_id_t pool;
   items_group_index_t item_index;
@@ -699,8 +893,13 @@ int memory_pools_free(
     pool,
     item_index);
   memory_pool_item->start.item_status = ITEM_STATUS_FREE;
-  result = items_group_put_free_item(
-    &memory_pools->pools[pool].items_group_free, item_index);
+  cache = memory_pools_get_cache(memory_pools);
+  result = memory_pool_put_item(
+    &memory_pools->pools[pool], &cache->magazines[pool], item_index);
+  __atomic_store_n(
+    &cache->magazines[pool].freed,
+    cache->magazines[pool].freed + 1,
+    __ATOMIC_RELAXED);
   AssertError(
     result == EXIT_SUCCESS,
     {},
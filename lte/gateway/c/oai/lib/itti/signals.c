@@ -120,7 +120,6 @@ int signal_mask(void)
   DevAssert(get_thread_count(getpid()) == 1);
 
   sigemptyset(&set);
-  sigaddset(&set, SIGTIMER);
   sigaddset(&set, SIGUSR1);
   sigaddset(&set, SIGABRT);
   sigaddset(&set, SIGSEGV);
@@ -141,7 +140,6 @@ int signal_handle(int *end)
   siginfo_t info;
 
   sigemptyset(&set);
-  sigaddset(&set, SIGTIMER);
   sigaddset(&set, SIGUSR1);
   sigaddset(&set, SIGABRT);
   sigaddset(&set, SIGSEGV);
@@ -165,39 +163,31 @@ int signal_handle(int *end)
   //printf("Received signal %d\n", info.si_signo);
 
   /*
-   * Real-time signals are non constant and are therefore not suitable for
-   * * * use in switch.
+   * Dispatch the signal to sub-handlers
    */
-  if (info.si_signo == SIGTIMER) {
-    timer_handle_signal(&info);
-  } else {
-    /*
-     * Dispatch the signal to sub-handlers
-     */
-    switch (info.si_signo) {
-      case SIGUSR1:
+  switch (info.si_signo) {
+    case SIGUSR1:
 #if LINK_GCOV
-        __gcov_flush();
+      __gcov_flush();
 #endif
-        SIG_DEBUG("Received SIGUSR1\n");
-        *end = 1;
-        break;
-
-      case SIGSEGV: /* Fall through */
-      case SIGABRT:
-        SIG_DEBUG("Received SIGABORT\n");
-        backtrace_handle_signal(&info);
-        break;
-
-      case SIGINT:
-      case SIGTERM:
-        printf("Received SIGINT or SIGTERM\n");
-        itti_send_terminate_message(TASK_UNKNOWN);
-        *end = 1;
-        break;
-
-      default: SIG_ERROR("Received unknown signal %d\n", info.si_signo); break;
-    }
+      SIG_DEBUG("Received SIGUSR1\n");
+      *end = 1;
+      break;
+
+    case SIGSEGV: /* Fall through */
+    case SIGABRT:
+      SIG_DEBUG("Received SIGABORT\n");
+      backtrace_handle_signal(&info);
+      break;
+
+    case SIGINT:
+    case SIGTERM:
+      printf("Received SIGINT or SIGTERM\n");
+      itti_send_terminate_message(TASK_UNKNOWN);
+      *end = 1;
+      break;
+
+    default: SIG_ERROR("Received unknown signal %d\n", info.si_signo); break;
   }
 
   return 0;
@@ -33,83 +33,430 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <signal.h>
 #include <time.h>
 #include <errno.h>
-#include <sys/time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 #include "intertask_interface.h"
 #include "timer.h"
 #include "log.h"
-#include "queue.h"
 #include "dynamic_memory_check.h"
 #include "assertions.h"
 #include "timer_messages_types.h"
 
-int timer_handle_signal(siginfo_t *info);
+/*
+ * Timers are kept in a hierarchical timing wheel driven by a single timerfd
+ * owned by TASK_TIMER. Level 0 has one slot per tick, each upper level has
+ * slots TIMER_WHEEL_SLOTS times coarser than the level below. Timers are
+ * cascaded down one level each time the lower level wraps around.
+ *
+ * Timer elements live in a growable array and are linked by index, so a timer
+ * id is simply the element index plus a generation counter. Lookup, arming and
+ * cancellation are O(1) whatever the number of running timers.
+ */
+#define TIMER_WHEEL_TICK_MS 10
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_TICKS                                                  \
+  ((UINT64_C(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1)
+
+#define TIMER_POOL_INITIAL_SIZE 1024
+#define TIMER_EXPIRED_BATCH_INITIAL_SIZE 64
+#define TIMER_INDEX_NONE UINT32_MAX
+#define TIMER_GENERATION_MASK 0x7fffffff
+
+#define TIMER_ID_BUILD(iNDEX, gENERATION)                                      \
+  ((long) (((uint64_t)(gENERATION) << 32) | ((uint64_t)(iNDEX) + 1)))
+#define TIMER_ID_INDEX(tIMERiD) ((uint32_t)((uint64_t)(tIMERiD) & 0xffffffff) - 1)
+#define TIMER_ID_GENERATION(tIMERiD) ((uint32_t)((uint64_t)(tIMERiD) >> 32))
+
+typedef enum timer_state_e {
+  TIMER_STATE_FREE = 0,
+  TIMER_STATE_ARMED, ///< Linked in a wheel slot
+  TIMER_STATE_FIRED, ///< One shot timer waiting for timer_handle_expired()
+} timer_state_t;
 
 struct timer_elm_s {
   task_id_t task_id; ///< Task ID which has requested the timer
   int32_t instance;  ///< Instance of the task which has requested the timer
-  timer_t timer;     ///< Unique timer id
   timer_type_t type; ///< Timer type
+  timer_state_t state;
+  uint32_t generation; ///< Bumped each time the element is released
+  uint32_t prev;       ///< Previous element in the wheel slot or free list
+  uint32_t next;       ///< Next element in the wheel slot or free list
+  uint32_t slot;       ///< Wheel slot (level * TIMER_WHEEL_SLOTS + index)
+  uint64_t expires;    ///< Absolute expiry, in ticks
+  uint64_t interval;   ///< Timer interval, in ticks
   void *timer_arg; ///< Optional argument that will be passed when timer expires
-  STAILQ_ENTRY(timer_elm_s) entries; ///< Pointer to next element
 };
 
+typedef struct timer_expired_s {
+  task_id_t task_id;
+  int32_t instance;
+  long timer_id;
+  void *timer_arg;
+} timer_expired_t;
+
 typedef struct timer_desc_s {
-  STAILQ_HEAD(timer_list_head, timer_elm_s) timer_queue;
   pthread_mutex_t timer_list_mutex;
-  struct timespec timeout;
+
+  struct timer_elm_s *timers;
+  uint32_t timers_size;
+  uint32_t free_head;
+
+  uint32_t wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t current_tick; ///< Next tick to be processed by the wheel
+  uint32_t nb_armed;     ///< Number of timers linked in the wheel
+  struct timespec origin;
+
+  int timer_fd;
+  bool ticking;
+
+  /* Only touched by TASK_TIMER */
+  timer_expired_t *expired;
+  size_t expired_size;
+  size_t expired_capacity;
 } timer_desc_t;
 
 static timer_desc_t timer_desc;
 
-static int _timer_delete_helper(struct timer_elm_s *timer_p);
+static void *_timer_thread(void *args);
 static struct timer_elm_s *_find_timer(long timer_id);
 
-#define TIMER_SEARCH(vAR, tIMERfIELD, tIMERvALUE, tIMERqUEUE)                  \
-  do {                                                                         \
-    STAILQ_FOREACH(vAR, tIMERqUEUE, entries)                                   \
-    {                                                                          \
-      if (((vAR)->tIMERfIELD == tIMERvALUE)) break;                            \
-    }                                                                          \
-  } while (0)
+//------------------------------------------------------------------------------
+static uint64_t _timer_now_tick(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)(now.tv_sec - timer_desc.origin.tv_sec) * 1000 +
+          (now.tv_nsec - timer_desc.origin.tv_nsec) / 1000000) /
+         TIMER_WHEEL_TICK_MS;
+}
 
-int timer_handle_signal(siginfo_t *info)
+//------------------------------------------------------------------------------
+static uint64_t _timer_interval_to_ticks(
+  uint32_t interval_sec,
+  uint32_t interval_us)
 {
-  struct timer_elm_s *timer_p;
-  MessageDef *message_p;
-  timer_has_expired_t *timer_expired_p;
-  task_id_t task_id;
-  int32_t instance;
+  uint64_t us = (uint64_t) interval_sec * 1000000 + interval_us;
+  uint64_t ticks =
+    (us + TIMER_WHEEL_TICK_MS * 1000 - 1) / (TIMER_WHEEL_TICK_MS * 1000);
 
-  /*
-   * Get back pointer to timer list element
-   */
-  timer_p = (struct timer_elm_s *) info->si_ptr;
-  // LG: To many traces for msc timer:
-  // TMR_DEBUG("Timer with id 0x%lx has expired", (long)timer_p->timer);
-  task_id = timer_p->task_id;
-  instance = timer_p->instance;
-  message_p = itti_alloc_new_message(TASK_TIMER, TIMER_HAS_EXPIRED);
-  timer_expired_p = &message_p->ittiMsg.timer_has_expired;
-  timer_expired_p->timer_id = (long) timer_p->timer;
-  timer_expired_p->arg = timer_p->timer_arg;
+  return ticks ? ticks : 1;
+}
 
-  /*
-   * Notify task of timer expiry
-   */
-  if (itti_send_msg_to_task(task_id, instance, message_p) < 0) {
-    OAILOG_DEBUG(
-      LOG_ITTI, "Failed to send msg TIMER_HAS_EXPIRED to task %u\n", task_id);
-    itti_free(TASK_TIMER, message_p);
-    return -1;
+//------------------------------------------------------------------------------
+// Arm or disarm the wheel tick, must be called with timer_list_mutex held
+static void _timer_set_ticking(bool ticking)
+{
+  struct itimerspec its = {{0}};
+
+  if (timer_desc.ticking == ticking) return;
+
+  if (ticking) {
+    its.it_value.tv_nsec = TIMER_WHEEL_TICK_MS * 1000000;
+    its.it_interval.tv_nsec = TIMER_WHEEL_TICK_MS * 1000000;
   }
+  if (timerfd_settime(timer_desc.timer_fd, 0, &its, NULL) < 0) {
+    OAILOG_ERROR(
+      LOG_ITTI, "Failed to set timerfd: (%s:%d)\n", strerror(errno), errno);
+    return;
+  }
+  timer_desc.ticking = ticking;
+}
 
+//------------------------------------------------------------------------------
+// Grow the timer element pool, must be called with timer_list_mutex held
+static int _timer_pool_grow(void)
+{
+  uint32_t new_size = timer_desc.timers_size ? 2 * timer_desc.timers_size :
+                                               TIMER_POOL_INITIAL_SIZE;
+  struct timer_elm_s *timers =
+    realloc(timer_desc.timers, new_size * sizeof(struct timer_elm_s));
+
+  if (timers == NULL) {
+    return -1;
+  }
+  memset(
+    &timers[timer_desc.timers_size],
+    0,
+    (new_size - timer_desc.timers_size) * sizeof(struct timer_elm_s));
+  for (uint32_t i = timer_desc.timers_size; i < new_size; i++) {
+    timers[i].generation = 1;
+    timers[i].next = (i + 1 < new_size) ? i + 1 : timer_desc.free_head;
+  }
+  timer_desc.free_head = timer_desc.timers_size;
+  timer_desc.timers = timers;
+  timer_desc.timers_size = new_size;
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Link a timer in the wheel slot matching its expiry
+static void _timer_wheel_insert(uint32_t index)
+{
+  struct timer_elm_s *timer_p = &timer_desc.timers[index];
+  uint64_t delta = timer_p->expires - timer_desc.current_tick;
+  int level;
+
+  if ((int64_t) delta < 0) {
+    timer_p->expires = timer_desc.current_tick;
+    delta = 0;
+  } else if (delta > TIMER_WHEEL_MAX_TICKS) {
+    timer_p->expires = timer_desc.current_tick + TIMER_WHEEL_MAX_TICKS;
+    delta = TIMER_WHEEL_MAX_TICKS;
+  }
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+    if (delta < (UINT64_C(1) << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) break;
+  }
+
+  uint32_t slot =
+    (timer_p->expires >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+  uint32_t *head = &timer_desc.wheel[level][slot];
+
+  timer_p->slot = level * TIMER_WHEEL_SLOTS + slot;
+  timer_p->prev = TIMER_INDEX_NONE;
+  timer_p->next = *head;
+  if (*head != TIMER_INDEX_NONE) {
+    timer_desc.timers[*head].prev = index;
+  }
+  *head = index;
+  timer_p->state = TIMER_STATE_ARMED;
+}
+
+//------------------------------------------------------------------------------
+// Unlink an armed timer from its wheel slot
+static void _timer_wheel_unlink(uint32_t index)
+{
+  struct timer_elm_s *timer_p = &timer_desc.timers[index];
+  uint32_t *head = &timer_desc.wheel[timer_p->slot / TIMER_WHEEL_SLOTS]
+                                    [timer_p->slot % TIMER_WHEEL_SLOTS];
+
+  if (timer_p->prev != TIMER_INDEX_NONE) {
+    timer_desc.timers[timer_p->prev].next = timer_p->next;
+  } else {
+    *head = timer_p->next;
+  }
+  if (timer_p->next != TIMER_INDEX_NONE) {
+    timer_desc.timers[timer_p->next].prev = timer_p->prev;
+  }
+  timer_p->prev = TIMER_INDEX_NONE;
+  timer_p->next = TIMER_INDEX_NONE;
+}
+
+//------------------------------------------------------------------------------
+// Release a timer element, must be called with timer_list_mutex held
+static void _timer_release(uint32_t index)
+{
+  struct timer_elm_s *timer_p = &timer_desc.timers[index];
+
+  if (timer_p->state == TIMER_STATE_ARMED) {
+    _timer_wheel_unlink(index);
+    timer_desc.nb_armed--;
+  }
+  timer_p->state = TIMER_STATE_FREE;
+  timer_p->timer_arg = NULL;
+  timer_p->generation = (timer_p->generation + 1) & TIMER_GENERATION_MASK;
+  if (timer_p->generation == 0) timer_p->generation = 1;
+  timer_p->next = timer_desc.free_head;
+  timer_desc.free_head = index;
+}
+
+//------------------------------------------------------------------------------
+// Move every timer of an upper level slot to the levels below
+static uint32_t _timer_wheel_cascade(int level, uint32_t slot)
+{
+  uint32_t index = timer_desc.wheel[level][slot];
+
+  timer_desc.wheel[level][slot] = TIMER_INDEX_NONE;
+  while (index != TIMER_INDEX_NONE) {
+    uint32_t next = timer_desc.timers[index].next;
+
+    _timer_wheel_insert(index);
+    index = next;
+  }
+  return slot;
+}
+
+//------------------------------------------------------------------------------
+// Queue an expired timer for notification, called with timer_list_mutex held
+static void _timer_expired_push(uint32_t index)
+{
+  struct timer_elm_s *timer_p = &timer_desc.timers[index];
+  timer_expired_t *expired_p;
+
+  if (timer_desc.expired_size == timer_desc.expired_capacity) {
+    size_t capacity = timer_desc.expired_capacity ?
+                        2 * timer_desc.expired_capacity :
+                        TIMER_EXPIRED_BATCH_INITIAL_SIZE;
+    timer_expired_t *expired =
+      realloc(timer_desc.expired, capacity * sizeof(timer_expired_t));
+
+    AssertFatal(expired != NULL, "Failed to grow expired timers batch\n");
+    timer_desc.expired = expired;
+    timer_desc.expired_capacity = capacity;
+  }
+  expired_p = &timer_desc.expired[timer_desc.expired_size++];
+  expired_p->task_id = timer_p->task_id;
+  expired_p->instance = timer_p->instance;
+  expired_p->timer_id = TIMER_ID_BUILD(index, timer_p->generation);
+  expired_p->timer_arg = timer_p->timer_arg;
+}
+
+//------------------------------------------------------------------------------
+// Run the wheel up to the current tick and collect the expired timers
+static void _timer_wheel_advance(void)
+{
+  uint64_t now_tick;
+
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  now_tick = _timer_now_tick();
+  while (timer_desc.nb_armed > 0 && timer_desc.current_tick <= now_tick) {
+    uint32_t slot = timer_desc.current_tick & TIMER_WHEEL_SLOT_MASK;
+    uint32_t index;
+
+    if (slot == 0) {
+      for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if (_timer_wheel_cascade(
+              level,
+              (timer_desc.current_tick >> (level * TIMER_WHEEL_SLOT_BITS)) &
+                TIMER_WHEEL_SLOT_MASK) != 0) {
+          break;
+        }
+      }
+    }
+    timer_desc.current_tick++;
+
+    index = timer_desc.wheel[0][slot];
+    timer_desc.wheel[0][slot] = TIMER_INDEX_NONE;
+    while (index != TIMER_INDEX_NONE) {
+      struct timer_elm_s *timer_p = &timer_desc.timers[index];
+      uint32_t next = timer_p->next;
+
+      _timer_expired_push(index);
+      if (timer_p->type == TIMER_PERIODIC) {
+        timer_p->expires += timer_p->interval;
+        _timer_wheel_insert(index);
+      } else {
+        timer_p->state = TIMER_STATE_FIRED;
+        timer_p->prev = TIMER_INDEX_NONE;
+        timer_p->next = TIMER_INDEX_NONE;
+        timer_desc.nb_armed--;
+      }
+      index = next;
+    }
+  }
+  if (timer_desc.nb_armed == 0) {
+    _timer_set_ticking(false);
+  }
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+}
+
+//------------------------------------------------------------------------------
+// Notify the owners of the timers collected by _timer_wheel_advance()
+static void _timer_expired_flush(void)
+{
+  for (size_t i = 0; i < timer_desc.expired_size; i++) {
+    timer_expired_t *expired_p = &timer_desc.expired[i];
+    MessageDef *message_p =
+      itti_alloc_new_message(TASK_TIMER, TIMER_HAS_EXPIRED);
+
+    message_p->ittiMsg.timer_has_expired.timer_id = expired_p->timer_id;
+    message_p->ittiMsg.timer_has_expired.arg = expired_p->timer_arg;
+
+    /*
+     * Notify task of timer expiry
+     */
+    if (
+      itti_send_msg_to_task(
+        expired_p->task_id, expired_p->instance, message_p) < 0) {
+      OAILOG_DEBUG(
+        LOG_ITTI,
+        "Failed to send msg TIMER_HAS_EXPIRED to task %u\n",
+        expired_p->task_id);
+      itti_free(TASK_TIMER, message_p);
+    }
+  }
+  timer_desc.expired_size = 0;
+}
+
+//------------------------------------------------------------------------------
+static void *_timer_thread(void *args)
+{
+  struct epoll_event events[2];
+  struct epoll_event event = {0};
+  int task_fd = itti_get_task_event_fd(TASK_TIMER);
+  int epoll_fd = epoll_create1(0);
+
+  AssertFatal(epoll_fd >= 0, "epoll_create1 failed: %s\n", strerror(errno));
+  event.events = EPOLLIN;
+  event.data.fd = timer_desc.timer_fd;
+  AssertFatal(
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_desc.timer_fd, &event) == 0,
+    "Failed to watch timerfd: %s\n",
+    strerror(errno));
+  event.data.fd = task_fd;
+  AssertFatal(
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, task_fd, &event) == 0,
+    "Failed to watch TASK_TIMER event fd: %s\n",
+    strerror(errno));
+
+  itti_mark_task_ready(TASK_TIMER);
+
+  while (1) {
+    int nb_events = epoll_wait(epoll_fd, events, 2, -1);
+
+    if (nb_events < 0) {
+      if (errno == EINTR) continue;
+      Fatal("epoll_wait failed: %s\n", strerror(errno));
+    }
+    for (int i = 0; i < nb_events; i++) {
+      if (events[i].data.fd == timer_desc.timer_fd) {
+        uint64_t nb_expirations;
+
+        if (
+          read(timer_desc.timer_fd, &nb_expirations, sizeof(nb_expirations)) !=
+          sizeof(nb_expirations)) {
+          continue;
+        }
+        _timer_wheel_advance();
+        _timer_expired_flush();
+      } else {
+        MessageDef *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+        size_t nb_messages;
+
+        do {
+          nb_messages = itti_poll_msgs(
+            TASK_TIMER, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+          for (size_t j = 0; j < nb_messages; j++) {
+            MessageDef *received_message_p = received_messages[j];
+
+            if (ITTI_MSG_ID(received_message_p) == TERMINATE_MESSAGE) {
+              // The messages of the timer task carry no content
+              for (; j < nb_messages; j++) {
+                itti_free(
+                  ITTI_MSG_ORIGIN_ID(received_messages[j]),
+                  received_messages[j]);
+              }
+              close(epoll_fd);
+              itti_exit_task();
+            }
+            itti_free(
+              ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
+          }
+        } while (nb_messages == ITTI_RECEIVE_BATCH_SIZE);
+      }
+    }
+  }
+  return NULL;
+}
+
 int timer_setup(
   uint32_t interval_sec,
   uint32_t interval_us,
@@ -120,10 +467,9 @@ int timer_setup(
   size_t arg_size,
   long *timer_id)
 {
-  struct sigevent se;
-  struct itimerspec its;
   struct timer_elm_s *timer_p;
-  timer_t timer;
+  void *arg_copy = NULL;
+  uint32_t index;
 
   if (timer_id == NULL) {
     return -1;
@@ -134,81 +480,54 @@ int timer_setup(
     "Invalid timer type (%d/%d)!\n",
     type,
     TIMER_TYPE_MAX);
-  /*
-   * Allocate new timer list element
-   */
-  timer_p = calloc(1, sizeof(struct timer_elm_s));
-
-  if (timer_p == NULL) {
-    OAILOG_ERROR(LOG_ITTI, "Failed to create new timer element\n");
-    return -1;
-  }
 
-  memset(&timer, 0, sizeof(timer_t));
-  memset(&se, 0, sizeof(struct sigevent));
-  timer_p->task_id = task_id;
-  timer_p->instance = instance;
-  timer_p->type = type;
   // copy timer_arg if it exists
   if (timer_arg != NULL) {
-    void *arg_copy = calloc(1, arg_size);
+    arg_copy = calloc(1, arg_size);
     if (arg_copy == NULL) {
       OAILOG_ERROR(LOG_ITTI, "Failed to copy timer argument\n");
-      free_wrapper((void **) &timer_p);
       return -1;
     }
     memcpy(arg_copy, timer_arg, arg_size);
-    timer_p->timer_arg = arg_copy;
   }
 
-  /*
-   * Setting up alarm
-   */
-  /*
-   * Set and enable alarm
-   */
-  se.sigev_notify = SIGEV_SIGNAL;
-  se.sigev_signo = SIGTIMER;
-  se.sigev_value.sival_ptr = timer_p;
-
-  /*
-   * At the timer creation, the timer structure will be filled in with timer_id,
-   * * * which is unique for this process. This id is allocated by kernel and the
-   * * * value might be used to distinguish timers.
-   */
-  if (timer_create(CLOCK_REALTIME, &se, &timer) < 0) {
-    OAILOG_ERROR(
-      LOG_ITTI, "Failed to create timer: (%s:%d)\n", strerror(errno), errno);
-    free_wrapper((void **) &timer_p);
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  if (
+    timer_desc.free_head == TIMER_INDEX_NONE && _timer_pool_grow() < 0) {
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+    OAILOG_ERROR(LOG_ITTI, "Failed to create new timer element\n");
+    free_wrapper(&arg_copy);
     return -1;
   }
+  index = timer_desc.free_head;
+  timer_p = &timer_desc.timers[index];
+  timer_desc.free_head = timer_p->next;
 
-  /*
-   * Fill in the first expiration value.
-   */
-  its.it_value.tv_sec = interval_sec;
-  its.it_value.tv_nsec = interval_us * 1000;
+  timer_p->task_id = task_id;
+  timer_p->instance = instance;
+  timer_p->type = type;
+  timer_p->timer_arg = arg_copy;
+  timer_p->interval = _timer_interval_to_ticks(interval_sec, interval_us);
 
-  if (type == TIMER_PERIODIC) {
-    /*
-     * Asked for periodic timer. We set the interval time
-     */
-    its.it_interval.tv_sec = interval_sec;
-    its.it_interval.tv_nsec = interval_us * 1000;
-  } else {
+  if (timer_desc.nb_armed == 0) {
     /*
-     * Asked for one-shot timer. Do not set the interval field
+     * The wheel is empty and may have stopped ticking, catch up with the
+     * clock before linking the first timer
      */
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
+    timer_desc.current_tick = _timer_now_tick() + 1;
   }
+  timer_p->expires = timer_desc.current_tick + timer_p->interval;
+  _timer_wheel_insert(index);
+  timer_desc.nb_armed++;
+  _timer_set_ticking(true);
 
-  timer_settime(timer, 0, &its, NULL);
   /*
    * Simply set the timer_id argument. so it can be used by caller
    */
-  *timer_id = (long) timer;
-  OAILOG_INFO(
+  *timer_id = TIMER_ID_BUILD(index, timer_p->generation);
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+
+  OAILOG_DEBUG(
     LOG_ITTI,
     "Requesting new %s timer with id 0x%lx that expires within "
     "%d sec and %d usec\n",
@@ -216,48 +535,21 @@ int timer_setup(
     *timer_id,
     interval_sec,
     interval_us);
-  timer_p->timer = timer;
-  /*
-   * Lock the queue and insert the timer at the tail
-   */
-  pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  STAILQ_INSERT_TAIL(&timer_desc.timer_queue, timer_p, entries);
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
   return 0;
 }
 
-// Helper function to delete a timer from queue and cleanup associated resources
-static int _timer_delete_helper(struct timer_elm_s *timer_p)
-{
-  int rc = TIMER_OK;
-  pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-
-  if (timer_delete(timer_p->timer) < 0) {
-    OAILOG_ERROR(
-      LOG_ITTI, "Failed to delete timer 0x%lx\n", (long) timer_p->timer);
-    rc = TIMER_ERR;
-  }
-
-  free_wrapper(&timer_p->timer_arg);
-  free_wrapper((void **) &timer_p);
-  timer_p = NULL;
-  return rc;
-}
-
-// Helper function to find a timer in the queue
+// Helper function to find a timer, must be called with timer_list_mutex held
 static struct timer_elm_s *_find_timer(long timer_id)
 {
-  struct timer_elm_s *timer_p = NULL;
-  pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  TIMER_SEARCH(timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
+  uint32_t index = TIMER_ID_INDEX(timer_id);
 
-  if (timer_p == NULL) {
-    OAILOG_ERROR(LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
+  if (
+    index >= timer_desc.timers_size ||
+    timer_desc.timers[index].state == TIMER_STATE_FREE ||
+    timer_desc.timers[index].generation != TIMER_ID_GENERATION(timer_id)) {
+    return NULL;
   }
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-  return timer_p;
+  return &timer_desc.timers[index];
 }
 
 /**
@@ -267,38 +559,54 @@ static struct timer_elm_s *_find_timer(long timer_id)
  */
 int timer_handle_expired(long timer_id)
 {
-  OAILOG_INFO(LOG_ITTI, "timer 0x%lx expired \n", timer_id);
-  struct timer_elm_s *timer_p = _find_timer(timer_id);
+  struct timer_elm_s *timer_p;
+  void *timer_arg;
+
+  OAILOG_DEBUG(LOG_ITTI, "timer 0x%lx expired \n", timer_id);
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  timer_p = _find_timer(timer_id);
   if (timer_p == NULL) {
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+    OAILOG_ERROR(LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
     return TIMER_NOT_FOUND;
   }
 
-  if (timer_p->type == TIMER_ONE_SHOT) {
-    OAILOG_INFO(
-      LOG_ITTI, "Timer 0x%lx expiry signal received, deleting\n", timer_id);
-    return _timer_delete_helper(timer_p);
+  if (timer_p->type != TIMER_ONE_SHOT) {
+    pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+    OAILOG_DEBUG(
+      LOG_ITTI,
+      "Timer 0x%lx expired but is not one shot, not deleting\n",
+      timer_id);
+    return TIMER_OK;
   }
 
-  OAILOG_INFO(
-    LOG_ITTI,
-    "Timer 0x%lx expired but is not one shot, not deleting\n",
-    timer_id);
+  timer_arg = timer_p->timer_arg;
+  _timer_release(TIMER_ID_INDEX(timer_id));
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+
+  OAILOG_DEBUG(
+    LOG_ITTI, "Timer 0x%lx expiry signal received, deleting\n", timer_id);
+  free_wrapper(&timer_arg);
   return TIMER_OK;
 }
 
 bool timer_exists(long timer_id)
 {
-  return _find_timer(timer_id) != NULL;
+  bool exists;
+
+  pthread_mutex_lock(&timer_desc.timer_list_mutex);
+  exists = _find_timer(timer_id) != NULL;
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+  return exists;
 }
 
 int timer_remove(long timer_id, void **arg)
 {
-  int rc = 0;
   struct timer_elm_s *timer_p;
 
   OAILOG_DEBUG(LOG_ITTI, "Removing timer 0x%lx\n", timer_id);
   pthread_mutex_lock(&timer_desc.timer_list_mutex);
-  TIMER_SEARCH(timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
+  timer_p = _find_timer(timer_id);
 
   /*
    * We didn't find the timer in list
@@ -310,28 +618,38 @@ int timer_remove(long timer_id, void **arg)
     return -1;
   }
 
-  STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-
   // let user of API get back arg that can be an allocated memory (memory leak).
-
   if (arg) *arg = timer_p->timer_arg;
-  if (timer_delete(timer_p->timer) < 0) {
-    OAILOG_ERROR(
-      LOG_ITTI, "Failed to delete timer 0x%lx\n", (long) timer_p->timer);
-    rc = -1;
-  }
-
-  free_wrapper((void **) &timer_p);
-  return rc;
+  _timer_release(TIMER_ID_INDEX(timer_id));
+  pthread_mutex_unlock(&timer_desc.timer_list_mutex);
+  return 0;
 }
 
 int timer_init(void)
 {
   OAILOG_DEBUG(LOG_ITTI, "Initializing TIMER task interface\n");
   memset(&timer_desc, 0, sizeof(timer_desc_t));
-  STAILQ_INIT(&timer_desc.timer_queue);
   pthread_mutex_init(&timer_desc.timer_list_mutex, NULL);
+  memset(timer_desc.wheel, 0xff, sizeof(timer_desc.wheel));
+  timer_desc.free_head = TIMER_INDEX_NONE;
+  clock_gettime(CLOCK_MONOTONIC, &timer_desc.origin);
+
+  if (_timer_pool_grow() < 0) {
+    OAILOG_ERROR(LOG_ITTI, "Failed to allocate timer pool\n");
+    return -1;
+  }
+
+  timer_desc.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (timer_desc.timer_fd < 0) {
+    OAILOG_ERROR(
+      LOG_ITTI, "Failed to create timerfd: (%s:%d)\n", strerror(errno), errno);
+    return -1;
+  }
+
+  if (itti_create_task(TASK_TIMER, &_timer_thread, NULL) < 0) {
+    OAILOG_ERROR(LOG_ITTI, "Failed to create TIMER task\n");
+    return -1;
+  }
   OAILOG_DEBUG(LOG_ITTI, "Initializing TIMER task interface: DONE\n");
   return 0;
 }
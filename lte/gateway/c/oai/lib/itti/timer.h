@@ -38,8 +38,6 @@
 
 #include "intertask_interface_types.h"
 
-#define SIGTIMER SIGRTMIN
-
 typedef enum timer_type_s {
   TIMER_PERIODIC,
   TIMER_ONE_SHOT,
@@ -52,8 +50,6 @@ typedef enum {
   TIMER_ERR = -2,
 } timer_result_t;
 
-int timer_handle_signal(siginfo_t *info);
-
 /** \brief Request a new timer
  *  \param interval_sec timer interval in seconds
  *  \param interval_us  timer interval in micro seconds
@@ -89,7 +85,8 @@ int timer_remove(long timer_id, void **arg);
 #define timer_stop timer_remove
 
 /** \brief Initialize timer task and its API
- *  \param mme_config MME common configuration
+ *  Timers are run by a hierarchical timing wheel owned by TASK_TIMER, which is
+ *  started here. Expirations are delivered as TIMER_HAS_EXPIRED messages.
  *  @returns -1 on failure, 0 otherwise
  **/
 int timer_init(void);
@@ -0,0 +1,583 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Throughput of the S1AP task, without SCTP nor eNB.
+ *
+ * The eNBs are set up, then each op attaches a UE to the first eNB, releases
+ * it and pages it on every eNB. The PDUs of the eNBs are replayed as the S1AP
+ * task does on SCTP_DATA_IND, through s1ap_mme_decode_pdu() and the handler
+ * dispatch. The messages of MME_APP are handed to the S1AP handlers, which
+ * encode with s1ap_mme_encode_pdu(). The handlers run on the bench thread so
+ * that each message is timed on its own, the messages they send to SCTP,
+ * MME_APP and NAS are freed by sink tasks.
+ *
+ * Per message are reported:
+ * - ns/op
+ * - allocs/op: heap allocations of the bench thread, the codec, S1AP state,
+ *   bstrings and ITTI messages
+ * - codec/op: allocations of the codec, from the S1AP arena or from the heap
+ *
+ * Usage: oai_bench [--smoke]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+
+#include "common_defs.h"
+#include "3gpp_29.274.h"
+#include "mme_config.h"
+#include "log.h"
+#include "shared_ts_log.h"
+#include "s1ap_arena.h"
+#include "s1ap_common.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_decoder.h"
+#include "s1ap_mme_handlers.h"
+#include "s1ap_mme_nas_procedures.h"
+#include "s1ap_state.h"
+#include "s1ap_bench_corpus.h"
+
+#define BENCH_SMOKE_DIVIDER 1000
+#define BENCH_OPS 20000
+
+// eNBs paged, the UEs attach to the first one
+#define BENCH_ENBS 8
+#define BENCH_ASSOC_ID 1
+#define BENCH_INSTREAMS 2
+#define BENCH_OUTSTREAMS 2
+#define BENCH_UE_STREAM 1
+
+#define BENCH_ENB_ID 0x0e00a
+#define BENCH_TAC 1
+#define BENCH_MME_UE_S1AP_ID 7
+#define BENCH_ENB_UE_S1AP_ID 3
+#define BENCH_MME_GID 4
+#define BENCH_MME_CODE 1
+#define BENCH_M_TMSI 0x2bd2f7f1
+#define BENCH_IMSI "001010000000001"
+#define BENCH_E_RAB_ID 5
+#define BENCH_QCI 9
+#define BENCH_PRIORITY_LEVEL 15
+#define BENCH_S1U_TEID 0x0000000b
+
+typedef enum {
+  BENCH_S1_SETUP = 0,
+  BENCH_INITIAL_UE_MESSAGE,
+  BENCH_DOWNLINK_NAS_TRANSPORT,
+  BENCH_UPLINK_NAS_TRANSPORT,
+  BENCH_ICS_REQUEST,
+  BENCH_ICS_RESPONSE,
+  BENCH_UE_CONTEXT_RELEASE_REQUEST,
+  BENCH_UE_CONTEXT_RELEASE_COMMAND,
+  BENCH_UE_CONTEXT_RELEASE_COMPLETE,
+  BENCH_PAGING,
+  BENCH_MESSAGES,
+} bench_message_t;
+
+static const char *const bench_message_names[BENCH_MESSAGES] = {
+  "S1Setup",
+  "InitialUEMessage",
+  "DownlinkNASTransport",
+  "UplinkNASTransport",
+  "InitialContextSetupRequest",
+  "InitialContextSetupResponse",
+  "UEContextReleaseRequest",
+  "UEContextReleaseCommand",
+  "UEContextReleaseComplete",
+  "Paging",
+};
+
+typedef struct bench_counters_s {
+  uint64_t ns;
+  uint64_t allocs;
+  uint64_t codec_allocs;
+} bench_counters_t;
+
+// Tasks the S1AP handlers send messages to
+static const task_id_t bench_sink_tasks[] = {
+  TASK_SCTP,
+  TASK_MME_APP,
+  TASK_NAS_MME,
+};
+
+// Authentication Request
+static const uint8_t bench_authentication_request[] = {
+  0x07, 0x52, 0x00, 0x1f, 0x42, 0x9b, 0x8d, 0x7c, 0x70, 0x53, 0x6a, 0x0d,
+  0x9e, 0x1e, 0xc2, 0x2c, 0x9c, 0x31, 0x65, 0x10, 0x1f, 0x84, 0x5e, 0x49,
+  0x1d, 0x2e, 0x80, 0x00, 0x9b, 0x1c, 0x0d, 0x1b, 0xb4, 0xcd, 0x27, 0x10};
+
+// Attach Accept with an Activate Default EPS Bearer Context Request
+static const uint8_t bench_attach_accept[] = {
+  0x27, 0x5d, 0x12, 0x68, 0x2b, 0x01, 0x07, 0x42, 0x01, 0x49, 0x06, 0x20,
+  0x00, 0xf1, 0x10, 0x00, 0x01, 0x00, 0x2e, 0x52, 0x01, 0xc1, 0x01, 0x09,
+  0x09, 0x08, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x65, 0x74, 0x05, 0x01,
+  0xc0, 0xa8, 0x80, 0x0c, 0x5e, 0x04, 0xfe, 0xfe, 0xde, 0x9e, 0x27, 0x08,
+  0x80, 0x00, 0x0d, 0x04, 0x08, 0x08, 0x08, 0x08, 0x50, 0x0b, 0xf6, 0x00,
+  0xf1, 0x10, 0x00, 0x01, 0x01, 0x2b, 0xd2, 0xf7, 0xf1};
+
+static const uint8_t bench_s1u_address[] = {192, 168, 60, 142};
+
+static uint16_t bench_served_mcc[] = {S1AP_BENCH_MCC};
+static uint16_t bench_served_mnc[] = {S1AP_BENCH_MNC};
+static uint16_t bench_served_mnc_len[] = {S1AP_BENCH_MNC_LEN};
+static uint16_t bench_served_tac[] = {BENCH_TAC};
+
+static s1ap_arena_t bench_arena;
+static bench_counters_t bench_totals[BENCH_MESSAGES];
+
+/*
+ * The binary is linked with --wrap for the allocation functions, the heap
+ * allocations of the bench thread are counted here
+ */
+static __thread uint64_t bench_heap_allocs = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  bench_heap_allocs++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+  bench_heap_allocs++;
+  return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  bench_heap_allocs++;
+  return __real_realloc(ptr, size);
+}
+
+static void *_bench_sink_thread(void *args)
+{
+  task_id_t task_id = *(const task_id_t *) args;
+
+  itti_mark_task_ready(task_id);
+
+  while (1) {
+    MessageDef *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_messages = itti_receive_msgs(
+      task_id, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+
+    for (size_t i = 0; i < nb_messages; i++) {
+      MessageDef *received_message_p = received_messages[i];
+
+      if (ITTI_MSG_ID(received_message_p) == TERMINATE_MESSAGE) {
+        itti_exit_task();
+      }
+      itti_free_msg_content(received_message_p);
+      itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
+    }
+  }
+  return NULL;
+}
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void _bench_allocs(bench_counters_t *counters)
+{
+  s1ap_arena_stats_t stats;
+
+  s1ap_arena_get_stats(&stats);
+  counters->allocs = bench_heap_allocs;
+  counters->codec_allocs = stats.num_arena_allocs + stats.num_malloc_allocs;
+}
+
+static void _bench_start(bench_counters_t *start)
+{
+  _bench_allocs(start);
+  start->ns = _bench_now_ns();
+}
+
+/*
+ * Accounts the message started at start, then gives the codec memory back as
+ * the S1AP task does once a message has been handled
+ */
+static void _bench_stop(bench_message_t m, const bench_counters_t *start)
+{
+  bench_counters_t end;
+
+  end.ns = _bench_now_ns();
+  _bench_allocs(&end);
+  bench_totals[m].ns += end.ns - start->ns;
+  bench_totals[m].allocs += end.allocs - start->allocs;
+  bench_totals[m].codec_allocs += end.codec_allocs - start->codec_allocs;
+  s1ap_arena_reset(&bench_arena);
+}
+
+// Handles the PDU as the S1AP task does on SCTP_DATA_IND
+static int _bench_replay(
+  s1ap_state_t *state,
+  sctp_assoc_id_t assoc_id,
+  sctp_stream_id_t stream,
+  const_bstring pdu)
+{
+  s1ap_message message = {0};
+  MessagesIds message_id = MESSAGES_ID_MAX;
+  int rc = RETURNerror;
+
+  if (s1ap_mme_decode_pdu(&message, pdu, &message_id) >= 0) {
+    rc = s1ap_mme_handle_message(state, assoc_id, stream, &message);
+  }
+  if (message_id != MESSAGES_ID_MAX) {
+    s1ap_free_mme_decode_pdu(&message, message_id);
+  }
+  return rc;
+}
+
+static int _bench_replay_message(
+  s1ap_state_t *state,
+  bench_message_t m,
+  sctp_stream_id_t stream,
+  const_bstring pdu)
+{
+  bench_counters_t start;
+  int rc = RETURNerror;
+
+  _bench_start(&start);
+  rc = _bench_replay(state, BENCH_ASSOC_ID, stream, pdu);
+  _bench_stop(m, &start);
+  return rc;
+}
+
+static void _bench_config(void)
+{
+  mme_config.max_enbs = BENCH_ENBS;
+  mme_config.max_ues = 64;
+  mme_config.use_stateless = false;
+  mme_config.relative_capacity = 10;
+  mme_config.served_tai.list_type =
+    TRACKING_AREA_IDENTITY_LIST_TYPE_ONE_PLMN_NON_CONSECUTIVE_TACS;
+  mme_config.served_tai.nb_tai = 1;
+  mme_config.served_tai.plmn_mcc = bench_served_mcc;
+  mme_config.served_tai.plmn_mnc = bench_served_mnc;
+  mme_config.served_tai.plmn_mnc_len = bench_served_mnc_len;
+  mme_config.served_tai.tac = bench_served_tac;
+  mme_config.gummei.nb = 1;
+  mme_config.gummei.gummei[0].mme_gid = BENCH_MME_GID;
+  mme_config.gummei.gummei[0].mme_code = BENCH_MME_CODE;
+}
+
+// The Create Session Response of the UE, as MME_APP hands it to S1AP
+static void _bench_conn_est_cnf(
+  itti_mme_app_connection_establishment_cnf_t *conn_est_cnf)
+{
+  memset(conn_est_cnf, 0, sizeof(*conn_est_cnf));
+  conn_est_cnf->ue_id = BENCH_MME_UE_S1AP_ID;
+  conn_est_cnf->ue_ambr.br_ul = 100000000;
+  conn_est_cnf->ue_ambr.br_dl = 200000000;
+  conn_est_cnf->no_of_e_rabs = 1;
+  conn_est_cnf->e_rab_id[0] = BENCH_E_RAB_ID;
+  conn_est_cnf->e_rab_level_qos_qci[0] = BENCH_QCI;
+  conn_est_cnf->e_rab_level_qos_priority_level[0] = BENCH_PRIORITY_LEVEL;
+  conn_est_cnf->e_rab_level_qos_preemption_capability[0] =
+    PRE_EMPTION_CAPABILITY_DISABLED;
+  conn_est_cnf->e_rab_level_qos_preemption_vulnerability[0] =
+    PRE_EMPTION_VULNERABILITY_ENABLED;
+  conn_est_cnf->transport_layer_address[0] =
+    blk2bstr(bench_s1u_address, sizeof(bench_s1u_address));
+  conn_est_cnf->gtp_teid[0] = BENCH_S1U_TEID;
+  conn_est_cnf->nas_pdu[0] =
+    blk2bstr(bench_attach_accept, sizeof(bench_attach_accept));
+  conn_est_cnf->ue_security_capabilities_encryption_algorithms = 0xe000;
+  conn_est_cnf->ue_security_capabilities_integrity_algorithms = 0xe000;
+  for (int i = 0; i < AUTH_KENB_SIZE; i++) {
+    conn_est_cnf->kenb[i] = (uint8_t) i;
+  }
+}
+
+static int _bench_setup_enbs(s1ap_state_t *state, bstring *s1_setups)
+{
+  for (int e = 0; e < BENCH_ENBS; e++) {
+    sctp_new_peer_t peer = {
+      .instreams = BENCH_INSTREAMS,
+      .outstreams = BENCH_OUTSTREAMS,
+      .assoc_id = BENCH_ASSOC_ID + e,
+    };
+    enb_description_t *enb = NULL;
+
+    if (
+      s1ap_handle_new_association(state, &peer) != RETURNok ||
+      _bench_replay(state, peer.assoc_id, 0, s1_setups[e]) != RETURNok) {
+      return RETURNerror;
+    }
+    s1ap_arena_reset(&bench_arena);
+    enb = s1ap_state_get_enb(state, peer.assoc_id);
+    if (!enb || enb->s1_state != S1AP_READY) return RETURNerror;
+  }
+  return RETURNok;
+}
+
+/*
+ * Attaches the UE, releases it and pages it, each message in the order the
+ * S1AP task would handle it
+ */
+static int _bench_op(
+  s1ap_state_t *state,
+  size_t op,
+  bstring *s1_setups,
+  bstring *pdus,
+  const itti_mme_app_connection_establishment_cnf_t *conn_est_cnf)
+{
+  itti_mme_app_s1ap_mme_ue_id_notification_t notification = {
+    .enb_ue_s1ap_id = BENCH_ENB_UE_S1AP_ID,
+    .mme_ue_s1ap_id = BENCH_MME_UE_S1AP_ID,
+    .sctp_assoc_id = BENCH_ASSOC_ID,
+  };
+  itti_s1ap_ue_context_release_command_t release_command = {
+    .mme_ue_s1ap_id = BENCH_MME_UE_S1AP_ID,
+    .enb_ue_s1ap_id = BENCH_ENB_UE_S1AP_ID,
+    .cause = S1AP_RADIO_EUTRAN_GENERATED_REASON,
+  };
+  itti_s1ap_paging_request_t paging_request = {
+    .imsi = BENCH_IMSI,
+    .imsi_length = sizeof(BENCH_IMSI) - 1,
+    .m_tmsi = BENCH_M_TMSI,
+    .mme_code = BENCH_MME_CODE,
+    .sctp_assoc_id = BENCH_ASSOC_ID,
+    .paging_id = S1AP_PAGING_ID_STMSI,
+    .domain_indicator = CN_DOMAIN_PS,
+  };
+  sctp_assoc_id_t assoc_id = BENCH_ASSOC_ID + op % BENCH_ENBS;
+  bench_counters_t start;
+  bstring nas = NULL;
+  int rc = RETURNok;
+
+  _bench_start(&start);
+  rc = _bench_replay(state, assoc_id, 0, s1_setups[op % BENCH_ENBS]);
+  _bench_stop(BENCH_S1_SETUP, &start);
+  if (rc != RETURNok) return BENCH_S1_SETUP;
+
+  if (
+    _bench_replay_message(
+      state,
+      BENCH_INITIAL_UE_MESSAGE,
+      BENCH_UE_STREAM,
+      pdus[S1AP_BENCH_INITIAL_UE_MESSAGE]) != RETURNok) {
+    return BENCH_INITIAL_UE_MESSAGE;
+  }
+  s1ap_handle_mme_ue_id_notification(state, &notification);
+
+  // Stolen by the handler, as the NAS message of S1AP_NAS_DL_DATA_REQ
+  nas = blk2bstr(
+    bench_authentication_request, sizeof(bench_authentication_request));
+  _bench_start(&start);
+  rc = s1ap_generate_downlink_nas_transport(
+    state, BENCH_ENB_UE_S1AP_ID, BENCH_MME_UE_S1AP_ID, &nas);
+  _bench_stop(BENCH_DOWNLINK_NAS_TRANSPORT, &start);
+  if (rc != RETURNok) return BENCH_DOWNLINK_NAS_TRANSPORT;
+
+  if (
+    _bench_replay_message(
+      state,
+      BENCH_UPLINK_NAS_TRANSPORT,
+      BENCH_UE_STREAM,
+      pdus[S1AP_BENCH_UPLINK_NAS_TRANSPORT]) != RETURNok) {
+    return BENCH_UPLINK_NAS_TRANSPORT;
+  }
+
+  _bench_start(&start);
+  s1ap_handle_conn_est_cnf(state, conn_est_cnf);
+  _bench_stop(BENCH_ICS_REQUEST, &start);
+
+  if (
+    _bench_replay_message(
+      state,
+      BENCH_ICS_RESPONSE,
+      BENCH_UE_STREAM,
+      pdus[S1AP_BENCH_ICS_RESPONSE]) != RETURNok) {
+    return BENCH_ICS_RESPONSE;
+  }
+  if (
+    _bench_replay_message(
+      state,
+      BENCH_UE_CONTEXT_RELEASE_REQUEST,
+      BENCH_UE_STREAM,
+      pdus[S1AP_BENCH_UE_CONTEXT_RELEASE_REQUEST]) != RETURNok) {
+    return BENCH_UE_CONTEXT_RELEASE_REQUEST;
+  }
+
+  _bench_start(&start);
+  rc = s1ap_handle_ue_context_release_command(state, &release_command);
+  _bench_stop(BENCH_UE_CONTEXT_RELEASE_COMMAND, &start);
+  if (rc != RETURNok || s1ap_state_get_ue_mmeid(state, BENCH_MME_UE_S1AP_ID)) {
+    return BENCH_UE_CONTEXT_RELEASE_COMMAND;
+  }
+
+  if (
+    _bench_replay_message(
+      state,
+      BENCH_UE_CONTEXT_RELEASE_COMPLETE,
+      BENCH_UE_STREAM,
+      pdus[S1AP_BENCH_UE_CONTEXT_RELEASE_COMPLETE]) != RETURNok) {
+    return BENCH_UE_CONTEXT_RELEASE_COMPLETE;
+  }
+
+  _bench_start(&start);
+  rc = s1ap_handle_paging_request(state, &paging_request);
+  _bench_stop(BENCH_PAGING, &start);
+  if (rc != RETURNok) return BENCH_PAGING;
+
+  return BENCH_MESSAGES;
+}
+
+int main(int argc, char *argv[])
+{
+  bool smoke = argc > 1 && strcmp(argv[1], "--smoke") == 0;
+  size_t nb_ops = BENCH_OPS / (smoke ? BENCH_SMOKE_DIVIDER : 1);
+  s1ap_bench_ids_t ids = {
+    .enb_id = BENCH_ENB_ID,
+    .tac = BENCH_TAC,
+    .mme_ue_s1ap_id = BENCH_MME_UE_S1AP_ID,
+    .enb_ue_s1ap_id = BENCH_ENB_UE_S1AP_ID,
+  };
+  bstring s1_setups[BENCH_ENBS] = {NULL};
+  bstring pdus[S1AP_BENCH_ENB_PDUS] = {NULL};
+  itti_mme_app_connection_establishment_cnf_t conn_est_cnf;
+  s1ap_state_t *state = NULL;
+
+  _bench_config();
+  if (
+    itti_init(
+      TASK_MAX,
+      THREAD_MAX,
+      MESSAGES_ID_MAX,
+      tasks_info,
+      messages_info,
+      NULL,
+      NULL) != RETURNok ||
+    OAILOG_INIT(
+      MME_CONFIG_STRING_MME_CONFIG, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS) !=
+      RETURNok ||
+    shared_log_init(MAX_LOG_PROTOS) != RETURNok) {
+    fprintf(stderr, "Cannot initialize ITTI and the logs\n");
+    return EXIT_FAILURE;
+  }
+  for (size_t t = 0; t < sizeof(bench_sink_tasks) / sizeof(bench_sink_tasks[0]);
+       t++) {
+    if (
+      itti_create_task(
+        bench_sink_tasks[t],
+        _bench_sink_thread,
+        (void *) &bench_sink_tasks[t]) != RETURNok) {
+      fprintf(
+        stderr,
+        "Cannot create the %s sink\n",
+        itti_get_task_name(bench_sink_tasks[t]));
+      return EXIT_FAILURE;
+    }
+  }
+  if (
+    s1ap_state_init() != RETURNok ||
+    !s1ap_arena_init(&bench_arena, S1AP_ARENA_CHUNK_SIZE)) {
+    fprintf(stderr, "Cannot initialize the S1AP state\n");
+    return EXIT_FAILURE;
+  }
+  s1ap_arena_use(&bench_arena);
+  // As on the ACTIVATE_MESSAGE of the S6a task
+  hss_associated = true;
+
+  for (int e = 0; e < BENCH_ENBS; e++) {
+    ids.enb_id = BENCH_ENB_ID + e;
+    s1_setups[e] = s1ap_bench_enb_pdu(S1AP_BENCH_S1_SETUP_REQUEST, &ids);
+    if (!s1_setups[e]) {
+      fprintf(stderr, "Cannot encode the S1 Setup Request of eNB %d\n", e);
+      return EXIT_FAILURE;
+    }
+  }
+  ids.enb_id = BENCH_ENB_ID;
+  for (int p = S1AP_BENCH_S1_SETUP_REQUEST + 1; p < S1AP_BENCH_ENB_PDUS; p++) {
+    pdus[p] = s1ap_bench_enb_pdu(p, &ids);
+    if (!pdus[p]) {
+      fprintf(stderr, "Cannot encode %s\n", s1ap_bench_enb_pdu_names[p]);
+      return EXIT_FAILURE;
+    }
+  }
+  _bench_conn_est_cnf(&conn_est_cnf);
+
+  state = s1ap_state_get();
+  if (_bench_setup_enbs(state, s1_setups) != RETURNok) {
+    fprintf(stderr, "Cannot set up the eNBs\n");
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 0; i < nb_ops; i++) {
+    int failed = _bench_op(state, i, s1_setups, pdus, &conn_est_cnf);
+
+    if (failed != BENCH_MESSAGES) {
+      fprintf(
+        stderr,
+        "Op %zu: %s was not handled\n",
+        i,
+        bench_message_names[failed]);
+      return EXIT_FAILURE;
+    }
+  }
+  s1ap_state_put(state);
+
+  printf(
+    "%zu ops, %d eNBs paged, S1AP arena %s\n",
+    nb_ops,
+    BENCH_ENBS,
+    S1AP_ARENA ? "on" : "off");
+  printf(
+    "%-28s %12s %12s %12s\n", "message", "ns/op", "allocs/op", "codec/op");
+  for (int m = 0; m < BENCH_MESSAGES; m++) {
+    printf(
+      "%-28s %12.1f %12.1f %12.1f\n",
+      bench_message_names[m],
+      (double) bench_totals[m].ns / (double) nb_ops,
+      (double) bench_totals[m].allocs / (double) nb_ops,
+      (double) bench_totals[m].codec_allocs / (double) nb_ops);
+  }
+
+  s1ap_arena_use(NULL);
+  s1ap_arena_destroy(&bench_arena);
+  for (int e = 0; e < BENCH_ENBS; e++) {
+    bdestroy(s1_setups[e]);
+  }
+  for (int p = 0; p < S1AP_BENCH_ENB_PDUS; p++) {
+    bdestroy(pdus[p]);
+  }
+  bdestroy(conn_est_cnf.transport_layer_address[0]);
+  bdestroy(conn_est_cnf.nas_pdu[0]);
+  return EXIT_SUCCESS;
+}
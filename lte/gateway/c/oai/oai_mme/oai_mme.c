@@ -95,6 +95,9 @@ int main(int argc, char *argv[])
   // Intialize loggers and configured log levels.
   OAILOG_LOG_CONFIGURE(&mme_config.log_config);
   CHECK_INIT_RETURN(service303_init(&(mme_config.service303_config)));
+  service303_itti_metrics_enable(mme_config.itti_config.metrics);
+  service303_hashtable_metrics_enable(mme_config.hashtable_metrics);
+  s1ap_mme_watch_queues(&mme_config.itti_config);
 
   // Service started, but not healthy yet
   send_app_health_to_service303(TASK_MME_APP, false);
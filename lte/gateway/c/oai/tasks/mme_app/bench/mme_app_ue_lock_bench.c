@@ -0,0 +1,290 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Benchmark of the UE context lock.
+ *
+ * First the cost of a lock and unlock of a UE context by a single thread:
+ * - timedlock: the previous lock_ue_contexts(), gettimeofday() and
+ *   pthread_mutex_timedlock() on a recursive mutex, its logs left out
+ * - mutex: pthread_mutex_lock() on a recursive mutex
+ * - ue_lock: mme_app_ue_lock(), and taken again while held
+ * The cost per attach is for BENCH_LOCKS_PER_ATTACH locks, an estimate of
+ * the handlers and NAS helpers locking the context during an attach.
+ *
+ * Then 1 to BENCH_MAX_THREADS threads lock either their own UEs, as the
+ * MME_APP workers do, or all the same UE. Each thread increments a counter
+ * of the UE under the lock, a lost increment fails the run.
+ *
+ * Usage: mme_app_ue_lock_bench [--smoke]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "mme_app_ue_lock.h"
+
+#define BENCH_SMOKE_DIVIDER 100
+#define BENCH_LOCKS 10000000
+#define BENCH_LOCKS_PER_ATTACH 64
+#define BENCH_MAX_THREADS 8
+#define BENCH_UES_PER_THREAD 64
+
+typedef enum bench_lock_type_e {
+  BENCH_LOCK_TIMEDLOCK = 0,
+  BENCH_LOCK_MUTEX,
+  BENCH_LOCK_UE_LOCK,
+  BENCH_LOCK_UE_LOCK_NESTED,
+  BENCH_LOCK_TYPE_MAX,
+} bench_lock_type_t;
+
+static const char *const bench_lock_names[BENCH_LOCK_TYPE_MAX] = {
+  "timedlock",
+  "mutex",
+  "ue_lock",
+  "ue_lock nested",
+};
+
+// A UE context reduced to its lock and some state it protects
+typedef struct bench_ue_s {
+  pthread_mutex_t mutex;
+  mme_app_ue_lock_t lock;
+  uint64_t counter;
+  char padding[64];
+} bench_ue_t;
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void _bench_ue_init(bench_ue_t *ue)
+{
+  pthread_mutexattr_t mutexattr;
+
+  memset(ue, 0, sizeof(*ue));
+  pthread_mutexattr_init(&mutexattr);
+  pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&ue->mutex, &mutexattr);
+  pthread_mutexattr_destroy(&mutexattr);
+  mme_app_ue_lock_init(&ue->lock);
+}
+
+static int _bench_lock(bench_ue_t *ue, bench_lock_type_t type)
+{
+  struct timeval now;
+  struct timespec wait;
+
+  switch (type) {
+    case BENCH_LOCK_TIMEDLOCK:
+      gettimeofday(&now, NULL);
+      wait.tv_sec = now.tv_sec + 5;
+      wait.tv_nsec = now.tv_usec * 1000;
+      return pthread_mutex_timedlock(&ue->mutex, &wait);
+    case BENCH_LOCK_MUTEX:
+      return pthread_mutex_lock(&ue->mutex);
+    default:
+      return mme_app_ue_lock(&ue->lock);
+  }
+}
+
+static int _bench_unlock(bench_ue_t *ue, bench_lock_type_t type)
+{
+  switch (type) {
+    case BENCH_LOCK_TIMEDLOCK:
+    case BENCH_LOCK_MUTEX:
+      return pthread_mutex_unlock(&ue->mutex);
+    default:
+      return mme_app_ue_unlock(&ue->lock);
+  }
+}
+
+// Returns the ns per lock and unlock of a UE context by a single thread
+static double _bench_run_single(bench_lock_type_t type, size_t nb_locks)
+{
+  bench_ue_t ue;
+  size_t errors = 0;
+  uint64_t t0 = 0, ns = 0;
+
+  _bench_ue_init(&ue);
+  if (type == BENCH_LOCK_UE_LOCK_NESTED) {
+    errors += mme_app_ue_lock(&ue.lock) != 0;
+  }
+  t0 = _bench_now_ns();
+  for (size_t i = 0; i < nb_locks; i++) {
+    errors += _bench_lock(&ue, type) != 0;
+    ue.counter++;
+    errors += _bench_unlock(&ue, type) != 0;
+  }
+  ns = _bench_now_ns() - t0;
+  if (type == BENCH_LOCK_UE_LOCK_NESTED) {
+    errors += mme_app_ue_unlock(&ue.lock) != 0;
+  }
+  // The lock is free again, another thread could take it
+  errors += mme_app_ue_unlock(&ue.lock) == 0;
+  if (errors || ue.counter != nb_locks) {
+    fprintf(stderr, "%s: %zu lock errors\n", bench_lock_names[type], errors);
+    exit(EXIT_FAILURE);
+  }
+  return (double) ns / (double) nb_locks;
+}
+
+typedef struct bench_thread_s {
+  pthread_t thread;
+  bench_lock_type_t type;
+  bench_ue_t *ues;
+  size_t nb_ues;
+  size_t nb_locks;
+  size_t errors;
+} bench_thread_t;
+
+static void *_bench_locker(void *arg)
+{
+  bench_thread_t *locker = (bench_thread_t *) arg;
+
+  for (size_t i = 0; i < locker->nb_locks; i++) {
+    bench_ue_t *ue = &locker->ues[i % locker->nb_ues];
+
+    locker->errors += _bench_lock(ue, locker->type) != 0;
+    ue->counter++;
+    locker->errors += _bench_unlock(ue, locker->type) != 0;
+  }
+  return NULL;
+}
+
+static void _bench_run_threads(
+  bench_lock_type_t type,
+  int nb_threads,
+  bool shared,
+  size_t nb_locks)
+{
+  const size_t nb_ues = shared ? 1 : nb_threads * BENCH_UES_PER_THREAD;
+  bench_ue_t *ues = calloc(nb_ues, sizeof(bench_ue_t));
+  bench_thread_t threads[BENCH_MAX_THREADS];
+  mme_app_ue_lock_stats_t before, after;
+  uint64_t t0 = 0, ns = 0, total = 0;
+  size_t errors = 0;
+
+  if (!ues) {
+    fprintf(stderr, "Cannot allocate %zu UEs\n", nb_ues);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t u = 0; u < nb_ues; u++) {
+    _bench_ue_init(&ues[u]);
+  }
+  memset(threads, 0, sizeof(threads));
+  mme_app_ue_lock_get_stats(&before);
+  t0 = _bench_now_ns();
+  for (int t = 0; t < nb_threads; t++) {
+    threads[t].type = type;
+    threads[t].ues = shared ? ues : ues + t * BENCH_UES_PER_THREAD;
+    threads[t].nb_ues = shared ? 1 : BENCH_UES_PER_THREAD;
+    threads[t].nb_locks = nb_locks;
+    pthread_create(&threads[t].thread, NULL, _bench_locker, &threads[t]);
+  }
+  for (int t = 0; t < nb_threads; t++) {
+    pthread_join(threads[t].thread, NULL);
+    errors += threads[t].errors;
+  }
+  ns = _bench_now_ns() - t0;
+  mme_app_ue_lock_get_stats(&after);
+  for (size_t u = 0; u < nb_ues; u++) {
+    total += ues[u].counter;
+  }
+
+  printf(
+    "%-14s %-7s %7d %9.2f %10" PRIu64 " %10" PRIu64 "\n",
+    bench_lock_names[type],
+    shared ? "shared" : "owned",
+    nb_threads,
+    ns ? (double) total * 1000.0 / (double) ns : 0.0,
+    after.nb_contended - before.nb_contended,
+    after.nb_waits - before.nb_waits);
+  free(ues);
+  if (errors || total != nb_threads * nb_locks) {
+    fprintf(
+      stderr,
+      "%s: %zu lock errors, %" PRIu64 " of %zu increments\n",
+      bench_lock_names[type],
+      errors,
+      total,
+      nb_threads * nb_locks);
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void *_bench_idle(void *arg)
+{
+  return arg;
+}
+
+int main(int argc, char *argv[])
+{
+  bool smoke = argc > 1 && strcmp(argv[1], "--smoke") == 0;
+  size_t nb_locks = smoke ? BENCH_LOCKS / BENCH_SMOKE_DIVIDER : BENCH_LOCKS;
+  pthread_t idle;
+
+  // glibc skips the atomic operations of the mutexes until a thread starts
+  pthread_create(&idle, NULL, _bench_idle, NULL);
+  pthread_join(idle, NULL);
+
+  printf("%-14s %9s %9s %9s\n", "lock", "lock", "attach", "attaches");
+  printf("%14s %9s %9s %9s\n", "", "(ns)", "(us)", "(k/s)");
+  for (int type = 0; type < BENCH_LOCK_TYPE_MAX; type++) {
+    double ns = _bench_run_single(type, nb_locks);
+
+    // Attaches per second if the UE locks were all an attach did
+    printf(
+      "%-14s %9.1f %9.2f %9.0f\n",
+      bench_lock_names[type],
+      ns,
+      ns * BENCH_LOCKS_PER_ATTACH / 1000.0,
+      1000000.0 / (ns * BENCH_LOCKS_PER_ATTACH));
+  }
+
+  printf(
+    "\n%-14s %-7s %7s %9s %10s %10s\n",
+    "lock",
+    "ues",
+    "threads",
+    "locks",
+    "contended",
+    "waits");
+  printf("%30s %9s\n", "", "(Mops/s)");
+  for (int type = BENCH_LOCK_MUTEX; type <= BENCH_LOCK_UE_LOCK; type++) {
+    for (int shared = 0; shared <= 1; shared++) {
+      for (int threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+        _bench_run_threads(type, threads, shared, nb_locks / threads);
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -41,25 +41,29 @@ struct apn_configuration_s *mme_app_select_apn(
   ue_mm_context_t *const ue_context,
   const_bstring const ue_selected_apn)
 {
-  context_identifier_t default_context_identifier =
-    ue_context->apn_config_profile.context_identifier;
+  apn_config_profile_t *apn_config_profile = ue_context->apn_config_profile;
+  context_identifier_t default_context_identifier;
   int index;
 
-  for (index = 0; index < ue_context->apn_config_profile.nb_apns; index++) {
+  if (!apn_config_profile) {
+    return NULL;
+  }
+  default_context_identifier = apn_config_profile->context_identifier;
+
+  for (index = 0; index < apn_config_profile->nb_apns; index++) {
     if (!ue_selected_apn) {
       /*
        * OK we got our default APN
        */
       if (
-        ue_context->apn_config_profile.apn_configuration[index]
-          .context_identifier == default_context_identifier) {
+        apn_config_profile->apn_configuration[index].context_identifier ==
+        default_context_identifier) {
         OAILOG_DEBUG(
           LOG_MME_APP,
           "Selected APN %s for UE " IMSI_64_FMT "\n",
-          ue_context->apn_config_profile.apn_configuration[index]
-            .service_selection,
+          apn_config_profile->apn_configuration[index].service_selection,
           ue_context->emm_context._imsi64);
-        return &ue_context->apn_config_profile.apn_configuration[index];
+        return &apn_config_profile->apn_configuration[index];
       }
     } else {
       /*
@@ -68,17 +72,15 @@ struct apn_configuration_s *mme_app_select_apn(
       if (
         biseqcaselessblk(
           ue_selected_apn,
-          ue_context->apn_config_profile.apn_configuration[index]
-            .service_selection,
-          strlen(ue_context->apn_config_profile.apn_configuration[index]
+          apn_config_profile->apn_configuration[index].service_selection,
+          strlen(apn_config_profile->apn_configuration[index]
                    .service_selection)) == 1) {
         OAILOG_DEBUG(
           LOG_MME_APP,
           "Selected APN %s for UE " IMSI_64_FMT "\n",
-          ue_context->apn_config_profile.apn_configuration[index]
-            .service_selection,
+          apn_config_profile->apn_configuration[index].service_selection,
           ue_context->emm_context._imsi64);
-        return &ue_context->apn_config_profile.apn_configuration[index];
+        return &apn_config_profile->apn_configuration[index];
       }
     }
   }
@@ -91,13 +93,17 @@ struct apn_configuration_s *mme_app_get_apn_config(
   ue_mm_context_t *const ue_context,
   const context_identifier_t context_identifier)
 {
+  apn_config_profile_t *apn_config_profile = ue_context->apn_config_profile;
   int index;
 
-  for (index = 0; index < ue_context->apn_config_profile.nb_apns; index++) {
+  if (!apn_config_profile) {
+    return NULL;
+  }
+  for (index = 0; index < apn_config_profile->nb_apns; index++) {
     if (
-      ue_context->apn_config_profile.apn_configuration[index]
-        .context_identifier == context_identifier) {
-      return &ue_context->apn_config_profile.apn_configuration[index];
+      apn_config_profile->apn_configuration[index].context_identifier ==
+      context_identifier) {
+      return &apn_config_profile->apn_configuration[index];
     }
   }
   return NULL;
@@ -167,10 +167,6 @@ int _send_pcrf_bearer_actv_rsp(
 }
 
 //---------------------------------------------------------------------------
-static bool mme_app_construct_guti(
-  const plmn_t *const plmn_p,
-  const s_tmsi_t *const s_tmsi_p,
-  guti_t *const guti_p);
 static void notify_s1ap_new_ue_mme_s1ap_id_association(
   struct ue_mm_context_s *ue_context_p);
 
@@ -183,7 +179,6 @@ int mme_app_handle_nas_pdn_connectivity_req(
   imsi64_t imsi64 = INVALID_IMSI64;
   int rc = RETURNok;
   mme_ue_s1ap_id_t ue_id = INVALID_MME_UE_S1AP_ID;
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
 
   DevAssert(nas_pdn_connectivity_req_pP);
   IMSI_STRING_TO_IMSI64((char *) nas_pdn_connectivity_req_pP->imsi, &imsi64);
@@ -239,26 +234,6 @@ int mme_app_handle_nas_pdn_connectivity_req(
         nas_pdn_connectivity_req_pP->imsi_length,
         ue_context_p->mme_teid_s11,
         &ue_context_p->emm_context._guti);
-      /*
-       * In some cases if ue context already has valid value , hashtables are not updated by mme_ue_context_update_coll_keys
-       * function. Inserting mme_ue_s1ap_id in imsi hashtable explicitly
-       */
-      h_rc = hashtable_uint64_ts_insert(
-        mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl,
-        (const hash_key_t) imsi64,
-        ue_context_p->mme_ue_s1ap_id);
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "Error could not update this ue context %p "
-          "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-          " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT ": %s\n",
-          ue_context_p,
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id,
-          imsi64,
-          hashtable_rc_code2string(h_rc));
-      }
       mme_ue_context_dump_coll_keys();
     } else {
       OAILOG_ERROR(
@@ -612,9 +587,10 @@ void mme_app_handle_initial_ue_message(
               ue_context_p->mme_ue_s1ap_id);
             mme_app_itti_ue_context_release(
               ue_context_p, ue_context_p->ue_context_rel_cause);
-            hashtable_uint64_ts_remove(
-              mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl,
-              (const hash_key_t) ue_context_p->enb_s1ap_id_key);
+            mme_ue_context_remove_coll_key(
+              &mme_app_desc.mme_ue_contexts,
+              ue_context_p,
+              MME_UE_COLL_KEY_ENB_S1AP_ID);
             ue_context_p->enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
             ue_context_p->ue_context_rel_cause = S1AP_INVALID_CAUSE;
           }
@@ -860,9 +836,8 @@ void mme_app_handle_delete_session_rsp(
       delete_sess_resp_pP->teid);
     OAILOG_FUNC_OUT(LOG_MME_APP);
   }
-  hashtable_uint64_ts_remove(
-    mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl,
-    (const hash_key_t) ue_context_p->mme_teid_s11);
+  mme_ue_context_remove_coll_key(
+    &mme_app_desc.mme_ue_contexts, ue_context_p, MME_UE_COLL_KEY_S11_TEID);
   ue_context_p->mme_teid_s11 = 0;
 
   if (delete_sess_resp_pP->cause.cause_value != REQUEST_ACCEPTED) {
@@ -1782,7 +1757,7 @@ void mme_app_handle_initial_context_setup_failure(
   OAILOG_FUNC_OUT(LOG_MME_APP);
 }
 //------------------------------------------------------------------------------
-static bool mme_app_construct_guti(
+bool mme_app_construct_guti(
   const plmn_t *const plmn_p,
   const s_tmsi_t *const s_tmsi_p,
   guti_t *const guti_p)
@@ -2848,9 +2823,10 @@ void mme_app_handle_path_switch_request(
   }
   if (ue_context_p->enb_s1ap_id_key != INVALID_ENB_UE_S1AP_ID_KEY) {
     /* Remove existing enb_s1ap_id_key which is mapped with suorce eNB  */
-    hashtable_uint64_ts_remove(
-          mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl,
-          (const hash_key_t) ue_context_p->enb_s1ap_id_key);
+    mme_ue_context_remove_coll_key(
+      &mme_app_desc.mme_ue_contexts,
+      ue_context_p,
+      MME_UE_COLL_KEY_ENB_S1AP_ID);
     ue_context_p->enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
   }
   // Update MME UE context with new enb_ue_s1ap_id
@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/time.h>
 #include <pthread.h>
@@ -63,10 +64,12 @@
 #include "3gpp_24.008.h"
 #include "3gpp_29.274.h"
 #include "3gpp_36.401.h"
+#include "TrackingAreaIdentity.h"
 #include "bstrlib.h"
 #include "emm_data.h"
 #include "esm_data.h"
 #include "hashtable.h"
+#include "hashtable_epoch.h"
 #include "intertask_interface_types.h"
 #include "itti_types.h"
 #include "mme_api.h"
@@ -124,109 +127,94 @@ static void _directoryd_remove_location(uint64_t imsi, uint8_t imsi_len)
 }
 
 //------------------------------------------------------------------------------
-int lock_ue_contexts(ue_mm_context_t *const ue_mm_context)
+static void _mme_ue_context_free(void *ue_mm_context)
 {
-  OAILOG_FUNC_IN(LOG_MME_APP);
-  int rc = RETURNerror;
-  if (ue_mm_context) {
-    struct timeval start_time;
-    gettimeofday(&start_time, NULL);
-    struct timespec wait = {0}; // timed is useful for debug
-    wait.tv_sec = start_time.tv_sec + 5;
-    wait.tv_nsec = start_time.tv_usec * 1000;
-    rc = pthread_mutex_timedlock(&ue_mm_context->recmutex, &wait);
-    if (rc) {
-      OAILOG_ERROR(
-        LOG_MME_APP,
-        "Cannot lock UE context mutex, err=%s " MME_UE_S1AP_ID_FMT "\n",
-        strerror(rc),
-        ue_mm_context->mme_ue_s1ap_id);
-#if ASSERT_MUTEX
-      struct timeval end_time;
-      gettimeofday(&end_time, NULL);
-      AssertFatal(
-        !rc,
-        "Cannot lock UE context mutex, err=%s took %ld seconds \n",
-        strerror(rc),
-        end_time.tv_sec - start_time.tv_sec);
-#endif
-    } else {
-      OAILOG_DEBUG(
-        LOG_MME_APP,
-        "Locked UE context mutex for " MME_UE_S1AP_ID_FMT "\n",
-        ue_mm_context->mme_ue_s1ap_id);
-#if DEBUG_MUTEX
-      OAILOG_TRACE(
-        LOG_MME_APP,
-        "UE context mutex locked, count %d lock %d\n",
-        ue_mm_context->recmutex.__data.__count,
-        ue_mm_context->recmutex.__data.__lock);
-#endif
+  free_wrapper(&ue_mm_context);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Takes a reference on a UE context read from the registry, between
+ * hashtable_epoch_enter() and hashtable_epoch_exit(): the context may be
+ * retired meanwhile but not freed. Fails once its last reference is gone.
+ */
+static bool _mme_ue_context_try_ref(ue_mm_context_t *const ue_mm_context)
+{
+  uint32_t refcount =
+    __atomic_load_n(&ue_mm_context->refcount, __ATOMIC_RELAXED);
+
+  do {
+    if (refcount == 0) {
+      return false;
     }
+  } while (!__atomic_compare_exchange_n(
+    &ue_mm_context->refcount,
+    &refcount,
+    refcount + 1,
+    true,
+    __ATOMIC_ACQUIRE,
+    __ATOMIC_RELAXED));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// The lookups that may still read the context are waited for by the retire
+static void _mme_ue_context_unref(
+  ue_mm_context_t *const ue_mm_context,
+  const uint32_t nb_refs)
+{
+  if (!__atomic_sub_fetch(&ue_mm_context->refcount, nb_refs, __ATOMIC_ACQ_REL)) {
+    hashtable_epoch_retire(ue_mm_context, _mme_ue_context_free);
   }
-  OAILOG_FUNC_RETURN(LOG_MME_APP, rc);
+}
+
+//------------------------------------------------------------------------------
+// The caller must already hold a reference, or the lock, on the context
+int lock_ue_contexts(ue_mm_context_t *const ue_mm_context)
+{
+  if (!ue_mm_context) {
+    return RETURNerror;
+  }
+  __atomic_fetch_add(&ue_mm_context->refcount, 1, __ATOMIC_RELAXED);
+  return mme_app_ue_lock(&ue_mm_context->lock);
 }
 //------------------------------------------------------------------------------
 int unlock_ue_contexts(ue_mm_context_t *const ue_mm_context)
 {
-  OAILOG_FUNC_IN(LOG_MME_APP);
   int rc = RETURNerror;
+
   if (ue_mm_context) {
-    OAILOG_DEBUG(
-      LOG_MME_APP,
-      "Unlocking UE context mutex for " MME_UE_S1AP_ID_FMT "\n",
-      ue_mm_context->mme_ue_s1ap_id);
-    rc = pthread_mutex_unlock(&ue_mm_context->recmutex);
+    rc = mme_app_ue_unlock(&ue_mm_context->lock);
     if (rc) {
       OAILOG_ERROR(
-        LOG_MME_APP, "Cannot unlock UE context mutex, err=%s\n", strerror(rc));
+        LOG_MME_APP,
+        "Cannot unlock UE context " MME_UE_S1AP_ID_FMT
+        ", not held by this thread\n",
+        ue_mm_context->mme_ue_s1ap_id);
+    } else {
+      _mme_ue_context_unref(ue_mm_context, 1);
     }
-#if DEBUG_MUTEX
-    OAILOG_TRACE(
-      LOG_MME_APP,
-      "UE context mutex unlocked, count %d lock %d\n",
-      ue_mm_context->recmutex.__data.__count,
-      ue_mm_context->recmutex.__data.__lock);
-#endif
   }
-  OAILOG_FUNC_RETURN(LOG_MME_APP, rc);
+  return rc;
 }
 //------------------------------------------------------------------------------
 // warning: lock the UE context
 ue_mm_context_t *mme_create_new_ue_context(void)
 {
   ue_mm_context_t *new_p = calloc(1, sizeof(ue_mm_context_t));
-  pthread_mutexattr_t mutexattr = {0};
-  int rc = pthread_mutexattr_init(&mutexattr);
-  if (rc) {
-    OAILOG_ERROR(
-      LOG_MME_APP,
-      "Cannot create UE context, failed to init mutex attribute: %s\n",
-      strerror(rc));
-    return NULL;
-  }
-  rc = pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE);
-  if (rc) {
-    OAILOG_ERROR(
-      LOG_MME_APP,
-      "Cannot create UE context, failed to set mutex attribute type: %s\n",
-      strerror(rc));
-    return NULL;
-  }
-  rc = pthread_mutex_init(&new_p->recmutex, &mutexattr);
-  if (rc) {
-    OAILOG_ERROR(
-      LOG_MME_APP,
-      "Cannot create UE context, failed to init mutex: %s\n",
-      strerror(rc));
+  int rc = RETURNok;
+
+  if (!new_p) {
+    OAILOG_ERROR(LOG_MME_APP, "Cannot allocate a UE context\n");
     return NULL;
   }
+  mme_app_ue_lock_init(&new_p->lock);
+  // Dropped by mme_remove_ue_context()
+  new_p->refcount = 1;
   rc = lock_ue_contexts(new_p);
   if (rc) {
-    OAILOG_ERROR(
-      LOG_MME_APP,
-      "Cannot create UE context, failed to lock mutex: %s\n",
-      strerror(rc));
+    OAILOG_ERROR(LOG_MME_APP, "Cannot create UE context, failed to lock it\n");
+    free(new_p);
     return NULL;
   }
 
@@ -325,6 +313,7 @@ void mme_app_ue_context_free_content(ue_mm_context_t *const ue_context_p)
   bdestroy_wrapper(&ue_context_p->msisdn);
   bdestroy_wrapper(&ue_context_p->ue_radio_capability);
   bdestroy_wrapper(&ue_context_p->apn_oi_replacement);
+  free_wrapper((void **) &ue_context_p->apn_config_profile);
 
   // Stop Mobile reachability timer,if running
   if (ue_context_p->mobile_reachability_timer.id != MME_APP_TIMER_INACTIVE_ID) {
@@ -416,22 +405,65 @@ void mme_app_ue_context_free_content(ue_mm_context_t *const ue_context_p)
 }
 
 //------------------------------------------------------------------------------
-ue_mm_context_t *mme_ue_context_exists_enb_ue_s1ap_id(
+static size_t _mme_app_bstring_size(const_bstring b)
+{
+  return b ? sizeof(*b) + b->mlen : 0;
+}
+
+//------------------------------------------------------------------------------
+size_t mme_app_ue_context_size(const ue_mm_context_t *const ue_context_p)
+{
+  size_t size = sizeof(*ue_context_p);
+
+  size += _mme_app_bstring_size(ue_context_p->msisdn);
+  size += _mme_app_bstring_size(ue_context_p->ue_radio_capability);
+  size += _mme_app_bstring_size(ue_context_p->apn_oi_replacement);
+  if (ue_context_p->apn_config_profile) {
+    size += sizeof(*ue_context_p->apn_config_profile);
+  }
+  for (int i = 0; i < MAX_APN_PER_UE; i++) {
+    if (ue_context_p->pdn_contexts[i]) {
+      size += sizeof(*ue_context_p->pdn_contexts[i]);
+    }
+  }
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if (ue_context_p->bearer_contexts[i]) {
+      size += sizeof(*ue_context_p->bearer_contexts[i]);
+    }
+  }
+  if (ue_context_p->sgs_context) {
+    size += sizeof(*ue_context_p->sgs_context);
+  }
+  return size;
+}
+
+//------------------------------------------------------------------------------
+// UE context indexed by key in the coll_key index of the UE registry, locked
+static ue_mm_context_t *_mme_ue_context_exists_coll_key(
   mme_ue_context_t *const mme_ue_context_p,
-  const enb_s1ap_id_key_t enb_key)
+  const mme_ue_coll_key_t coll_key,
+  const hash_key_t key)
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
   uint64_t mme_ue_s1ap_id64 = 0;
 
-  hashtable_uint64_ts_get(
-    mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-    (const hash_key_t) enb_key,
-    &mme_ue_s1ap_id64);
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id(
-      mme_ue_context_p, (mme_ue_s1ap_id_t) mme_ue_s1ap_id64);
+  if (
+    HASH_TABLE_OK != hashtable_uint64_ts_get(
+                       mme_ue_context_p->coll_key_htbl[coll_key],
+                       key,
+                       &mme_ue_s1ap_id64)) {
+    return NULL;
   }
-  return NULL;
+  return mme_ue_context_exists_mme_ue_s1ap_id(
+    mme_ue_context_p, (mme_ue_s1ap_id_t) mme_ue_s1ap_id64);
+}
+
+//------------------------------------------------------------------------------
+ue_mm_context_t *mme_ue_context_exists_enb_ue_s1ap_id(
+  mme_ue_context_t *const mme_ue_context_p,
+  const enb_s1ap_id_key_t enb_key)
+{
+  return _mme_ue_context_exists_coll_key(
+    mme_ue_context_p, MME_UE_COLL_KEY_ENB_S1AP_ID, (const hash_key_t) enb_key);
 }
 
 //------------------------------------------------------------------------------
@@ -441,12 +473,23 @@ ue_mm_context_t *mme_ue_context_exists_mme_ue_s1ap_id(
 {
   struct ue_mm_context_s *ue_context_p = NULL;
 
+  hashtable_epoch_enter();
   hashtable_ts_get(
     mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
     (const hash_key_t) mme_ue_s1ap_id,
     (void **) &ue_context_p);
+  if (ue_context_p && !_mme_ue_context_try_ref(ue_context_p)) {
+    ue_context_p = NULL;
+  }
+  hashtable_epoch_exit();
   if (ue_context_p) {
-    lock_ue_contexts(ue_context_p);
+    // The reference taken above is the one of this lock level
+    mme_app_ue_lock(&ue_context_p->lock);
+    if (INVALID_MME_UE_S1AP_ID == ue_context_p->registry_slot.mme_ue_s1ap_id) {
+      // Removed by its worker while this thread waited for the lock
+      unlock_ue_contexts(ue_context_p);
+      return NULL;
+    }
     OAILOG_TRACE(
       LOG_MME_APP,
       "UE  " MME_UE_S1AP_ID_FMT " fetched MM state %s, ECM state %s\n ",
@@ -461,27 +504,69 @@ ue_mm_context_t *mme_ue_context_exists_mme_ue_s1ap_id(
   }
   return ue_context_p;
 }
+//------------------------------------------------------------------------------
+ue_mm_context_t *mme_ue_context_walk_start(
+  mme_ue_context_t *const mme_ue_context_p)
+{
+  hashtable_ts_cursor_t cursor;
+  hash_key_t key = 0;
+  ue_mm_context_t *ue_context_p = NULL;
+  ue_mm_context_t *walk = NULL;
+  ue_mm_context_t *last = NULL;
+
+  hashtable_ts_cursor_init(
+    &cursor,
+    mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
+    HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &key, (void **) &ue_context_p)) {
+    // Seen twice when its mme_ue_s1ap_id changed during the walk
+    if (ue_context_p->walk_next || ue_context_p == last) {
+      continue;
+    }
+    // Never waits: the lock of a stripe is held
+    if (_mme_ue_context_try_ref(ue_context_p)) {
+      if (last) {
+        last->walk_next = ue_context_p;
+      } else {
+        walk = ue_context_p;
+      }
+      last = ue_context_p;
+    }
+  }
+  return walk;
+}
+
+//------------------------------------------------------------------------------
+ue_mm_context_t *mme_ue_context_walk_next(ue_mm_context_t **const walk_p)
+{
+  ue_mm_context_t *ue_context_p = NULL;
+
+  while ((ue_context_p = *walk_p)) {
+    *walk_p = ue_context_p->walk_next;
+    ue_context_p->walk_next = NULL;
+    // The reference of the walk is the one of this lock level
+    mme_app_ue_lock(&ue_context_p->lock);
+    if (INVALID_MME_UE_S1AP_ID != ue_context_p->registry_slot.mme_ue_s1ap_id) {
+      return ue_context_p;
+    }
+    unlock_ue_contexts(ue_context_p);
+  }
+  return NULL;
+}
+
 //------------------------------------------------------------------------------
 struct ue_mm_context_s *mme_ue_context_exists_imsi(
   mme_ue_context_t *const mme_ue_context_p,
   const imsi64_t imsi)
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
-  uint64_t mme_ue_s1ap_id64 = 0;
-
-  h_rc = hashtable_uint64_ts_get(
-    mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl,
-    (const hash_key_t) imsi,
-    &mme_ue_s1ap_id64);
+  ue_mm_context_t *ue_context_p = _mme_ue_context_exists_coll_key(
+    mme_ue_context_p, MME_UE_COLL_KEY_IMSI, (const hash_key_t) imsi);
 
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id(
-      mme_ue_context_p, (mme_ue_s1ap_id_t) mme_ue_s1ap_id64);
-  } else {
+  if (!ue_context_p) {
     OAILOG_WARNING(
       LOG_MME_APP, " No IMSI hashtable for IMSI " IMSI_64_FMT "\n", imsi);
   }
-  return NULL;
+  return ue_context_p;
 }
 
 //------------------------------------------------------------------------------
@@ -489,22 +574,14 @@ struct ue_mm_context_s *mme_ue_context_exists_s11_teid(
   mme_ue_context_t *const mme_ue_context_p,
   const s11_teid_t teid)
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
-  uint64_t mme_ue_s1ap_id64 = 0;
-
-  h_rc = hashtable_uint64_ts_get(
-    mme_ue_context_p->tun11_ue_context_htbl,
-    (const hash_key_t) teid,
-    &mme_ue_s1ap_id64);
+  ue_mm_context_t *ue_context_p = _mme_ue_context_exists_coll_key(
+    mme_ue_context_p, MME_UE_COLL_KEY_S11_TEID, (const hash_key_t) teid);
 
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id(
-      mme_ue_context_p, (mme_ue_s1ap_id_t) mme_ue_s1ap_id64);
-  } else {
+  if (!ue_context_p) {
     OAILOG_WARNING(
       LOG_MME_APP, " No S11 hashtable for S11 Teid " TEID_FMT "\n", teid);
   }
-  return NULL;
+  return ue_context_p;
 }
 
 //------------------------------------------------------------------------------
@@ -512,23 +589,21 @@ ue_mm_context_t *mme_ue_context_exists_guti(
   mme_ue_context_t *const mme_ue_context_p,
   const guti_t *const guti_p)
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
-  uint64_t mme_ue_s1ap_id64 = 0;
-
-  h_rc = obj_hashtable_uint64_ts_get(
-    mme_ue_context_p->guti_ue_context_htbl,
-    (const void *) guti_p,
-    sizeof(*guti_p),
-    &mme_ue_s1ap_id64);
+  ue_mm_context_t *ue_context_p = _mme_ue_context_exists_coll_key(
+    mme_ue_context_p, MME_UE_COLL_KEY_GUTI, MME_APP_GUTI_KEY(guti_p));
 
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id(
-      mme_ue_context_p, (mme_ue_s1ap_id_t) mme_ue_s1ap_id64);
-  } else {
+  // The PLMN is not part of the key
+  if (
+    ue_context_p &&
+    !PLMNS_ARE_EQUAL(
+      ue_context_p->emm_context._guti.gummei.plmn, guti_p->gummei.plmn)) {
+    unlock_ue_contexts(ue_context_p);
+    ue_context_p = NULL;
+  }
+  if (!ue_context_p) {
     OAILOG_WARNING(LOG_MME_APP, " No GUTI hashtable for GUTI ");
   }
-
-  return NULL;
+  return ue_context_p;
 }
 
 //------------------------------------------------------------------------------
@@ -539,16 +614,160 @@ void mme_app_move_context(ue_mm_context_t *dst, ue_mm_context_t *src)
     enb_s1ap_id_key_t enb_s1ap_id_key = dst->enb_s1ap_id_key;
     enb_ue_s1ap_id_t enb_ue_s1ap_id = dst->enb_ue_s1ap_id;
     mme_ue_s1ap_id_t mme_ue_s1ap_id = dst->mme_ue_s1ap_id;
-    memcpy(dst, src, sizeof(*dst));
+    mme_ue_registry_slot_t registry_slot = dst->registry_slot;
+    // The lock, references and walk link of dst stay, others may use them
+    const size_t offset = offsetof(ue_mm_context_t, mme_ue_s1ap_id);
+    memcpy(
+      (uint8_t *) dst + offset, (uint8_t *) src + offset, sizeof(*dst) - offset);
     dst->enb_s1ap_id_key = enb_s1ap_id_key;
     dst->enb_ue_s1ap_id = enb_ue_s1ap_id;
     dst->mme_ue_s1ap_id = mme_ue_s1ap_id;
+    dst->registry_slot = registry_slot;
   }
   OAILOG_FUNC_OUT(LOG_MME_APP);
 }
 
 //------------------------------------------------------------------------------
-void mme_ue_context_update_coll_keys(
+/*
+   UE registry
+   The slot of an UE context records the keys it is indexed by, the stale
+   keys are removed from there rather than from the context fields that the
+   procedures update on their own. Only the entries that still point to the
+   UE are removed, another UE may have taken the key since. The functions
+   below are called with registry_mutex held.
+*/
+static hashtable_rc_t _mme_ue_registry_index(
+  mme_ue_context_t *const mme_ue_context_p,
+  mme_ue_registry_slot_t *const slot_p,
+  const mme_ue_coll_key_t coll_key,
+  const hash_key_t key,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  hash_table_uint64_ts_t *htbl = mme_ue_context_p->coll_key_htbl[coll_key];
+  hash_key_t old_key = slot_p->keys[coll_key];
+  uint8_t bit = 1 << coll_key;
+  uint64_t mme_ue_s1ap_id64 = 0;
+  hashtable_rc_t h_rc = HASH_TABLE_OK;
+
+  if (slot_p->indexed & bit) {
+    if ((old_key == key) && (slot_p->mme_ue_s1ap_id == mme_ue_s1ap_id)) {
+      return HASH_TABLE_OK;
+    }
+    if (
+      (HASH_TABLE_OK ==
+       hashtable_uint64_ts_get(htbl, old_key, &mme_ue_s1ap_id64)) &&
+      (mme_ue_s1ap_id64 == slot_p->mme_ue_s1ap_id)) {
+      hashtable_uint64_ts_remove(htbl, old_key);
+    }
+    slot_p->indexed &= ~bit;
+  }
+  if (INVALID_MME_UE_S1AP_ID == mme_ue_s1ap_id) {
+    return HASH_TABLE_OK;
+  }
+  h_rc = hashtable_uint64_ts_insert(htbl, key, (uint64_t) mme_ue_s1ap_id);
+  if (HASH_TABLE_INSERT_OVERWRITTEN_DATA == h_rc) {
+    // Taken over from another UE, that one keeps it in its slot
+    h_rc = HASH_TABLE_OK;
+  }
+  if (HASH_TABLE_OK == h_rc) {
+    slot_p->keys[coll_key] = key;
+    slot_p->indexed |= bit;
+  }
+  return h_rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Moves the UE to its new slot: registered by mme_ue_s1ap_id and indexed by
+ * the keys[coll_key] whose bit is set in indexed. An INVALID_MME_UE_S1AP_ID
+ * unregisters it. The UE is registered under its new mme_ue_s1ap_id before
+ * the indexes point to it, so that lookups do not miss it meanwhile.
+ */
+static int _mme_ue_registry_update(
+  mme_ue_context_t *const mme_ue_context_p,
+  ue_mm_context_t *const ue_context_p,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+  const hash_key_t *const keys,
+  const uint8_t indexed)
+{
+  hash_table_ts_t *htbl = mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl;
+  mme_ue_registry_slot_t *slot_p = &ue_context_p->registry_slot;
+  hash_key_t old_key = (hash_key_t) slot_p->mme_ue_s1ap_id;
+  hashtable_rc_t h_rc = HASH_TABLE_OK;
+  void *data = NULL;
+  int rc = RETURNok;
+
+  if (
+    (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) &&
+    (slot_p->mme_ue_s1ap_id != mme_ue_s1ap_id)) {
+    // An overwrite would free the context of the UE holding the id
+    h_rc = hashtable_ts_is_key_exists(htbl, (const hash_key_t) mme_ue_s1ap_id);
+    if (HASH_TABLE_OK == h_rc) {
+      h_rc = HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+    } else {
+      h_rc = hashtable_ts_insert(
+        htbl, (const hash_key_t) mme_ue_s1ap_id, (void *) ue_context_p);
+    }
+    if (HASH_TABLE_OK != h_rc) {
+      OAILOG_ERROR(
+        LOG_MME_APP,
+        "Error could not register this ue context %p "
+        "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
+        ue_context_p,
+        mme_ue_s1ap_id,
+        hashtable_rc_code2string(h_rc));
+      return RETURNerror;
+    }
+  }
+  for (int coll_key = 0; coll_key < MME_UE_COLL_KEY_MAX; coll_key++) {
+    h_rc = _mme_ue_registry_index(
+      mme_ue_context_p,
+      slot_p,
+      coll_key,
+      keys[coll_key],
+      (indexed & (1 << coll_key)) ? mme_ue_s1ap_id : INVALID_MME_UE_S1AP_ID);
+    if (HASH_TABLE_OK != h_rc) {
+      OAILOG_ERROR(
+        LOG_MME_APP,
+        "Error could not update this ue context %p "
+        "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " in %s: %s\n",
+        ue_context_p,
+        mme_ue_s1ap_id,
+        bdata(mme_ue_context_p->coll_key_htbl[coll_key]->name),
+        hashtable_rc_code2string(h_rc));
+      rc = RETURNerror;
+    }
+  }
+  if (
+    (INVALID_MME_UE_S1AP_ID != slot_p->mme_ue_s1ap_id) &&
+    (slot_p->mme_ue_s1ap_id != mme_ue_s1ap_id) &&
+    (HASH_TABLE_OK == hashtable_ts_get(htbl, old_key, &data)) &&
+    (data == ue_context_p)) {
+    hashtable_ts_remove(htbl, old_key, &data);
+  }
+  slot_p->mme_ue_s1ap_id = mme_ue_s1ap_id;
+  OAILOG_TRACE(
+    LOG_MME_APP,
+    "UE registry slot of ue context %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
+    " indexed 0x%x\n",
+    ue_context_p,
+    mme_ue_s1ap_id,
+    slot_p->indexed);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Index bit of a GUTI key, none for the GUTIs that were never allocated
+static uint8_t _mme_ue_registry_guti_bit(const guti_t *const guti_p)
+{
+  if ((INVALID_M_TMSI == guti_p->m_tmsi) || !MME_APP_GUTI_KEY(guti_p)) {
+    return 0;
+  }
+  return 1 << MME_UE_COLL_KEY_GUTI;
+}
+
+//------------------------------------------------------------------------------
+static void _mme_ue_context_update_coll_keys(
   mme_ue_context_t *const mme_ue_context_p,
   ue_mm_context_t *const ue_context_p,
   const enb_s1ap_id_key_t enb_s1ap_id_key,
@@ -558,7 +777,9 @@ void mme_ue_context_update_coll_keys(
   const s11_teid_t mme_teid_s11,
   const guti_t *const guti_p) //  never NULL, if none put &ue_context_p->guti
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
+  mme_ue_registry_slot_t *slot_p = &ue_context_p->registry_slot;
+  hash_key_t keys[MME_UE_COLL_KEY_MAX] = {0};
+  uint8_t indexed = 0;
 
   OAILOG_FUNC_IN(LOG_MME_APP);
 
@@ -583,177 +804,127 @@ void mme_ue_context_update_coll_keys(
     imsi,
     GUTI_ARG(guti_p));
 
-  if (
-    (INVALID_ENB_UE_S1AP_ID_KEY != enb_s1ap_id_key) &&
-    (ue_context_p->enb_s1ap_id_key != enb_s1ap_id_key)) {
-    // new insertion of enb_ue_s1ap_id_key,
-    h_rc = hashtable_uint64_ts_remove(
-      mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-      (const hash_key_t) ue_context_p->enb_s1ap_id_key);
-    h_rc = hashtable_uint64_ts_insert(
-      mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-      (const hash_key_t) enb_s1ap_id_key,
-      mme_ue_s1ap_id);
-
-    if (HASH_TABLE_OK != h_rc) {
-      OAILOG_ERROR(
-        LOG_MME_APP,
-        "Error could not update this ue context %p "
-        "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-        " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
-        ue_context_p,
-        ue_context_p->enb_ue_s1ap_id,
-        ue_context_p->mme_ue_s1ap_id,
-        hashtable_rc_code2string(h_rc));
-    }
-    ue_context_p->enb_s1ap_id_key = enb_s1ap_id_key;
-  } else {
-    OAILOG_DEBUG(
-      LOG_MME_APP,
-      "Did not update enb_s1ap_id_key %ld in ue context %p "
-      "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-      " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
-      enb_s1ap_id_key,
-      ue_context_p,
-      ue_context_p->enb_ue_s1ap_id,
-      ue_context_p->mme_ue_s1ap_id);
+  // The keys that are not given stay as they are
+  memcpy(keys, slot_p->keys, sizeof(keys));
+  indexed = slot_p->indexed;
+  if (INVALID_ENB_UE_S1AP_ID_KEY != enb_s1ap_id_key) {
+    keys[MME_UE_COLL_KEY_ENB_S1AP_ID] = (hash_key_t) enb_s1ap_id_key;
+    indexed |= 1 << MME_UE_COLL_KEY_ENB_S1AP_ID;
+  }
+  keys[MME_UE_COLL_KEY_IMSI] = (hash_key_t) imsi;
+  indexed &= ~(1 << MME_UE_COLL_KEY_IMSI);
+  if (INVALID_IMSI64 != imsi) {
+    indexed |= 1 << MME_UE_COLL_KEY_IMSI;
+  }
+  keys[MME_UE_COLL_KEY_S11_TEID] = (hash_key_t) mme_teid_s11;
+  indexed &= ~(1 << MME_UE_COLL_KEY_S11_TEID);
+  if (mme_teid_s11) {
+    indexed |= 1 << MME_UE_COLL_KEY_S11_TEID;
+  }
+  if (guti_p) {
+    keys[MME_UE_COLL_KEY_GUTI] = MME_APP_GUTI_KEY(guti_p);
+    indexed &= ~(1 << MME_UE_COLL_KEY_GUTI);
+    indexed |= _mme_ue_registry_guti_bit(guti_p);
   }
 
-  if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-    if (ue_context_p->mme_ue_s1ap_id != mme_ue_s1ap_id) {
-      // new insertion of mme_ue_s1ap_id, not a change in the id
-      h_rc = hashtable_ts_remove(
-        mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
-        (const hash_key_t) ue_context_p->mme_ue_s1ap_id,
-        (void **) &ue_context_p);
-      h_rc = hashtable_ts_insert(
-        mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
-        (const hash_key_t) mme_ue_s1ap_id,
-        (void *) ue_context_p);
+  _mme_ue_registry_update(
+    mme_ue_context_p,
+    ue_context_p,
+    (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) ? mme_ue_s1ap_id :
+                                                 slot_p->mme_ue_s1ap_id,
+    keys,
+    indexed);
 
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "Error could not update this ue context %p "
-          "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-          " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
-          ue_context_p,
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id,
-          hashtable_rc_code2string(h_rc));
-      }
-      ue_context_p->mme_ue_s1ap_id = mme_ue_s1ap_id;
-    }
-  } else {
-    OAILOG_DEBUG(
-      LOG_MME_APP,
-      "Did not update hashtable  for ue context %p "
-      "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-      " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT " \n",
-      ue_context_p,
-      ue_context_p->enb_ue_s1ap_id,
-      ue_context_p->mme_ue_s1ap_id,
-      imsi);
+  if (INVALID_ENB_UE_S1AP_ID_KEY != enb_s1ap_id_key) {
+    ue_context_p->enb_s1ap_id_key = enb_s1ap_id_key;
   }
-
-  h_rc = hashtable_uint64_ts_remove(
-    mme_ue_context_p->imsi_ue_context_htbl,
-    (const hash_key_t) ue_context_p->emm_context._imsi64);
   if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-    h_rc = hashtable_uint64_ts_insert(
-      mme_ue_context_p->imsi_ue_context_htbl,
-      (const hash_key_t) imsi,
-      mme_ue_s1ap_id);
-  } else {
-    h_rc = HASH_TABLE_KEY_NOT_EXISTS;
-  }
-  if (HASH_TABLE_OK != h_rc) {
-    OAILOG_ERROR(
-      LOG_MME_APP,
-      "Error could not update this ue context %p "
-      "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-      " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT ": %s\n",
-      ue_context_p,
-      ue_context_p->enb_ue_s1ap_id,
-      ue_context_p->mme_ue_s1ap_id,
-      imsi,
-      hashtable_rc_code2string(h_rc));
+    ue_context_p->mme_ue_s1ap_id = mme_ue_s1ap_id;
   }
   ue_context_p->imsi = imsi;
   ue_context_p->imsi_len = imsi_len;
   _directoryd_report_location(ue_context_p->imsi, imsi_len);
-
-  h_rc = hashtable_uint64_ts_remove(
-    mme_ue_context_p->tun11_ue_context_htbl,
-    (const hash_key_t) ue_context_p->mme_teid_s11);
-  if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-    h_rc = hashtable_uint64_ts_insert(
-      mme_ue_context_p->tun11_ue_context_htbl,
-      (const hash_key_t) mme_teid_s11,
-      (uint64_t) mme_ue_s1ap_id);
-  } else {
-    h_rc = HASH_TABLE_KEY_NOT_EXISTS;
+  ue_context_p->mme_teid_s11 = mme_teid_s11;
+  if (guti_p) {
+    ue_context_p->emm_context._guti = *guti_p;
   }
+  OAILOG_FUNC_OUT(LOG_MME_APP);
+}
 
-  if (HASH_TABLE_OK != h_rc) {
-    OAILOG_ERROR(
-      LOG_MME_APP,
-      "Error could not update this ue context %p "
-      "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-      " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " mme_teid_s11 " TEID_FMT " : %s\n",
+//------------------------------------------------------------------------------
+void mme_ue_context_update_coll_keys(
+  mme_ue_context_t *const mme_ue_context_p,
+  ue_mm_context_t *const ue_context_p,
+  const enb_s1ap_id_key_t enb_s1ap_id_key,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+  const imsi64_t imsi,
+  uint8_t imsi_len,
+  const s11_teid_t mme_teid_s11,
+  const guti_t *const guti_p)
+{
+  // The UE registry is updated by every MME_APP worker
+  pthread_mutex_lock(&mme_ue_context_p->registry_mutex);
+  _mme_ue_context_update_coll_keys(
+    mme_ue_context_p,
+    ue_context_p,
+    enb_s1ap_id_key,
+    mme_ue_s1ap_id,
+    imsi,
+    imsi_len,
+    mme_teid_s11,
+    guti_p);
+  pthread_mutex_unlock(&mme_ue_context_p->registry_mutex);
+}
+
+//------------------------------------------------------------------------------
+int mme_ue_context_update_coll_key(
+  mme_ue_context_t *const mme_ue_context_p,
+  ue_mm_context_t *const ue_context_p,
+  const mme_ue_coll_key_t coll_key,
+  const hash_key_t key)
+{
+  mme_ue_registry_slot_t *slot_p = &ue_context_p->registry_slot;
+  hash_key_t keys[MME_UE_COLL_KEY_MAX] = {0};
+  int rc = RETURNerror;
+
+  pthread_mutex_lock(&mme_ue_context_p->registry_mutex);
+  if (INVALID_MME_UE_S1AP_ID != slot_p->mme_ue_s1ap_id) {
+    memcpy(keys, slot_p->keys, sizeof(keys));
+    keys[coll_key] = key;
+    rc = _mme_ue_registry_update(
+      mme_ue_context_p,
       ue_context_p,
-      ue_context_p->enb_ue_s1ap_id,
-      ue_context_p->mme_ue_s1ap_id,
-      mme_teid_s11,
-      hashtable_rc_code2string(h_rc));
+      slot_p->mme_ue_s1ap_id,
+      keys,
+      slot_p->indexed | (1 << coll_key));
   }
-  ue_context_p->mme_teid_s11 = mme_teid_s11;
+  pthread_mutex_unlock(&mme_ue_context_p->registry_mutex);
+  return rc;
+}
 
-  if (guti_p) {
-    if (
-      (guti_p->gummei.mme_code !=
-       ue_context_p->emm_context._guti.gummei.mme_code) ||
-      (guti_p->gummei.mme_gid !=
-       ue_context_p->emm_context._guti.gummei.mme_gid) ||
-      (guti_p->m_tmsi != ue_context_p->emm_context._guti.m_tmsi) ||
-      (guti_p->gummei.plmn.mcc_digit1 !=
-       ue_context_p->emm_context._guti.gummei.plmn.mcc_digit1) ||
-      (guti_p->gummei.plmn.mcc_digit2 !=
-       ue_context_p->emm_context._guti.gummei.plmn.mcc_digit2) ||
-      (guti_p->gummei.plmn.mcc_digit3 !=
-       ue_context_p->emm_context._guti.gummei.plmn.mcc_digit3) ||
-      (ue_context_p->mme_ue_s1ap_id != mme_ue_s1ap_id)) {
-      // may check guti_p with a kind of instanceof()?
-      h_rc = obj_hashtable_uint64_ts_remove(
-        mme_ue_context_p->guti_ue_context_htbl,
-        &ue_context_p->emm_context._guti,
-        sizeof(*guti_p));
-      if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-        h_rc = obj_hashtable_uint64_ts_insert(
-          mme_ue_context_p->guti_ue_context_htbl,
-          (const void *const) guti_p,
-          sizeof(*guti_p),
-          (uint64_t) mme_ue_s1ap_id);
-      } else {
-        h_rc = HASH_TABLE_KEY_NOT_EXISTS;
-      }
+//------------------------------------------------------------------------------
+void mme_ue_context_remove_coll_key(
+  mme_ue_context_t *const mme_ue_context_p,
+  ue_mm_context_t *const ue_context_p,
+  const mme_ue_coll_key_t coll_key)
+{
+  mme_ue_registry_slot_t *slot_p = &ue_context_p->registry_slot;
 
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "Error could not update this ue context %p "
-          "enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT
-          " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " guti " GUTI_FMT " %s\n",
-          ue_context_p,
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id,
-          GUTI_ARG(guti_p),
-          hashtable_rc_code2string(h_rc));
-      }
-      ue_context_p->emm_context._guti = *guti_p;
-    }
-  }
-  OAILOG_FUNC_OUT(LOG_MME_APP);
+  pthread_mutex_lock(&mme_ue_context_p->registry_mutex);
+  if (!(slot_p->indexed & (1 << coll_key))) {
+    OAILOG_DEBUG(
+      LOG_MME_APP,
+      "UE context mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " not in %s\n",
+      ue_context_p->mme_ue_s1ap_id,
+      bdata(mme_ue_context_p->coll_key_htbl[coll_key]->name));
+  }
+  _mme_ue_registry_index(
+    mme_ue_context_p,
+    slot_p,
+    coll_key,
+    slot_p->keys[coll_key],
+    INVALID_MME_UE_S1AP_ID);
+  pthread_mutex_unlock(&mme_ue_context_p->registry_mutex);
 }
 
 //------------------------------------------------------------------------------
@@ -761,50 +932,41 @@ void mme_ue_context_dump_coll_keys(void)
 {
   bstring tmp = bfromcstr(" ");
 
-  btrunc(tmp, 0);
-  hashtable_uint64_ts_dump_content(
-    mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, tmp);
-  OAILOG_INFO(LOG_MME_APP, "imsi_ue_context_htbl %s\n", bdata(tmp));
+  for (int coll_key = 0; coll_key < MME_UE_COLL_KEY_MAX; coll_key++) {
+    hash_table_uint64_ts_t *htbl =
+      mme_app_desc.mme_ue_contexts.coll_key_htbl[coll_key];
 
-  btrunc(tmp, 0);
-  hashtable_uint64_ts_dump_content(
-    mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl, tmp);
-  OAILOG_INFO(LOG_MME_APP, "tun11_ue_context_htbl %s\n", bdata(tmp));
+    btrunc(tmp, 0);
+    hashtable_uint64_ts_dump_content(htbl, tmp);
+    OAILOG_INFO(LOG_MME_APP, "%s %s\n", bdata(htbl->name), bdata(tmp));
+  }
 
   btrunc(tmp, 0);
   hashtable_ts_dump_content(
     mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, tmp);
   OAILOG_INFO(LOG_MME_APP, "mme_ue_s1ap_id_ue_context_htbl %s\n", bdata(tmp));
 
-  btrunc(tmp, 0);
-  hashtable_uint64_ts_dump_content(
-    mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl, tmp);
-  OAILOG_INFO(LOG_MME_APP, "enb_ue_s1ap_id_ue_context_htbl %s\n", bdata(tmp));
-
-  btrunc(tmp, 0);
-  obj_hashtable_uint64_ts_dump_content(
-    mme_app_desc.mme_ue_contexts.guti_ue_context_htbl, tmp);
-  OAILOG_INFO(LOG_MME_APP, "guti_ue_context_htbl %s", bdata(tmp));
-
   bdestroy(tmp);
 }
 
 //------------------------------------------------------------------------------
-int mme_insert_ue_context(
+static int _mme_insert_ue_context(
   mme_ue_context_t *const mme_ue_context_p,
-  const struct ue_mm_context_s *const ue_context_p)
+  struct ue_mm_context_s *const ue_context_p)
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
+  hash_key_t keys[MME_UE_COLL_KEY_MAX] = {0};
+  uint8_t indexed = 1 << MME_UE_COLL_KEY_ENB_S1AP_ID;
 
   OAILOG_FUNC_IN(LOG_MME_APP);
   DevAssert(mme_ue_context_p);
   DevAssert(ue_context_p);
 
   // filled ENB UE S1AP ID
-  h_rc = hashtable_uint64_ts_is_key_exists(
-    mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-    (const hash_key_t) ue_context_p->enb_s1ap_id_key);
-  if (HASH_TABLE_OK == h_rc) {
+  if (
+    HASH_TABLE_OK ==
+    hashtable_uint64_ts_is_key_exists(
+      mme_ue_context_p->coll_key_htbl[MME_UE_COLL_KEY_ENB_S1AP_ID],
+      (const hash_key_t) ue_context_p->enb_s1ap_id_key)) {
     OAILOG_DEBUG(
       LOG_MME_APP,
       "This ue context %p already exists enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
@@ -813,122 +975,75 @@ int mme_insert_ue_context(
       ue_context_p->enb_ue_s1ap_id);
     OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
   }
-  h_rc = hashtable_uint64_ts_insert(
-    mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-    (const hash_key_t) ue_context_p->enb_s1ap_id_key,
-    ue_context_p->mme_ue_s1ap_id);
 
-  if (HASH_TABLE_OK != h_rc) {
+  if (INVALID_MME_UE_S1AP_ID == ue_context_p->mme_ue_s1ap_id) {
     OAILOG_DEBUG(
       LOG_MME_APP,
       "Error could not register this ue context %p "
-      "enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " ue_id 0x%x\n",
+      "enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " without mme_ue_s1ap_id\n",
       ue_context_p,
-      ue_context_p->enb_ue_s1ap_id,
-      ue_context_p->mme_ue_s1ap_id);
+      ue_context_p->enb_ue_s1ap_id);
     OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
   }
-
-  if (INVALID_MME_UE_S1AP_ID != ue_context_p->mme_ue_s1ap_id) {
-    h_rc = hashtable_ts_is_key_exists(
-      mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
-      (const hash_key_t) ue_context_p->mme_ue_s1ap_id);
-
-    if (HASH_TABLE_OK == h_rc) {
-      OAILOG_DEBUG(
-        LOG_MME_APP,
-        "This ue context %p already exists mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
-        "\n",
-        ue_context_p,
-        ue_context_p->mme_ue_s1ap_id);
-      OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
-    }
-
-    h_rc = hashtable_ts_insert(
+  if (
+    HASH_TABLE_OK ==
+    hashtable_ts_is_key_exists(
       mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
-      (const hash_key_t) ue_context_p->mme_ue_s1ap_id,
-      (void *) ue_context_p);
-
-    if (HASH_TABLE_OK != h_rc) {
-      OAILOG_DEBUG(
-        LOG_MME_APP,
-        "Error could not register this ue context %p "
-        "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
-        ue_context_p,
-        ue_context_p->mme_ue_s1ap_id);
-      OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
-    }
-
-    // filled IMSI
-    if (ue_context_p->emm_context._imsi64) {
-      h_rc = hashtable_uint64_ts_insert(
-        mme_ue_context_p->imsi_ue_context_htbl,
-        (const hash_key_t) ue_context_p->emm_context._imsi64,
-        ue_context_p->mme_ue_s1ap_id);
-
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_DEBUG(
-          LOG_MME_APP,
-          "Error could not register this ue context %p "
-          "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT "\n",
-          ue_context_p,
-          ue_context_p->mme_ue_s1ap_id,
-          ue_context_p->emm_context._imsi64);
-        OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
-      }
-
-      _directoryd_report_location(ue_context_p->imsi, ue_context_p->imsi_len);
-    }
-
-    // filled S11 tun id
-    if (ue_context_p->mme_teid_s11) {
-      h_rc = hashtable_uint64_ts_insert(
-        mme_ue_context_p->tun11_ue_context_htbl,
-        (const hash_key_t) ue_context_p->mme_teid_s11,
-        ue_context_p->mme_ue_s1ap_id);
-
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_DEBUG(
-          LOG_MME_APP,
-          "Error could not register this ue context %p "
-          "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " mme_teid_s11 " TEID_FMT "\n",
-          ue_context_p,
-          ue_context_p->mme_ue_s1ap_id,
-          ue_context_p->mme_teid_s11);
-        OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
-      }
-    }
+      (const hash_key_t) ue_context_p->mme_ue_s1ap_id)) {
+    OAILOG_DEBUG(
+      LOG_MME_APP,
+      "This ue context %p already exists mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
+      "\n",
+      ue_context_p,
+      ue_context_p->mme_ue_s1ap_id);
+    OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
+  }
 
-    // filled guti
-    if (
-      (0 != ue_context_p->emm_context._guti.gummei.mme_code) ||
-      (0 != ue_context_p->emm_context._guti.gummei.mme_gid) ||
-      (0 != ue_context_p->emm_context._guti.m_tmsi) ||
-      (0 != ue_context_p->emm_context._guti.gummei.plmn
-              .mcc_digit1) || // MCC 000 does not exist in ITU table
-      (0 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit2) ||
-      (0 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit3)) {
-      h_rc = obj_hashtable_uint64_ts_insert(
-        mme_ue_context_p->guti_ue_context_htbl,
-        (const void *const) & ue_context_p->emm_context._guti,
-        sizeof(ue_context_p->emm_context._guti),
-        ue_context_p->mme_ue_s1ap_id);
+  keys[MME_UE_COLL_KEY_ENB_S1AP_ID] =
+    (hash_key_t) ue_context_p->enb_s1ap_id_key;
+  // filled IMSI
+  if (ue_context_p->emm_context._imsi64) {
+    keys[MME_UE_COLL_KEY_IMSI] = (hash_key_t) ue_context_p->emm_context._imsi64;
+    indexed |= 1 << MME_UE_COLL_KEY_IMSI;
+  }
+  // filled S11 tun id
+  if (ue_context_p->mme_teid_s11) {
+    keys[MME_UE_COLL_KEY_S11_TEID] = (hash_key_t) ue_context_p->mme_teid_s11;
+    indexed |= 1 << MME_UE_COLL_KEY_S11_TEID;
+  }
+  // filled guti
+  keys[MME_UE_COLL_KEY_GUTI] =
+    MME_APP_GUTI_KEY(&ue_context_p->emm_context._guti);
+  indexed |= _mme_ue_registry_guti_bit(&ue_context_p->emm_context._guti);
 
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_DEBUG(
-          LOG_MME_APP,
-          "Error could not register this ue context %p "
-          "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " guti " GUTI_FMT "\n",
-          ue_context_p,
-          ue_context_p->mme_ue_s1ap_id,
-          GUTI_ARG(&ue_context_p->emm_context._guti));
-        OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
-      }
-    }
+  if (
+    RETURNok != _mme_ue_registry_update(
+                  mme_ue_context_p,
+                  ue_context_p,
+                  ue_context_p->mme_ue_s1ap_id,
+                  keys,
+                  indexed)) {
+    OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
+  }
+  if (indexed & (1 << MME_UE_COLL_KEY_IMSI)) {
+    _directoryd_report_location(ue_context_p->imsi, ue_context_p->imsi_len);
   }
 
   OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNok);
 }
+
+//------------------------------------------------------------------------------
+int mme_insert_ue_context(
+  mme_ue_context_t *const mme_ue_context_p,
+  struct ue_mm_context_s *const ue_context_p)
+{
+  int rc;
+
+  pthread_mutex_lock(&mme_ue_context_p->registry_mutex);
+  rc = _mme_insert_ue_context(mme_ue_context_p, ue_context_p);
+  pthread_mutex_unlock(&mme_ue_context_p->registry_mutex);
+  return rc;
+}
 //------------------------------------------------------------------------------
 void mme_notify_ue_context_released(
   mme_ue_context_t *const mme_ue_context_p,
@@ -947,104 +1062,37 @@ void mme_remove_ue_context(
   struct ue_mm_context_s *ue_context_p)
 {
   OAILOG_FUNC_IN(LOG_MME_APP);
-  hashtable_rc_t hash_rc = HASH_TABLE_OK;
 
   DevAssert(mme_ue_context_p);
   DevAssert(ue_context_p);
 
   if (!lock_ue_contexts(ue_context_p)) {
-    // IMSI
-    if (ue_context_p->emm_context._imsi64) {
-      hash_rc = hashtable_uint64_ts_remove(
-        mme_ue_context_p->imsi_ue_context_htbl,
-        (const hash_key_t) ue_context_p->emm_context._imsi64);
-      if (HASH_TABLE_OK != hash_rc)
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "UE context not found!\n"
-          " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
-          " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", IMSI " IMSI_64_FMT
-          "  not in IMSI collection\n",
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id,
-          ue_context_p->emm_context._imsi64);
-    }
-
-    // eNB UE S1P UE ID
-    hash_rc = hashtable_uint64_ts_remove(
-      mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-      (const hash_key_t) ue_context_p->enb_s1ap_id_key);
-    if (HASH_TABLE_OK != hash_rc)
-      OAILOG_ERROR(
+    pthread_mutex_lock(&mme_ue_context_p->registry_mutex);
+    if (INVALID_MME_UE_S1AP_ID == ue_context_p->registry_slot.mme_ue_s1ap_id) {
+      OAILOG_DEBUG(
         LOG_MME_APP,
-        "UE context not found!\n"
-        " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
-        " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
-        ", ENB_UE_S1AP_ID not in ENB_UE_S1AP_ID collection",
+        "UE context enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
+        " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " was not registered\n",
         ue_context_p->enb_ue_s1ap_id,
         ue_context_p->mme_ue_s1ap_id);
-
-    // filled S11 tun id
-    if (ue_context_p->mme_teid_s11) {
-      hash_rc = hashtable_uint64_ts_remove(
-        mme_ue_context_p->tun11_ue_context_htbl,
-        (const hash_key_t) ue_context_p->mme_teid_s11);
-      if (HASH_TABLE_OK != hash_rc)
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "UE Context not found!\n"
-          " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
-          " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", MME S11 TEID  " TEID_FMT
-          "  not in S11 collection\n",
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id,
-          ue_context_p->mme_teid_s11);
-    }
-    // filled guti
-    if (
-      (ue_context_p->emm_context._guti.gummei.mme_code) ||
-      (ue_context_p->emm_context._guti.gummei.mme_gid) ||
-      (ue_context_p->emm_context._guti.m_tmsi) ||
-      (ue_context_p->emm_context._guti.gummei.plmn.mcc_digit1) ||
-      (ue_context_p->emm_context._guti.gummei.plmn.mcc_digit2) ||
-      (ue_context_p->emm_context._guti.gummei.plmn
-         .mcc_digit3)) { // MCC 000 does not exist in ITU table
-      hash_rc = obj_hashtable_uint64_ts_remove(
-        mme_ue_context_p->guti_ue_context_htbl,
-        (const void *const) & ue_context_p->emm_context._guti,
-        sizeof(ue_context_p->emm_context._guti));
-      if (HASH_TABLE_OK != hash_rc)
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "UE Context not found!\n"
-          " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
-          " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
-          ", GUTI  not in GUTI collection\n",
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id);
-    }
-
-    // filled NAS UE ID/ MME UE S1AP ID
-    if (INVALID_MME_UE_S1AP_ID != ue_context_p->mme_ue_s1ap_id) {
-      hash_rc = hashtable_ts_remove(
-        mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
-        (const hash_key_t) ue_context_p->mme_ue_s1ap_id,
-        (void **) &ue_context_p);
-      if (HASH_TABLE_OK != hash_rc)
-        OAILOG_ERROR(
-          LOG_MME_APP,
-          "UE context not found!\n"
-          "  enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
-          ", mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
-          " not in MME UE S1AP ID collection",
-          ue_context_p->enb_ue_s1ap_id,
-          ue_context_p->mme_ue_s1ap_id);
     }
+    _mme_ue_registry_update(
+      mme_ue_context_p,
+      ue_context_p,
+      INVALID_MME_UE_S1AP_ID,
+      ue_context_p->registry_slot.keys,
+      0);
+    pthread_mutex_unlock(&mme_ue_context_p->registry_mutex);
 
     _directoryd_remove_location(ue_context_p->imsi, ue_context_p->imsi_len);
     mme_app_ue_context_free_content(ue_context_p);
-    unlock_ue_contexts(ue_context_p);
-    free_wrapper((void **) &ue_context_p);
+    /*
+     * The lock levels of the caller go with this one, and so do their
+     * references and the one of the creation. The threads still waiting for
+     * the lock find the context unregistered and drop theirs.
+     */
+    _mme_ue_context_unref(
+      ue_context_p, mme_app_ue_unlock_all(&ue_context_p->lock) + 1);
   }
   OAILOG_FUNC_OUT(LOG_MME_APP);
 }
@@ -1674,24 +1722,12 @@ void mme_ue_context_update_ue_sig_connection_state(
   ecm_state_t new_ecm_state)
 {
   // Function is used to update UE's Signaling Connection State
-  hashtable_rc_t hash_rc = HASH_TABLE_OK;
-
   OAILOG_FUNC_IN(LOG_MME_APP);
   DevAssert(mme_ue_context_p);
   DevAssert(ue_context_p);
   if (new_ecm_state == ECM_IDLE) {
-    hash_rc = hashtable_uint64_ts_remove(
-      mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-      (const hash_key_t) ue_context_p->enb_s1ap_id_key);
-    if (HASH_TABLE_OK != hash_rc) {
-      OAILOG_DEBUG(
-        LOG_MME_APP,
-        "UE context enb_ue_s1ap_ue_id_key %ld "
-        "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT
-        ", ENB_UE_S1AP_ID_KEY could not be found",
-        ue_context_p->enb_s1ap_id_key,
-        ue_context_p->mme_ue_s1ap_id);
-    }
+    mme_ue_context_remove_coll_key(
+      mme_ue_context_p, ue_context_p, MME_UE_COLL_KEY_ENB_S1AP_ID);
     ue_context_p->enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
 
     OAILOG_DEBUG(
@@ -1876,10 +1912,13 @@ bool mme_app_dump_ue_context(
 
       bformata(bstr_dump, "    - APN config list:\n");
 
-      for (j = 0; j < ue_mm_context->apn_config_profile.nb_apns; j++) {
+      apn_config_profile_t *apn_config_profile =
+        ue_mm_context->apn_config_profile;
+
+      for (j = 0; apn_config_profile && j < apn_config_profile->nb_apns; j++) {
         struct apn_configuration_s *apn_config_p;
 
-        apn_config_p = &ue_mm_context->apn_config_profile.apn_configuration[j];
+        apn_config_p = &apn_config_profile->apn_configuration[j];
         /*
          * Default APN ?
          */
@@ -1887,7 +1926,7 @@ bool mme_app_dump_ue_context(
           bstr_dump,
           "        - Default APN ...: %s\n",
           (apn_config_p->context_identifier ==
-           ue_mm_context->apn_config_profile.context_identifier) ?
+           apn_config_profile->context_identifier) ?
             "TRUE" :
             "FALSE");
         bformata(
@@ -79,6 +79,11 @@ void mme_app_handle_conn_est_cnf(
 void mme_app_handle_initial_ue_message(
   itti_s1ap_initial_ue_message_t *const conn_est_ind_pP);
 
+bool mme_app_construct_guti(
+  const plmn_t *const plmn_p,
+  const s_tmsi_t *const s_tmsi_p,
+  guti_t *const guti_p);
+
 int mme_app_handle_create_sess_resp(
   itti_s11_create_session_response_t *const
     create_sess_resp_pP); //not const because we need to free internal stucts
@@ -300,10 +305,4 @@ void mme_app_handle_path_switch_req_ack(
 void mme_app_handle_path_switch_req_failure(
     struct ue_mm_context_s *ue_context_p);
 
-#define mme_stats_read_lock(mMEsTATS)                                          \
-  pthread_rwlock_rdlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_write_lock(mMEsTATS)                                         \
-  pthread_rwlock_wrlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_unlock(mMEsTATS) pthread_rwlock_unlock(&(mMEsTATS)->rw_lock)
-
 #endif /* MME_APP_DEFS_H_ */
@@ -315,8 +315,19 @@ int mme_app_handle_s6a_update_location_ans(
   }
   ue_mm_context->rau_tau_timer = ula_pP->subscription_data.rau_tau_timer;
   ue_mm_context->network_access_mode = ula_pP->subscription_data.access_mode;
+  if (!ue_mm_context->apn_config_profile) {
+    ue_mm_context->apn_config_profile = calloc(1, sizeof(apn_config_profile_t));
+    if (!ue_mm_context->apn_config_profile) {
+      OAILOG_ERROR(
+        LOG_MME_APP,
+        "Cannot allocate the APN config profile for " IMSI_64_FMT "\n",
+        imsi64);
+      unlock_ue_contexts(ue_mm_context);
+      OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
+    }
+  }
   memcpy(
-    &ue_mm_context->apn_config_profile,
+    ue_mm_context->apn_config_profile,
     &ula_pP->subscription_data.apn_config_profile,
     sizeof(apn_config_profile_t));
 
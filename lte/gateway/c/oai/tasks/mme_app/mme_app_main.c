@@ -33,6 +33,7 @@
 #include <pthread.h>
 
 #include "bstrlib.h"
+#include "conversions.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
 #include "assertions.h"
@@ -61,10 +62,15 @@
 #include "obj_hashtable.h"
 #include "s11_messages_types.h"
 #include "s1ap_messages_types.h"
+#include "s6a_messages_types.h"
 #include "sctp_messages_types.h"
+#include "sgs_messages_types.h"
 #include "timer_messages_types.h"
 
-mme_app_desc_t mme_app_desc = {.rw_lock = PTHREAD_RWLOCK_INITIALIZER, 0};
+// The UE context tables start at this size and grow with the number of UEs
+#define MME_APP_UE_CONTEXT_HTBL_INITIAL_SIZE 1024
+
+mme_app_desc_t mme_app_desc = {0};
 
 bool mme_hss_associated = false;
 bool mme_sctp_bounded = false;
@@ -72,6 +78,7 @@ bool mme_sctp_bounded = false;
 void *mme_app_thread(void *args);
 static void _check_mme_healthy_and_notify_service(void);
 static bool _is_mme_app_healthy(void);
+static uint32_t _mme_app_get_message_shard(const MessageDef *message_p);
 
 //------------------------------------------------------------------------------
 void *mme_app_thread(void *args)
@@ -80,534 +87,765 @@ void *mme_app_thread(void *args)
   itti_mark_task_ready(TASK_MME_APP);
 
   while (1) {
-    MessageDef *received_message_p = NULL;
+    MessageDef *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_messages;
 
     /*
-     * Trying to fetch a message from the message queue.
+     * Trying to fetch messages from the message queue.
      * If the queue is empty, this function will block till a
      * message is sent to the task.
      */
-    itti_receive_msg(TASK_MME_APP, &received_message_p);
-    DevAssert(received_message_p);
-
-    switch (ITTI_MSG_ID(received_message_p)) {
-      case MESSAGE_TEST: {
-        OAI_FPRINTF_INFO("TASK_MME_APP received MESSAGE_TEST\n");
-      } break;
-
-      case MME_APP_INITIAL_CONTEXT_SETUP_RSP: {
-        mme_app_handle_initial_context_setup_rsp(
-          &MME_APP_INITIAL_CONTEXT_SETUP_RSP(received_message_p));
-      } break;
-
-      case MME_APP_CREATE_DEDICATED_BEARER_RSP: {
-        mme_app_handle_create_dedicated_bearer_rsp(
-          &MME_APP_CREATE_DEDICATED_BEARER_RSP(received_message_p));
-      } break;
-
-      case MME_APP_CREATE_DEDICATED_BEARER_REJ: {
-        mme_app_handle_create_dedicated_bearer_rej(
-          &MME_APP_CREATE_DEDICATED_BEARER_REJ(received_message_p));
-      } break;
-
-      case NAS_CONNECTION_ESTABLISHMENT_CNF: {
-        mme_app_handle_conn_est_cnf(
-          &NAS_CONNECTION_ESTABLISHMENT_CNF(received_message_p));
-      } break;
-
-      case MME_APP_DELETE_DEDICATED_BEARER_RSP: {
-        mme_app_handle_delete_dedicated_bearer_rsp(
-          &MME_APP_DELETE_DEDICATED_BEARER_RSP(received_message_p));
-      } break;
-
-      case NAS_DETACH_REQ: {
-        mme_app_handle_detach_req(&received_message_p->ittiMsg.nas_detach_req);
-      } break;
-
-      case S6A_CANCEL_LOCATION_REQ: {
-        /*
-         * Check cancellation-type and handle it if it is SUBSCRIPTION_WITHDRAWAL.
-         * For any other cancellation-type log it and ignore it.
-         */
-        mme_app_handle_s6a_cancel_location_req(
-          &received_message_p->ittiMsg.s6a_cancel_location_req);
-      } break;
-
-      case NAS_ERAB_SETUP_REQ: {
-        mme_app_handle_erab_setup_req(&NAS_ERAB_SETUP_REQ(received_message_p));
-      } break;
-
-      case NAS_ERAB_REL_CMD: {
-        mme_app_handle_erab_rel_cmd(&NAS_ERAB_REL_CMD(received_message_p));
-      } break;
-
-
-      case NAS_PDN_CONFIG_REQ: {
-        OAILOG_INFO(
-          TASK_MME_APP, "Received PDN CONFIG REQ from NAS_MME for ue_id = (%u)\n",
-          received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
-        struct ue_mm_context_s *ue_context_p = NULL;
-        ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id(
-          &mme_app_desc.mme_ue_contexts,
-          received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
-        if (ue_context_p) {
-          mme_app_send_s6a_update_location_req(ue_context_p);
-          unlock_ue_contexts(ue_context_p);
-        } else {
-          OAILOG_ERROR(
-            TASK_MME_APP, "UE context NULL for ue_id = (%u)\n",
+    nb_messages = itti_receive_msgs(
+      TASK_MME_APP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+
+    for (size_t i = 0; i < nb_messages; i++) {
+      MessageDef *received_message_p = received_messages[i];
+
+      switch (ITTI_MSG_ID(received_message_p)) {
+        case MESSAGE_TEST: {
+          OAI_FPRINTF_INFO("TASK_MME_APP received MESSAGE_TEST\n");
+        } break;
+
+        case MME_APP_INITIAL_CONTEXT_SETUP_RSP: {
+          mme_app_handle_initial_context_setup_rsp(
+            &MME_APP_INITIAL_CONTEXT_SETUP_RSP(received_message_p));
+        } break;
+
+        case MME_APP_CREATE_DEDICATED_BEARER_RSP: {
+          mme_app_handle_create_dedicated_bearer_rsp(
+            &MME_APP_CREATE_DEDICATED_BEARER_RSP(received_message_p));
+        } break;
+
+        case MME_APP_CREATE_DEDICATED_BEARER_REJ: {
+          mme_app_handle_create_dedicated_bearer_rej(
+            &MME_APP_CREATE_DEDICATED_BEARER_REJ(received_message_p));
+        } break;
+
+        case NAS_CONNECTION_ESTABLISHMENT_CNF: {
+          mme_app_handle_conn_est_cnf(
+            &NAS_CONNECTION_ESTABLISHMENT_CNF(received_message_p));
+        } break;
+
+        case MME_APP_DELETE_DEDICATED_BEARER_RSP: {
+          mme_app_handle_delete_dedicated_bearer_rsp(
+            &MME_APP_DELETE_DEDICATED_BEARER_RSP(received_message_p));
+        } break;
+
+        case NAS_DETACH_REQ: {
+          mme_app_handle_detach_req(
+            &received_message_p->ittiMsg.nas_detach_req);
+        } break;
+
+        case S6A_CANCEL_LOCATION_REQ: {
+          /*
+           * Check cancellation-type and handle it if it is SUBSCRIPTION_WITHDRAWAL.
+           * For any other cancellation-type log it and ignore it.
+           */
+          mme_app_handle_s6a_cancel_location_req(
+            &received_message_p->ittiMsg.s6a_cancel_location_req);
+        } break;
+
+        case NAS_ERAB_SETUP_REQ: {
+          mme_app_handle_erab_setup_req(
+            &NAS_ERAB_SETUP_REQ(received_message_p));
+        } break;
+
+        case NAS_ERAB_REL_CMD: {
+          mme_app_handle_erab_rel_cmd(&NAS_ERAB_REL_CMD(received_message_p));
+        } break;
+
+
+        case NAS_PDN_CONFIG_REQ: {
+          OAILOG_INFO(
+            TASK_MME_APP, "Received PDN CONFIG REQ from NAS_MME for ue_id = (%u)\n",
             received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
-        }
-      } break;
-
-      case NAS_PDN_CONNECTIVITY_REQ: {
-        OAILOG_INFO(
-          TASK_MME_APP, "Received PDN CONNECTIVITY REQ from NAS_MME\n");
-        mme_app_handle_nas_pdn_connectivity_req(
-          &received_message_p->ittiMsg.nas_pdn_connectivity_req);
-      } break;
-
-      case NAS_UPLINK_DATA_IND: {
-        ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id(
-          &mme_app_desc.mme_ue_contexts,
-          NAS_UL_DATA_IND(received_message_p).ue_id);
-        nas_proc_ul_transfer_ind(
-          NAS_UL_DATA_IND(received_message_p).ue_id,
-          NAS_UL_DATA_IND(received_message_p).tai,
-          NAS_UL_DATA_IND(received_message_p).cgi,
-          &NAS_UL_DATA_IND(received_message_p).nas_msg);
-        if (ue_context_p) {
-          unlock_ue_contexts(ue_context_p);
-        }
-      } break;
-
-      case S11_CREATE_BEARER_REQUEST: {
-        mme_app_handle_s11_create_bearer_req(
-          &received_message_p->ittiMsg.s11_create_bearer_request);
-      } break;
-
-      case S6A_RESET_REQ: {
-        mme_app_handle_s6a_reset_req(
-          &received_message_p->ittiMsg.s6a_reset_req);
-      } break;
-
-      case S11_CREATE_SESSION_RESPONSE: {
-        mme_app_handle_create_sess_resp(
-          &received_message_p->ittiMsg.s11_create_session_response);
-      } break;
-
-      case S11_MODIFY_BEARER_RESPONSE: {
-        OAILOG_INFO(
-          TASK_MME_APP, "Received S11 MODIFY BEARER RESPONSE from SPGW\n");
-        ue_context_p = mme_ue_context_exists_s11_teid(
-          &mme_app_desc.mme_ue_contexts,
-          received_message_p->ittiMsg.s11_modify_bearer_response.teid);
-
-        if (ue_context_p == NULL) {
-          OAILOG_WARNING(
-            LOG_MME_APP,
-            "We didn't find this teid in list of UE: %08x\n",
-            received_message_p->ittiMsg.s11_modify_bearer_response.teid);
-        } else {
-          OAILOG_DEBUG(
-            TASK_MME_APP, "S11 MODIFY BEARER RESPONSE local S11 teid = " TEID_FMT"\n",
-            received_message_p->ittiMsg.s11_modify_bearer_response.teid);
-
-          if (ue_context_p->path_switch_req != true) {
-            /* Updating statistics */
-            update_mme_app_stats_s1u_bearer_add();
-          }
-          if (ue_context_p->path_switch_req == true) {
-            mme_app_handle_path_switch_req_ack(
-              &received_message_p->ittiMsg.s11_modify_bearer_response,
-              ue_context_p);
-            ue_context_p->path_switch_req = false;
+          struct ue_mm_context_s *ue_context_p = NULL;
+          ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id(
+            &mme_app_desc.mme_ue_contexts,
+            received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
+          if (ue_context_p) {
+            mme_app_send_s6a_update_location_req(ue_context_p);
+            unlock_ue_contexts(ue_context_p);
+          } else {
+            OAILOG_ERROR(
+              TASK_MME_APP, "UE context NULL for ue_id = (%u)\n",
+              received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
           }
+        } break;
 
-          unlock_ue_contexts(ue_context_p);
-        }
-      } break;
-
-      case S11_RELEASE_ACCESS_BEARERS_RESPONSE: {
-        mme_app_handle_release_access_bearers_resp(
-          &received_message_p->ittiMsg.s11_release_access_bearers_response);
-      } break;
-
-      case S11_DELETE_SESSION_RESPONSE: {
-        mme_app_handle_delete_session_rsp(
-          &received_message_p->ittiMsg.s11_delete_session_response);
-      } break;
-
-      case S11_SUSPEND_ACKNOWLEDGE: {
-        mme_app_handle_suspend_acknowledge(
-          &received_message_p->ittiMsg.s11_suspend_acknowledge);
-      } break;
-
-      case S1AP_E_RAB_SETUP_RSP: {
-        mme_app_handle_e_rab_setup_rsp(
-          &S1AP_E_RAB_SETUP_RSP(received_message_p));
-      } break;
-
-      case S1AP_E_RAB_REL_RSP: {
-        mme_app_handle_e_rab_rel_rsp(
-          &S1AP_E_RAB_REL_RSP(received_message_p));
-      } break;
-
-      case NAS_EXTENDED_SERVICE_REQ: {
-        mme_app_handle_nas_extended_service_req(
-          &received_message_p->ittiMsg.nas_extended_service_req);
-      } break;
-
-      case S1AP_INITIAL_UE_MESSAGE: {
-        mme_app_handle_initial_ue_message(
-          &S1AP_INITIAL_UE_MESSAGE(received_message_p));
-      } break;
-
-      case NAS_SGS_DETACH_REQ: {
-        OAILOG_INFO(LOG_MME_APP, "Recieved SGS detach request from NAS\n");
-        mme_app_handle_sgs_detach_req(
-          &received_message_p->ittiMsg.nas_sgs_detach_req);
-      } break;
-
-      case S6A_UPDATE_LOCATION_ANS: {
-        /*
-         * We received the update location answer message from HSS -> Handle it
-         */
-        OAILOG_INFO(LOG_MME_APP, "Received S6A Update Location Answer from S6A\n");
-        mme_app_handle_s6a_update_location_ans(
-          &received_message_p->ittiMsg.s6a_update_location_ans);
-      } break;
-
-      case S1AP_ENB_INITIATED_RESET_REQ: {
-        mme_app_handle_enb_reset_req(
-          &S1AP_ENB_INITIATED_RESET_REQ(received_message_p));
-      } break;
-
-      case S11_PAGING_REQUEST: {
-        const char *imsi = received_message_p->ittiMsg.s11_paging_request.imsi;
-        OAILOG_DEBUG(
-          TASK_MME_APP, "MME handling paging request for IMSI%s\n", imsi);
-        if (mme_app_handle_initial_paging_request(imsi) != RETURNok) {
-          OAILOG_ERROR(
-            TASK_MME_APP,
-            "Failed to send paging request to S1AP for IMSI%s\n",
-            imsi);
-        }
-      } break;
-
-      case MME_APP_INITIAL_CONTEXT_SETUP_FAILURE: {
-        mme_app_handle_initial_context_setup_failure(
-          &MME_APP_INITIAL_CONTEXT_SETUP_FAILURE(received_message_p));
-      } break;
-
-      case TIMER_HAS_EXPIRED: {
-        /*
-         * Check statistic timer
-         */
-        if (!timer_exists(
-              received_message_p->ittiMsg.timer_has_expired.timer_id)) {
-          OAILOG_WARNING(
-            LOG_MME_APP,
-            "Timer expiry signal received for timer \
-            %lu, but it has already been deleted\n",
-            received_message_p->ittiMsg.timer_has_expired.timer_id);
-          break;
-        }
-        if (
-          received_message_p->ittiMsg.timer_has_expired.timer_id ==
-          mme_app_desc.statistic_timer_id) {
-          mme_app_statistics_display();
-        } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
-          mme_ue_s1ap_id_t mme_ue_s1ap_id =
-            *((mme_ue_s1ap_id_t *) (received_message_p->ittiMsg
-                                      .timer_has_expired.arg));
+        case NAS_PDN_CONNECTIVITY_REQ: {
+          OAILOG_INFO(
+            TASK_MME_APP, "Received PDN CONNECTIVITY REQ from NAS_MME\n");
+          mme_app_handle_nas_pdn_connectivity_req(
+            &received_message_p->ittiMsg.nas_pdn_connectivity_req);
+        } break;
+
+        case NAS_UPLINK_DATA_IND: {
           ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id(
-            &mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
+            &mme_app_desc.mme_ue_contexts,
+            NAS_UL_DATA_IND(received_message_p).ue_id);
+          nas_proc_ul_transfer_ind(
+            NAS_UL_DATA_IND(received_message_p).ue_id,
+            NAS_UL_DATA_IND(received_message_p).tai,
+            NAS_UL_DATA_IND(received_message_p).cgi,
+            &NAS_UL_DATA_IND(received_message_p).nas_msg);
+          if (ue_context_p) {
+            unlock_ue_contexts(ue_context_p);
+          }
+        } break;
+
+        case S11_CREATE_BEARER_REQUEST: {
+          mme_app_handle_s11_create_bearer_req(
+            &received_message_p->ittiMsg.s11_create_bearer_request);
+        } break;
+
+        case S6A_RESET_REQ: {
+          mme_app_handle_s6a_reset_req(
+            &received_message_p->ittiMsg.s6a_reset_req);
+        } break;
+
+        case S11_CREATE_SESSION_RESPONSE: {
+          mme_app_handle_create_sess_resp(
+            &received_message_p->ittiMsg.s11_create_session_response);
+        } break;
+
+        case S11_MODIFY_BEARER_RESPONSE: {
+          OAILOG_INFO(
+            TASK_MME_APP, "Received S11 MODIFY BEARER RESPONSE from SPGW\n");
+          ue_context_p = mme_ue_context_exists_s11_teid(
+            &mme_app_desc.mme_ue_contexts,
+            received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+
           if (ue_context_p == NULL) {
             OAILOG_WARNING(
               LOG_MME_APP,
-              "Timer expired but no assoicated UE context for UE "
-              "id " MME_UE_S1AP_ID_FMT "\n",
-              mme_ue_s1ap_id);
-            timer_handle_expired(
+              "We didn't find this teid in list of UE: %08x\n",
+              received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+          } else {
+            OAILOG_DEBUG(
+              TASK_MME_APP, "S11 MODIFY BEARER RESPONSE local S11 teid = " TEID_FMT"\n",
+              received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+
+            if (ue_context_p->path_switch_req != true) {
+              /* Updating statistics */
+              update_mme_app_stats_s1u_bearer_add();
+            }
+            if (ue_context_p->path_switch_req == true) {
+              mme_app_handle_path_switch_req_ack(
+                &received_message_p->ittiMsg.s11_modify_bearer_response,
+                ue_context_p);
+              ue_context_p->path_switch_req = false;
+            }
+
+            unlock_ue_contexts(ue_context_p);
+          }
+        } break;
+
+        case S11_RELEASE_ACCESS_BEARERS_RESPONSE: {
+          mme_app_handle_release_access_bearers_resp(
+            &received_message_p->ittiMsg.s11_release_access_bearers_response);
+        } break;
+
+        case S11_DELETE_SESSION_RESPONSE: {
+          mme_app_handle_delete_session_rsp(
+            &received_message_p->ittiMsg.s11_delete_session_response);
+        } break;
+
+        case S11_SUSPEND_ACKNOWLEDGE: {
+          mme_app_handle_suspend_acknowledge(
+            &received_message_p->ittiMsg.s11_suspend_acknowledge);
+        } break;
+
+        case S1AP_E_RAB_SETUP_RSP: {
+          mme_app_handle_e_rab_setup_rsp(
+            &S1AP_E_RAB_SETUP_RSP(received_message_p));
+        } break;
+
+        case S1AP_E_RAB_REL_RSP: {
+          mme_app_handle_e_rab_rel_rsp(
+            &S1AP_E_RAB_REL_RSP(received_message_p));
+        } break;
+
+        case NAS_EXTENDED_SERVICE_REQ: {
+          mme_app_handle_nas_extended_service_req(
+            &received_message_p->ittiMsg.nas_extended_service_req);
+        } break;
+
+        case S1AP_INITIAL_UE_MESSAGE: {
+          mme_app_handle_initial_ue_message(
+            &S1AP_INITIAL_UE_MESSAGE(received_message_p));
+        } break;
+
+        case NAS_SGS_DETACH_REQ: {
+          OAILOG_INFO(LOG_MME_APP, "Recieved SGS detach request from NAS\n");
+          mme_app_handle_sgs_detach_req(
+            &received_message_p->ittiMsg.nas_sgs_detach_req);
+        } break;
+
+        case S6A_UPDATE_LOCATION_ANS: {
+          /*
+           * We received the update location answer message from HSS -> Handle it
+           */
+          OAILOG_INFO(LOG_MME_APP, "Received S6A Update Location Answer from S6A\n");
+          mme_app_handle_s6a_update_location_ans(
+            &received_message_p->ittiMsg.s6a_update_location_ans);
+        } break;
+
+        case S1AP_ENB_INITIATED_RESET_REQ: {
+          mme_app_handle_enb_reset_req(
+            &S1AP_ENB_INITIATED_RESET_REQ(received_message_p));
+        } break;
+
+        case S11_PAGING_REQUEST: {
+          const char *imsi =
+            received_message_p->ittiMsg.s11_paging_request.imsi;
+          OAILOG_DEBUG(
+            TASK_MME_APP, "MME handling paging request for IMSI%s\n", imsi);
+          if (mme_app_handle_initial_paging_request(imsi) != RETURNok) {
+            OAILOG_ERROR(
+              TASK_MME_APP,
+              "Failed to send paging request to S1AP for IMSI%s\n",
+              imsi);
+          }
+        } break;
+
+        case MME_APP_INITIAL_CONTEXT_SETUP_FAILURE: {
+          mme_app_handle_initial_context_setup_failure(
+            &MME_APP_INITIAL_CONTEXT_SETUP_FAILURE(received_message_p));
+        } break;
+
+        case TIMER_HAS_EXPIRED: {
+          /*
+           * Check statistic timer
+           */
+          if (!timer_exists(
+                received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+            OAILOG_WARNING(
+              LOG_MME_APP,
+              "Timer expiry signal received for timer \
+              %lu, but it has already been deleted\n",
               received_message_p->ittiMsg.timer_has_expired.timer_id);
             break;
           }
           if (
             received_message_p->ittiMsg.timer_has_expired.timer_id ==
-            ue_context_p->mobile_reachability_timer.id) {
-            // Mobile Reachability Timer expiry handler
-            mme_app_handle_mobile_reachability_timer_expiry(ue_context_p);
-          } else if (
-            received_message_p->ittiMsg.timer_has_expired.timer_id ==
-            ue_context_p->implicit_detach_timer.id) {
-            // Implicit Detach Timer expiry handler
-            increment_counter("implicit_detach_timer_expired", 1, NO_LABELS);
-            mme_app_handle_implicit_detach_timer_expiry(ue_context_p);
-          } else if (
-            received_message_p->ittiMsg.timer_has_expired.timer_id ==
-            ue_context_p->initial_context_setup_rsp_timer.id) {
-            // Initial Context Setup Rsp Timer expiry handler
-            increment_counter(
-              "initial_context_setup_request_timer_expired", 1, NO_LABELS);
-            mme_app_handle_initial_context_setup_rsp_timer_expiry(ue_context_p);
+            mme_app_desc.statistic_timer_id) {
+            mme_app_statistics_display();
           } else if (
-            received_message_p->ittiMsg.timer_has_expired.timer_id ==
-            ue_context_p->paging_response_timer.id) {
-            mme_app_handle_paging_timer_expiry(ue_context_p);
-          } else if (
-            received_message_p->ittiMsg.timer_has_expired.timer_id ==
-            ue_context_p->ulr_response_timer.id) {
-            mme_app_handle_ulr_timer_expiry(ue_context_p);
-          } else if (
-            received_message_p->ittiMsg.timer_has_expired.timer_id ==
-            ue_context_p->ue_context_modification_timer.id) {
-            // UE Context modification Timer expiry handler
-            increment_counter(
-              "ue_context_modification_timer expired", 1, NO_LABELS);
-            mme_app_handle_ue_context_modification_timer_expiry(ue_context_p);
-          } else if (ue_context_p->sgs_context != NULL){
-              if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
-                  ue_context_p->sgs_context->ts6_1_timer.id) {
-                  mme_app_handle_ts6_1_timer_expiry(ue_context_p);
-              } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
-                ue_context_p->sgs_context->ts8_timer.id) {
-                mme_app_handle_sgs_eps_detach_timer_expiry(ue_context_p);
-              } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
-                ue_context_p->sgs_context->ts9_timer.id) {
-                mme_app_handle_sgs_imsi_detach_timer_expiry(ue_context_p);
-              } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
-                ue_context_p->sgs_context->ts10_timer.id) {
-                mme_app_handle_sgs_implicit_imsi_detach_timer_expiry(ue_context_p);
-              } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
-                ue_context_p->sgs_context->ts13_timer.id) {
-                mme_app_handle_sgs_implicit_eps_detach_timer_expiry(ue_context_p);
-              }
+            received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
+            mme_ue_s1ap_id_t mme_ue_s1ap_id =
+              *((mme_ue_s1ap_id_t *) (received_message_p->ittiMsg
+                                        .timer_has_expired.arg));
+            ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id(
+              &mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
+            if (ue_context_p == NULL) {
+              OAILOG_WARNING(
+                LOG_MME_APP,
+                "Timer expired but no assoicated UE context for UE "
+                "id " MME_UE_S1AP_ID_FMT "\n",
+                mme_ue_s1ap_id);
+              timer_handle_expired(
+                received_message_p->ittiMsg.timer_has_expired.timer_id);
+              break;
+            }
+            if (
+              received_message_p->ittiMsg.timer_has_expired.timer_id ==
+              ue_context_p->mobile_reachability_timer.id) {
+              // Mobile Reachability Timer expiry handler
+              mme_app_handle_mobile_reachability_timer_expiry(ue_context_p);
+            } else if (
+              received_message_p->ittiMsg.timer_has_expired.timer_id ==
+              ue_context_p->implicit_detach_timer.id) {
+              // Implicit Detach Timer expiry handler
+              increment_counter("implicit_detach_timer_expired", 1, NO_LABELS);
+              mme_app_handle_implicit_detach_timer_expiry(ue_context_p);
+            } else if (
+              received_message_p->ittiMsg.timer_has_expired.timer_id ==
+              ue_context_p->initial_context_setup_rsp_timer.id) {
+              // Initial Context Setup Rsp Timer expiry handler
+              increment_counter(
+                "initial_context_setup_request_timer_expired", 1, NO_LABELS);
+              mme_app_handle_initial_context_setup_rsp_timer_expiry(
+                ue_context_p);
+            } else if (
+              received_message_p->ittiMsg.timer_has_expired.timer_id ==
+              ue_context_p->paging_response_timer.id) {
+              mme_app_handle_paging_timer_expiry(ue_context_p);
+            } else if (
+              received_message_p->ittiMsg.timer_has_expired.timer_id ==
+              ue_context_p->ulr_response_timer.id) {
+              mme_app_handle_ulr_timer_expiry(ue_context_p);
+            } else if (
+              received_message_p->ittiMsg.timer_has_expired.timer_id ==
+              ue_context_p->ue_context_modification_timer.id) {
+              // UE Context modification Timer expiry handler
+              increment_counter(
+                "ue_context_modification_timer expired", 1, NO_LABELS);
+              mme_app_handle_ue_context_modification_timer_expiry(ue_context_p);
+            } else if (ue_context_p->sgs_context != NULL){
+                if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                    ue_context_p->sgs_context->ts6_1_timer.id) {
+                    mme_app_handle_ts6_1_timer_expiry(ue_context_p);
+                } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                  ue_context_p->sgs_context->ts8_timer.id) {
+                  mme_app_handle_sgs_eps_detach_timer_expiry(ue_context_p);
+                } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                  ue_context_p->sgs_context->ts9_timer.id) {
+                  mme_app_handle_sgs_imsi_detach_timer_expiry(ue_context_p);
+                } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                  ue_context_p->sgs_context->ts10_timer.id) {
+                  mme_app_handle_sgs_implicit_imsi_detach_timer_expiry(ue_context_p);
+                } else if (received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                  ue_context_p->sgs_context->ts13_timer.id) {
+                  mme_app_handle_sgs_implicit_eps_detach_timer_expiry(ue_context_p);
+                }
+            }
+            else {
+              OAILOG_WARNING(
+                LOG_MME_APP,
+                "Timer expired but no associated timer_id for UE "
+                "id " MME_UE_S1AP_ID_FMT "\n",
+                mme_ue_s1ap_id);
+            }
+            if (ue_context_p) {
+              unlock_ue_contexts(ue_context_p);
+            }
           }
-          else {
-            OAILOG_WARNING(
-              LOG_MME_APP,
-              "Timer expired but no associated timer_id for UE "
-              "id " MME_UE_S1AP_ID_FMT "\n",
-              mme_ue_s1ap_id);
-          }
-          if (ue_context_p) {
-            unlock_ue_contexts(ue_context_p);
+          timer_handle_expired(
+            received_message_p->ittiMsg.timer_has_expired.timer_id);
+        } break;
+
+        case S1AP_UE_CAPABILITIES_IND: {
+          mme_app_handle_s1ap_ue_capabilities_ind(
+            &received_message_p->ittiMsg.s1ap_ue_cap_ind);
+        } break;
+
+        case S1AP_UE_CONTEXT_RELEASE_REQ: {
+          mme_app_handle_s1ap_ue_context_release_req(
+            &received_message_p->ittiMsg.s1ap_ue_context_release_req);
+        } break;
+
+        case S1AP_UE_CONTEXT_MODIFICATION_RESPONSE: {
+          mme_app_handle_s1ap_ue_context_modification_resp(
+            &received_message_p->ittiMsg.s1ap_ue_context_mod_response);
+        } break;
+
+        case S1AP_UE_CONTEXT_MODIFICATION_FAILURE: {
+          mme_app_handle_s1ap_ue_context_modification_fail(
+            &received_message_p->ittiMsg.s1ap_ue_context_mod_failure);
+        } break;
+        case S1AP_UE_CONTEXT_RELEASE_COMPLETE: {
+          mme_app_handle_s1ap_ue_context_release_complete(
+            &received_message_p->ittiMsg.s1ap_ue_context_release_complete);
+        } break;
+
+        case NAS_DOWNLINK_DATA_REQ: {
+          mme_app_handle_nas_dl_req(
+            &received_message_p->ittiMsg.nas_dl_data_req);
+        } break;
+
+        case S1AP_ENB_DEREGISTERED_IND: {
+          mme_app_handle_enb_deregister_ind(
+            &received_message_p->ittiMsg.s1ap_eNB_deregistered_ind);
+        } break;
+
+        case ACTIVATE_MESSAGE: {
+          mme_hss_associated = true;
+          _check_mme_healthy_and_notify_service();
+        } break;
+
+        case SCTP_MME_SERVER_INITIALIZED: {
+          mme_sctp_bounded =
+            &received_message_p->ittiMsg.sctp_mme_server_initialized.successful;
+          _check_mme_healthy_and_notify_service();
+        } break;
+
+        case S6A_PURGE_UE_ANS: {
+          mme_app_handle_s6a_purge_ue_ans(
+            &received_message_p->ittiMsg.s6a_purge_ue_ans);
+        } break;
+
+        case NAS_CS_DOMAIN_LOCATION_UPDATE_REQ: {
+          /*Received SGS Location Update Request message from NAS task*/
+          OAILOG_INFO(
+            TASK_MME_APP, "Received CS DOMAIN LOCATION UPDATE REQ from NAS\n");
+          mme_app_handle_nas_cs_domain_location_update_req(
+            &received_message_p->ittiMsg.nas_cs_domain_location_update_req);
+        } break;
+
+        case SGSAP_LOCATION_UPDATE_ACC: {
+          /*Received SGSAP Location Update Accept message from SGS task*/
+          OAILOG_INFO(
+            TASK_MME_APP, "Received SGSAP Location Update Accept from SGS\n");
+          mme_app_handle_sgsap_location_update_acc(
+            &received_message_p->ittiMsg.sgsap_location_update_acc);
+        } break;
+
+        case SGSAP_LOCATION_UPDATE_REJ: {
+          /*Received SGSAP Location Update Reject message from SGS task*/
+          mme_app_handle_sgsap_location_update_rej(
+            &received_message_p->ittiMsg.sgsap_location_update_rej);
+        } break;
+
+        case NAS_TAU_COMPLETE: {
+          /*Received TAU Complete message from NAS task*/
+          mme_app_handle_nas_tau_complete(
+            &received_message_p->ittiMsg.nas_tau_complete);
+        } break;
+
+        case SGSAP_ALERT_REQUEST: {
+          /*Received SGSAP Alert Request message from SGS task*/
+          mme_app_handle_sgsap_alert_request(
+            &received_message_p->ittiMsg.sgsap_alert_request);
+        } break;
+
+        case SGSAP_VLR_RESET_INDICATION: {
+          /*Received SGSAP Reset Indication from SGS task*/
+          mme_app_handle_sgsap_reset_indication(
+            &received_message_p->ittiMsg.sgsap_vlr_reset_indication);
+        } break;
+
+        case SGSAP_PAGING_REQUEST: {
+          mme_app_handle_sgsap_paging_request(
+            &received_message_p->ittiMsg.sgsap_paging_request);
+        } break;
+
+        case SGSAP_SERVICE_ABORT_REQ: {
+          mme_app_handle_sgsap_service_abort_request(
+            &received_message_p->ittiMsg.sgsap_service_abort_req);
+        } break;
+
+        case SGSAP_EPS_DETACH_ACK: {
+          mme_app_handle_sgs_eps_detach_ack(
+            &received_message_p->ittiMsg.sgsap_eps_detach_ack);
+        } break;
+
+        case SGSAP_IMSI_DETACH_ACK: {
+          mme_app_handle_sgs_imsi_detach_ack(
+            &received_message_p->ittiMsg.sgsap_imsi_detach_ack);
+        } break;
+
+        case S11_MODIFY_UE_AMBR_REQUEST: {
+          mme_app_handle_modify_ue_ambr_request(
+            &S11_MODIFY_UE_AMBR_REQUEST(received_message_p));
+        } break;
+
+        case S11_NW_INITIATED_ACTIVATE_BEARER_REQUEST: {
+          mme_app_handle_nw_init_ded_bearer_actv_req(
+            &received_message_p->ittiMsg.s11_nw_init_actv_bearer_request);
+        } break;
+
+        case SGSAP_STATUS: {
+          mme_app_handle_sgs_status_message(
+            &received_message_p->ittiMsg.sgsap_status);
+        } break;
+
+        case S11_NW_INITIATED_DEACTIVATE_BEARER_REQUEST: {
+          mme_app_handle_nw_init_bearer_deactv_req(
+            &received_message_p->ittiMsg.s11_nw_init_deactv_bearer_request);
+        } break;
+
+        case MME_APP_DELETE_DEDICATED_BEARER_REJ: {
+          mme_app_handle_delete_dedicated_bearer_rej(
+            &MME_APP_DELETE_DEDICATED_BEARER_REJ(received_message_p));
+        } break;
+
+        case S1AP_PATH_SWITCH_REQUEST: {
+          mme_app_handle_path_switch_request(
+            &S1AP_PATH_SWITCH_REQUEST(received_message_p));
+        } break;
+
+        case TERMINATE_MESSAGE: {
+          /*
+         * Termination message received TODO -> release any data allocated
+         * Every worker gets it, the task thread releases the shared data
+         */
+          if (itti_get_task_worker(TASK_MME_APP) == 0) {
+            mme_app_exit();
           }
-        }
-        timer_handle_expired(
-          received_message_p->ittiMsg.timer_has_expired.timer_id);
-      } break;
-
-      case S1AP_UE_CAPABILITIES_IND: {
-        mme_app_handle_s1ap_ue_capabilities_ind(
-          &received_message_p->ittiMsg.s1ap_ue_cap_ind);
-      } break;
-
-      case S1AP_UE_CONTEXT_RELEASE_REQ: {
-        mme_app_handle_s1ap_ue_context_release_req(
-          &received_message_p->ittiMsg.s1ap_ue_context_release_req);
-      } break;
-
-      case S1AP_UE_CONTEXT_MODIFICATION_RESPONSE: {
-        mme_app_handle_s1ap_ue_context_modification_resp(
-          &received_message_p->ittiMsg.s1ap_ue_context_mod_response);
-      } break;
-
-      case S1AP_UE_CONTEXT_MODIFICATION_FAILURE: {
-        mme_app_handle_s1ap_ue_context_modification_fail(
-          &received_message_p->ittiMsg.s1ap_ue_context_mod_failure);
-      } break;
-      case S1AP_UE_CONTEXT_RELEASE_COMPLETE: {
-        mme_app_handle_s1ap_ue_context_release_complete(
-          &received_message_p->ittiMsg.s1ap_ue_context_release_complete);
-      } break;
-
-      case NAS_DOWNLINK_DATA_REQ: {
-        mme_app_handle_nas_dl_req(&received_message_p->ittiMsg.nas_dl_data_req);
-      } break;
-
-      case S1AP_ENB_DEREGISTERED_IND: {
-        mme_app_handle_enb_deregister_ind(
-          &received_message_p->ittiMsg.s1ap_eNB_deregistered_ind);
-      } break;
-
-      case ACTIVATE_MESSAGE: {
-        mme_hss_associated = true;
-        _check_mme_healthy_and_notify_service();
-      } break;
-
-      case SCTP_MME_SERVER_INITIALIZED: {
-        mme_sctp_bounded =
-          &received_message_p->ittiMsg.sctp_mme_server_initialized.successful;
-        _check_mme_healthy_and_notify_service();
-      } break;
-
-      case S6A_PURGE_UE_ANS: {
-        mme_app_handle_s6a_purge_ue_ans(
-          &received_message_p->ittiMsg.s6a_purge_ue_ans);
-      } break;
-
-      case NAS_CS_DOMAIN_LOCATION_UPDATE_REQ: {
-        /*Received SGS Location Update Request message from NAS task*/
-        OAILOG_INFO(
-          TASK_MME_APP, "Received CS DOMAIN LOCATION UPDATE REQ from NAS\n");
-        mme_app_handle_nas_cs_domain_location_update_req(
-          &received_message_p->ittiMsg.nas_cs_domain_location_update_req);
-      } break;
-
-      case SGSAP_LOCATION_UPDATE_ACC: {
-        /*Received SGSAP Location Update Accept message from SGS task*/
-        OAILOG_INFO(
-          TASK_MME_APP, "Received SGSAP Location Update Accept from SGS\n");
-        mme_app_handle_sgsap_location_update_acc(
-          &received_message_p->ittiMsg.sgsap_location_update_acc);
-      } break;
-
-      case SGSAP_LOCATION_UPDATE_REJ: {
-        /*Received SGSAP Location Update Reject message from SGS task*/
-        mme_app_handle_sgsap_location_update_rej(
-          &received_message_p->ittiMsg.sgsap_location_update_rej);
-      } break;
-
-      case NAS_TAU_COMPLETE: {
-        /*Received TAU Complete message from NAS task*/
-        mme_app_handle_nas_tau_complete(
-          &received_message_p->ittiMsg.nas_tau_complete);
-      } break;
-
-      case SGSAP_ALERT_REQUEST: {
-        /*Received SGSAP Alert Request message from SGS task*/
-        mme_app_handle_sgsap_alert_request(
-          &received_message_p->ittiMsg.sgsap_alert_request);
-      } break;
-
-      case SGSAP_VLR_RESET_INDICATION: {
-        /*Received SGSAP Reset Indication from SGS task*/
-        mme_app_handle_sgsap_reset_indication(
-          &received_message_p->ittiMsg.sgsap_vlr_reset_indication);
-      } break;
-
-      case SGSAP_PAGING_REQUEST: {
-        mme_app_handle_sgsap_paging_request(
-          &received_message_p->ittiMsg.sgsap_paging_request);
-      } break;
-
-      case SGSAP_SERVICE_ABORT_REQ: {
-        mme_app_handle_sgsap_service_abort_request(
-          &received_message_p->ittiMsg.sgsap_service_abort_req);
-      } break;
-
-      case SGSAP_EPS_DETACH_ACK: {
-        mme_app_handle_sgs_eps_detach_ack(
-          &received_message_p->ittiMsg.sgsap_eps_detach_ack);
-      } break;
-
-      case SGSAP_IMSI_DETACH_ACK: {
-        mme_app_handle_sgs_imsi_detach_ack(
-          &received_message_p->ittiMsg.sgsap_imsi_detach_ack);
-      } break;
-
-      case S11_MODIFY_UE_AMBR_REQUEST: {
-        mme_app_handle_modify_ue_ambr_request(
-          &S11_MODIFY_UE_AMBR_REQUEST(received_message_p));
-      } break;
-
-      case S11_NW_INITIATED_ACTIVATE_BEARER_REQUEST: {
-        mme_app_handle_nw_init_ded_bearer_actv_req(
-          &received_message_p->ittiMsg.s11_nw_init_actv_bearer_request);
-      } break;
-
-      case SGSAP_STATUS: {
-        mme_app_handle_sgs_status_message(
-          &received_message_p->ittiMsg.sgsap_status);
-      } break;
-
-      case S11_NW_INITIATED_DEACTIVATE_BEARER_REQUEST: {
-        mme_app_handle_nw_init_bearer_deactv_req(
-          &received_message_p->ittiMsg.s11_nw_init_deactv_bearer_request);
-      } break;
-
-      case MME_APP_DELETE_DEDICATED_BEARER_REJ: {
-        mme_app_handle_delete_dedicated_bearer_rej(
-          &MME_APP_DELETE_DEDICATED_BEARER_REJ(received_message_p));
-      } break;
-
-      case S1AP_PATH_SWITCH_REQUEST: {
-        mme_app_handle_path_switch_request(
-          &S1AP_PATH_SWITCH_REQUEST(received_message_p));
-      } break;
-
-      case TERMINATE_MESSAGE: {
-        /*
-       * Termination message received TODO -> release any data allocated
-       */
-        mme_app_exit();
-        itti_free_msg_content(received_message_p);
-        itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
-        OAI_FPRINTF_INFO("TASK_MME_APP terminated\n");
-        itti_exit_task();
-      } break;
-
-      default: {
-        OAILOG_DEBUG(
-          LOG_MME_APP,
-          "Unkwnon message ID %d:%s\n",
-          ITTI_MSG_ID(received_message_p),
-          ITTI_MSG_NAME(received_message_p));
-        AssertFatal(
-          0,
-          "Unkwnon message ID %d:%s\n",
-          ITTI_MSG_ID(received_message_p),
-          ITTI_MSG_NAME(received_message_p));
-      } break;
-    }
+          itti_free_msgs(&received_messages[i], nb_messages - i);
+          OAI_FPRINTF_INFO("TASK_MME_APP terminated\n");
+          itti_exit_task();
+        } break;
 
-    itti_free_msg_content(received_message_p);
-    itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
-    received_message_p = NULL;
+        default: {
+          OAILOG_DEBUG(
+            LOG_MME_APP,
+            "Unkwnon message ID %d:%s\n",
+            ITTI_MSG_ID(received_message_p),
+            ITTI_MSG_NAME(received_message_p));
+          AssertFatal(
+            0,
+            "Unkwnon message ID %d:%s\n",
+            ITTI_MSG_ID(received_message_p),
+            ITTI_MSG_NAME(received_message_p));
+        } break;
+      }
+
+      itti_free_msg_content(received_message_p);
+      itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
+    }
   }
 
   return NULL;
 }
 
+//------------------------------------------------------------------------------
+// Shard key of the UE registered with key in htbl, worker 0 if none
+static uint32_t _mme_app_shard_by_coll_key(
+  hash_table_uint64_ts_t *const htbl,
+  const hash_key_t key)
+{
+  uint64_t mme_ue_s1ap_id64 = 0;
+
+  if (HASH_TABLE_OK != hashtable_uint64_ts_get(htbl, key, &mme_ue_s1ap_id64)) {
+    return 0;
+  }
+  return (uint32_t) mme_ue_s1ap_id64;
+}
+
+static uint32_t _mme_app_shard_by_imsi(const char *const imsi)
+{
+  imsi64_t imsi64 = INVALID_IMSI64;
+
+  IMSI_STRING_TO_IMSI64(imsi, &imsi64);
+  return _mme_app_shard_by_coll_key(
+    mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_IMSI], imsi64);
+}
+
+static uint32_t _mme_app_shard_by_s11_teid(const teid_t teid)
+{
+  return _mme_app_shard_by_coll_key(
+    mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_S11_TEID], teid);
+}
+
+static uint32_t _mme_app_shard_initial_ue_message(
+  const itti_s1ap_initial_ue_message_t *const initial_p)
+{
+  // A UE coming back from idle goes to the worker of its context
+  if (initial_p->is_s_tmsi_valid) {
+    guti_t guti = {.gummei.plmn = {0},
+                   .gummei.mme_gid = 0,
+                   .gummei.mme_code = 0,
+                   .m_tmsi = INVALID_M_TMSI};
+    plmn_t plmn = {.mcc_digit1 = initial_p->tai.mcc_digit1,
+                   .mcc_digit2 = initial_p->tai.mcc_digit2,
+                   .mcc_digit3 = initial_p->tai.mcc_digit3,
+                   .mnc_digit1 = initial_p->tai.mnc_digit1,
+                   .mnc_digit2 = initial_p->tai.mnc_digit2,
+                   .mnc_digit3 = initial_p->tai.mnc_digit3};
+
+    // The PLMN is not checked, a foreign GUTI only picks another worker
+    if (mme_app_construct_guti(&plmn, &initial_p->opt_s_tmsi, &guti)) {
+      uint32_t shard = _mme_app_shard_by_coll_key(
+        mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_GUTI],
+        MME_APP_GUTI_KEY(&guti));
+
+      if (shard) {
+        return shard;
+      }
+    }
+  }
+  /*
+   * A new UE may be handled by any worker, its mme_ue_s1ap_id is then
+   * allocated so that its next messages reach the same worker
+   */
+  return initial_p->enb_id ^ initial_p->enb_ue_s1ap_id;
+}
+
+/*
+ * Shard key of the messages sent to the MME_APP workers: the mme_ue_s1ap_id
+ * of the UE they are about, looked up from its other identities if needed.
+ * Messages that are not about a single UE are all handled by worker 0.
+ */
+static uint32_t _mme_app_get_message_shard(const MessageDef *message_p)
+{
+  switch (ITTI_MSG_ID(message_p)) {
+    case MME_APP_INITIAL_CONTEXT_SETUP_RSP:
+      return MME_APP_INITIAL_CONTEXT_SETUP_RSP(message_p).ue_id;
+    case MME_APP_INITIAL_CONTEXT_SETUP_FAILURE:
+      return MME_APP_INITIAL_CONTEXT_SETUP_FAILURE(message_p).mme_ue_s1ap_id;
+    case MME_APP_CREATE_DEDICATED_BEARER_RSP:
+      return MME_APP_CREATE_DEDICATED_BEARER_RSP(message_p).ue_id;
+    case MME_APP_CREATE_DEDICATED_BEARER_REJ:
+      return MME_APP_CREATE_DEDICATED_BEARER_REJ(message_p).ue_id;
+    case MME_APP_DELETE_DEDICATED_BEARER_RSP:
+      return MME_APP_DELETE_DEDICATED_BEARER_RSP(message_p).ue_id;
+    case MME_APP_DELETE_DEDICATED_BEARER_REJ:
+      return MME_APP_DELETE_DEDICATED_BEARER_REJ(message_p).ue_id;
+    case NAS_CONNECTION_ESTABLISHMENT_CNF:
+      return NAS_CONNECTION_ESTABLISHMENT_CNF(message_p).ue_id;
+    case NAS_DETACH_REQ:
+      return message_p->ittiMsg.nas_detach_req.ue_id;
+    case NAS_ERAB_SETUP_REQ:
+      return NAS_ERAB_SETUP_REQ(message_p).ue_id;
+    case NAS_ERAB_REL_CMD:
+      return NAS_ERAB_REL_CMD(message_p).ue_id;
+    case NAS_PDN_CONFIG_REQ:
+      return message_p->ittiMsg.nas_pdn_config_req.ue_id;
+    case NAS_PDN_CONNECTIVITY_REQ:
+      return message_p->ittiMsg.nas_pdn_connectivity_req.ue_id;
+    case NAS_UPLINK_DATA_IND:
+      return NAS_UL_DATA_IND(message_p).ue_id;
+    case NAS_DOWNLINK_DATA_REQ:
+      return message_p->ittiMsg.nas_dl_data_req.ue_id;
+    case NAS_EXTENDED_SERVICE_REQ:
+      return message_p->ittiMsg.nas_extended_service_req.ue_id;
+    case NAS_SGS_DETACH_REQ:
+      return message_p->ittiMsg.nas_sgs_detach_req.ue_id;
+    case NAS_CS_DOMAIN_LOCATION_UPDATE_REQ:
+      return message_p->ittiMsg.nas_cs_domain_location_update_req.ue_id;
+    case NAS_TAU_COMPLETE:
+      return message_p->ittiMsg.nas_tau_complete.ue_id;
+    case S1AP_INITIAL_UE_MESSAGE:
+      return _mme_app_shard_initial_ue_message(
+        &S1AP_INITIAL_UE_MESSAGE(message_p));
+    case S1AP_E_RAB_SETUP_RSP:
+      return S1AP_E_RAB_SETUP_RSP(message_p).mme_ue_s1ap_id;
+    case S1AP_E_RAB_REL_RSP:
+      return S1AP_E_RAB_REL_RSP(message_p).mme_ue_s1ap_id;
+    case S1AP_UE_CAPABILITIES_IND:
+      return message_p->ittiMsg.s1ap_ue_cap_ind.mme_ue_s1ap_id;
+    case S1AP_UE_CONTEXT_RELEASE_REQ:
+      return message_p->ittiMsg.s1ap_ue_context_release_req.mme_ue_s1ap_id;
+    case S1AP_UE_CONTEXT_MODIFICATION_RESPONSE:
+      return message_p->ittiMsg.s1ap_ue_context_mod_response.mme_ue_s1ap_id;
+    case S1AP_UE_CONTEXT_MODIFICATION_FAILURE:
+      return message_p->ittiMsg.s1ap_ue_context_mod_failure.mme_ue_s1ap_id;
+    case S1AP_UE_CONTEXT_RELEASE_COMPLETE:
+      return message_p->ittiMsg.s1ap_ue_context_release_complete
+        .mme_ue_s1ap_id;
+    case S1AP_PATH_SWITCH_REQUEST:
+      return S1AP_PATH_SWITCH_REQUEST(message_p).mme_ue_s1ap_id;
+    case S6A_UPDATE_LOCATION_ANS:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.s6a_update_location_ans.imsi);
+    case S6A_CANCEL_LOCATION_REQ:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.s6a_cancel_location_req.imsi);
+    case S6A_PURGE_UE_ANS:
+      return _mme_app_shard_by_imsi(message_p->ittiMsg.s6a_purge_ue_ans.imsi);
+    case SGSAP_LOCATION_UPDATE_ACC:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_location_update_acc.imsi);
+    case SGSAP_LOCATION_UPDATE_REJ:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_location_update_rej.imsi);
+    case SGSAP_ALERT_REQUEST:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_alert_request.imsi);
+    case SGSAP_PAGING_REQUEST:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_paging_request.imsi);
+    case SGSAP_SERVICE_ABORT_REQ:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_service_abort_req.imsi);
+    case SGSAP_EPS_DETACH_ACK:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_eps_detach_ack.imsi);
+    case SGSAP_IMSI_DETACH_ACK:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.sgsap_imsi_detach_ack.imsi);
+    case SGSAP_STATUS:
+      return _mme_app_shard_by_imsi(message_p->ittiMsg.sgsap_status.imsi);
+    case S11_PAGING_REQUEST:
+      return _mme_app_shard_by_imsi(
+        message_p->ittiMsg.s11_paging_request.imsi);
+    case S11_CREATE_SESSION_RESPONSE:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_create_session_response.teid);
+    case S11_MODIFY_BEARER_RESPONSE:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_modify_bearer_response.teid);
+    case S11_RELEASE_ACCESS_BEARERS_RESPONSE:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_release_access_bearers_response.teid);
+    case S11_DELETE_SESSION_RESPONSE:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_delete_session_response.teid);
+    case S11_SUSPEND_ACKNOWLEDGE:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_suspend_acknowledge.teid);
+    case S11_CREATE_BEARER_REQUEST:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_create_bearer_request.teid);
+    case S11_MODIFY_UE_AMBR_REQUEST:
+      return _mme_app_shard_by_s11_teid(
+        S11_MODIFY_UE_AMBR_REQUEST(message_p).teid);
+    case S11_NW_INITIATED_ACTIVATE_BEARER_REQUEST:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_nw_init_actv_bearer_request.s11_mme_teid);
+    case S11_NW_INITIATED_DEACTIVATE_BEARER_REQUEST:
+      return _mme_app_shard_by_s11_teid(
+        message_p->ittiMsg.s11_nw_init_deactv_bearer_request.s11_mme_teid);
+    case TIMER_HAS_EXPIRED:
+      // UE timers carry the mme_ue_s1ap_id, the statistics one nothing
+      if (message_p->ittiMsg.timer_has_expired.arg != NULL) {
+        return *((mme_ue_s1ap_id_t *) message_p->ittiMsg.timer_has_expired.arg);
+      }
+      return 0;
+    default:
+      // eNB and HSS resets, health and statistics
+      return 0;
+  }
+}
+
 //------------------------------------------------------------------------------
 int mme_app_init(const mme_config_t *mme_config_p)
 {
   OAILOG_FUNC_IN(LOG_MME_APP);
   memset(&mme_app_desc, 0, sizeof(mme_app_desc));
-  pthread_rwlock_init(&mme_app_desc.rw_lock, NULL);
+  pthread_mutex_init(&mme_app_desc.mme_ue_contexts.registry_mutex, NULL);
+  /*
+   * IMSIs are spread and eNB keys share their low bits between eNBs, both
+   * hash better in the open addressing tables
+   */
   bstring b = bfromcstr("mme_app_imsi_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl =
-    hashtable_uint64_ts_create(mme_config.max_ues, NULL, b);
+  mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_IMSI] =
+    hashtable_uint64_ts_create_backend(
+      MME_APP_UE_CONTEXT_HTBL_INITIAL_SIZE,
+      NULL,
+      b,
+      HASH_TABLE_BACKEND_OPEN_ADDRESSING);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_tun11_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl =
-    hashtable_uint64_ts_create(mme_config.max_ues, NULL, b);
+  mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_S11_TEID] =
+    hashtable_uint64_ts_create(MME_APP_UE_CONTEXT_HTBL_INITIAL_SIZE, NULL, b);
   AssertFatal(
     sizeof(uintptr_t) >= sizeof(uint64_t),
     "Problem with mme_ue_s1ap_id_ue_context_htbl in MME_APP");
   btrunc(b, 0);
   bassigncstr(b, "mme_app_mme_ue_s1ap_id_ue_context_htbl");
   mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl =
-    hashtable_ts_create(mme_config.max_ues, NULL, NULL, b);
+    hashtable_ts_create(MME_APP_UE_CONTEXT_HTBL_INITIAL_SIZE, NULL, NULL, b);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_enb_ue_s1ap_id_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl =
-    hashtable_uint64_ts_create(mme_config.max_ues, NULL, b);
+  mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_ENB_S1AP_ID] =
+    hashtable_uint64_ts_create_backend(
+      MME_APP_UE_CONTEXT_HTBL_INITIAL_SIZE,
+      NULL,
+      b,
+      HASH_TABLE_BACKEND_OPEN_ADDRESSING);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_guti_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.guti_ue_context_htbl =
-    obj_hashtable_uint64_ts_create(mme_config.max_ues, NULL, NULL, b);
+  mme_app_desc.mme_ue_contexts.coll_key_htbl[MME_UE_COLL_KEY_GUTI] =
+    hashtable_uint64_ts_create(mme_config.max_ues, NULL, b);
   bdestroy_wrapper(&b);
 
   if (mme_app_edns_init(mme_config_p)) {
     OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
   }
   /*
-   * Create the thread associated with MME applicative layer
+   * Create the threads associated with MME applicative layer, the messages
+   * of a UE are always handled by the same worker
    */
-  if (itti_create_task(TASK_MME_APP, &mme_app_thread, NULL) < 0) {
+  if (
+    itti_create_task_workers(
+      TASK_MME_APP,
+      &mme_app_thread,
+      NULL,
+      mme_config_p->itti_config.mme_app_workers,
+      _mme_app_get_message_shard) < 0) {
     OAILOG_ERROR(LOG_MME_APP, "MME APP create task failed\n");
     OAILOG_FUNC_RETURN(LOG_MME_APP, RETURNerror);
   }
@@ -657,15 +895,11 @@ void mme_app_exit(void)
 {
   timer_remove(mme_app_desc.statistic_timer_id, NULL);
   mme_app_edns_exit();
-  hashtable_uint64_ts_destroy(
-    mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
-  hashtable_uint64_ts_destroy(
-    mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl);
+  for (int coll_key = 0; coll_key < MME_UE_COLL_KEY_MAX; coll_key++) {
+    hashtable_uint64_ts_destroy(
+      mme_app_desc.mme_ue_contexts.coll_key_htbl[coll_key]);
+  }
   hashtable_ts_destroy(
     mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
-  hashtable_uint64_ts_destroy(
-    mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
-  obj_hashtable_uint64_ts_destroy(
-    mme_app_desc.mme_ue_contexts.guti_ue_context_htbl);
   mme_config_exit();
 }
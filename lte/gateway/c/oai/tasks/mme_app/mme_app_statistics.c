@@ -19,13 +19,89 @@
  *      contact@openairinterface.org
  */
 
+#include <inttypes.h>
+#include <string.h>
+
 #include "log.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
 #include "mme_app_desc.h"
+#include "mme_app_ue_lock.h"
+
+// Shards are handed out to the threads in the order of their first update
+static uint32_t mme_app_stats_next_shard = 0;
+static __thread mme_app_stats_shard_t *mme_app_stats_shard = NULL;
+
+// Statistics at the last display, only used by the statistics timer
+static mme_app_stats_snapshot_t mme_app_stats_last_display = {{0}};
+
+static inline mme_app_stats_shard_t *mme_app_stats_self(void)
+{
+  if (!mme_app_stats_shard) {
+    uint32_t shard =
+      __atomic_fetch_add(&mme_app_stats_next_shard, 1, __ATOMIC_RELAXED);
+    mme_app_stats_shard = &mme_app_desc.stats[shard % MME_APP_STATS_SHARDS];
+  }
+  return mme_app_stats_shard;
+}
+
+static inline void mme_app_stats_add(const mme_app_stat_t stat)
+{
+  __atomic_fetch_add(&mme_app_stats_self()->added[stat], 1, __ATOMIC_RELAXED);
+}
+
+static inline void mme_app_stats_sub(const mme_app_stat_t stat)
+{
+  __atomic_fetch_add(
+    &mme_app_stats_self()->removed[stat], 1, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_statistics_snapshot(mme_app_stats_snapshot_t *const snapshot)
+{
+  memset(snapshot, 0, sizeof(*snapshot));
+  for (int i = 0; i < MME_APP_STATS_SHARDS; i++) {
+    const mme_app_stats_shard_t *const shard = &mme_app_desc.stats[i];
+
+    // Removals are read first, not to count one without its addition
+    for (int stat = 0; stat < MME_APP_STAT_MAX; stat++) {
+      snapshot->removed[stat] +=
+        __atomic_load_n(&shard->removed[stat], __ATOMIC_RELAXED);
+      snapshot->added[stat] +=
+        __atomic_load_n(&shard->added[stat], __ATOMIC_RELAXED);
+    }
+  }
+  for (int stat = 0; stat < MME_APP_STAT_MAX; stat++) {
+    if (snapshot->added[stat] > snapshot->removed[stat]) {
+      snapshot->current[stat] =
+        (uint32_t)(snapshot->added[stat] - snapshot->removed[stat]);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_statistics_display_line(
+  const char *const name,
+  const mme_app_stats_snapshot_t *const stats,
+  const mme_app_stat_t stat)
+{
+  OAILOG_DEBUG(
+    LOG_MME_APP,
+    "%-15s| %10u      |     %10" PRIu64 "              |    %10" PRIu64
+    "               |\n",
+    name,
+    stats->current[stat],
+    stats->added[stat] - mme_app_stats_last_display.added[stat],
+    stats->removed[stat] - mme_app_stats_last_display.removed[stat]);
+}
 
 int mme_app_statistics_display(void)
 {
+  mme_app_stats_snapshot_t stats;
+  mme_app_ue_lock_stats_t lock_stats;
+
+  mme_app_statistics_snapshot(&stats);
+  mme_app_ue_lock_get_stats(&lock_stats);
   OAILOG_DEBUG(
     LOG_MME_APP,
     "======================================= STATISTICS "
@@ -34,61 +110,28 @@ int mme_app_statistics_display(void)
     LOG_MME_APP,
     "               |   Current Status| Added since last display|  Removed "
     "since last display |\n");
+  mme_app_statistics_display_line(
+    "Connected eNBs", &stats, MME_APP_STAT_ENB_CONNECTED);
+  mme_app_statistics_display_line(
+    "Attached UEs", &stats, MME_APP_STAT_UE_ATTACHED);
+  mme_app_statistics_display_line(
+    "Connected UEs", &stats, MME_APP_STAT_UE_CONNECTED);
+  mme_app_statistics_display_line(
+    "Default Bearers", &stats, MME_APP_STAT_DEFAULT_EPS_BEARERS);
+  mme_app_statistics_display_line(
+    "S1-U Bearers", &stats, MME_APP_STAT_S1U_BEARERS);
   OAILOG_DEBUG(
     LOG_MME_APP,
-    "Connected eNBs | %10u      |     %10u              |    %10u              "
-    " |\n",
-    mme_app_desc.nb_enb_connected,
-    mme_app_desc.nb_enb_connected_since_last_stat,
-    mme_app_desc.nb_enb_released_since_last_stat);
-  OAILOG_DEBUG(
-    LOG_MME_APP,
-    "Attached UEs   | %10u      |     %10u              |    %10u              "
-    " |\n",
-    mme_app_desc.nb_ue_attached,
-    mme_app_desc.nb_ue_attached_since_last_stat,
-    mme_app_desc.nb_ue_detached_since_last_stat);
-  OAILOG_DEBUG(
-    LOG_MME_APP,
-    "Connected UEs  | %10u      |     %10u              |    %10u              "
-    " |\n",
-    mme_app_desc.nb_ue_connected,
-    mme_app_desc.nb_ue_connected_since_last_stat,
-    mme_app_desc.nb_ue_disconnected_since_last_stat);
-  OAILOG_DEBUG(
-    LOG_MME_APP,
-    "Default Bearers| %10u      |     %10u              |    %10u              "
-    " |\n",
-    mme_app_desc.nb_default_eps_bearers,
-    mme_app_desc.nb_eps_bearers_established_since_last_stat,
-    mme_app_desc.nb_eps_bearers_released_since_last_stat);
-  OAILOG_DEBUG(
-    LOG_MME_APP,
-    "S1-U Bearers   | %10u      |     %10u              |    %10u              "
-    " |\n\n",
-    mme_app_desc.nb_s1u_bearers,
-    mme_app_desc.nb_s1u_bearers_established_since_last_stat,
-    mme_app_desc.nb_s1u_bearers_released_since_last_stat);
+    "UE locks       | %10" PRIu64 " contended, %10" PRIu64 " waited for\n\n",
+    lock_stats.nb_contended,
+    lock_stats.nb_waits);
   OAILOG_DEBUG(
     LOG_MME_APP,
     "======================================= STATISTICS "
     "============================================\n\n");
 
-  mme_stats_write_lock(&mme_app_desc);
-
-  // resetting stats for next display
-  mme_app_desc.nb_enb_connected_since_last_stat = 0;
-  mme_app_desc.nb_enb_released_since_last_stat = 0;
-  mme_app_desc.nb_ue_connected_since_last_stat = 0;
-  mme_app_desc.nb_ue_disconnected_since_last_stat = 0;
-  mme_app_desc.nb_s1u_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_s1u_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_ue_attached_since_last_stat = 0;
-  mme_app_desc.nb_ue_detached_since_last_stat = 0;
-
-  mme_stats_unlock(&mme_app_desc);
+  // the next display reports the changes from this one
+  mme_app_stats_last_display = stats;
 
   return 0;
 }
@@ -98,95 +141,54 @@ int mme_app_statistics_display(void)
 // Number of Connected eNBs
 void update_mme_app_stats_connected_enb_add(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  (mme_app_desc.nb_enb_connected)++;
-  (mme_app_desc.nb_enb_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_add(MME_APP_STAT_ENB_CONNECTED);
 }
 void update_mme_app_stats_connected_enb_sub(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  if (mme_app_desc.nb_enb_connected != 0) (mme_app_desc.nb_enb_connected)--;
-  (mme_app_desc.nb_enb_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_sub(MME_APP_STAT_ENB_CONNECTED);
 }
 
 /*****************************************************/
 // Number of Connected UEs
 void update_mme_app_stats_connected_ue_add(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  (mme_app_desc.nb_ue_connected)++;
-  (mme_app_desc.nb_ue_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_add(MME_APP_STAT_UE_CONNECTED);
 }
 void update_mme_app_stats_connected_ue_sub(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  if (mme_app_desc.nb_ue_connected != 0) (mme_app_desc.nb_ue_connected)--;
-  (mme_app_desc.nb_ue_disconnected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_sub(MME_APP_STAT_UE_CONNECTED);
 }
 
 /*****************************************************/
 // Number of S1U Bearers
 void update_mme_app_stats_s1u_bearer_add(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  (mme_app_desc.nb_s1u_bearers)++;
-  (mme_app_desc.nb_s1u_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_add(MME_APP_STAT_S1U_BEARERS);
 }
 void update_mme_app_stats_s1u_bearer_sub(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  if (mme_app_desc.nb_s1u_bearers != 0) (mme_app_desc.nb_s1u_bearers)--;
-  (mme_app_desc.nb_s1u_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_sub(MME_APP_STAT_S1U_BEARERS);
 }
 
 /*****************************************************/
 // Number of Default EPS Bearers
 void update_mme_app_stats_default_bearer_add(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  (mme_app_desc.nb_default_eps_bearers)++;
-  (mme_app_desc.nb_eps_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_add(MME_APP_STAT_DEFAULT_EPS_BEARERS);
 }
 void update_mme_app_stats_default_bearer_sub(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  if (mme_app_desc.nb_default_eps_bearers != 0)
-    (mme_app_desc.nb_default_eps_bearers)--;
-  (mme_app_desc.nb_eps_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_sub(MME_APP_STAT_DEFAULT_EPS_BEARERS);
 }
 
 /*****************************************************/
 // Number of Attached UEs
 void update_mme_app_stats_attached_ue_add(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  (mme_app_desc.nb_ue_attached)++;
-  (mme_app_desc.nb_ue_attached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_add(MME_APP_STAT_UE_ATTACHED);
 }
 void update_mme_app_stats_attached_ue_sub(void)
 {
-  mme_stats_write_lock(&mme_app_desc);
-  if (mme_app_desc.nb_ue_attached != 0) (mme_app_desc.nb_ue_attached)--;
-  (mme_app_desc.nb_ue_detached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_sub(MME_APP_STAT_UE_ATTACHED);
 }
 /*****************************************************/
@@ -33,6 +33,7 @@
 #include <inttypes.h>
 
 #include "conversions.h"
+#include "intertask_interface.h"
 #include "mme_app_ue_context.h"
 #include "3gpp_23.003.h"
 #include "3gpp_36.401.h"
@@ -141,6 +142,27 @@ uint64_t mme_app_imsi_to_u64(mme_app_imsi_t imsi_src)
 mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void)
 {
   mme_ue_s1ap_id_t tmp = 0;
-  tmp = __sync_fetch_and_add(&mme_app_ue_s1ap_id_generator, 1);
+  mme_ue_s1ap_id_t next = 0;
+  uint32_t nb_workers = itti_get_task_nb_workers(TASK_MME_APP);
+  uint32_t worker = itti_get_task_worker(TASK_MME_APP);
+
+  if (nb_workers == 1) {
+    tmp = __sync_fetch_and_add(&mme_app_ue_s1ap_id_generator, 1);
+    return tmp;
+  }
+  /*
+   * The messages of a UE are handled by the MME_APP worker
+   * mme_ue_s1ap_id % nb_workers, take the next id of the calling worker
+   */
+  next = __atomic_load_n(&mme_app_ue_s1ap_id_generator, __ATOMIC_RELAXED);
+  do {
+    tmp = next + (worker + nb_workers - next % nb_workers) % nb_workers;
+  } while (!__atomic_compare_exchange_n(
+    &mme_app_ue_s1ap_id_generator,
+    &next,
+    tmp + 1,
+    false,
+    __ATOMIC_RELAXED,
+    __ATOMIC_RELAXED));
   return tmp;
 }
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_ue_lock.c
+  \brief Recursive lock of the UE contexts
+*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "assertions.h"
+#include "common_defs.h"
+#include "mme_app_ue_lock.h"
+
+// Attempts to take a held lock before sleeping on it
+#define MME_APP_UE_LOCK_SPINS 100
+
+static mme_app_ue_lock_stats_t mme_app_ue_lock_stats = {0};
+
+// Ids of the threads taking UE locks, from 1
+static uint32_t mme_app_ue_lock_next_thread_id = 1;
+static __thread uint32_t mme_app_ue_lock_thread_id = 0;
+
+static inline uint32_t mme_app_ue_lock_self(void)
+{
+  if (!mme_app_ue_lock_thread_id) {
+    mme_app_ue_lock_thread_id =
+      __atomic_fetch_add(&mme_app_ue_lock_next_thread_id, 1, __ATOMIC_RELAXED);
+  }
+  return mme_app_ue_lock_thread_id;
+}
+
+static inline void mme_app_ue_lock_pause(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static long mme_app_ue_lock_futex(
+  uint32_t *const word,
+  const int op,
+  const uint32_t value,
+  const struct timespec *const timeout)
+{
+  return syscall(SYS_futex, word, op, value, timeout, NULL, 0);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_ue_lock_init(mme_app_ue_lock_t *const lock)
+{
+  __atomic_store_n(&lock->state, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&lock->owner, 0, __ATOMIC_RELAXED);
+  lock->depth = 0;
+}
+
+//------------------------------------------------------------------------------
+// Waits for a lock held by another thread, as mutex2 in Drepper's "Futexes
+// are tricky": state 2 tells the holder it has to wake a waiter up
+static void mme_app_ue_lock_wait(mme_app_ue_lock_t *const lock)
+{
+  uint32_t state = 0;
+#if ASSERT_MUTEX
+  struct timespec timeout = {.tv_sec = 1, .tv_nsec = 0};
+  int waited_sec = 0;
+#endif
+
+  __atomic_fetch_add(&mme_app_ue_lock_stats.nb_contended, 1, __ATOMIC_RELAXED);
+  for (int spin = 0; spin < MME_APP_UE_LOCK_SPINS; spin++) {
+    mme_app_ue_lock_pause();
+    state = 0;
+    if (
+      __atomic_load_n(&lock->state, __ATOMIC_RELAXED) == 0 &&
+      __atomic_compare_exchange_n(
+        &lock->state, &state, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      return;
+    }
+  }
+
+  __atomic_fetch_add(&mme_app_ue_lock_stats.nb_waits, 1, __ATOMIC_RELAXED);
+  while (__atomic_exchange_n(&lock->state, 2, __ATOMIC_ACQUIRE) != 0) {
+#if ASSERT_MUTEX
+    if (
+      mme_app_ue_lock_futex(&lock->state, FUTEX_WAIT_PRIVATE, 2, &timeout) &&
+      errno == ETIMEDOUT) {
+      AssertFatal(
+        ++waited_sec < MME_APP_UE_LOCK_TIMEOUT_SEC,
+        "Cannot lock UE context, held by thread %u for %d seconds\n",
+        __atomic_load_n(&lock->owner, __ATOMIC_RELAXED),
+        waited_sec);
+    }
+#else
+    mme_app_ue_lock_futex(&lock->state, FUTEX_WAIT_PRIVATE, 2, NULL);
+#endif
+  }
+}
+
+//------------------------------------------------------------------------------
+int mme_app_ue_lock(mme_app_ue_lock_t *const lock)
+{
+  const uint32_t self = mme_app_ue_lock_self();
+  uint32_t state = 0;
+
+  // Only this thread may have stored its own id
+  if (__atomic_load_n(&lock->owner, __ATOMIC_RELAXED) == self) {
+    lock->depth++;
+    return RETURNok;
+  }
+  if (!__atomic_compare_exchange_n(
+        &lock->state, &state, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    mme_app_ue_lock_wait(lock);
+  }
+  __atomic_store_n(&lock->owner, self, __ATOMIC_RELAXED);
+  lock->depth = 1;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_ue_unlock(mme_app_ue_lock_t *const lock)
+{
+  if (__atomic_load_n(&lock->owner, __ATOMIC_RELAXED) !=
+      mme_app_ue_lock_self()) {
+    return RETURNerror;
+  }
+  if (--lock->depth) {
+    return RETURNok;
+  }
+  __atomic_store_n(&lock->owner, 0, __ATOMIC_RELAXED);
+  if (__atomic_exchange_n(&lock->state, 0, __ATOMIC_RELEASE) == 2) {
+    mme_app_ue_lock_futex(&lock->state, FUTEX_WAKE_PRIVATE, 1, NULL);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+uint32_t mme_app_ue_unlock_all(mme_app_ue_lock_t *const lock)
+{
+  uint32_t depth = 0;
+
+  if (__atomic_load_n(&lock->owner, __ATOMIC_RELAXED) !=
+      mme_app_ue_lock_self()) {
+    return 0;
+  }
+  depth = lock->depth;
+  lock->depth = 1;
+  mme_app_ue_unlock(lock);
+  return depth;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_ue_lock_get_stats(mme_app_ue_lock_stats_t *const stats)
+{
+  stats->nb_contended =
+    __atomic_load_n(&mme_app_ue_lock_stats.nb_contended, __ATOMIC_RELAXED);
+  stats->nb_waits =
+    __atomic_load_n(&mme_app_ue_lock_stats.nb_waits, __ATOMIC_RELAXED);
+}
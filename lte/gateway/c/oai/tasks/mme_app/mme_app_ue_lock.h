@@ -0,0 +1,67 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#ifndef FILE_MME_APP_UE_LOCK_SEEN
+#define FILE_MME_APP_UE_LOCK_SEEN
+
+/*! \file mme_app_ue_lock.h
+  \brief Recursive lock of the UE contexts
+*/
+
+#include <stdint.h>
+
+/*
+ * The messages of a UE are all handled by its MME_APP worker, so its context
+ * lock is nearly never contended. The lock is taken with one compare and swap,
+ * and taken again by its owner without any atomic operation. A waiter spins
+ * shortly then sleeps on a futex.
+ *
+ * Built with ASSERT_MUTEX, a thread waiting more than
+ * MME_APP_UE_LOCK_TIMEOUT_SEC for a lock aborts, naming its owner.
+ */
+#define MME_APP_UE_LOCK_TIMEOUT_SEC 5
+
+typedef struct mme_app_ue_lock_s {
+  uint32_t state; // 0 free, 1 held, 2 held with waiters
+  uint32_t owner; // id of the owning thread, 0 if free
+  uint32_t depth; // number of times the owner took the lock
+} mme_app_ue_lock_t;
+
+// Contention counters of all the UE locks since the start
+typedef struct mme_app_ue_lock_stats_s {
+  uint64_t nb_contended; // the lock was held by another thread
+  uint64_t nb_waits;     // and the thread had to sleep for it
+} mme_app_ue_lock_stats_t;
+
+void mme_app_ue_lock_init(mme_app_ue_lock_t *const lock);
+
+// Returns RETURNok once the lock is held
+int mme_app_ue_lock(mme_app_ue_lock_t *const lock);
+
+// Returns RETURNerror if the calling thread does not hold the lock
+int mme_app_ue_unlock(mme_app_ue_lock_t *const lock);
+
+// Releases the lock however many times the calling thread took it, returns
+// that number, 0 if the thread does not hold the lock
+uint32_t mme_app_ue_unlock_all(mme_app_ue_lock_t *const lock);
+
+void mme_app_ue_lock_get_stats(mme_app_ue_lock_stats_t *const stats);
+
+#endif /* FILE_MME_APP_UE_LOCK_SEEN */
@@ -166,6 +166,7 @@ void s1ap_config_init(s1ap_config_t *s1ap_conf)
 {
   s1ap_conf->port_number = S1AP_PORT_NUMBER;
   s1ap_conf->outcome_drop_timer_sec = S1AP_OUTCOME_TIMER_DEFAULT;
+  s1ap_conf->state_commit_window_ms = 0;
 }
 
 void s6a_config_init(s6a_config_t *s6a_conf)
@@ -177,6 +178,11 @@ void s6a_config_init(s6a_config_t *s6a_conf)
 void itti_config_init(itti_config_t *itti_conf)
 {
   itti_conf->queue_size = ITTI_QUEUE_MAX_ELEMENTS;
+  itti_conf->mme_app_workers = 1;
+  itti_conf->mme_app_watermarks.high = ITTI_QUEUE_HIGH_WATERMARK;
+  itti_conf->mme_app_watermarks.low = ITTI_QUEUE_LOW_WATERMARK;
+  itti_conf->s1ap_watermarks.high = ITTI_QUEUE_HIGH_WATERMARK;
+  itti_conf->s1ap_watermarks.low = ITTI_QUEUE_LOW_WATERMARK;
   itti_conf->log_file = NULL;
 }
 
@@ -188,6 +194,7 @@ void sctp_config_init(sctp_config_t *sctp_conf)
 
 void nas_config_init(nas_config_t *nas_conf)
 {
+  nas_conf->t3346_min = T3346_DEFAULT_VALUE;
   nas_conf->t3402_min = T3402_DEFAULT_VALUE;
   nas_conf->t3412_min = T3412_DEFAULT_VALUE;
   nas_conf->t3422_sec = T3422_DEFAULT_VALUE;
@@ -535,6 +542,13 @@ int mme_config_parse_file(mme_config_t *config_pP)
       config_pP->use_stateless = parse_bool(astring);
     }
 
+    if ((config_setting_lookup_string(
+          setting_mme,
+          MME_CONFIG_STRING_HASHTABLE_METRICS,
+          (const char **) &astring))) {
+      config_pP->hashtable_metrics = parse_bool(astring);
+    }
+
     if ((config_setting_lookup_string(
           setting_mme,
           EPS_NETWORK_FEATURE_SUPPORT_EMERGENCY_BEARER_SERVICES_IN_S1_MODE,
@@ -582,6 +596,61 @@ int mme_config_parse_file(mme_config_t *config_pP)
             &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+      if ((config_setting_lookup_string(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_METRICS,
+            (const char **) &astring))) {
+        config_pP->itti_config.metrics = parse_bool(astring);
+      }
+      if ((config_setting_lookup_int(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_MME_APP_WORKERS,
+            &aint))) {
+        AssertFatal(
+          aint > 0 && aint <= ITTI_TASK_WORKERS_MAX,
+          "Bad MME_APP_WORKERS %d, must be in [1, %d]\n",
+          aint,
+          ITTI_TASK_WORKERS_MAX);
+        config_pP->itti_config.mme_app_workers = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_MME_APP_HIGH_WATERMARK,
+            &aint))) {
+        config_pP->itti_config.mme_app_watermarks.high = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_MME_APP_LOW_WATERMARK,
+            &aint))) {
+        config_pP->itti_config.mme_app_watermarks.low = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_S1AP_HIGH_WATERMARK,
+            &aint))) {
+        config_pP->itti_config.s1ap_watermarks.high = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int(
+            setting,
+            MME_CONFIG_STRING_INTERTASK_INTERFACE_S1AP_LOW_WATERMARK,
+            &aint))) {
+        config_pP->itti_config.s1ap_watermarks.low = (uint32_t) aint;
+      }
+      AssertFatal(
+        config_pP->itti_config.mme_app_watermarks.high == 0 ||
+          config_pP->itti_config.mme_app_watermarks.low <
+            config_pP->itti_config.mme_app_watermarks.high,
+        "Bad MME_APP watermarks, low %u must be lower than high %u\n",
+        config_pP->itti_config.mme_app_watermarks.low,
+        config_pP->itti_config.mme_app_watermarks.high);
+      AssertFatal(
+        config_pP->itti_config.s1ap_watermarks.high == 0 ||
+          config_pP->itti_config.s1ap_watermarks.low <
+            config_pP->itti_config.s1ap_watermarks.high,
+        "Bad S1AP watermarks, low %u must be lower than high %u\n",
+        config_pP->itti_config.s1ap_watermarks.low,
+        config_pP->itti_config.s1ap_watermarks.high);
     }
     // S6A SETTING
     setting =
@@ -648,6 +717,11 @@ int mme_config_parse_file(mme_config_t *config_pP)
             setting, MME_CONFIG_STRING_S1AP_PORT, &aint))) {
         config_pP->s1ap_config.port_number = (uint16_t) aint;
       }
+
+      if ((config_setting_lookup_int(
+            setting, MME_CONFIG_STRING_S1AP_STATE_COMMIT_WINDOW, &aint))) {
+        config_pP->s1ap_config.state_commit_window_ms = (uint32_t) aint;
+      }
     }
     // TAI list setting
     setting =
@@ -1030,6 +1104,10 @@ int mme_config_parse_file(mme_config_t *config_pP)
           }
         }
       }
+      if ((config_setting_lookup_int(
+            setting, MME_CONFIG_STRING_NAS_T3346_TIMER, &aint))) {
+        config_pP->nas_config.t3346_min = (uint32_t) aint;
+      }
       if ((config_setting_lookup_int(
             setting, MME_CONFIG_STRING_NAS_T3402_TIMER, &aint))) {
         config_pP->nas_config.t3402_min = (uint32_t) aint;
@@ -1285,6 +1363,10 @@ void mme_config_display(mme_config_t *config_pP)
     LOG_CONFIG,
     "- Use Stateless ........................: %s\n\n",
     config_pP->use_stateless ? "true" : "false");
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "- Hashtable metrics ....................: %s\n\n",
+    config_pP->hashtable_metrics ? "true" : "false");
   OAILOG_INFO(LOG_CONFIG, "- CSFB:\n");
   OAILOG_INFO(
     LOG_CONFIG,
@@ -1295,6 +1377,10 @@ void mme_config_display(mme_config_t *config_pP)
     LOG_CONFIG,
     "    port number ......: %d\n",
     config_pP->s1ap_config.port_number);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    commit window ....: %u (ms)\n",
+    config_pP->s1ap_config.state_commit_window_ms);
   OAILOG_INFO(LOG_CONFIG, "- IP:\n");
   OAILOG_INFO(
     LOG_CONFIG,
@@ -1319,6 +1405,24 @@ void mme_config_display(mme_config_t *config_pP)
     LOG_CONFIG,
     "    queue size .......: %u (bytes)\n",
     config_pP->itti_config.queue_size);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    metrics ..........: %s\n",
+    config_pP->itti_config.metrics ? "true" : "false");
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    MME_APP workers ..: %u\n",
+    config_pP->itti_config.mme_app_workers);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    MME_APP watermarks: %u high, %u low (messages)\n",
+    config_pP->itti_config.mme_app_watermarks.high,
+    config_pP->itti_config.mme_app_watermarks.low);
+  OAILOG_INFO(
+    LOG_CONFIG,
+    "    S1AP watermarks ..: %u high, %u low (messages)\n",
+    config_pP->itti_config.s1ap_watermarks.high,
+    config_pP->itti_config.s1ap_watermarks.low);
   OAILOG_INFO(
     LOG_CONFIG,
     "    log file .........: %s\n",
@@ -1389,6 +1493,8 @@ void mme_config_display(mme_config_t *config_pP)
     config_pP->nas_config.prefered_ciphering_algorithm[1],
     config_pP->nas_config.prefered_ciphering_algorithm[2],
     config_pP->nas_config.prefered_ciphering_algorithm[3]);
+  OAILOG_INFO(
+    LOG_CONFIG, "    T3346 ....: %d min\n", config_pP->nas_config.t3346_min);
   OAILOG_INFO(
     LOG_CONFIG, "    T3402 ....: %d min\n", config_pP->nas_config.t3402_min);
   OAILOG_INFO(
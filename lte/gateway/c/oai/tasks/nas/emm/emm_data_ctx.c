@@ -756,29 +756,21 @@ void emm_data_context_remove_mobile_ids(
 
 int emm_context_upsert_imsi(emm_data_t *emm_data, struct emm_context_s *elm)
 {
-  hashtable_rc_t h_rc = HASH_TABLE_OK;
-  mme_ue_s1ap_id_t ue_id =
-    (PARENT_STRUCT(elm, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id;
-
-  h_rc = hashtable_uint64_ts_remove(
-    mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl,
-    (const hash_key_t) elm->_imsi64);
-  if (INVALID_MME_UE_S1AP_ID != ue_id) {
-    h_rc = hashtable_uint64_ts_insert(
-      mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl,
-      (const hash_key_t) elm->_imsi64,
-      ue_id);
-  } else {
-    h_rc = HASH_TABLE_KEY_NOT_EXISTS;
-  }
-  if (HASH_TABLE_OK != h_rc) {
+  ue_mm_context_t *ue_mm_context =
+    PARENT_STRUCT(elm, struct ue_mm_context_s, emm_context);
+
+  if (
+    RETURNok != mme_ue_context_update_coll_key(
+                  &mme_app_desc.mme_ue_contexts,
+                  ue_mm_context,
+                  MME_UE_COLL_KEY_IMSI,
+                  (const hash_key_t) elm->_imsi64)) {
     OAILOG_TRACE(
       LOG_MME_APP,
       "Error could not update this ue context "
-      "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT ": %s\n",
-      ue_id,
-      elm->_imsi64,
-      hashtable_rc_code2string(h_rc));
+      "mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT "\n",
+      ue_mm_context->mme_ue_s1ap_id,
+      elm->_imsi64);
     return RETURNerror;
   }
   return RETURNok;
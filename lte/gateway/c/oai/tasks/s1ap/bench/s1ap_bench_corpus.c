@@ -0,0 +1,294 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_bench_corpus.c
+  \brief S1AP PDUs sent by an eNB, for the benchmarks of the S1AP codec
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "conversions.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_bench_corpus.h"
+
+#define S1AP_BENCH_ENB_NAME "bench-enb"
+#define S1AP_BENCH_E_RAB_ID 5
+#define S1AP_BENCH_ENB_TEID 0x10000001
+// 192.168.60.142
+#define S1AP_BENCH_ENB_ADDRESS 0xc0a83c8e
+
+typedef ssize_t (*s1ap_bench_generate_t)(
+  uint8_t **buffer,
+  uint32_t *length,
+  e_S1ap_ProcedureCode procedureCode,
+  S1ap_Criticality_t criticality,
+  asn_TYPE_descriptor_t *td,
+  void *sptr);
+
+// Attach Request of IMSI 001010000000001 with a PDN Connectivity Request
+static const uint8_t s1ap_bench_attach_request[] = {
+  0x07, 0x41, 0x71, 0x08, 0x09, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x10,
+  0x05, 0xf0, 0x70, 0xc0, 0x40, 0x11, 0x00, 0x05, 0x02, 0x01, 0xd0, 0x11,
+  0xd1, 0x52, 0x00, 0xf1, 0x10, 0x00, 0x01, 0x5c, 0x0a, 0x00, 0x31, 0x03,
+  0xe5, 0xe0, 0x34, 0x90, 0x11, 0x03, 0x57, 0x58, 0xa6, 0x5d, 0x01, 0x00,
+  0xe0, 0xc1};
+
+// Authentication Response
+static const uint8_t s1ap_bench_authentication_response[] = {
+  0x07, 0x53, 0x08, 0x2e, 0x9b, 0x4a, 0x10, 0x73, 0x41, 0xd5, 0x27};
+
+const char *const s1ap_bench_enb_pdu_names[S1AP_BENCH_ENB_PDUS] = {
+  "S1SetupRequest",
+  "InitialUEMessage",
+  "UplinkNASTransport",
+  "InitialContextSetupResponse",
+  "UEContextReleaseRequest",
+  "UEContextReleaseComplete",
+};
+
+static void _corpus_tai(const s1ap_bench_ids_t *ids, S1ap_TAI_t *tai)
+{
+  MCC_MNC_TO_PLMNID(
+    S1AP_BENCH_MCC, S1AP_BENCH_MNC, S1AP_BENCH_MNC_LEN, &tai->pLMNidentity);
+  TAC_TO_ASN1(ids->tac, &tai->tAC);
+}
+
+static void _corpus_cgi(const s1ap_bench_ids_t *ids, S1ap_EUTRAN_CGI_t *cgi)
+{
+  MCC_MNC_TO_PLMNID(
+    S1AP_BENCH_MCC, S1AP_BENCH_MNC, S1AP_BENCH_MNC_LEN, &cgi->pLMNidentity);
+  MACRO_ENB_ID_TO_CELL_IDENTITY(ids->enb_id, 1, &cgi->cell_ID);
+}
+
+// Encodes the message of pdu, the generate functions free its IEs
+static bstring _corpus_encode(
+  s1ap_bench_generate_t generate,
+  e_S1ap_ProcedureCode procedure_code,
+  S1ap_Criticality_t criticality,
+  asn_TYPE_descriptor_t *td,
+  void *pdu)
+{
+  uint8_t *buffer = NULL;
+  uint32_t length = 0;
+  bstring b = NULL;
+
+  if (generate(&buffer, &length, procedure_code, criticality, td, pdu) >= 0) {
+    b = blk2bstr(buffer, length);
+    free(buffer);
+  }
+  return b;
+}
+
+static bstring _corpus_s1_setup_request(const s1ap_bench_ids_t *ids)
+{
+  S1ap_S1SetupRequestIEs_t ies = {0};
+  S1ap_S1SetupRequest_t pdu;
+  S1ap_SupportedTAs_Item_t *ta = calloc(1, sizeof(*ta));
+  S1ap_PLMNidentity_t *plmn = calloc(1, sizeof(*plmn));
+  bstring b = NULL;
+
+  memset(&pdu, 0, sizeof(pdu));
+
+  MCC_MNC_TO_PLMNID(
+    S1AP_BENCH_MCC,
+    S1AP_BENCH_MNC,
+    S1AP_BENCH_MNC_LEN,
+    &ies.global_ENB_ID.pLMNidentity);
+  ies.global_ENB_ID.eNB_ID.present = S1ap_ENB_ID_PR_macroENB_ID;
+  MACRO_ENB_ID_TO_BIT_STRING(
+    ids->enb_id, &ies.global_ENB_ID.eNB_ID.choice.macroENB_ID);
+  ies.presenceMask |= S1AP_S1SETUPREQUESTIES_ENBNAME_PRESENT;
+  OCTET_STRING_fromBuf(
+    &ies.eNBname, S1AP_BENCH_ENB_NAME, strlen(S1AP_BENCH_ENB_NAME));
+  TAC_TO_ASN1(ids->tac, &ta->tAC);
+  MCC_MNC_TO_PLMNID(S1AP_BENCH_MCC, S1AP_BENCH_MNC, S1AP_BENCH_MNC_LEN, plmn);
+  ASN_SEQUENCE_ADD(&ta->broadcastPLMNs.list, plmn);
+  ASN_SEQUENCE_ADD(&ies.supportedTAs.list, ta);
+  ies.defaultPagingDRX = S1ap_PagingDRX_v64;
+
+  if (s1ap_encode_s1ap_s1setuprequesties(&pdu, &ies) == 0) {
+    b = _corpus_encode(
+      s1ap_generate_initiating_message,
+      S1ap_ProcedureCode_id_S1Setup,
+      S1ap_Criticality_reject,
+      &asn_DEF_S1ap_S1SetupRequest,
+      &pdu);
+  }
+  free_s1ap_s1setuprequest(&ies);
+  return b;
+}
+
+static bstring _corpus_initial_ue_message(const s1ap_bench_ids_t *ids)
+{
+  S1ap_InitialUEMessageIEs_t ies = {0};
+  S1ap_InitialUEMessage_t pdu;
+  bstring b = NULL;
+
+  memset(&pdu, 0, sizeof(pdu));
+
+  ies.eNB_UE_S1AP_ID = ids->enb_ue_s1ap_id;
+  OCTET_STRING_fromBuf(
+    &ies.nas_pdu,
+    (const char *) s1ap_bench_attach_request,
+    sizeof(s1ap_bench_attach_request));
+  _corpus_tai(ids, &ies.tai);
+  _corpus_cgi(ids, &ies.eutran_cgi);
+  ies.rrC_Establishment_Cause = S1ap_RRC_Establishment_Cause_mo_Signalling;
+
+  if (s1ap_encode_s1ap_initialuemessageies(&pdu, &ies) == 0) {
+    b = _corpus_encode(
+      s1ap_generate_initiating_message,
+      S1ap_ProcedureCode_id_initialUEMessage,
+      S1ap_Criticality_ignore,
+      &asn_DEF_S1ap_InitialUEMessage,
+      &pdu);
+  }
+  free_s1ap_initialuemessage(&ies);
+  return b;
+}
+
+static bstring _corpus_uplink_nas_transport(const s1ap_bench_ids_t *ids)
+{
+  S1ap_UplinkNASTransportIEs_t ies = {0};
+  S1ap_UplinkNASTransport_t pdu;
+  bstring b = NULL;
+
+  memset(&pdu, 0, sizeof(pdu));
+
+  ies.mme_ue_s1ap_id = ids->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ids->enb_ue_s1ap_id;
+  OCTET_STRING_fromBuf(
+    &ies.nas_pdu,
+    (const char *) s1ap_bench_authentication_response,
+    sizeof(s1ap_bench_authentication_response));
+  _corpus_cgi(ids, &ies.eutran_cgi);
+  _corpus_tai(ids, &ies.tai);
+
+  if (s1ap_encode_s1ap_uplinknastransporties(&pdu, &ies) == 0) {
+    b = _corpus_encode(
+      s1ap_generate_initiating_message,
+      S1ap_ProcedureCode_id_uplinkNASTransport,
+      S1ap_Criticality_ignore,
+      &asn_DEF_S1ap_UplinkNASTransport,
+      &pdu);
+  }
+  free_s1ap_uplinknastransport(&ies);
+  return b;
+}
+
+static bstring _corpus_ics_response(const s1ap_bench_ids_t *ids)
+{
+  S1ap_InitialContextSetupResponseIEs_t ies = {0};
+  S1ap_InitialContextSetupResponse_t pdu;
+  S1ap_E_RABSetupItemCtxtSURes_t *e_rab = calloc(1, sizeof(*e_rab));
+  bstring b = NULL;
+
+  memset(&pdu, 0, sizeof(pdu));
+
+  ies.mme_ue_s1ap_id = ids->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ids->enb_ue_s1ap_id;
+  e_rab->e_RAB_ID = S1AP_BENCH_E_RAB_ID;
+  INT32_TO_BIT_STRING(S1AP_BENCH_ENB_ADDRESS, &e_rab->transportLayerAddress);
+  GTP_TEID_TO_ASN1(S1AP_BENCH_ENB_TEID, &e_rab->gTP_TEID);
+  ASN_SEQUENCE_ADD(&ies.e_RABSetupListCtxtSURes, e_rab);
+
+  if (s1ap_encode_s1ap_initialcontextsetupresponseies(&pdu, &ies) == 0) {
+    b = _corpus_encode(
+      s1ap_generate_successfull_outcome,
+      S1ap_ProcedureCode_id_InitialContextSetup,
+      S1ap_Criticality_reject,
+      &asn_DEF_S1ap_InitialContextSetupResponse,
+      &pdu);
+  }
+  free_s1ap_initialcontextsetupresponse(&ies);
+  return b;
+}
+
+static bstring _corpus_ue_context_release_request(const s1ap_bench_ids_t *ids)
+{
+  S1ap_UEContextReleaseRequestIEs_t ies = {0};
+  S1ap_UEContextReleaseRequest_t pdu;
+  bstring b = NULL;
+
+  memset(&pdu, 0, sizeof(pdu));
+
+  ies.mme_ue_s1ap_id = ids->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ids->enb_ue_s1ap_id;
+  ies.cause.present = S1ap_Cause_PR_radioNetwork;
+  ies.cause.choice.radioNetwork = S1ap_CauseRadioNetwork_user_inactivity;
+
+  if (s1ap_encode_s1ap_uecontextreleaserequesties(&pdu, &ies) == 0) {
+    b = _corpus_encode(
+      s1ap_generate_initiating_message,
+      S1ap_ProcedureCode_id_UEContextReleaseRequest,
+      S1ap_Criticality_ignore,
+      &asn_DEF_S1ap_UEContextReleaseRequest,
+      &pdu);
+  }
+  free_s1ap_uecontextreleaserequest(&ies);
+  return b;
+}
+
+static bstring _corpus_ue_context_release_complete(
+  const s1ap_bench_ids_t *ids)
+{
+  S1ap_UEContextReleaseCompleteIEs_t ies = {0};
+  S1ap_UEContextReleaseComplete_t pdu;
+  bstring b = NULL;
+
+  memset(&pdu, 0, sizeof(pdu));
+
+  ies.mme_ue_s1ap_id = ids->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ids->enb_ue_s1ap_id;
+
+  if (s1ap_encode_s1ap_uecontextreleasecompleteies(&pdu, &ies) == 0) {
+    b = _corpus_encode(
+      s1ap_generate_successfull_outcome,
+      S1ap_ProcedureCode_id_UEContextRelease,
+      S1ap_Criticality_reject,
+      &asn_DEF_S1ap_UEContextReleaseComplete,
+      &pdu);
+  }
+  free_s1ap_uecontextreleasecomplete(&ies);
+  return b;
+}
+
+bstring s1ap_bench_enb_pdu(
+  s1ap_bench_enb_pdu_t pdu,
+  const s1ap_bench_ids_t *ids)
+{
+  switch (pdu) {
+    case S1AP_BENCH_S1_SETUP_REQUEST: return _corpus_s1_setup_request(ids);
+    case S1AP_BENCH_INITIAL_UE_MESSAGE: return _corpus_initial_ue_message(ids);
+    case S1AP_BENCH_UPLINK_NAS_TRANSPORT:
+      return _corpus_uplink_nas_transport(ids);
+    case S1AP_BENCH_ICS_RESPONSE: return _corpus_ics_response(ids);
+    case S1AP_BENCH_UE_CONTEXT_RELEASE_REQUEST:
+      return _corpus_ue_context_release_request(ids);
+    case S1AP_BENCH_UE_CONTEXT_RELEASE_COMPLETE:
+      return _corpus_ue_context_release_complete(ids);
+    default: return NULL;
+  }
+}
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_bench_corpus.h
+  \brief S1AP PDUs sent by an eNB, for the benchmarks of the S1AP codec
+*/
+
+#ifndef FILE_S1AP_BENCH_CORPUS_SEEN
+#define FILE_S1AP_BENCH_CORPUS_SEEN
+
+#include <stdint.h>
+
+#include "bstrlib.h"
+#include "3gpp_36.401.h"
+#include "TrackingAreaIdentity.h"
+
+// PLMN 001/01 of the eNBs and of the UEs
+#define S1AP_BENCH_MCC 1
+#define S1AP_BENCH_MNC 1
+#define S1AP_BENCH_MNC_LEN 2
+
+// The PDUs of an attach and of the release of the UE, in that order
+typedef enum {
+  S1AP_BENCH_S1_SETUP_REQUEST = 0,
+  S1AP_BENCH_INITIAL_UE_MESSAGE,
+  S1AP_BENCH_UPLINK_NAS_TRANSPORT,
+  S1AP_BENCH_ICS_RESPONSE,
+  S1AP_BENCH_UE_CONTEXT_RELEASE_REQUEST,
+  S1AP_BENCH_UE_CONTEXT_RELEASE_COMPLETE,
+  S1AP_BENCH_ENB_PDUS,
+} s1ap_bench_enb_pdu_t;
+
+typedef struct s1ap_bench_ids_s {
+  uint32_t enb_id; // Macro eNB ID, 20 bits
+  tac_t tac;
+  mme_ue_s1ap_id_t mme_ue_s1ap_id;
+  enb_ue_s1ap_id_t enb_ue_s1ap_id;
+} s1ap_bench_ids_t;
+
+extern const char *const s1ap_bench_enb_pdu_names[S1AP_BENCH_ENB_PDUS];
+
+/*
+ * Returns the encoded PDU of the eNB and UE of ids, or NULL if it could not
+ * be encoded
+ */
+bstring s1ap_bench_enb_pdu(
+  s1ap_bench_enb_pdu_t pdu,
+  const s1ap_bench_ids_t *ids);
+
+#endif /* FILE_S1AP_BENCH_CORPUS_SEEN */
@@ -0,0 +1,400 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Benchmark of the S1AP codec, with and without the arena of the S1AP task.
+ *
+ * The PDUs of an attach sent by an eNB are decoded by s1ap_mme_decode_pdu()
+ * and the messages of the MME are encoded by s1ap_mme_encode_pdu(), filled
+ * and freed as the S1AP handlers do:
+ * - malloc: the codec allocates from the heap
+ * - arena: the codec allocates from an arena, reset after each message as the
+ *   S1AP task does
+ * The heap allocations counted are those made through the asn1c allocation
+ * macros. With the arena only the REALLOCs of memory which does not come from
+ * it remain, besides the copy of the encoded PDU out of the arena. The PDUs
+ * encoded in both runs have to be of the same size.
+ *
+ * Usage: s1ap_codec_bench [--smoke]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "conversions.h"
+#include "intertask_interface_types.h"
+#include "s1ap_arena.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_decoder.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_bench_corpus.h"
+
+#define BENCH_SMOKE_DIVIDER 1000
+#define BENCH_OPS 200000
+
+#define BENCH_ENB_ID 0x0e00a
+#define BENCH_TAC 1
+#define BENCH_MME_UE_S1AP_ID 7
+#define BENCH_ENB_UE_S1AP_ID 3
+#define BENCH_MME_GID 4
+#define BENCH_MME_CODE 1
+#define BENCH_M_TMSI 0x2bd2f7f1
+#define BENCH_KENB_SIZE 32
+
+typedef enum {
+  BENCH_S1_SETUP_RESPONSE = 0,
+  BENCH_DOWNLINK_NAS_TRANSPORT,
+  BENCH_ICS_REQUEST,
+  BENCH_UE_CONTEXT_RELEASE_COMMAND,
+  BENCH_PAGING,
+  BENCH_MME_MESSAGES,
+} bench_mme_message_t;
+
+static const char *const bench_mme_message_names[BENCH_MME_MESSAGES] = {
+  "S1SetupResponse",
+  "DownlinkNASTransport",
+  "InitialContextSetupRequest",
+  "UEContextReleaseCommand",
+  "Paging",
+};
+
+// Authentication Request
+static const uint8_t bench_authentication_request[] = {
+  0x07, 0x52, 0x00, 0x1f, 0x42, 0x9b, 0x8d, 0x7c, 0x70, 0x53, 0x6a, 0x0d,
+  0x9e, 0x1e, 0xc2, 0x2c, 0x9c, 0x31, 0x65, 0x10, 0x1f, 0x84, 0x5e, 0x49,
+  0x1d, 0x2e, 0x80, 0x00, 0x9b, 0x1c, 0x0d, 0x1b, 0xb4, 0xcd, 0x27, 0x10};
+
+// Attach Accept with an Activate Default EPS Bearer Context Request
+static const uint8_t bench_attach_accept[] = {
+  0x27, 0x5d, 0x12, 0x68, 0x2b, 0x01, 0x07, 0x42, 0x01, 0x49, 0x06, 0x20,
+  0x00, 0xf1, 0x10, 0x00, 0x01, 0x00, 0x2e, 0x52, 0x01, 0xc1, 0x01, 0x09,
+  0x09, 0x08, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x65, 0x74, 0x05, 0x01,
+  0xc0, 0xa8, 0x80, 0x0c, 0x5e, 0x04, 0xfe, 0xfe, 0xde, 0x9e, 0x27, 0x08,
+  0x80, 0x00, 0x0d, 0x04, 0x08, 0x08, 0x08, 0x08, 0x50, 0x0b, 0xf6, 0x00,
+  0xf1, 0x10, 0x00, 0x01, 0x01, 0x2b, 0xd2, 0xf7, 0xf1};
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t _bench_heap_allocs(void)
+{
+  s1ap_arena_stats_t stats;
+
+  s1ap_arena_get_stats(&stats);
+  return stats.num_malloc_allocs;
+}
+
+static void _bench_s1_setup_response(S1ap_S1SetupResponseIEs_t *ies)
+{
+  S1ap_ServedGUMMEIsItem_t *served_gummei = CALLOC(1, sizeof(*served_gummei));
+  S1ap_PLMNidentity_t *plmn = CALLOC(1, sizeof(*plmn));
+  S1ap_MME_Group_ID_t *mme_gid = CALLOC(1, sizeof(*mme_gid));
+  S1ap_MME_Code_t *mmec = CALLOC(1, sizeof(*mmec));
+
+  ies->relativeMMECapacity = 10;
+  MCC_MNC_TO_PLMNID(S1AP_BENCH_MCC, S1AP_BENCH_MNC, S1AP_BENCH_MNC_LEN, plmn);
+  ASN_SEQUENCE_ADD(&served_gummei->servedPLMNs.list, plmn);
+  INT16_TO_OCTET_STRING(BENCH_MME_GID, mme_gid);
+  ASN_SEQUENCE_ADD(&served_gummei->servedGroupIDs.list, mme_gid);
+  INT8_TO_OCTET_STRING(BENCH_MME_CODE, mmec);
+  ASN_SEQUENCE_ADD(&served_gummei->servedMMECs.list, mmec);
+  ASN_SEQUENCE_ADD(&ies->servedGUMMEIs, served_gummei);
+}
+
+static void _bench_ics_request(S1ap_InitialContextSetupRequestIEs_t *ies)
+{
+  S1ap_E_RABToBeSetupItemCtxtSUReq_t *e_rab = CALLOC(1, sizeof(*e_rab));
+  S1ap_NAS_PDU_t *nas_pdu = CALLOC(1, sizeof(*nas_pdu));
+  S1ap_UESecurityCapabilities_t *capabilities = &ies->ueSecurityCapabilities;
+
+  ies->mme_ue_s1ap_id = BENCH_MME_UE_S1AP_ID;
+  ies->eNB_UE_S1AP_ID = BENCH_ENB_UE_S1AP_ID;
+  asn_uint642INTEGER(
+    &ies->uEaggregateMaximumBitrate.uEaggregateMaximumBitRateDL, 200000000);
+  asn_uint642INTEGER(
+    &ies->uEaggregateMaximumBitrate.uEaggregateMaximumBitRateUL, 100000000);
+
+  e_rab->e_RAB_ID = 5;
+  e_rab->e_RABlevelQoSParameters.qCI = 9;
+  e_rab->e_RABlevelQoSParameters.allocationRetentionPriority.priorityLevel =
+    15;
+  e_rab->e_RABlevelQoSParameters.allocationRetentionPriority
+    .pre_emptionCapability =
+    S1ap_Pre_emptionCapability_shall_not_trigger_pre_emption;
+  e_rab->e_RABlevelQoSParameters.allocationRetentionPriority
+    .pre_emptionVulnerability = S1ap_Pre_emptionVulnerability_pre_emptable;
+  nas_pdu->size = sizeof(bench_attach_accept);
+  nas_pdu->buf = MALLOC(sizeof(bench_attach_accept));
+  memcpy(nas_pdu->buf, bench_attach_accept, sizeof(bench_attach_accept));
+  e_rab->nAS_PDU = nas_pdu;
+  INT32_TO_OCTET_STRING(0x00000001, &e_rab->gTP_TEID);
+  e_rab->transportLayerAddress.buf = CALLOC(4, sizeof(uint8_t));
+  INT32_TO_BUFFER(0xc0a83c8e, e_rab->transportLayerAddress.buf);
+  e_rab->transportLayerAddress.size = 4;
+  ASN_SEQUENCE_ADD(&ies->e_RABToBeSetupListCtxtSUReq, e_rab);
+
+  capabilities->encryptionAlgorithms.buf = CALLOC(2, sizeof(uint8_t));
+  capabilities->encryptionAlgorithms.buf[0] = 0xe0;
+  capabilities->encryptionAlgorithms.size = 2;
+  capabilities->integrityProtectionAlgorithms.buf = CALLOC(2, sizeof(uint8_t));
+  capabilities->integrityProtectionAlgorithms.buf[0] = 0xe0;
+  capabilities->integrityProtectionAlgorithms.size = 2;
+  ies->securityKey.buf = CALLOC(BENCH_KENB_SIZE, sizeof(uint8_t));
+  memset(ies->securityKey.buf, 0x5a, BENCH_KENB_SIZE);
+  ies->securityKey.size = BENCH_KENB_SIZE;
+}
+
+static void _bench_paging(S1ap_PagingIEs_t *ies)
+{
+  S1ap_TAIItem_t *tai_item = CALLOC(1, sizeof(*tai_item));
+
+  UE_ID_INDEX_TO_BIT_STRING(1, &ies->ueIdentityIndexValue);
+  ies->cnDomain = S1ap_CNDomain_ps;
+  ies->uePagingID.present = S1ap_UEPagingID_PR_s_TMSI;
+  MME_CODE_TO_OCTET_STRING(
+    BENCH_MME_CODE, &ies->uePagingID.choice.s_TMSI.mMEC);
+  M_TMSI_TO_OCTET_STRING(BENCH_M_TMSI, &ies->uePagingID.choice.s_TMSI.m_TMSI);
+  MCC_MNC_TO_PLMNID(
+    S1AP_BENCH_MCC,
+    S1AP_BENCH_MNC,
+    S1AP_BENCH_MNC_LEN,
+    &tai_item->tAI.pLMNidentity);
+  TAC_TO_ASN1(BENCH_TAC, &tai_item->tAI.tAC);
+  ASN_SEQUENCE_ADD(&ies->taiList, tai_item);
+}
+
+// Fills and encodes the message, returns the size of the encoded PDU
+static uint32_t _bench_encode(bench_mme_message_t mme_message)
+{
+  s1ap_message message = {0};
+  uint8_t *buffer = NULL;
+  uint32_t length = 0;
+  int rc = 0;
+
+  switch (mme_message) {
+    case BENCH_S1_SETUP_RESPONSE:
+      message.procedureCode = S1ap_ProcedureCode_id_S1Setup;
+      message.direction = S1AP_PDU_PR_successfulOutcome;
+      _bench_s1_setup_response(&message.msg.s1ap_S1SetupResponseIEs);
+      break;
+    case BENCH_DOWNLINK_NAS_TRANSPORT:
+      message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+      message.direction = S1AP_PDU_PR_initiatingMessage;
+      message.msg.s1ap_DownlinkNASTransportIEs.mme_ue_s1ap_id =
+        BENCH_MME_UE_S1AP_ID;
+      message.msg.s1ap_DownlinkNASTransportIEs.eNB_UE_S1AP_ID =
+        BENCH_ENB_UE_S1AP_ID;
+      OCTET_STRING_fromBuf(
+        &message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu,
+        (const char *) bench_authentication_request,
+        sizeof(bench_authentication_request));
+      break;
+    case BENCH_ICS_REQUEST:
+      message.procedureCode = S1ap_ProcedureCode_id_InitialContextSetup;
+      message.direction = S1AP_PDU_PR_initiatingMessage;
+      _bench_ics_request(&message.msg.s1ap_InitialContextSetupRequestIEs);
+      break;
+    case BENCH_UE_CONTEXT_RELEASE_COMMAND:
+      message.procedureCode = S1ap_ProcedureCode_id_UEContextRelease;
+      message.direction = S1AP_PDU_PR_initiatingMessage;
+      message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.present =
+        S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair;
+      message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice
+        .uE_S1AP_ID_pair.mME_UE_S1AP_ID = BENCH_MME_UE_S1AP_ID;
+      message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice
+        .uE_S1AP_ID_pair.eNB_UE_S1AP_ID = BENCH_ENB_UE_S1AP_ID;
+      message.msg.s1ap_UEContextReleaseCommandIEs.cause.present =
+        S1ap_Cause_PR_nas;
+      message.msg.s1ap_UEContextReleaseCommandIEs.cause.choice.nas =
+        S1ap_CauseNas_detach;
+      break;
+    case BENCH_PAGING:
+      message.procedureCode = S1ap_ProcedureCode_id_Paging;
+      message.direction = S1AP_PDU_PR_initiatingMessage;
+      _bench_paging(&message.msg.s1ap_PagingIEs);
+      break;
+    default: break;
+  }
+
+  rc = s1ap_mme_encode_pdu(&message, &buffer, &length);
+
+  switch (mme_message) {
+    case BENCH_S1_SETUP_RESPONSE:
+      free_s1ap_s1setupresponse(&message.msg.s1ap_S1SetupResponseIEs);
+      break;
+    case BENCH_DOWNLINK_NAS_TRANSPORT:
+      free_s1ap_downlinknastransport(
+        &message.msg.s1ap_DownlinkNASTransportIEs);
+      break;
+    case BENCH_ICS_REQUEST:
+      free_s1ap_initialcontextsetuprequest(
+        &message.msg.s1ap_InitialContextSetupRequestIEs);
+      break;
+    case BENCH_UE_CONTEXT_RELEASE_COMMAND:
+      free_s1ap_uecontextreleasecommand(
+        &message.msg.s1ap_UEContextReleaseCommandIEs);
+      break;
+    case BENCH_PAGING: free_s1ap_paging(&message.msg.s1ap_PagingIEs); break;
+    default: break;
+  }
+  if (rc < 0) {
+    fprintf(
+      stderr, "Cannot encode %s\n", bench_mme_message_names[mme_message]);
+    exit(EXIT_FAILURE);
+  }
+  // The S1AP task copies the PDU into the payload of SCTP_DATA_REQ
+  free(buffer);
+  return length;
+}
+
+static void _bench_decode(s1ap_bench_enb_pdu_t pdu, const_bstring raw)
+{
+  s1ap_message message = {0};
+  MessagesIds message_id = MESSAGES_ID_MAX;
+
+  if (s1ap_mme_decode_pdu(&message, raw, &message_id) < 0) {
+    fprintf(stderr, "Cannot decode %s\n", s1ap_bench_enb_pdu_names[pdu]);
+    exit(EXIT_FAILURE);
+  }
+  s1ap_free_mme_decode_pdu(&message, message_id);
+}
+
+// Prints the ns and the heap allocations per message, without then with arena
+static void _bench_print(
+  const char *name,
+  const double ns[2],
+  const double allocs[2])
+{
+  printf(
+    "%-28s %10.1f %10.1f %12.2f %12.2f\n",
+    name,
+    ns[0],
+    ns[1],
+    allocs[0],
+    allocs[1]);
+}
+
+int main(int argc, char *argv[])
+{
+  bool smoke = argc > 1 && strcmp(argv[1], "--smoke") == 0;
+  size_t nb_ops = BENCH_OPS / (smoke ? BENCH_SMOKE_DIVIDER : 1);
+  s1ap_bench_ids_t ids = {
+    .enb_id = BENCH_ENB_ID,
+    .tac = BENCH_TAC,
+    .mme_ue_s1ap_id = BENCH_MME_UE_S1AP_ID,
+    .enb_ue_s1ap_id = BENCH_ENB_UE_S1AP_ID,
+  };
+  bstring pdus[S1AP_BENCH_ENB_PDUS] = {NULL};
+  s1ap_arena_t arena;
+  double ns[2], allocs[2];
+
+  for (int p = 0; p < S1AP_BENCH_ENB_PDUS; p++) {
+    pdus[p] = s1ap_bench_enb_pdu(p, &ids);
+    if (!pdus[p]) {
+      fprintf(stderr, "Cannot encode %s\n", s1ap_bench_enb_pdu_names[p]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!s1ap_arena_init(&arena, S1AP_ARENA_CHUNK_SIZE)) {
+    fprintf(stderr, "Cannot allocate the arena\n");
+    return EXIT_FAILURE;
+  }
+  if (!S1AP_ARENA) {
+    printf("The arena is disabled, both runs use the heap\n");
+  }
+
+  printf(
+    "%-28s %10s %10s %12s %12s\n",
+    "decode",
+    "malloc(ns)",
+    "arena(ns)",
+    "malloc(allocs)",
+    "arena(allocs)");
+  for (int p = 0; p < S1AP_BENCH_ENB_PDUS; p++) {
+    for (int a = 0; a < 2; a++) {
+      uint64_t t0 = 0, allocs0 = 0;
+
+      s1ap_arena_use(a ? &arena : NULL);
+      allocs0 = _bench_heap_allocs();
+      t0 = _bench_now_ns();
+      for (size_t i = 0; i < nb_ops; i++) {
+        _bench_decode(p, pdus[p]);
+        if (a) s1ap_arena_reset(&arena);
+      }
+      ns[a] = (double) (_bench_now_ns() - t0) / (double) nb_ops;
+      allocs[a] = (double) (_bench_heap_allocs() - allocs0) / (double) nb_ops;
+    }
+    _bench_print(s1ap_bench_enb_pdu_names[p], ns, allocs);
+  }
+
+  printf("%-28s\n", "encode");
+  for (int m = 0; m < BENCH_MME_MESSAGES; m++) {
+    uint32_t length[2] = {0};
+
+    for (int a = 0; a < 2; a++) {
+      uint64_t t0 = 0, allocs0 = 0;
+
+      s1ap_arena_use(a ? &arena : NULL);
+      allocs0 = _bench_heap_allocs();
+      t0 = _bench_now_ns();
+      for (size_t i = 0; i < nb_ops; i++) {
+        length[a] = _bench_encode(m);
+        if (a) s1ap_arena_reset(&arena);
+      }
+      ns[a] = (double) (_bench_now_ns() - t0) / (double) nb_ops;
+      allocs[a] = (double) (_bench_heap_allocs() - allocs0) / (double) nb_ops;
+    }
+    if (length[0] != length[1]) {
+      fprintf(
+        stderr,
+        "%s: %" PRIu32 " bytes with the arena, %" PRIu32 " without\n",
+        bench_mme_message_names[m],
+        length[1],
+        length[0]);
+      return EXIT_FAILURE;
+    }
+    _bench_print(bench_mme_message_names[m], ns, allocs);
+  }
+  s1ap_arena_use(NULL);
+  printf(
+    "arena: %zu bytes, %zu bytes at most per message, %" PRIu64 " grows\n",
+    arena.size,
+    arena.high_water,
+    arena.num_grows);
+
+  s1ap_arena_destroy(&arena);
+  for (int p = 0; p < S1AP_BENCH_ENB_PDUS; p++) {
+    bdestroy(pdus[p]);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Benchmark of the lookups of the S1AP UE descriptions by mme_ue_s1ap_id.
+ *
+ * The UEs are spread over BENCH_ENBS eNBs and looked up in a random order:
+ * - index: s1ap_state_get_ue_mmeid(), through the mmeid2ueid index
+ * - scan: the previous lookup, going through the UEs of every eNB
+ * The time per lookup of the index should not grow with the number of UEs.
+ *
+ * The UEs are then all removed, the index has to be left empty.
+ *
+ * Usage: s1ap_state_bench [--smoke]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "mme_config.h"
+#include "s1ap_mme.h"
+#include "s1ap_state.h"
+
+#define BENCH_SMOKE_DIVIDER 100
+#define BENCH_ENBS 500
+#define BENCH_LOOKUPS 1000000
+// The scan is too slow to look every UE up
+#define BENCH_SCAN_LOOKUPS 1000
+
+static const size_t bench_nb_ues[] = {1000, 10000, 50000};
+
+static uint64_t _bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static ue_description_t *_bench_scan(
+  s1ap_state_t *state,
+  mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  hashtable_ts_cursor_t enb_cursor, ue_cursor;
+  hash_key_t key;
+  void *enb, *ue;
+
+  hashtable_ts_cursor_init(
+    &enb_cursor, &state->enbs, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&enb_cursor, &key, &enb)) {
+    hashtable_ts_cursor_init(
+      &ue_cursor,
+      &((enb_description_t *) enb)->ue_coll,
+      HASH_TABLE_CURSOR_STRIPED);
+    while (hashtable_ts_cursor_next(&ue_cursor, &key, &ue)) {
+      if (((ue_description_t *) ue)->mme_ue_s1ap_id == mme_ue_s1ap_id) {
+        hashtable_ts_cursor_end(&ue_cursor);
+        hashtable_ts_cursor_end(&enb_cursor);
+        return (ue_description_t *) ue;
+      }
+    }
+  }
+  return NULL;
+}
+
+// Returns the ns per lookup of random UEs, a wrong UE fails the run
+static double _bench_lookups(
+  s1ap_state_t *state,
+  size_t nb_ues,
+  size_t nb_lookups,
+  bool scan)
+{
+  uint64_t t0 = 0, ns = 0;
+  size_t errors = 0;
+  unsigned int seed = 1;
+
+  t0 = _bench_now_ns();
+  for (size_t i = 0; i < nb_lookups; i++) {
+    mme_ue_s1ap_id_t mme_ue_s1ap_id = 1 + rand_r(&seed) % nb_ues;
+    ue_description_t *ue = scan ?
+                             _bench_scan(state, mme_ue_s1ap_id) :
+                             s1ap_state_get_ue_mmeid(state, mme_ue_s1ap_id);
+
+    errors += !ue || ue->mme_ue_s1ap_id != mme_ue_s1ap_id;
+  }
+  ns = _bench_now_ns() - t0;
+  if (errors) {
+    fprintf(stderr, "%zu UEs: %zu lookups failed\n", nb_ues, errors);
+    exit(EXIT_FAILURE);
+  }
+  return (double) ns / (double) nb_lookups;
+}
+
+static void _bench_run(
+  s1ap_state_t *state,
+  size_t nb_enbs,
+  size_t nb_ues,
+  size_t nb_lookups,
+  size_t nb_scan_lookups)
+{
+  ue_description_t **ues = calloc(nb_ues, sizeof(ue_description_t *));
+  enb_description_t *enb = NULL;
+  double index_ns = 0, scan_ns = 0;
+
+  if (!ues) {
+    fprintf(stderr, "Cannot allocate %zu UEs\n", nb_ues);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t e = 0; e < nb_enbs; e++) {
+    enb = s1ap_new_enb(state);
+    enb->sctp_assoc_id = e + 1;
+    hashtable_ts_insert(
+      &state->enbs, (const hash_key_t) enb->sctp_assoc_id, (void *) enb);
+  }
+  for (size_t u = 0; u < nb_ues; u++) {
+    ues[u] = s1ap_new_ue(state, 1 + u % nb_enbs, u / nb_enbs);
+    if (!ues[u]) {
+      fprintf(stderr, "Cannot add UE %zu\n", u);
+      exit(EXIT_FAILURE);
+    }
+    ues[u]->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
+    ues[u]->mme_ue_s1ap_id = u + 1;
+    s1ap_state_associate_ue_mmeid(state, ues[u]);
+  }
+
+  index_ns = _bench_lookups(state, nb_ues, nb_lookups, false);
+  scan_ns = _bench_lookups(state, nb_ues, nb_scan_lookups, true);
+  printf("%8zu %12.1f %12.1f\n", nb_ues, index_ns, scan_ns);
+
+  for (size_t u = 0; u < nb_ues; u++) {
+    s1ap_remove_ue(state, ues[u]);
+  }
+  if (state->mmeid2ueid.num_elements) {
+    fprintf(
+      stderr,
+      "%zu UEs: %" PRIu64 " left in the index\n",
+      nb_ues,
+      (uint64_t) state->mmeid2ueid.num_elements);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t e = 0; e < nb_enbs; e++) {
+    s1ap_remove_enb(state, s1ap_state_get_enb(state, e + 1));
+  }
+  free(ues);
+}
+
+int main(int argc, char *argv[])
+{
+  bool smoke = argc > 1 && strcmp(argv[1], "--smoke") == 0;
+  size_t divider = smoke ? BENCH_SMOKE_DIVIDER : 1;
+  s1ap_state_t *state = NULL;
+
+  // Small tables, they grow with the UEs as they do in the MME
+  mme_config.max_enbs = BENCH_ENBS;
+  mme_config.max_ues = 64;
+  mme_config.use_stateless = false;
+  if (s1ap_state_init() != RETURNok) {
+    fprintf(stderr, "Cannot init the S1AP state\n");
+    return EXIT_FAILURE;
+  }
+  state = s1ap_state_get();
+
+  printf("%8s %12s %12s\n", "UEs", "index (ns)", "scan (ns)");
+  for (size_t i = 0; i < sizeof(bench_nb_ues) / sizeof(bench_nb_ues[0]); i++) {
+    _bench_run(
+      state,
+      BENCH_ENBS / divider,
+      bench_nb_ues[i] / divider,
+      BENCH_LOOKUPS / divider,
+      BENCH_SCAN_LOOKUPS / divider);
+  }
+
+  s1ap_state_put(state);
+  s1ap_state_exit();
+  return EXIT_SUCCESS;
+}
@@ -505,7 +505,7 @@ for key in iesDefs:
              iesStructName,
              re.sub('IEs', '', lowerFirstCamelWord(re.sub('-', '_', key)))))
     f.write("    }\n")
-    f.write("    free(%s->%s.array);\n" %
+    f.write("    FREEMEM(%s->%s.array);\n" %
             (iesStructName, re.sub('IEs', '', lowerFirstCamelWord(re.sub('-', '_', key)))))
     f.write("    return 0;\n")
     f.write("}\n\n")
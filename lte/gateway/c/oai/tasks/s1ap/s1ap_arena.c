@@ -0,0 +1,270 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_arena.c
+  \brief Per message arena of the S1AP codec
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "s1ap_arena.h"
+
+// Blocks are 16 bytes aligned, as malloc() does
+#define S1AP_ARENA_ALIGN 16
+#define S1AP_ARENA_ROUND_SIZE(s)                                               \
+  (((s) + S1AP_ARENA_ALIGN - 1) & ~((size_t) S1AP_ARENA_ALIGN - 1))
+// Each block is preceded by its size, for REALLOC
+#define S1AP_ARENA_HEADER_SIZE S1AP_ARENA_ALIGN
+
+struct s1ap_arena_chunk_s {
+  struct s1ap_arena_chunk_s *next;
+  size_t size;
+  size_t used;
+  size_t unused; // keeps data aligned
+  unsigned char data[];
+};
+
+static __thread s1ap_arena_t *s1ap_arena_current = NULL;
+static __thread s1ap_arena_stats_t s1ap_arena_stats;
+
+static s1ap_arena_chunk_t *s1ap_arena_new_chunk(size_t size)
+{
+  s1ap_arena_chunk_t *chunk = malloc(sizeof(*chunk) + size);
+
+  if (chunk) {
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+  }
+  return chunk;
+}
+
+static inline size_t s1ap_arena_block_size(const void *ptr)
+{
+  return *(const size_t *) ((const unsigned char *) ptr -
+                            S1AP_ARENA_HEADER_SIZE);
+}
+
+static void *s1ap_arena_alloc(s1ap_arena_t *arena, size_t size)
+{
+  s1ap_arena_chunk_t *chunk = arena->chunks;
+  size_t needed = 0;
+  unsigned char *block = NULL;
+
+  if (size > SIZE_MAX / 2) return NULL;
+  needed = S1AP_ARENA_HEADER_SIZE + S1AP_ARENA_ROUND_SIZE(size);
+  if (chunk->size - chunk->used < needed) {
+    size_t chunk_size = 2 * chunk->size;
+
+    if (chunk_size < needed) chunk_size = needed;
+    chunk = s1ap_arena_new_chunk(chunk_size);
+    if (!chunk) return NULL;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->size += chunk_size;
+    arena->num_grows++;
+  }
+  block = chunk->data + chunk->used;
+  *(size_t *) block = size;
+  chunk->used += needed;
+  arena->used += needed;
+  if (arena->used > arena->high_water) arena->high_water = arena->used;
+  arena->last = block + S1AP_ARENA_HEADER_SIZE;
+  s1ap_arena_stats.num_arena_allocs++;
+  return arena->last;
+}
+
+bool s1ap_arena_init(s1ap_arena_t *arena, size_t size)
+{
+  memset(arena, 0, sizeof(*arena));
+  arena->chunks = s1ap_arena_new_chunk(S1AP_ARENA_ROUND_SIZE(size));
+  if (!arena->chunks) return false;
+  arena->size = arena->chunks->size;
+  return true;
+}
+
+void s1ap_arena_destroy(s1ap_arena_t *arena)
+{
+  s1ap_arena_chunk_t *chunk = arena->chunks;
+
+  if (s1ap_arena_current == arena) s1ap_arena_current = NULL;
+  while (chunk) {
+    s1ap_arena_chunk_t *next = chunk->next;
+
+    free(chunk);
+    chunk = next;
+  }
+  memset(arena, 0, sizeof(*arena));
+}
+
+void s1ap_arena_use(s1ap_arena_t *arena)
+{
+#if S1AP_ARENA
+  s1ap_arena_current = arena;
+#endif
+}
+
+void s1ap_arena_reset(s1ap_arena_t *arena)
+{
+  s1ap_arena_chunk_t *chunk = arena->chunks;
+
+  if (chunk->next) {
+    /*
+     * The message did not fit, replace the chunks by one large enough for it
+     * or fall back to the first one
+     */
+    s1ap_arena_chunk_t *keep = NULL;
+
+    if (arena->size <= S1AP_ARENA_MAX_SIZE) {
+      keep = s1ap_arena_new_chunk(arena->size);
+    }
+    while (chunk) {
+      s1ap_arena_chunk_t *next = chunk->next;
+
+      if (next || keep) {
+        free(chunk);
+      } else {
+        keep = chunk;
+      }
+      chunk = next;
+    }
+    keep->next = NULL;
+    arena->chunks = keep;
+    arena->size = keep->size;
+  }
+  arena->chunks->used = 0;
+  arena->used = 0;
+  arena->last = NULL;
+}
+
+bool s1ap_arena_owns(const s1ap_arena_t *arena, const void *ptr)
+{
+  uintptr_t p = (uintptr_t) ptr;
+
+  for (const s1ap_arena_chunk_t *chunk = arena->chunks; chunk;
+       chunk = chunk->next) {
+    if (
+      p >= (uintptr_t) chunk->data &&
+      p < (uintptr_t) chunk->data + chunk->used) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void *s1ap_arena_export(void *ptr, size_t size)
+{
+  s1ap_arena_t *arena = s1ap_arena_current;
+  void *copy = NULL;
+
+  if (!ptr || !arena || !s1ap_arena_owns(arena, ptr)) return ptr;
+  copy = malloc(size ? size : 1);
+  if (copy) memcpy(copy, ptr, size);
+  s1ap_arena_free(ptr);
+  return copy;
+}
+
+void s1ap_arena_get_stats(s1ap_arena_stats_t *stats)
+{
+  *stats = s1ap_arena_stats;
+}
+
+void *s1ap_arena_calloc(size_t nmemb, size_t size)
+{
+  s1ap_arena_t *arena = s1ap_arena_current;
+  void *ptr = NULL;
+
+  if (!arena) {
+    s1ap_arena_stats.num_malloc_allocs++;
+    return calloc(nmemb, size);
+  }
+  if (size && nmemb > SIZE_MAX / size) return NULL;
+  ptr = s1ap_arena_alloc(arena, nmemb * size);
+  if (ptr) memset(ptr, 0, nmemb * size);
+  return ptr;
+}
+
+void *s1ap_arena_malloc(size_t size)
+{
+  s1ap_arena_t *arena = s1ap_arena_current;
+
+  if (!arena) {
+    s1ap_arena_stats.num_malloc_allocs++;
+    return malloc(size);
+  }
+  return s1ap_arena_alloc(arena, size);
+}
+
+void *s1ap_arena_realloc(void *ptr, size_t size)
+{
+  s1ap_arena_t *arena = s1ap_arena_current;
+  s1ap_arena_chunk_t *chunk = NULL;
+  size_t old_size = 0, grow = 0;
+  void *new_ptr = NULL;
+
+  // The memory which does not come from the arena stays out of it
+  if (!arena || (ptr && !s1ap_arena_owns(arena, ptr))) {
+    s1ap_arena_stats.num_malloc_allocs++;
+    return realloc(ptr, size);
+  }
+  if (!ptr) return s1ap_arena_alloc(arena, size);
+
+  old_size = s1ap_arena_block_size(ptr);
+  if (size <= old_size) return ptr;
+  if (ptr == arena->last && size <= SIZE_MAX / 2) {
+    chunk = arena->chunks;
+    grow = S1AP_ARENA_ROUND_SIZE(size) - S1AP_ARENA_ROUND_SIZE(old_size);
+    if (chunk->size - chunk->used >= grow) {
+      *(size_t *) ((unsigned char *) ptr - S1AP_ARENA_HEADER_SIZE) = size;
+      chunk->used += grow;
+      arena->used += grow;
+      if (arena->used > arena->high_water) arena->high_water = arena->used;
+      return ptr;
+    }
+  }
+  new_ptr = s1ap_arena_alloc(arena, size);
+  if (new_ptr) memcpy(new_ptr, ptr, old_size);
+  return new_ptr;
+}
+
+void s1ap_arena_free(void *ptr)
+{
+  s1ap_arena_t *arena = s1ap_arena_current;
+
+  if (!ptr) return;
+  if (!arena || !s1ap_arena_owns(arena, ptr)) {
+    free(ptr);
+    return;
+  }
+  // Only the last block is given back, the others wait for the reset
+  if (ptr == arena->last) {
+    size_t needed = S1AP_ARENA_HEADER_SIZE +
+                    S1AP_ARENA_ROUND_SIZE(s1ap_arena_block_size(ptr));
+
+    arena->chunks->used -= needed;
+    arena->used -= needed;
+    arena->last = NULL;
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_arena.h
+  \brief Per message arena of the S1AP codec
+*/
+
+#ifndef FILE_S1AP_ARENA_SEEN
+#define FILE_S1AP_ARENA_SEEN
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The asn1c runtime of the S1AP codec allocates through the CALLOC, MALLOC,
+ * REALLOC and FREEMEM macros of asn_internal.h, which generate_asn1 points to
+ * the functions below. While a thread uses an arena they bump allocate from
+ * it and FREEMEM of its memory does nothing, everything is given back at once
+ * by s1ap_arena_reset(). The S1AP task resets its arena once each message has
+ * been handled, so no codec memory may outlive the message.
+ *
+ * Without an arena, and for the memory that does not come from it, they are
+ * malloc(), realloc() and free(). The encoded PDUs handed to the callers of
+ * the encoder are copied out of the arena with s1ap_arena_export().
+ *
+ * Define S1AP_ARENA to 0 to never use an arena, it is the default under
+ * AddressSanitizer so that it keeps tracking the codec allocations.
+ */
+#ifndef S1AP_ARENA
+#if defined(__SANITIZE_ADDRESS__)
+#define S1AP_ARENA 0
+#else
+#define S1AP_ARENA 1
+#endif
+#endif
+
+#define S1AP_ARENA_CHUNK_SIZE (64 * 1024)
+// Most memory an arena keeps across a reset, after a message did not fit
+#define S1AP_ARENA_MAX_SIZE (1024 * 1024)
+
+typedef struct s1ap_arena_chunk_s s1ap_arena_chunk_t;
+
+typedef struct s1ap_arena_s {
+  // Current chunk first
+  s1ap_arena_chunk_t *chunks;
+  // Last allocation, the only one given back by FREEMEM or grown in place
+  void *last;
+  size_t size;
+  // Bytes allocated since the last reset, and the most between two resets
+  size_t used;
+  size_t high_water;
+  // Chunks added when a message did not fit
+  uint64_t num_grows;
+} s1ap_arena_t;
+
+typedef struct s1ap_arena_stats_s {
+  // Codec allocations of the calling thread, from an arena or from malloc()
+  uint64_t num_arena_allocs;
+  uint64_t num_malloc_allocs;
+} s1ap_arena_stats_t;
+
+bool s1ap_arena_init(s1ap_arena_t *arena, size_t size);
+void s1ap_arena_destroy(s1ap_arena_t *arena);
+// Makes the codec of the calling thread allocate from the arena, or malloc()
+void s1ap_arena_use(s1ap_arena_t *arena);
+void s1ap_arena_reset(s1ap_arena_t *arena);
+bool s1ap_arena_owns(const s1ap_arena_t *arena, const void *ptr);
+// Returns ptr, or a malloc() copy of its size bytes if it is arena memory
+void *s1ap_arena_export(void *ptr, size_t size);
+void s1ap_arena_get_stats(s1ap_arena_stats_t *stats);
+
+void *s1ap_arena_calloc(size_t nmemb, size_t size);
+void *s1ap_arena_malloc(size_t size);
+void *s1ap_arena_realloc(void *ptr, size_t size);
+void s1ap_arena_free(void *ptr);
+
+#endif /* FILE_S1AP_ARENA_SEEN */
@@ -34,6 +34,7 @@
 #include "s1ap_common.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
+#include "s1ap_arena.h"
 #include "ANY.h"
 #include "S1AP-PDU.h"
 #include "S1ap-InitiatingMessage.h"
@@ -77,6 +78,11 @@ ssize_t s1ap_generate_initiating_message(
     OAILOG_ERROR(LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
+  // The callers free() the buffer, it must not stay in the arena
+  if (!(*buffer = s1ap_arena_export(*buffer, encoded))) {
+    ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_S1AP_PDU, &pdu);
+    return -1;
+  }
 
   ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_S1AP_PDU, &pdu);
 
@@ -116,6 +122,11 @@ ssize_t s1ap_generate_successfull_outcome(
     OAILOG_ERROR(LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
+  // The callers free() the buffer, it must not stay in the arena
+  if (!(*buffer = s1ap_arena_export(*buffer, encoded))) {
+    ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_S1AP_PDU, &pdu);
+    return -1;
+  }
 
   // Might need this if there is a leak here
   ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_S1AP_PDU, &pdu);
@@ -156,6 +167,11 @@ ssize_t s1ap_generate_unsuccessfull_outcome(
     OAILOG_ERROR(LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
+  // The callers free() the buffer, it must not stay in the arena
+  if (!(*buffer = s1ap_arena_export(*buffer, encoded))) {
+    ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_S1AP_PDU, &pdu);
+    return -1;
+  }
 
   // Might need this if there is a leak here
   ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_S1AP_PDU, &pdu);
@@ -172,7 +188,7 @@ S1ap_IE_t *s1ap_new_ie(
 {
   S1ap_IE_t *buff;
 
-  if ((buff = malloc(sizeof(S1ap_IE_t))) == NULL) {
+  if ((buff = MALLOC(sizeof(S1ap_IE_t))) == NULL) {
     // Possible error on malloc
     return NULL;
   }
@@ -183,13 +199,13 @@ S1ap_IE_t *s1ap_new_ie(
 
   if (ANY_fromType_aper(&buff->value, type, sptr) < 0) {
     OAILOG_ERROR(LOG_S1AP, "Encoding of %s failed\n", type->name);
-    free_wrapper((void **) &buff);
+    FREEMEM(buff);
     return NULL;
   }
 
   if (asn1_xer_print)
     if (xer_fprint(stdout, &asn_DEF_S1ap_IE, buff) < 0) {
-      free_wrapper((void **) &buff);
+      FREEMEM(buff);
       return NULL;
     }
 
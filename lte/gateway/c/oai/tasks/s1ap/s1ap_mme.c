@@ -44,6 +44,7 @@
 #include "log.h"
 #include "assertions.h"
 #include "mme_app_statistics.h"
+#include "s1ap_arena.h"
 #include "s1ap_mme_decoder.h"
 #include "s1ap_mme_handlers.h"
 #include "s1ap_ies_defs.h"
@@ -92,6 +93,9 @@ bool hss_associated = false;
 
 static int indent = 0;
 
+// The codec memory of the message being handled
+static s1ap_arena_t s1ap_arena;
+
 //------------------------------------------------------------------------------
 static int s1ap_send_init_sctp(void)
 {
@@ -121,255 +125,272 @@ void *s1ap_mme_thread(__attribute__((unused)) void *args)
   s1ap_state_t *state;
 
   itti_mark_task_ready(TASK_S1AP);
+  s1ap_arena_use(&s1ap_arena);
 
   while (1) {
-    MessageDef *received_message_p = NULL;
-    MessagesIds message_id = MESSAGES_ID_MAX;
+    MessageDef *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_messages;
     /*
-     * Trying to fetch a message from the message queue.
+     * Trying to fetch messages from the message queue.
      * * * * If the queue is empty, this function will block till a
      * * * * message is sent to the task.
      */
-    itti_receive_msg(TASK_S1AP, &received_message_p);
+    nb_messages = itti_receive_msgs(
+      TASK_S1AP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
 
-    state = s1ap_state_get();
-    AssertFatal(state != NULL, "failed to retrieve s1ap state (was null)");
+    for (size_t i = 0; i < nb_messages; i++) {
+      MessageDef *received_message_p = received_messages[i];
+      MessagesIds message_id = MESSAGES_ID_MAX;
 
-    switch (ITTI_MSG_ID(received_message_p)) {
-      case ACTIVATE_MESSAGE: {
-        hss_associated = true;
-      } break;
+      state = s1ap_state_get();
+      AssertFatal(state != NULL, "failed to retrieve s1ap state (was null)");
 
-      case MESSAGE_TEST:
-        OAILOG_DEBUG(LOG_S1AP, "Received MESSAGE_TEST\n");
-        break;
+      switch (ITTI_MSG_ID(received_message_p)) {
+        case ACTIVATE_MESSAGE: {
+          hss_associated = true;
+        } break;
 
-      case SCTP_DATA_IND: {
-        /*
-         * New message received from SCTP layer.
-         * * * * Decode and handle it.
-         */
-        s1ap_message message = {0};
+        case MESSAGE_TEST:
+          OAILOG_DEBUG(LOG_S1AP, "Received MESSAGE_TEST\n");
+          break;
 
-        /*
-         * Invoke S1AP message decoder
-         */
-        if (
-          s1ap_mme_decode_pdu(
-            &message, SCTP_DATA_IND(received_message_p).payload, &message_id) <
-          0) {
-          // TODO: Notify eNB of failure with right cause
-          OAILOG_ERROR(LOG_S1AP, "Failed to decode new buffer\n");
-        } else {
-          s1ap_mme_handle_message(
-            state,
-            SCTP_DATA_IND(received_message_p).assoc_id,
-            SCTP_DATA_IND(received_message_p).stream,
-            &message);
-        }
+        case SCTP_DATA_IND: {
+          /*
+           * New message received from SCTP layer.
+           * * * * Decode and handle it.
+           */
+          s1ap_message message = {0};
+
+          /*
+           * Invoke S1AP message decoder
+           */
+          if (
+            s1ap_mme_decode_pdu(
+              &message,
+              SCTP_DATA_IND(received_message_p).payload,
+              &message_id) < 0) {
+            // TODO: Notify eNB of failure with right cause
+            OAILOG_ERROR(LOG_S1AP, "Failed to decode new buffer\n");
+          } else {
+            s1ap_mme_handle_message(
+              state,
+              SCTP_DATA_IND(received_message_p).assoc_id,
+              SCTP_DATA_IND(received_message_p).stream,
+              &message);
+          }
 
-        if (message_id != MESSAGES_ID_MAX) {
-          s1ap_free_mme_decode_pdu(&message, message_id);
-        }
+          if (message_id != MESSAGES_ID_MAX) {
+            s1ap_free_mme_decode_pdu(&message, message_id);
+          }
 
-        /*
-         * Free received PDU array
-         */
-        bdestroy_wrapper(&SCTP_DATA_IND(received_message_p).payload);
-      } break;
-
-      case SCTP_DATA_CNF:
-        s1ap_mme_itti_nas_downlink_cnf(
-          SCTP_DATA_CNF(received_message_p).mme_ue_s1ap_id,
-          SCTP_DATA_CNF(received_message_p).is_success);
-        break;
-        /*
-       * SCTP layer notifies S1AP of disconnection of a peer.
-       */
-      case SCTP_CLOSE_ASSOCIATION: {
-        s1ap_handle_sctp_disconnection(
-          state,
-          SCTP_CLOSE_ASSOCIATION(received_message_p).assoc_id,
-          SCTP_CLOSE_ASSOCIATION(received_message_p).reset);
-      } break;
-
-      case SCTP_NEW_ASSOCIATION: {
-        increment_counter("mme_new_association", 1, NO_LABELS);
-        if (s1ap_handle_new_association(
-              state, &received_message_p->ittiMsg.sctp_new_peer)) {
-          increment_counter("mme_new_association", 1, 1, "result", "failure");
-        } else {
-          increment_counter("mme_new_association", 1, 1, "result", "success");
-        }
-      } break;
-
-      case S1AP_NAS_DL_DATA_REQ: {
-        /*
-         * New message received from NAS task.
-         * * * * This corresponds to a S1AP downlink nas transport message.
-         */
-        s1ap_generate_downlink_nas_transport(
-          state,
-          S1AP_NAS_DL_DATA_REQ(received_message_p).enb_ue_s1ap_id,
-          S1AP_NAS_DL_DATA_REQ(received_message_p).mme_ue_s1ap_id,
-          &S1AP_NAS_DL_DATA_REQ(received_message_p).nas_msg);
-      } break;
-
-      case S1AP_E_RAB_SETUP_REQ: {
-        s1ap_generate_s1ap_e_rab_setup_req(
-          state, &S1AP_E_RAB_SETUP_REQ(received_message_p));
-      } break;
-
-      // From MME_APP task
-      case S1AP_UE_CONTEXT_RELEASE_COMMAND: {
-        s1ap_handle_ue_context_release_command(
-          state, &received_message_p->ittiMsg.s1ap_ue_context_release_command);
-      } break;
-
-      case MME_APP_CONNECTION_ESTABLISHMENT_CNF: {
-        s1ap_handle_conn_est_cnf(
-          state, &MME_APP_CONNECTION_ESTABLISHMENT_CNF(received_message_p));
-      } break;
-
-      case MME_APP_S1AP_MME_UE_ID_NOTIFICATION: {
-        s1ap_handle_mme_ue_id_notification(
-          state, &MME_APP_S1AP_MME_UE_ID_NOTIFICATION(received_message_p));
-      } break;
-
-      case S1AP_ENB_INITIATED_RESET_ACK: {
-        s1ap_handle_enb_initiated_reset_ack(
-          &S1AP_ENB_INITIATED_RESET_ACK(received_message_p));
-      } break;
-
-      case S1AP_PAGING_REQUEST: {
-        if (
-          s1ap_handle_paging_request(
-            &S1AP_PAGING_REQUEST(received_message_p)) != RETURNok) {
-          OAILOG_ERROR(LOG_S1AP, "Failed to send paging message\n");
-        }
-      } break;
-
-      case S1AP_UE_CONTEXT_MODIFICATION_REQUEST: {
-        s1ap_handle_ue_context_mod_req(
-          state, &received_message_p->ittiMsg.s1ap_ue_context_mod_request);
-      } break;
-
-      case S1AP_E_RAB_REL_CMD: {
-        s1ap_generate_s1ap_e_rab_rel_cmd(
-          state, &S1AP_E_RAB_REL_CMD(received_message_p));
-      } break;
-
-      case S1AP_PATH_SWITCH_REQUEST_ACK: {
-        s1ap_handle_path_switch_req_ack(
-          state, &received_message_p->ittiMsg.s1ap_path_switch_request_ack);
-      } break;
-
-      case S1AP_PATH_SWITCH_REQUEST_FAILURE: {
-        s1ap_handle_path_switch_req_failure(
-          state, &received_message_p->ittiMsg.s1ap_path_switch_request_failure);
-      } break;
-
-      case TIMER_HAS_EXPIRED: {
-        if (!timer_exists(
-              received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+          /*
+           * Free received PDU array
+           */
+          bdestroy_wrapper(&SCTP_DATA_IND(received_message_p).payload);
+        } break;
+
+        case SCTP_DATA_CNF:
+          s1ap_mme_itti_nas_downlink_cnf(
+            SCTP_DATA_CNF(received_message_p).mme_ue_s1ap_id,
+            SCTP_DATA_CNF(received_message_p).is_success);
           break;
-        }
-        ue_description_t *ue_ref_p = NULL;
-        enb_description_t *enb_ref_p = NULL;
-        if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
-          // check whether timer is related to eNB procedure or UE procedure
-          s1ap_timer_arg_t timer_arg =
-            *((s1ap_timer_arg_t *) (received_message_p->ittiMsg
-                                      .timer_has_expired.arg));
-          if (timer_arg.timer_class == S1AP_UE_TIMER) {
-            mme_ue_s1ap_id_t mme_ue_s1ap_id = timer_arg.instance_id;
-            if (
-              (ue_ref_p = s1ap_state_get_ue_mmeid(state, mme_ue_s1ap_id)) ==
-              NULL) {
-              OAILOG_WARNING(
-                LOG_S1AP,
-                "Timer expired but no assoicated UE context for UE id %d\n",
-                mme_ue_s1ap_id);
-              timer_handle_expired(
-                received_message_p->ittiMsg.timer_has_expired.timer_id);
-              break;
-            }
-            if (
-              received_message_p->ittiMsg.timer_has_expired.timer_id ==
-              ue_ref_p->s1ap_ue_context_rel_timer.id) {
-              // UE context release complete timer expiry handler
-              OAILOG_INFO(
-                LOG_S1AP,
-                "ue_context_release_command_timer_expired for UE id %d\n",
-                mme_ue_s1ap_id);
-              increment_counter(
-                "ue_context_release_command_timer_expired", 1, NO_LABELS);
-              s1ap_mme_handle_ue_context_rel_comp_timer_expiry(state, ue_ref_p);
-            }
-          } else if (timer_arg.timer_class == S1AP_ENB_TIMER) {
-            sctp_assoc_id_t assoc_id = timer_arg.instance_id;
-            if ((enb_ref_p = s1ap_state_get_enb(state, assoc_id)) == NULL) {
-              OAILOG_WARNING(
-                LOG_S1AP,
-                "Timer expired but no assoicated eNB context for eNB assoc_id "
-                "%d\n",
-                assoc_id);
-              timer_handle_expired(
-                received_message_p->ittiMsg.timer_has_expired.timer_id);
-              break;
-            }
-            if (
-              received_message_p->ittiMsg.timer_has_expired.timer_id ==
-              enb_ref_p->s1ap_enb_assoc_clean_up_timer.id) {
-              OAILOG_INFO(
-                LOG_S1AP,
-                "enb_sctp_shutdown_ue_clean_up_timer_expired for enb assoc_id "
-                "%d\n",
-                assoc_id);
-              increment_counter(
-                "enb_sctp_shutdown_ue_clean_up_timer_expired", 1, NO_LABELS);
-              s1ap_enb_assoc_clean_up_timer_expiry(state, enb_ref_p);
-            }
+          /*
+         * SCTP layer notifies S1AP of disconnection of a peer.
+         */
+        case SCTP_CLOSE_ASSOCIATION: {
+          s1ap_handle_sctp_disconnection(
+            state,
+            SCTP_CLOSE_ASSOCIATION(received_message_p).assoc_id,
+            SCTP_CLOSE_ASSOCIATION(received_message_p).reset);
+        } break;
+
+        case SCTP_NEW_ASSOCIATION: {
+          increment_counter("mme_new_association", 1, NO_LABELS);
+          if (s1ap_handle_new_association(
+                state, &received_message_p->ittiMsg.sctp_new_peer)) {
+            increment_counter("mme_new_association", 1, 1, "result", "failure");
           } else {
-            OAILOG_WARNING(
-              LOG_S1AP,
-              " S1AP Timer expired with invalid timer class  %u \n",
-              timer_arg.timer_class);
+            increment_counter("mme_new_association", 1, 1, "result", "success");
           }
-        }
-        timer_handle_expired(
-          received_message_p->ittiMsg.timer_has_expired.timer_id);
+        } break;
+
+        case S1AP_NAS_DL_DATA_REQ: {
+          /*
+           * New message received from NAS task.
+           * * * * This corresponds to a S1AP downlink nas transport message.
+           */
+          s1ap_generate_downlink_nas_transport(
+            state,
+            S1AP_NAS_DL_DATA_REQ(received_message_p).enb_ue_s1ap_id,
+            S1AP_NAS_DL_DATA_REQ(received_message_p).mme_ue_s1ap_id,
+            &S1AP_NAS_DL_DATA_REQ(received_message_p).nas_msg);
+        } break;
+
+        case S1AP_E_RAB_SETUP_REQ: {
+          s1ap_generate_s1ap_e_rab_setup_req(
+            state, &S1AP_E_RAB_SETUP_REQ(received_message_p));
+        } break;
+
+        // From MME_APP task
+        case S1AP_UE_CONTEXT_RELEASE_COMMAND: {
+          s1ap_handle_ue_context_release_command(
+            state,
+            &received_message_p->ittiMsg.s1ap_ue_context_release_command);
+        } break;
+
+        case MME_APP_CONNECTION_ESTABLISHMENT_CNF: {
+          s1ap_handle_conn_est_cnf(
+            state, &MME_APP_CONNECTION_ESTABLISHMENT_CNF(received_message_p));
+        } break;
+
+        case MME_APP_S1AP_MME_UE_ID_NOTIFICATION: {
+          s1ap_handle_mme_ue_id_notification(
+            state, &MME_APP_S1AP_MME_UE_ID_NOTIFICATION(received_message_p));
+        } break;
+
+        case S1AP_ENB_INITIATED_RESET_ACK: {
+          s1ap_handle_enb_initiated_reset_ack(
+            &S1AP_ENB_INITIATED_RESET_ACK(received_message_p));
+        } break;
+
+        case S1AP_PAGING_REQUEST: {
+          if (
+            s1ap_handle_paging_request(
+              state, &S1AP_PAGING_REQUEST(received_message_p)) != RETURNok) {
+            OAILOG_ERROR(LOG_S1AP, "Failed to send paging message\n");
+          }
+        } break;
 
-        /* TODO - Commenting out below function as it is not used as of now.
-         * Need to handle it when we support other timers in S1AP
-         */
+        case S1AP_UE_CONTEXT_MODIFICATION_REQUEST: {
+          s1ap_handle_ue_context_mod_req(
+            state, &received_message_p->ittiMsg.s1ap_ue_context_mod_request);
+        } break;
 
-        //s1ap_handle_timer_expiry (&received_message_p->ittiMsg.timer_has_expired);
-      } break;
-
-      case TERMINATE_MESSAGE: {
-        s1ap_state_put(state);
-        s1ap_mme_exit();
-        itti_free_msg_content(received_message_p);
-        itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
-        OAI_FPRINTF_INFO("TASK_S1AP terminated\n");
-        itti_exit_task();
-      } break;
-
-      default: {
-        OAILOG_ERROR(
-          LOG_S1AP,
-          "Unknown message ID %d:%s\n",
-          ITTI_MSG_ID(received_message_p),
-          ITTI_MSG_NAME(received_message_p));
-      } break;
-    }
+        case S1AP_E_RAB_REL_CMD: {
+          s1ap_generate_s1ap_e_rab_rel_cmd(
+            state, &S1AP_E_RAB_REL_CMD(received_message_p));
+        } break;
 
-    s1ap_state_put(state);
+        case S1AP_PATH_SWITCH_REQUEST_ACK: {
+          s1ap_handle_path_switch_req_ack(
+            state, &received_message_p->ittiMsg.s1ap_path_switch_request_ack);
+        } break;
 
-    itti_free_msg_content(received_message_p);
-    itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
-    received_message_p = NULL;
+        case S1AP_PATH_SWITCH_REQUEST_FAILURE: {
+          s1ap_handle_path_switch_req_failure(
+            state,
+            &received_message_p->ittiMsg.s1ap_path_switch_request_failure);
+        } break;
+
+        case S1AP_QUEUE_OVERLOAD_IND: {
+          s1ap_handle_queue_overload(state);
+        } break;
+
+        case TIMER_HAS_EXPIRED: {
+          if (!timer_exists(
+                received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+            break;
+          }
+          ue_description_t *ue_ref_p = NULL;
+          enb_description_t *enb_ref_p = NULL;
+          if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
+            // check whether timer is related to eNB procedure or UE procedure
+            s1ap_timer_arg_t timer_arg =
+              *((s1ap_timer_arg_t *) (received_message_p->ittiMsg
+                                        .timer_has_expired.arg));
+            if (timer_arg.timer_class == S1AP_UE_TIMER) {
+              mme_ue_s1ap_id_t mme_ue_s1ap_id = timer_arg.instance_id;
+              if (
+                (ue_ref_p = s1ap_state_get_ue_mmeid(state, mme_ue_s1ap_id)) ==
+                NULL) {
+                OAILOG_WARNING(
+                  LOG_S1AP,
+                  "Timer expired but no assoicated UE context for UE id %d\n",
+                  mme_ue_s1ap_id);
+                timer_handle_expired(
+                  received_message_p->ittiMsg.timer_has_expired.timer_id);
+                break;
+              }
+              if (
+                received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                ue_ref_p->s1ap_ue_context_rel_timer.id) {
+                // UE context release complete timer expiry handler
+                OAILOG_INFO(
+                  LOG_S1AP,
+                  "ue_context_release_command_timer_expired for UE id %d\n",
+                  mme_ue_s1ap_id);
+                increment_counter(
+                  "ue_context_release_command_timer_expired", 1, NO_LABELS);
+                s1ap_mme_handle_ue_context_rel_comp_timer_expiry(
+                  state, ue_ref_p);
+              }
+            } else if (timer_arg.timer_class == S1AP_ENB_TIMER) {
+              sctp_assoc_id_t assoc_id = timer_arg.instance_id;
+              if ((enb_ref_p = s1ap_state_get_enb(state, assoc_id)) == NULL) {
+                OAILOG_WARNING(
+                  LOG_S1AP,
+                  "Timer expired but no assoicated eNB context for eNB "
+                  "assoc_id %d\n",
+                  assoc_id);
+                timer_handle_expired(
+                  received_message_p->ittiMsg.timer_has_expired.timer_id);
+                break;
+              }
+              if (
+                received_message_p->ittiMsg.timer_has_expired.timer_id ==
+                enb_ref_p->s1ap_enb_assoc_clean_up_timer.id) {
+                OAILOG_INFO(
+                  LOG_S1AP,
+                  "enb_sctp_shutdown_ue_clean_up_timer_expired for enb "
+                  "assoc_id %d\n",
+                  assoc_id);
+                increment_counter(
+                  "enb_sctp_shutdown_ue_clean_up_timer_expired", 1, NO_LABELS);
+                s1ap_enb_assoc_clean_up_timer_expiry(state, enb_ref_p);
+              }
+            } else if (timer_arg.timer_class == S1AP_STATE_TIMER) {
+              // committed by the s1ap_state_put() below
+              s1ap_state_commit_timer_expired();
+            } else {
+              OAILOG_WARNING(
+                LOG_S1AP,
+                " S1AP Timer expired with invalid timer class  %u \n",
+                timer_arg.timer_class);
+            }
+          }
+          timer_handle_expired(
+            received_message_p->ittiMsg.timer_has_expired.timer_id);
+
+          /* TODO - Commenting out below function as it is not used as of now.
+           * Need to handle it when we support other timers in S1AP
+           */
+
+          //s1ap_handle_timer_expiry (&received_message_p->ittiMsg.timer_has_expired);
+        } break;
+
+        case TERMINATE_MESSAGE: {
+          s1ap_state_put(state);
+          s1ap_mme_exit();
+          itti_free_msgs(&received_messages[i], nb_messages - i);
+          OAI_FPRINTF_INFO("TASK_S1AP terminated\n");
+          itti_exit_task();
+        } break;
+
+        default: {
+          OAILOG_ERROR(
+            LOG_S1AP,
+            "Unknown message ID %d:%s\n",
+            ITTI_MSG_ID(received_message_p),
+            ITTI_MSG_NAME(received_message_p));
+        } break;
+      }
+
+      s1ap_state_put(state);
+
+      itti_free_msg_content(received_message_p);
+      itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
+      s1ap_arena_reset(&s1ap_arena);
+    }
   }
 
   return NULL;
@@ -397,6 +418,11 @@ int s1ap_mme_init(void)
     return RETURNerror;
   }
 
+  if (!s1ap_arena_init(&s1ap_arena, S1AP_ARENA_CHUNK_SIZE)) {
+    OAILOG_ERROR(LOG_S1AP, "Error while allocating the S1AP arena\n");
+    return RETURNerror;
+  }
+
   if (itti_create_task(TASK_S1AP, &s1ap_mme_thread, NULL) == RETURNerror) {
     OAILOG_ERROR(LOG_S1AP, "Error while creating S1AP task\n");
     return RETURNerror;
@@ -411,12 +437,48 @@ int s1ap_mme_init(void)
   return RETURNok;
 }
 
+//------------------------------------------------------------------------------
+static void s1ap_mme_queue_overload_cb(task_id_t task_id, bool overloaded)
+{
+  MessageDef *message_p = NULL;
+
+  OAILOG_DEBUG(
+    LOG_S1AP,
+    "Task %s queue overload %s\n",
+    itti_get_task_name(task_id),
+    overloaded ? "start" : "stop");
+  /*
+   * Runs on the thread crossing the watermark: admission control applies at
+   * once, the S1AP task tells the eNBs when handling the indication
+   */
+  s1ap_update_overload();
+  message_p = itti_alloc_new_message(TASK_S1AP, S1AP_QUEUE_OVERLOAD_IND);
+  itti_send_msg_to_task(TASK_S1AP, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_watch_queues(const itti_config_t *itti_config)
+{
+  itti_set_queue_watermarks(
+    TASK_MME_APP,
+    itti_config->mme_app_watermarks.high,
+    itti_config->mme_app_watermarks.low,
+    s1ap_mme_queue_overload_cb);
+  itti_set_queue_watermarks(
+    TASK_S1AP,
+    itti_config->s1ap_watermarks.high,
+    itti_config->s1ap_watermarks.low,
+    s1ap_mme_queue_overload_cb);
+}
+
 //------------------------------------------------------------------------------
 void s1ap_mme_exit(void)
 {
   OAILOG_DEBUG(LOG_S1AP, "Cleaning S1AP\n");
 
   s1ap_state_exit();
+  s1ap_arena_use(NULL);
+  s1ap_arena_destroy(&s1ap_arena);
 
   OAILOG_DEBUG(LOG_S1AP, "Cleaning S1AP: DONE\n");
 }
@@ -562,6 +624,7 @@ ue_description_t *s1ap_new_ue(
   }
   // Increment number of UE
   enb_ref->nb_ue_associated++;
+  s1ap_state_dirty_ue(state, ue_ref);
   return ue_ref;
 }
 
@@ -575,7 +638,6 @@ void s1ap_remove_ue(s1ap_state_t *state, ue_description_t *ue_ref)
    */
   if (ue_ref == NULL) return;
 
-  mme_ue_s1ap_id_t mme_ue_s1ap_id = ue_ref->mme_ue_s1ap_id;
   enb_ref = ue_ref->enb;
   /*
    * Updating number of UE
@@ -607,8 +669,10 @@ void s1ap_remove_ue(s1ap_state_t *state, ue_description_t *ue_ref)
     enb_ref->enb_id);
 
   ue_ref->s1_ue_state = S1AP_UE_INVALID_STATE;
+  s1ap_state_dirty_enb(state, enb_ref);
+  s1ap_state_dirty_ue(state, ue_ref);
+  s1ap_state_dissociate_ue_mmeid(state, ue_ref);
   hashtable_ts_free(&enb_ref->ue_coll, ue_ref->enb_ue_s1ap_id);
-  hashtable_ts_free(&state->mmeid2associd, mme_ue_s1ap_id);
   if (!enb_ref->nb_ue_associated) {
     if (enb_ref->s1_state == S1AP_RESETING) {
       OAILOG_INFO(LOG_S1AP, "Moving eNB state to S1AP_INIT \n");
@@ -625,6 +689,10 @@ void s1ap_remove_ue(s1ap_state_t *state, ue_description_t *ue_ref)
 //------------------------------------------------------------------------------
 void s1ap_remove_enb(s1ap_state_t *state, enb_description_t *enb_ref)
 {
+  hashtable_ts_cursor_t cursor;
+  hash_key_t enb_ue_s1ap_id;
+  void *ue_ref;
+
   if (enb_ref == NULL) {
     return;
   }
@@ -645,6 +713,14 @@ void s1ap_remove_enb(s1ap_state_t *state, enb_description_t *enb_ref)
     enb_ref->s1ap_enb_assoc_clean_up_timer.id = S1AP_TIMER_INACTIVE_ID;
   }
   enb_ref->s1_state = S1AP_INIT;
+  s1ap_state_dirty_enb(state, enb_ref);
+  s1ap_state_unindex_enb_tacs(state, enb_ref);
+  hashtable_ts_cursor_init(
+    &cursor, &enb_ref->ue_coll, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &enb_ue_s1ap_id, &ue_ref)) {
+    s1ap_state_dirty_ue(state, (ue_description_t *) ue_ref);
+    s1ap_state_dissociate_ue_mmeid(state, (ue_description_t *) ue_ref);
+  }
   hashtable_ts_destroy(&enb_ref->ue_coll);
   hashtable_ts_free(&state->enbs, enb_ref->sctp_assoc_id);
   state->num_enbs--;
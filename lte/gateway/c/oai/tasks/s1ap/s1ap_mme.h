@@ -33,6 +33,7 @@
 #include "intertask_interface.h"
 #endif
 
+#include "mme_config.h"
 #include "s1ap_state.h"
 #include "s1ap_types.h"
 
@@ -43,6 +44,12 @@ extern bool hss_associated;
  **/
 int s1ap_mme_init(void);
 
+/** \brief Start the MME overload control on the MME_APP and S1AP queues.
+ * Must be called before the MME_APP and S1AP tasks are created.
+ \param itti_config Watermarks of the queues
+ **/
+void s1ap_mme_watch_queues(const itti_config_t *itti_config);
+
 /** \brief S1AP layer top exit
  **/
 void s1ap_mme_exit(void);
@@ -115,6 +115,16 @@ static inline int s1ap_mme_encode_pathswitchreqfailure(
   uint8_t **buffer,
   uint32_t *length);
 
+static inline int s1ap_mme_encode_overload_start(
+  s1ap_message *message_p,
+  uint8_t **buffer,
+  uint32_t *length);
+
+static inline int s1ap_mme_encode_overload_stop(
+  s1ap_message *message_p,
+  uint8_t **buffer,
+  uint32_t *length);
+
 static inline int s1ap_mme_encode_initial_context_setup_request(
   s1ap_message *message_p,
   uint8_t **buffer,
@@ -209,6 +219,12 @@ static inline int s1ap_mme_encode_initiating(
       return s1ap_mme_encode_mme_configuration_transfer(
         message_p, buffer, length);
 
+    case S1ap_ProcedureCode_id_OverloadStart:
+      return s1ap_mme_encode_overload_start(message_p, buffer, length);
+
+    case S1ap_ProcedureCode_id_OverloadStop:
+      return s1ap_mme_encode_overload_stop(message_p, buffer, length);
+
     default:
       OAILOG_DEBUG(
         LOG_S1AP,
@@ -486,6 +502,50 @@ static inline int s1ap_mme_encode_paging(
     paging_p);
 }
 
+static inline int s1ap_mme_encode_overload_start(
+  s1ap_message *message_p,
+  uint8_t **buffer,
+  uint32_t *length)
+{
+  S1ap_OverloadStart_t overloadStart;
+  S1ap_OverloadStart_t *overloadStart_p = &overloadStart;
+  memset(overloadStart_p, 0, sizeof(S1ap_OverloadStart_t));
+  if (
+    s1ap_encode_s1ap_overloadstarties(
+      overloadStart_p, &message_p->msg.s1ap_OverloadStartIEs) < 0) {
+    return -1;
+  }
+  return s1ap_generate_initiating_message(
+    buffer,
+    length,
+    S1ap_ProcedureCode_id_OverloadStart,
+    S1ap_Criticality_ignore,
+    &asn_DEF_S1ap_OverloadStart,
+    overloadStart_p);
+}
+
+static inline int s1ap_mme_encode_overload_stop(
+  s1ap_message *message_p,
+  uint8_t **buffer,
+  uint32_t *length)
+{
+  S1ap_OverloadStop_t overloadStop;
+  S1ap_OverloadStop_t *overloadStop_p = &overloadStop;
+  memset(overloadStop_p, 0, sizeof(S1ap_OverloadStop_t));
+  if (
+    s1ap_encode_s1ap_overloadstopies(
+      overloadStop_p, &message_p->msg.s1ap_OverloadStopIEs) < 0) {
+    return -1;
+  }
+  return s1ap_generate_initiating_message(
+    buffer,
+    length,
+    S1ap_ProcedureCode_id_OverloadStop,
+    S1ap_Criticality_reject,
+    &asn_DEF_S1ap_OverloadStop,
+    overloadStop_p);
+}
+
 //------------------------------------------------------------------------------
 static inline int s1ap_mme_encode_e_rab_setup(
   s1ap_message *message_p,
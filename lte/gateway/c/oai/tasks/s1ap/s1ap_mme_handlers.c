@@ -33,6 +33,7 @@
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/types.h>
+#include <time.h>
 
 #include "bstrlib.h"
 #include "hashtable.h"
@@ -52,8 +53,11 @@
 #include "s1ap_mme_ta.h"
 #include "s1ap_mme_handlers.h"
 #include "mme_app_statistics.h"
+#include "mme_app_ue_context.h"
 #include "3gpp_23.003.h"
+#include "3gpp_24.007.h"
 #include "3gpp_24.008.h"
+#include "3gpp_24.301.h"
 #include "3gpp_36.401.h"
 #include "3gpp_36.413.h"
 #include "BIT_STRING.h"
@@ -297,6 +301,281 @@ int s1ap_mme_generate_s1_setup_failure(
   OAILOG_FUNC_RETURN(LOG_S1AP, rc);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//************************** Overload procedures *****************************//
+////////////////////////////////////////////////////////////////////////////////
+
+/* T3346 value IEI of the attach, tracking area update and service rejects */
+#define S1AP_NAS_T3346_VALUE_IEI 0x5F
+/* Header, message type, EMM cause and T3346 value */
+#define S1AP_NAS_CONGESTION_REJECT_LENGTH 6
+
+/*
+ * Set while the MME_APP or S1AP queue is above its high watermark. Written by
+ * the thread crossing a watermark, so that new UEs are rejected without
+ * waiting for the S1AP task to handle the overload indication.
+ */
+static bool s1ap_overloaded = false;
+/* Overload state last sent to the eNBs, only used by the S1AP task */
+static bool s1ap_overload_signalled = false;
+
+//------------------------------------------------------------------------------
+void s1ap_update_overload(void)
+{
+  __atomic_store_n(
+    &s1ap_overloaded,
+    itti_is_task_overloaded(TASK_MME_APP) || itti_is_task_overloaded(TASK_S1AP),
+    __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+bool s1ap_is_overloaded(void)
+{
+  return __atomic_load_n(&s1ap_overloaded, __ATOMIC_ACQUIRE);
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_generate_overload_start(const sctp_assoc_id_t assoc_id)
+{
+  uint8_t *buffer_p = NULL;
+  uint32_t length = 0;
+  s1ap_message message = {0};
+  S1ap_OverloadStartIEs_t *overload_start_p = NULL;
+  int rc = RETURNok;
+
+  OAILOG_FUNC_IN(LOG_S1AP);
+  overload_start_p = &message.msg.s1ap_OverloadStartIEs;
+  message.procedureCode = S1ap_ProcedureCode_id_OverloadStart;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  overload_start_p->overloadResponse.present =
+    S1ap_OverloadResponse_PR_overloadAction;
+  overload_start_p->overloadResponse.choice.overloadAction =
+    S1ap_OverloadAction_permit_emergency_sessions_and_mobile_terminated_services_only;
+
+  if (s1ap_mme_encode_pdu(&message, &buffer_p, &length) < 0) {
+    OAILOG_ERROR(LOG_S1AP, "Failed to encode overload start\n");
+    free_s1ap_overloadstart(overload_start_p);
+    OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
+  }
+
+  /*
+   * Non-UE signalling -> stream 0
+   */
+  bstring b = blk2bstr(buffer_p, length);
+  free(buffer_p);
+  rc = s1ap_mme_itti_send_sctp_request(&b, assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+  free_s1ap_overloadstart(overload_start_p);
+  OAILOG_FUNC_RETURN(LOG_S1AP, rc);
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_generate_overload_stop(const sctp_assoc_id_t assoc_id)
+{
+  uint8_t *buffer_p = NULL;
+  uint32_t length = 0;
+  s1ap_message message = {0};
+  S1ap_OverloadStopIEs_t *overload_stop_p = NULL;
+  int rc = RETURNok;
+
+  OAILOG_FUNC_IN(LOG_S1AP);
+  overload_stop_p = &message.msg.s1ap_OverloadStopIEs;
+  message.procedureCode = S1ap_ProcedureCode_id_OverloadStop;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+
+  if (s1ap_mme_encode_pdu(&message, &buffer_p, &length) < 0) {
+    OAILOG_ERROR(LOG_S1AP, "Failed to encode overload stop\n");
+    free_s1ap_overloadstop(overload_stop_p);
+    OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
+  }
+
+  bstring b = blk2bstr(buffer_p, length);
+  free(buffer_p);
+  rc = s1ap_mme_itti_send_sctp_request(&b, assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+  free_s1ap_overloadstop(overload_stop_p);
+  OAILOG_FUNC_RETURN(LOG_S1AP, rc);
+}
+
+//------------------------------------------------------------------------------
+static uint32_t s1ap_mme_encode_congestion_reject(
+  const S1ap_NAS_PDU_t *const nas_pdu,
+  uint8_t *const buffer)
+{
+  uint8_t security_header_type = 0;
+  uint8_t message_type = 0;
+  uint8_t reject_type = 0;
+  uint32_t t3346_min = mme_config.nas_config.t3346_min;
+
+  if (
+    nas_pdu->size < 2 ||
+    (nas_pdu->buf[0] & 0x0f) != EPS_MOBILITY_MANAGEMENT_MESSAGE) {
+    return 0;
+  }
+  /*
+   * A UE sends its initial NAS message in clear or only integrity protected,
+   * the message type then follows the 6 octets of the security header
+   */
+  security_header_type = nas_pdu->buf[0] >> 4;
+  if (security_header_type == SECURITY_HEADER_TYPE_SERVICE_REQUEST) {
+    reject_type = SERVICE_REJECT;
+  } else {
+    if (security_header_type == SECURITY_HEADER_TYPE_NOT_PROTECTED) {
+      message_type = nas_pdu->buf[1];
+    } else if (
+      security_header_type == SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED &&
+      nas_pdu->size >= 8) {
+      message_type = nas_pdu->buf[7];
+    }
+    switch (message_type) {
+      case ATTACH_REQUEST: reject_type = ATTACH_REJECT; break;
+      case TRACKING_AREA_UPDATE_REQUEST:
+        reject_type = TRACKING_AREA_UPDATE_REJECT;
+        break;
+      case EXTENDED_SERVICE_REQUEST: reject_type = SERVICE_REJECT; break;
+      default: return 0;
+    }
+  }
+
+  /*
+   * 3GPP TS 24.301 5.5.1.2.5, 5.5.3.2.5 and 5.6.1.5: EMM cause #22 and the
+   * T3346 value (GPRS timer 2) the UE backs off for
+   */
+  buffer[0] = (SECURITY_HEADER_TYPE_NOT_PROTECTED << 4) |
+              EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  buffer[1] = reject_type;
+  buffer[2] = EMM_CAUSE_CONGESTION;
+  buffer[3] = S1AP_NAS_T3346_VALUE_IEI;
+  buffer[4] = 1;
+  if (t3346_min <= 31) {
+    buffer[5] = (GPRS_TIMER_UNIT_60S << 5) | t3346_min;
+  } else {
+    buffer[5] = (GPRS_TIMER_UNIT_360S << 5) | OAI_MIN(t3346_min / 6, 31);
+  }
+  return S1AP_NAS_CONGESTION_REJECT_LENGTH;
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_generate_congestion_reject(
+  const sctp_assoc_id_t assoc_id,
+  const sctp_stream_id_t stream,
+  const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+  const S1ap_NAS_PDU_t *const nas_pdu)
+{
+  uint8_t nas_buffer[S1AP_NAS_CONGESTION_REJECT_LENGTH];
+  uint32_t nas_length = 0;
+  uint8_t *buffer_p = NULL;
+  uint32_t length = 0;
+  s1ap_message dl_message = {0};
+  s1ap_message release_message = {0};
+  S1ap_DownlinkNASTransportIEs_t *downlinkNasTransport = NULL;
+  S1ap_UEContextReleaseCommandIEs_t *ueContextReleaseCommandIEs_p = NULL;
+  mme_ue_s1ap_id_t mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+  bstring b = NULL;
+
+  OAILOG_FUNC_IN(LOG_S1AP);
+  /*
+   * Both messages are UE associated, they need an MME UE S1AP ID. No UE
+   * context is created for it: the release complete is ignored.
+   */
+  mme_ue_s1ap_id = mme_app_ctx_get_new_ue_id();
+
+  nas_length = s1ap_mme_encode_congestion_reject(nas_pdu, nas_buffer);
+  if (nas_length > 0) {
+    downlinkNasTransport = &dl_message.msg.s1ap_DownlinkNASTransportIEs;
+    dl_message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+    dl_message.direction = S1AP_PDU_PR_initiatingMessage;
+    downlinkNasTransport->mme_ue_s1ap_id = mme_ue_s1ap_id;
+    downlinkNasTransport->eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+    OCTET_STRING_fromBuf(
+      &downlinkNasTransport->nas_pdu, (char *) nas_buffer, nas_length);
+
+    if (s1ap_mme_encode_pdu(&dl_message, &buffer_p, &length) < 0) {
+      OAILOG_ERROR(LOG_S1AP, "Failed to encode congestion reject\n");
+      free_s1ap_downlinknastransport(downlinkNasTransport);
+      OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
+    }
+    b = blk2bstr(buffer_p, length);
+    free(buffer_p);
+    buffer_p = NULL;
+    s1ap_mme_itti_send_sctp_request(&b, assoc_id, stream, mme_ue_s1ap_id);
+    free_s1ap_downlinknastransport(downlinkNasTransport);
+  }
+
+  ueContextReleaseCommandIEs_p =
+    &release_message.msg.s1ap_UEContextReleaseCommandIEs;
+  release_message.procedureCode = S1ap_ProcedureCode_id_UEContextRelease;
+  release_message.direction = S1AP_PDU_PR_initiatingMessage;
+  ueContextReleaseCommandIEs_p->uE_S1AP_IDs.present =
+    S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair;
+  ueContextReleaseCommandIEs_p->uE_S1AP_IDs.choice.uE_S1AP_ID_pair
+    .mME_UE_S1AP_ID = mme_ue_s1ap_id;
+  ueContextReleaseCommandIEs_p->uE_S1AP_IDs.choice.uE_S1AP_ID_pair
+    .eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  ueContextReleaseCommandIEs_p->uE_S1AP_IDs.choice.uE_S1AP_ID_pair
+    .iE_Extensions = NULL;
+  s1ap_mme_set_cause(
+    &ueContextReleaseCommandIEs_p->cause,
+    S1ap_Cause_PR_misc,
+    S1ap_CauseMisc_control_processing_overload);
+
+  if (s1ap_mme_encode_pdu(&release_message, &buffer_p, &length) < 0) {
+    OAILOG_ERROR(LOG_S1AP, "Failed to encode UE context release command\n");
+    free_s1ap_uecontextreleasecommand(ueContextReleaseCommandIEs_p);
+    OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
+  }
+  b = blk2bstr(buffer_p, length);
+  free(buffer_p);
+  int rc =
+    s1ap_mme_itti_send_sctp_request(&b, assoc_id, stream, mme_ue_s1ap_id);
+  free_s1ap_uecontextreleasecommand(ueContextReleaseCommandIEs_p);
+  OAILOG_FUNC_RETURN(LOG_S1AP, rc);
+}
+
+//------------------------------------------------------------------------------
+void s1ap_handle_queue_overload(s1ap_state_t *state)
+{
+  bool overloaded = false;
+  hashtable_ts_cursor_t cursor;
+  hash_key_t enb_key = 0;
+  void *enb_element = NULL;
+
+  OAILOG_FUNC_IN(LOG_S1AP);
+  /*
+   * Indications may be stale or reordered, only the current queue states count
+   */
+  s1ap_update_overload();
+  overloaded = s1ap_is_overloaded();
+  if (overloaded == s1ap_overload_signalled) {
+    OAILOG_FUNC_OUT(LOG_S1AP);
+  }
+  s1ap_overload_signalled = overloaded;
+  if (overloaded) {
+    OAILOG_WARNING(
+      LOG_S1AP,
+      "MME queues above high watermark, sending OVERLOAD START to eNBs\n");
+    increment_counter("s1ap_overload_start", 1, NO_LABELS);
+  } else {
+    OAILOG_INFO(
+      LOG_S1AP,
+      "MME queues below low watermark, sending OVERLOAD STOP to eNBs\n");
+    increment_counter("s1ap_overload_stop", 1, NO_LABELS);
+  }
+  hashtable_ts_cursor_init(&cursor, &state->enbs, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &enb_key, &enb_element)) {
+    const enb_description_t *const enb_ref =
+      (enb_description_t *) enb_element;
+
+    if (enb_ref->s1_state != S1AP_READY) {
+      continue;
+    }
+    if (overloaded) {
+      s1ap_mme_generate_overload_start(enb_ref->sctp_assoc_id);
+    } else {
+      s1ap_mme_generate_overload_stop(enb_ref->sctp_assoc_id);
+    }
+  }
+  OAILOG_FUNC_OUT(LOG_S1AP);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //************************** Management procedures ***************************//
 ////////////////////////////////////////////////////////////////////////////////
@@ -504,6 +783,19 @@ int s1ap_mme_handle_s1_setup_request(
   enb_association->enb_id = enb_id;
   enb_association->default_paging_drx = s1SetupRequest_p->defaultPagingDRX;
 
+  // The TACs of a new S1 Setup Request replace the ones of the previous one
+  s1ap_state_unindex_enb_tacs(state, enb_association);
+  enb_association->nb_supported_tacs = 0;
+  for (int i = 0; i < s1SetupRequest_p->supportedTAs.list.count &&
+                  i < S1AP_MAX_SUPPORTED_TACS;
+       i++) {
+    OCTET_STRING_TO_TAC(
+      &s1SetupRequest_p->supportedTAs.list.array[i]->tAC,
+      enb_association->supported_tacs[i]);
+    enb_association->nb_supported_tacs++;
+  }
+  s1ap_state_index_enb_tacs(state, enb_association);
+
   if (enb_name != NULL) {
     memcpy(
       enb_association->enb_name,
@@ -538,7 +830,7 @@ static int s1ap_generate_s1_setup_response(
   OAILOG_FUNC_IN(LOG_S1AP);
   DevAssert(enb_association != NULL);
   // memset for gcc 4.8.4 instead of {0}, servedGUMMEI.servedPLMNs
-  servedGUMMEI = calloc(1, sizeof *servedGUMMEI);
+  servedGUMMEI = CALLOC(1, sizeof *servedGUMMEI);
   // Generating response
   s1_setup_response_p = &message.msg.s1ap_S1SetupResponseIEs;
   mme_config_read_lock(&mme_config);
@@ -564,7 +856,7 @@ static int s1ap_generate_s1_setup_response(
     }
     if (false == plmn_added) {
       S1ap_PLMNidentity_t *plmn = NULL;
-      plmn = calloc(1, sizeof(*plmn));
+      plmn = CALLOC(1, sizeof(*plmn));
       MCC_MNC_TO_PLMNID(
         mme_config.served_tai.plmn_mcc[i],
         mme_config.served_tai.plmn_mnc[i],
@@ -578,11 +870,11 @@ static int s1ap_generate_s1_setup_response(
     S1ap_MME_Group_ID_t *mme_gid = NULL;
     S1ap_MME_Code_t *mmec = NULL;
 
-    mme_gid = calloc(1, sizeof(*mme_gid));
+    mme_gid = CALLOC(1, sizeof(*mme_gid));
     INT16_TO_OCTET_STRING(mme_config.gummei.gummei[i].mme_gid, mme_gid);
     ASN_SEQUENCE_ADD(&servedGUMMEI->servedGroupIDs.list, mme_gid);
 
-    mmec = calloc(1, sizeof(*mmec));
+    mmec = CALLOC(1, sizeof(*mmec));
     INT8_TO_OCTET_STRING(mme_config.gummei.gummei[i].mme_code, mmec);
     ASN_SEQUENCE_ADD(&servedGUMMEI->servedMMECs.list, mmec);
   }
@@ -620,6 +912,13 @@ static int s1ap_generate_s1_setup_response(
 
   free_s1ap_s1setupresponse(s1_setup_response_p);
 
+  /*
+   * An eNB joining during an overload is told about it straight away
+   */
+  if (enc_rval >= 0 && rc == RETURNok && s1ap_overload_signalled) {
+    s1ap_mme_generate_overload_start(enb_association->sctp_assoc_id);
+  }
+
   OAILOG_FUNC_RETURN(LOG_S1AP, rc);
 }
 
@@ -1645,10 +1944,7 @@ int s1ap_mme_handle_path_switch_request(
     s1ap_remove_ue(state, ue_ref_p);
 
     /* Mapping between mme_ue_s1ap_id, assoc_id and enb_ue_s1ap_id */
-    hashtable_rc_t h_rc = hashtable_ts_insert(
-      &state->mmeid2associd,
-      (const hash_key_t) new_ue_ref_p->mme_ue_s1ap_id,
-      (void *) (uintptr_t) assoc_id);
+    hashtable_rc_t h_rc = s1ap_state_associate_ue_mmeid(state, new_ue_ref_p);
     OAILOG_DEBUG(
       LOG_S1AP,
       "Associated sctp_assoc_id %d, enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
@@ -1766,36 +2062,6 @@ static bool s1ap_send_enb_deregistered_ind(
   return false;
 }
 
-typedef struct arg_s1ap_construct_enb_reset_req_s {
-  uint8_t current_ue_index;
-  MessageDef *msg;
-} arg_s1ap_construct_enb_reset_req_t;
-
-static bool construct_s1ap_mme_full_reset_req(
-  const hash_key_t keyP,
-  void *const dataP,
-  void *argP,
-  void **resultP)
-{
-  arg_s1ap_construct_enb_reset_req_t *arg = argP;
-  ue_description_t *const ue_ref = dataP;
-
-  uint32_t i = arg->current_ue_index;
-  if (ue_ref) {
-    S1AP_ENB_INITIATED_RESET_REQ(arg->msg).ue_to_reset_list[i].mme_ue_s1ap_id =
-      ue_ref->mme_ue_s1ap_id;
-    S1AP_ENB_INITIATED_RESET_REQ(arg->msg).ue_to_reset_list[i].enb_ue_s1ap_id =
-      ue_ref->enb_ue_s1ap_id;
-  } else {
-    OAILOG_TRACE(LOG_S1AP, "No valid UE provided in callback: %p\n", ue_ref);
-    S1AP_ENB_INITIATED_RESET_REQ(arg->msg).ue_to_reset_list[i].mme_ue_s1ap_id =
-      INVALID_MME_UE_S1AP_ID;
-  }
-  arg->current_ue_index++;
-
-  return false;
-}
-
 //------------------------------------------------------------------------------
 int s1ap_handle_sctp_disconnection(
   s1ap_state_t *state,
@@ -2194,7 +2460,9 @@ int s1ap_mme_handle_enb_reset(
   enb_description_t *enb_association = NULL;
   s1ap_reset_type_t s1ap_reset_type;
   S1ap_UE_associatedLogicalS1_ConnectionItem_t *s1_sig_conn_id_p = NULL;
-  arg_s1ap_construct_enb_reset_req_t arg = {0};
+  hashtable_ts_cursor_t cursor;
+  hash_key_t ue_key = 0;
+  void *ue_element = NULL;
   uint32_t i = 0;
   int rc = RETURNok;
   mme_ue_s1ap_id_t mme_ue_s1ap_id;
@@ -2288,13 +2556,19 @@ int s1ap_mme_handle_enb_reset(
 
       DevAssert(reset_req->ue_to_reset_list != NULL);
 
-      arg.msg = msg;
-      arg.current_ue_index = 0;
-      hashtable_ts_apply_callback_on_elements(
-        &enb_association->ue_coll,
-        construct_s1ap_mme_full_reset_req,
-        &arg,
-        NULL);
+      hashtable_ts_cursor_init(
+        &cursor, &enb_association->ue_coll, HASH_TABLE_CURSOR_STRIPED);
+      for (i = 0; (i < reset_req->num_ue) &&
+                  hashtable_ts_cursor_next(&cursor, &ue_key, &ue_element);
+           i++) {
+        ue_ref_p = (ue_description_t *) ue_element;
+        reset_req->ue_to_reset_list[i].mme_ue_s1ap_id =
+          ue_ref_p->mme_ue_s1ap_id;
+        reset_req->ue_to_reset_list[i].enb_ue_s1ap_id =
+          ue_ref_p->enb_ue_s1ap_id;
+      }
+      hashtable_ts_cursor_end(&cursor);
+      break;
 
     case RESET_PARTIAL:
       // Partial Reset
@@ -2481,14 +2755,67 @@ void s1ap_enb_assoc_clean_up_timer_expiry(
 }
 //------------------------------------------------------------------------------
 
-int s1ap_handle_paging_request(const itti_s1ap_paging_request_t *paging_request)
+/* Paging histogram bucket boundaries, preceded by their count */
+#define S1AP_PAGING_MESSAGES_BOUNDARIES                                        \
+  (size_t) 7, 1., 2., 4., 8., 16., 64., 256.
+#define S1AP_PAGING_ENCODE_US_BOUNDARIES                                       \
+  (size_t) 6, 5., 10., 20., 50., 100., 500.
+
+// Sends the paging PDU on the stream 0 of the association, taking the payload
+static int s1ap_send_paging(
+  bstring *payload,
+  sctp_assoc_id_t assoc_id,
+  const itti_s1ap_paging_request_t *paging_request)
+{
+  int rc = s1ap_mme_itti_send_sctp_request(
+    payload,
+    assoc_id,
+    0,  // Stream id 0 for non UE related
+        // S1AP message
+    0); // mme_ue_s1ap_id 0 because UE
+        // in idle
+  if (rc != RETURNok) {
+    OAILOG_ERROR(
+      LOG_S1AP,
+      "Failed to send paging message over sctp assoc %u for IMSI %s\n",
+      assoc_id,
+      paging_request->imsi);
+  } else {
+    OAILOG_INFO(
+      LOG_S1AP,
+      "Sent paging message over sctp assoc %u for IMSI %s\n",
+      assoc_id,
+      paging_request->imsi);
+  }
+  return rc;
+}
+
+// Whether the eNB serves one of the TACs, it has already been paged for them
+static bool s1ap_enb_serves_tacs(
+  const enb_description_t *enb,
+  const tac_t *tacs,
+  int nb_tacs)
+{
+  for (int i = 0; i < nb_tacs; i++) {
+    for (int j = 0; j < enb->nb_supported_tacs; j++) {
+      if (enb->supported_tacs[j] == tacs[i]) return true;
+    }
+  }
+  return false;
+}
+
+int s1ap_handle_paging_request(
+  s1ap_state_t *state,
+  const itti_s1ap_paging_request_t *paging_request)
 {
   OAILOG_FUNC_IN(LOG_S1AP);
   DevAssert(paging_request != NULL);
-  // ue_description_t* ue_ref_p = NULL;
   S1ap_PagingIEs_t *paging_message = NULL;
   s1ap_message message = {0};
   imsi64_t imsi64;
+  tac_t tacs[S1AP_MAX_SUPPORTED_TACS];
+  int nb_tacs = 0;
+  struct timespec encode_start, encode_end;
 
   IMSI_STRING_TO_IMSI64((char *) paging_request->imsi, &imsi64);
   paging_message = &message.msg.s1ap_PagingIEs;
@@ -2520,11 +2847,11 @@ int s1ap_handle_paging_request(const itti_s1ap_paging_request_t *paging_request)
       paging_request->imsi_length,
       &paging_message->uePagingID.choice.iMSI);
   }
-  // Set TAI list
+  // Set TAI list, the UEs are given the TAI list served by the MME at attach
   mme_config_read_lock(&mme_config);
 
   for (int i = 0; i < mme_config.served_tai.nb_tai; i++) {
-    S1ap_TAIItem_t *tai_item = calloc(1, sizeof(S1ap_TAIItem_t));
+    S1ap_TAIItem_t *tai_item = CALLOC(1, sizeof(S1ap_TAIItem_t));
     MCC_MNC_TO_PLMNID(
       mme_config.served_tai.plmn_mcc[i],
       mme_config.served_tai.plmn_mnc[i],
@@ -2534,6 +2861,9 @@ int s1ap_handle_paging_request(const itti_s1ap_paging_request_t *paging_request)
     tai_item->iE_Extensions = NULL;
     tai_item->tAI.iE_Extensions = NULL;
     ASN_SEQUENCE_ADD(&paging_message->taiList, tai_item);
+    if (nb_tacs < S1AP_MAX_SUPPORTED_TACS) {
+      tacs[nb_tacs++] = mme_config.served_tai.tac[i];
+    }
   }
 
   mme_config_unlock(&mme_config);
@@ -2544,40 +2874,85 @@ int s1ap_handle_paging_request(const itti_s1ap_paging_request_t *paging_request)
   message.procedureCode = S1ap_ProcedureCode_id_Paging;
   message.direction = S1AP_PDU_PR_initiatingMessage;
 
-  // Encode message
+  // Encode message, once for all the eNBs paged
+  clock_gettime(CLOCK_MONOTONIC, &encode_start);
   int enc_rval = s1ap_mme_encode_pdu(&message, &buffer, &length);
+  clock_gettime(CLOCK_MONOTONIC, &encode_end);
+  free_s1ap_paging(paging_message);
   if (enc_rval < 0) {
     OAILOG_ERROR(
       LOG_S1AP,
       "Failed to encode paging message for IMSI %s\n",
       paging_request->imsi);
-    free_s1ap_paging(paging_message);
-    return RETURNerror;
+    increment_counter(
+      "s1ap_paging", 1, 2, "result", "failure", "cause", "encode");
+    OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
   }
+  observe_histogram(
+    "s1ap_paging_encode_us",
+    (encode_end.tv_sec - encode_start.tv_sec) * 1e6 +
+      (encode_end.tv_nsec - encode_start.tv_nsec) / 1e3,
+    NO_LABELS,
+    S1AP_PAGING_ENCODE_US_BOUNDARIES);
 
   bstring b = blk2bstr(buffer, length);
   free(buffer);
 
-  // Send message
-  int rc = s1ap_mme_itti_send_sctp_request(
-    &b,
-    paging_request->sctp_assoc_id,
-    0,  // Stream id 0 for non UE related
-        // S1AP message
-    0); // mme_ue_s1ap_id 0 because UE
-        // in idle
-  if (rc != RETURNok) {
-    OAILOG_ERROR(
-      LOG_S1AP,
-      "Failed to send paging message over sctp for IMSI %s\n",
-      paging_request->imsi);
+  /*
+   * Page the READY eNBs serving a TAC of the list and the last eNB of the UE,
+   * whose TACs are not indexed if it was set up before a stateless restart.
+   * Each SCTP_DATA_REQ owns its payload, every eNB but the last one is sent a
+   * copy of the PDU.
+   */
+  sctp_assoc_id_t last_assoc_id = paging_request->sctp_assoc_id;
+  int nb_messages = 0;
+  int rc = RETURNok;
+
+  for (int i = 0; i < nb_tacs; i++) {
+    const s1ap_tac_enbs_t *tac_enbs = s1ap_state_get_tac_enbs(state, tacs[i]);
+
+    for (uint32_t j = 0; tac_enbs && j < tac_enbs->nb_enbs; j++) {
+      enb_description_t *enb = NULL;
+      bstring copy = NULL;
+
+      // not through s1ap_state_get_enb(), paging does not change the eNB
+      hashtable_ts_get(
+        &state->enbs,
+        (const hash_key_t) tac_enbs->assoc_ids[j],
+        (void **) &enb);
+      if (
+        !enb || enb->s1_state != S1AP_READY ||
+        enb->sctp_assoc_id == paging_request->sctp_assoc_id ||
+        s1ap_enb_serves_tacs(enb, tacs, i)) {
+        continue;
+      }
+      copy = bstrcpy(b);
+      if (!copy || s1ap_send_paging(&copy, last_assoc_id, paging_request)) {
+        bdestroy_wrapper(&copy);
+        rc = RETURNerror;
+      } else {
+        nb_messages++;
+      }
+      last_assoc_id = enb->sctp_assoc_id;
+    }
+  }
+  if (s1ap_send_paging(&b, last_assoc_id, paging_request) != RETURNok) {
+    rc = RETURNerror;
   } else {
-    OAILOG_INFO(
-      LOG_S1AP,
-      "Sent paging message over sctp for IMSI %s\n",
-      paging_request->imsi);
+    nb_messages++;
+  }
+
+  observe_histogram(
+    "s1ap_paging_messages",
+    nb_messages,
+    NO_LABELS,
+    S1AP_PAGING_MESSAGES_BOUNDARIES);
+  if (rc == RETURNok) {
+    increment_counter("s1ap_paging", 1, 1, "result", "success");
+  } else {
+    increment_counter(
+      "s1ap_paging", 1, 2, "result", "failure", "cause", "sctp");
   }
-  free_s1ap_paging(paging_message);
   OAILOG_FUNC_RETURN(LOG_S1AP, rc);
 }
 
@@ -2592,11 +2967,12 @@ int s1ap_mme_handle_enb_configuration_transfer(
   uint8_t *enb_id_buf = NULL;
   enb_description_t *enb_association = NULL;
   enb_description_t *target_enb_association = NULL;
-  hashtable_element_array_t *enb_array = NULL;
+  hashtable_ts_cursor_t cursor;
+  hash_key_t enb_key = 0;
+  void *enb_element = NULL;
   uint32_t target_enb_id = 0;
   uint8_t *buffer = NULL;
   uint32_t length = 0;
-  uint32_t idx = 0;
   int rc = RETURNok;
 
   OAILOG_FUNC_IN(LOG_S1AP);
@@ -2645,20 +3021,18 @@ int s1ap_mme_handle_enb_configuration_transfer(
     }
   }
   // retrieve enb_description using hash table and match target_enb_id
-  if ((enb_array = hashtable_ts_get_elements(&state->enbs)) != NULL) {
-    for (idx = 0; idx < enb_array->num_elements; idx++) {
-       target_enb_association =
-          (enb_description_t *)(uintptr_t) enb_array->elements[idx];
-       if (target_enb_association->enb_id == target_enb_id) {
-          break;
-       }
-    }
-    if (target_enb_association->enb_id != target_enb_id) {
-       OAILOG_ERROR(
-         LOG_S1AP, "No eNB for enb_id %d\n", target_enb_id);
-       OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
+  hashtable_ts_cursor_init(&cursor, &state->enbs, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &enb_key, &enb_element)) {
+    if (((enb_description_t *) enb_element)->enb_id == target_enb_id) {
+      target_enb_association = (enb_description_t *) enb_element;
+      hashtable_ts_cursor_end(&cursor);
+      break;
     }
   }
+  if (!target_enb_association) {
+    OAILOG_ERROR(LOG_S1AP, "No eNB for enb_id %d\n", target_enb_id);
+    OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
+  }
 
   message->procedureCode = S1ap_ProcedureCode_id_MMEConfigurationTransfer;
   message->direction = S1AP_PDU_PR_initiatingMessage;
@@ -130,6 +130,48 @@ int s1ap_mme_generate_s1_setup_failure(
   const long cause_value,
   const long time_to_wait);
 
+/** \brief Ask an eNB to reduce the signalling load towards the MME.
+ * Only mobile terminated services and emergency sessions stay permitted.
+ \param assoc_id SCTP association ID of the eNB
+ @returns int
+ **/
+int s1ap_mme_generate_overload_start(const sctp_assoc_id_t assoc_id);
+
+/** \brief Let an eNB resume normal operation towards the MME.
+ \param assoc_id SCTP association ID of the eNB
+ @returns int
+ **/
+int s1ap_mme_generate_overload_stop(const sctp_assoc_id_t assoc_id);
+
+/** \brief Reject the initial NAS message of a UE while the MME is in overload
+ * control, with EMM cause #22 "congestion" and a T3346 back-off, then release
+ * the UE associated signalling connection. No UE context is created.
+ \param assoc_id SCTP association ID of the eNB
+ \param stream SCTP stream the initial UE message was received on
+ \param enb_ue_s1ap_id UE S1AP ID allocated by the eNB
+ \param nas_pdu NAS PDU of the initial UE message
+ @returns int
+ **/
+int s1ap_mme_generate_congestion_reject(
+  const sctp_assoc_id_t assoc_id,
+  const sctp_stream_id_t stream,
+  const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+  const S1ap_NAS_PDU_t *const nas_pdu);
+
+/** \brief Start or stop the MME overload control towards all the eNBs,
+ * according to the overload state of the MME_APP and S1AP queues.
+ **/
+void s1ap_handle_queue_overload(s1ap_state_t *state);
+
+/** \brief Refresh the overload state from the MME_APP and S1AP queues.
+ * May be called from any thread.
+ **/
+void s1ap_update_overload(void);
+
+/** \brief Return whether the MME is in overload control.
+ **/
+bool s1ap_is_overloaded(void);
+
 int s1ap_mme_handle_erab_setup_response(
   s1ap_state_t *state,
   const sctp_assoc_id_t assoc_id,
@@ -170,6 +212,7 @@ void s1ap_enb_assoc_clean_up_timer_expiry(
   enb_description_t *enb_ref_p);
 
 int s1ap_handle_paging_request(
+  s1ap_state_t *state,
   const itti_s1ap_paging_request_t *paging_request);
 
 int s1ap_mme_handle_ue_context_modification_response(
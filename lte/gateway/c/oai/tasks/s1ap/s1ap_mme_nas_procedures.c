@@ -114,6 +114,30 @@ int s1ap_mme_handle_initial_ue_message(
     enb_ue_s1ap_id);
   ue_ref = s1ap_state_get_ue_enbid(state, eNB_ref, enb_ue_s1ap_id);
 
+  /*
+   * While in overload control, only admit the access types the OVERLOAD START
+   * sent to the eNBs still permits
+   */
+  if (
+    ue_ref == NULL && s1ap_is_overloaded() &&
+    initialUEMessage_p->rrC_Establishment_Cause !=
+      S1ap_RRC_Establishment_Cause_emergency &&
+    initialUEMessage_p->rrC_Establishment_Cause !=
+      S1ap_RRC_Establishment_Cause_highPriorityAccess &&
+    initialUEMessage_p->rrC_Establishment_Cause !=
+      S1ap_RRC_Establishment_Cause_mt_Access) {
+    OAILOG_WARNING(
+      LOG_S1AP,
+      "MME overloaded, rejecting Initial UE message with eNB UE S1AP ID: "
+      ENB_UE_S1AP_ID_FMT " RRC establishment cause %ld\n",
+      enb_ue_s1ap_id,
+      initialUEMessage_p->rrC_Establishment_Cause);
+    increment_counter("initial_ue_message_rejected", 1, 1, "cause", "overload");
+    s1ap_mme_generate_congestion_reject(
+      assoc_id, stream, enb_ue_s1ap_id, &initialUEMessage_p->nas_pdu);
+    OAILOG_FUNC_RETURN(LOG_S1AP, RETURNok);
+  }
+
   if (ue_ref == NULL) {
     tai_t tai = {0};
     gummei_t gummei = {
@@ -401,30 +425,10 @@ int s1ap_generate_downlink_nas_transport(
   ue_description_t *ue_ref = NULL;
   uint8_t *buffer_p = NULL;
   uint32_t length = 0;
-  void *id = NULL;
 
   OAILOG_FUNC_IN(LOG_S1AP);
 
-  // Try to retrieve SCTP assoication id using mme_ue_s1ap_id
-  if (
-    HASH_TABLE_OK ==
-    hashtable_ts_get(
-      &state->mmeid2associd, (const hash_key_t) ue_id, (void **) &id)) {
-    sctp_assoc_id_t sctp_assoc_id = (sctp_assoc_id_t)(uintptr_t) id;
-    enb_description_t *enb_ref = s1ap_state_get_enb(state, sctp_assoc_id);
-    if (enb_ref) {
-      ue_ref = s1ap_state_get_ue_enbid(state, enb_ref, enb_ue_s1ap_id);
-    } else {
-      OAILOG_ERROR(
-        LOG_S1AP, "No eNB for SCTP association id %d \n", sctp_assoc_id);
-      OAILOG_FUNC_RETURN(LOG_S1AP, RETURNerror);
-    }
-  }
-  // TODO remove soon:
-  if (!ue_ref) {
-    ue_ref = s1ap_state_get_ue_mmeid(state, ue_id);
-  }
-  // finally!
+  ue_ref = s1ap_state_get_ue_mmeid(state, ue_id);
   if (!ue_ref) {
     /*
      * If the UE-associated logical S1-connection is not established,
@@ -504,24 +508,9 @@ int s1ap_generate_s1ap_e_rab_setup_req(
   ue_description_t *ue_ref = NULL;
   uint8_t *buffer_p = NULL;
   uint32_t length = 0;
-  void *id = NULL;
-  const enb_ue_s1ap_id_t enb_ue_s1ap_id = e_rab_setup_req->enb_ue_s1ap_id;
   const mme_ue_s1ap_id_t ue_id = e_rab_setup_req->mme_ue_s1ap_id;
 
-  hashtable_ts_get(
-    &state->mmeid2associd, (const hash_key_t) ue_id, (void **) &id);
-  if (id) {
-    sctp_assoc_id_t sctp_assoc_id = (sctp_assoc_id_t)(uintptr_t) id;
-    enb_description_t *enb_ref = s1ap_state_get_enb(state, sctp_assoc_id);
-    if (enb_ref) {
-      ue_ref = s1ap_state_get_ue_enbid(state, enb_ref, enb_ue_s1ap_id);
-    }
-  }
-  // TODO remove soon:
-  if (!ue_ref) {
-    ue_ref = s1ap_state_get_ue_mmeid(state, ue_id);
-  }
-  // finally!
+  ue_ref = s1ap_state_get_ue_mmeid(state, ue_id);
   if (!ue_ref) {
     /*
      * If the UE-associated logical S1-connection is not established,
@@ -783,7 +772,7 @@ void s1ap_handle_conn_est_cnf(
 
   for (int item = 0; item < conn_est_cnf_pP->no_of_e_rabs; item++) {
     // Free happens in free_s1ap_initialcontextsetuprequest
-    e_RABToBeSetup[item] = calloc(1, sizeof *e_RABToBeSetup[item]);
+    e_RABToBeSetup[item] = CALLOC(1, sizeof *e_RABToBeSetup[item]);
     memset((void *) e_RABToBeSetup[item], 0, sizeof(*e_RABToBeSetup[item]));
     e_RABToBeSetup[item]->e_RAB_ID = conn_est_cnf_pP->e_rab_id[item]; //5;
     e_RABToBeSetup[item]->e_RABlevelQoSParameters.qCI =
@@ -791,9 +780,9 @@ void s1ap_handle_conn_est_cnf(
 
     if (conn_est_cnf_pP->nas_pdu[item] != NULL) {
       // NAS PDU is optional in rab_setup
-      nas_pdu = calloc(1, sizeof *nas_pdu);
+      nas_pdu = CALLOC(1, sizeof *nas_pdu);
       nas_pdu->size = blength(conn_est_cnf_pP->nas_pdu[item]);
-      nas_pdu->buf = malloc(blength(conn_est_cnf_pP->nas_pdu[item]));
+      nas_pdu->buf = MALLOC(blength(conn_est_cnf_pP->nas_pdu[item]));
       memcpy(
         nas_pdu->buf,
         (void *) conn_est_cnf_pP->nas_pdu[item]->data,
@@ -818,7 +807,7 @@ void s1ap_handle_conn_est_cnf(
     INT32_TO_OCTET_STRING(
       conn_est_cnf_pP->gtp_teid[item], &(e_RABToBeSetup[item]->gTP_TEID));
     // S-GW IP address(es) for user-plane
-    e_RABToBeSetup[item]->transportLayerAddress.buf = calloc(
+    e_RABToBeSetup[item]->transportLayerAddress.buf = CALLOC(
       blength(conn_est_cnf_pP->transport_layer_address[item]), sizeof(uint8_t));
     memcpy(
       e_RABToBeSetup[item]->transportLayerAddress.buf,
@@ -842,7 +831,7 @@ void s1ap_handle_conn_est_cnf(
   }
 
   initialContextSetupRequest_p->ueSecurityCapabilities.encryptionAlgorithms
-    .buf = calloc(2, sizeof(uint8_t));
+    .buf = CALLOC(2, sizeof(uint8_t));
   memcpy(
     initialContextSetupRequest_p->ueSecurityCapabilities.encryptionAlgorithms
       .buf,
@@ -854,7 +843,7 @@ void s1ap_handle_conn_est_cnf(
   initialContextSetupRequest_p->ueSecurityCapabilities.encryptionAlgorithms
     .bits_unused = 0;
   initialContextSetupRequest_p->ueSecurityCapabilities
-    .integrityProtectionAlgorithms.buf = calloc(2, sizeof(uint8_t));
+    .integrityProtectionAlgorithms.buf = CALLOC(2, sizeof(uint8_t));
   memcpy(
     initialContextSetupRequest_p->ueSecurityCapabilities
       .integrityProtectionAlgorithms.buf,
@@ -875,7 +864,7 @@ void s1ap_handle_conn_est_cnf(
 
   if (conn_est_cnf_pP->kenb) {
     initialContextSetupRequest_p->securityKey.buf =
-      calloc(AUTH_KENB_SIZE, sizeof(uint8_t));
+      CALLOC(AUTH_KENB_SIZE, sizeof(uint8_t));
     memcpy(
       initialContextSetupRequest_p->securityKey.buf,
       conn_est_cnf_pP->kenb,
@@ -933,10 +922,7 @@ void s1ap_handle_mme_ue_id_notification(
       s1ap_state_get_ue_enbid(state, enb_ref, enb_ue_s1ap_id);
     if (ue_ref) {
       ue_ref->mme_ue_s1ap_id = mme_ue_s1ap_id;
-      hashtable_rc_t h_rc = hashtable_ts_insert(
-        &state->mmeid2associd,
-        (const hash_key_t) mme_ue_s1ap_id,
-        (void *) (uintptr_t) sctp_assoc_id);
+      hashtable_rc_t h_rc = s1ap_state_associate_ue_mmeid(state, ue_ref);
       OAILOG_DEBUG(
         LOG_S1AP,
         "Associated  sctp_assoc_id %d, enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT
@@ -968,22 +954,9 @@ int s1ap_generate_s1ap_e_rab_rel_cmd(
   ue_description_t *ue_ref = NULL;
   uint8_t *buffer_p = NULL;
   uint32_t length = 0;
-  void *id = NULL;
-  const enb_ue_s1ap_id_t enb_ue_s1ap_id = e_rab_rel_cmd->enb_ue_s1ap_id;
   const mme_ue_s1ap_id_t ue_id = e_rab_rel_cmd->mme_ue_s1ap_id;
 
-  hashtable_ts_get(
-    &state->mmeid2associd, (const hash_key_t) ue_id, (void **) &id);
-  if (id) {
-    sctp_assoc_id_t sctp_assoc_id = (sctp_assoc_id_t)(uintptr_t) id;
-    enb_description_t *enb_ref = s1ap_state_get_enb(state, sctp_assoc_id);
-    if (enb_ref) {
-      ue_ref = s1ap_state_get_ue_enbid(state, enb_ref, enb_ue_s1ap_id);
-    }
-  }
-  if (!ue_ref) {
-    ue_ref = s1ap_state_get_ue_mmeid(state, ue_id);
-  }
+  ue_ref = s1ap_state_get_ue_mmeid(state, ue_id);
   if (!ue_ref) {
     /*
      * If the UE-associated logical S1-connection is not established,
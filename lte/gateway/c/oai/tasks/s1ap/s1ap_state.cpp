@@ -25,6 +25,12 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <cpp_redis/cpp_redis>
 
@@ -38,6 +44,9 @@ extern "C" {
 #include "assertions.h"
 #include "common_defs.h"
 #include "dynamic_memory_check.h"
+#include "intertask_interface.h"
+#include "log.h"
+#include "timer.h"
 
 #include "mme_config.h"
 }
@@ -46,7 +55,15 @@ using magma::lte::gateway::s1ap::EnbDescription;
 using magma::lte::gateway::s1ap::S1apState;
 using magma::lte::gateway::s1ap::UeDescription;
 
+// whole state, as written before the per eNB and per UE hashes
 #define S1AP_STATE_TABLE "s1ap_state"
+// one field per eNB, per UE and per mme_ue_s1ap_id of the index
+#define S1AP_STATE_ENBS_TABLE "s1ap_state_enbs"
+#define S1AP_STATE_UES_TABLE "s1ap_state_ues"
+#define S1AP_STATE_MMEID2ASSOCID_TABLE "s1ap_state_mmeid2associd"
+
+// associations of a new tac2enbs entry, doubled when it is full
+#define S1AP_TAC_ENBS_MIN_SIZE 4
 
 s1ap_state_t *s1ap_state_new(void);
 void s1ap_state_free(s1ap_state_t *state);
@@ -54,7 +71,6 @@ void s1ap_state_free(s1ap_state_t *state);
 s1ap_state_t *s1ap_state_from_redis(void);
 void s1ap_state_to_redis(s1ap_state_t *state);
 
-void state2proto(S1apState *proto, s1ap_state_t *state);
 void proto2state(s1ap_state_t *state, S1apState *proto);
 
 void enb2proto(EnbDescription *proto, enb_description_t *enb);
@@ -68,16 +84,59 @@ bool s1ap_enb_compare_by_enb_id_cb(
   void *const elementP,
   void *parameterP,
   void **unused_res);
-bool s1ap_enb_find_ue_by_mme_ue_id_cb(
-  __attribute__((unused)) const hash_key_t keyP,
-  void *const elementP,
-  void *parameterP,
-  void **resultP);
 
 bool in_use = false;
 std::shared_ptr<cpp_redis::client> client = nullptr;
 s1ap_state_t *state_cache = NULL;
 
+/*
+ * Keys written to redis on the next commit, or deleted from it when they are
+ * no longer in the state. The UEs are keyed by s1ap_ue_id().
+ */
+static std::unordered_set<sctp_assoc_id_t> dirty_enbs;
+static std::unordered_set<uintptr_t> dirty_ues;
+static std::unordered_set<mme_ue_s1ap_id_t> dirty_mmeids;
+// the whole state key is deleted once it has been written to the hashes
+static bool dirty_legacy_state = false;
+
+static uint64_t last_commit_ms = 0;
+static long commit_timer_id = S1AP_TIMER_INACTIVE_ID;
+static bool commit_timer_expired = false;
+
+// Value of the mmeid2ueid index, both ids of the UE on its eNB association
+static inline void *s1ap_ue_id(
+  sctp_assoc_id_t assoc_id,
+  enb_ue_s1ap_id_t enb_ue_s1ap_id)
+{
+  return (void *) (((uintptr_t) assoc_id << 32) | enb_ue_s1ap_id);
+}
+
+static inline sctp_assoc_id_t s1ap_ue_id_assoc_id(void *ue_id)
+{
+  return (sctp_assoc_id_t)((uintptr_t) ue_id >> 32);
+}
+
+static inline enb_ue_s1ap_id_t s1ap_ue_id_enb_ue_s1ap_id(void *ue_id)
+{
+  return (enb_ue_s1ap_id_t)((uintptr_t) ue_id & 0xffffffff);
+}
+
+static inline void s1ap_state_dirty_ue_id(
+  sctp_assoc_id_t assoc_id,
+  enb_ue_s1ap_id_t enb_ue_s1ap_id)
+{
+  if (mme_config.use_stateless) {
+    dirty_ues.insert((uintptr_t) s1ap_ue_id(assoc_id, enb_ue_s1ap_id));
+  }
+}
+
+static inline void s1ap_state_dirty_mmeid(mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  if (mme_config.use_stateless) {
+    dirty_mmeids.insert(mme_ue_s1ap_id);
+  }
+}
+
 int s1ap_state_init(void)
 {
   in_use = false;
@@ -105,6 +164,13 @@ void s1ap_state_exit(void)
 {
   AssertFatal(!in_use, "Exiting without committing s1ap state");
 
+  // commit what is left of the commit window before disconnecting
+  if (
+    mme_config.use_stateless && client != nullptr && client->is_connected()) {
+    s1ap_state_to_redis(state_cache);
+    client->sync_commit();
+  }
+
   s1ap_state_free(state_cache);
 
   client = nullptr;
@@ -121,13 +187,63 @@ s1ap_state_t *s1ap_state_get(void)
   return state_cache;
 }
 
+static uint64_t s1ap_state_now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * With a commit window, the first put after a window commits at once and the
+ * following ones leave their descriptions dirty until the window ends, so a
+ * description changed by several messages is written once. The commit timer
+ * makes sure the end of a burst is committed without waiting for a message.
+ */
+static bool s1ap_state_commit_due(void)
+{
+  uint32_t window_ms = mme_config.s1ap_config.state_commit_window_ms;
+  uint64_t now_ms, left_ms;
+  s1ap_timer_arg_t timer_arg = {S1AP_STATE_TIMER, 0};
+
+  if (
+    dirty_enbs.empty() && dirty_ues.empty() && dirty_mmeids.empty() &&
+    !dirty_legacy_state) {
+    return false;
+  }
+  if (window_ms == 0 || commit_timer_expired) return true;
+
+  now_ms = s1ap_state_now_ms();
+  if (now_ms - last_commit_ms >= window_ms) return true;
+
+  if (commit_timer_id == S1AP_TIMER_INACTIVE_ID) {
+    left_ms = window_ms - (now_ms - last_commit_ms);
+    if (
+      timer_setup(
+        left_ms / 1000,
+        (left_ms % 1000) * 1000,
+        TASK_S1AP,
+        INSTANCE_DEFAULT,
+        TIMER_ONE_SHOT,
+        (void *) &timer_arg,
+        sizeof(timer_arg),
+        &commit_timer_id) < 0) {
+      OAILOG_ERROR(LOG_S1AP, "Failed to start the s1ap state commit timer\n");
+      commit_timer_id = S1AP_TIMER_INACTIVE_ID;
+      return true;
+    }
+  }
+  return false;
+}
+
 void s1ap_state_put(s1ap_state_t *state)
 {
   AssertFatal(in_use, "Tried to put s1ap_state while it was not in use");
 
   state_cache = state;
 
-  if (mme_config.use_stateless) {
+  if (mme_config.use_stateless && s1ap_state_commit_due()) {
     s1ap_state_to_redis(state);
   }
 
@@ -141,6 +257,8 @@ enb_description_t *s1ap_state_get_enb(
   enb_description_t *enb = NULL;
 
   hashtable_ts_get(&state->enbs, (const hash_key_t) assoc_id, (void **) &enb);
+  // a miss is marked too, the caller may be about to add the eNB
+  if (mme_config.use_stateless) dirty_enbs.insert(assoc_id);
 
   return enb;
 }
@@ -152,8 +270,12 @@ ue_description_t *s1ap_state_get_ue_enbid(
 {
   ue_description_t *ue = NULL;
 
-  hashtable_ts_get(
-    &enb->ue_coll, (const hash_key_t) enb_ue_s1ap_id, (void **) &ue);
+  if (
+    hashtable_ts_get(
+      &enb->ue_coll, (const hash_key_t) enb_ue_s1ap_id, (void **) &ue) ==
+    HASH_TABLE_OK) {
+    s1ap_state_dirty_ue_id(enb->sctp_assoc_id, enb_ue_s1ap_id);
+  }
 
   return ue;
 }
@@ -162,17 +284,156 @@ ue_description_t *s1ap_state_get_ue_mmeid(
   s1ap_state_t *state,
   mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
+  enb_description_t *enb = NULL;
   ue_description_t *ue = NULL;
+  void *ue_id = NULL;
 
-  hashtable_ts_apply_callback_on_elements(
+  if (
+    hashtable_ts_get(
+      &state->mmeid2ueid, (const hash_key_t) mme_ue_s1ap_id, &ue_id) !=
+    HASH_TABLE_OK) {
+    return NULL;
+  }
+  // only the UE is marked, its eNB is not changed through it
+  hashtable_ts_get(
     &state->enbs,
-    s1ap_enb_find_ue_by_mme_ue_id_cb,
-    &mme_ue_s1ap_id,
-    (void **) &ue);
+    (const hash_key_t) s1ap_ue_id_assoc_id(ue_id),
+    (void **) &enb);
+  if (enb) {
+    ue = s1ap_state_get_ue_enbid(state, enb, s1ap_ue_id_enb_ue_s1ap_id(ue_id));
+  }
+  // the UE description may have been replaced since it was indexed
+  if (ue && ue->mme_ue_s1ap_id != mme_ue_s1ap_id) {
+    ue = NULL;
+  }
 
   return ue;
 }
 
+hashtable_rc_t s1ap_state_associate_ue_mmeid(
+  s1ap_state_t *state,
+  ue_description_t *ue)
+{
+  s1ap_state_dirty_mmeid(ue->mme_ue_s1ap_id);
+  return hashtable_ts_insert(
+    &state->mmeid2ueid,
+    (const hash_key_t) ue->mme_ue_s1ap_id,
+    s1ap_ue_id(ue->enb->sctp_assoc_id, ue->enb_ue_s1ap_id));
+}
+
+void s1ap_state_dissociate_ue_mmeid(s1ap_state_t *state, ue_description_t *ue)
+{
+  void *ue_id = NULL;
+
+  if (
+    hashtable_ts_get(
+      &state->mmeid2ueid, (const hash_key_t) ue->mme_ue_s1ap_id, &ue_id) ==
+      HASH_TABLE_OK &&
+    ue_id == s1ap_ue_id(ue->enb->sctp_assoc_id, ue->enb_ue_s1ap_id)) {
+    s1ap_state_dirty_mmeid(ue->mme_ue_s1ap_id);
+    hashtable_ts_free(
+      &state->mmeid2ueid, (const hash_key_t) ue->mme_ue_s1ap_id);
+  }
+}
+
+static void s1ap_state_add_tac_enb(
+  s1ap_state_t *state,
+  tac_t tac,
+  sctp_assoc_id_t assoc_id)
+{
+  s1ap_tac_enbs_t *enbs = NULL, *grown = NULL;
+  uint32_t size = S1AP_TAC_ENBS_MIN_SIZE;
+
+  hashtable_ts_get(&state->tac2enbs, (const hash_key_t) tac, (void **) &enbs);
+  if (enbs) {
+    for (uint32_t i = 0; i < enbs->nb_enbs; i++) {
+      if (enbs->assoc_ids[i] == assoc_id) return;
+    }
+    if (enbs->nb_enbs < enbs->size) {
+      enbs->assoc_ids[enbs->nb_enbs++] = assoc_id;
+      return;
+    }
+    size = 2 * enbs->size;
+  }
+  grown = (s1ap_tac_enbs_t *) calloc(
+    1, sizeof(*grown) + size * sizeof(sctp_assoc_id_t));
+  AssertFatal(grown != NULL, "failed to alloc tac2enbs entry");
+  grown->size = size;
+  if (enbs) {
+    memcpy(
+      grown->assoc_ids,
+      enbs->assoc_ids,
+      enbs->nb_enbs * sizeof(sctp_assoc_id_t));
+    grown->nb_enbs = enbs->nb_enbs;
+  }
+  grown->assoc_ids[grown->nb_enbs++] = assoc_id;
+  // replacing the entry frees the previous one
+  hashtable_ts_insert(&state->tac2enbs, (const hash_key_t) tac, grown);
+}
+
+static void s1ap_state_remove_tac_enb(
+  s1ap_state_t *state,
+  tac_t tac,
+  sctp_assoc_id_t assoc_id)
+{
+  s1ap_tac_enbs_t *enbs = NULL;
+
+  if (
+    hashtable_ts_get(
+      &state->tac2enbs, (const hash_key_t) tac, (void **) &enbs) !=
+    HASH_TABLE_OK) {
+    return;
+  }
+  for (uint32_t i = 0; i < enbs->nb_enbs; i++) {
+    if (enbs->assoc_ids[i] == assoc_id) {
+      enbs->assoc_ids[i] = enbs->assoc_ids[--enbs->nb_enbs];
+      break;
+    }
+  }
+  if (enbs->nb_enbs == 0) {
+    hashtable_ts_free(&state->tac2enbs, (const hash_key_t) tac);
+  }
+}
+
+void s1ap_state_index_enb_tacs(s1ap_state_t *state, enb_description_t *enb)
+{
+  for (uint16_t i = 0; i < enb->nb_supported_tacs; i++) {
+    s1ap_state_add_tac_enb(state, enb->supported_tacs[i], enb->sctp_assoc_id);
+  }
+}
+
+void s1ap_state_unindex_enb_tacs(s1ap_state_t *state, enb_description_t *enb)
+{
+  for (uint16_t i = 0; i < enb->nb_supported_tacs; i++) {
+    s1ap_state_remove_tac_enb(
+      state, enb->supported_tacs[i], enb->sctp_assoc_id);
+  }
+}
+
+const s1ap_tac_enbs_t *s1ap_state_get_tac_enbs(s1ap_state_t *state, tac_t tac)
+{
+  s1ap_tac_enbs_t *enbs = NULL;
+
+  hashtable_ts_get(&state->tac2enbs, (const hash_key_t) tac, (void **) &enbs);
+  return enbs;
+}
+
+void s1ap_state_dirty_enb(s1ap_state_t *state, enb_description_t *enb)
+{
+  if (mme_config.use_stateless) dirty_enbs.insert(enb->sctp_assoc_id);
+}
+
+void s1ap_state_dirty_ue(s1ap_state_t *state, ue_description_t *ue)
+{
+  s1ap_state_dirty_ue_id(ue->enb->sctp_assoc_id, ue->enb_ue_s1ap_id);
+}
+
+void s1ap_state_commit_timer_expired(void)
+{
+  commit_timer_id = S1AP_TIMER_INACTIVE_ID;
+  commit_timer_expired = true;
+}
+
 s1ap_state_t *s1ap_state_new(void)
 {
   s1ap_state_t *state;
@@ -192,9 +453,9 @@ s1ap_state_t *s1ap_state_new(void)
     return NULL;
   }
 
-  ht_name = bfromcstr("s1ap_mme_id2assoc_id_coll");
+  ht_name = bfromcstr("s1ap_mme_id2ue_id_coll");
   ht = hashtable_ts_init(
-    &state->mmeid2associd,
+    &state->mmeid2ueid,
     mme_config.max_ues,
     NULL,
     hash_free_int_func,
@@ -207,6 +468,18 @@ s1ap_state_t *s1ap_state_new(void)
     return NULL;
   }
 
+  ht_name = bfromcstr("s1ap_tac2enbs_coll");
+  ht = hashtable_ts_init(
+    &state->tac2enbs, S1AP_MAX_SUPPORTED_TACS, NULL, free_wrapper, ht_name);
+  bdestroy(ht_name);
+
+  if (ht == NULL) {
+    hashtable_ts_destroy(&state->mmeid2ueid);
+    hashtable_ts_destroy(&state->enbs);
+    free(state);
+    return NULL;
+  }
+
   state->num_enbs = 0;
 
   return state;
@@ -214,129 +487,294 @@ s1ap_state_t *s1ap_state_new(void)
 
 void s1ap_state_free(s1ap_state_t *state)
 {
-  int i;
-  hashtable_rc_t ht_rc;
-  hashtable_key_array_t *keys;
-  sctp_assoc_id_t assoc_id;
+  hashtable_ts_cursor_t cursor;
+  hash_key_t assoc_id;
+  void *data;
   enb_description_t *enb;
 
-  keys = hashtable_ts_get_keys(&state->enbs);
-  if (!keys) {
-    OAILOG_DEBUG(LOG_S1AP, "No keys in the enb hashtable");
-  } else {
-    for (i = 0; i < keys->num_keys; i++) {
-      assoc_id = (sctp_assoc_id_t) keys->keys[i];
-      ht_rc =
-        hashtable_ts_get(&state->enbs, (hash_key_t) assoc_id, (void **) &enb);
-      AssertFatal(ht_rc == HASH_TABLE_OK, "enbueid not in assoc_id");
-
-      if (hashtable_ts_destroy(&enb->ue_coll) != HASH_TABLE_OK) {
-        OAI_FPRINTF_ERR("An error occured while destroying UE coll hash table");
-      }
+  hashtable_ts_cursor_init(&cursor, &state->enbs, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &assoc_id, &data)) {
+    enb = (enb_description_t *) data;
+    if (hashtable_ts_destroy(&enb->ue_coll) != HASH_TABLE_OK) {
+      OAI_FPRINTF_ERR("An error occured while destroying UE coll hash table");
     }
-    FREE_HASHTABLE_KEY_ARRAY(keys);
   }
 
   if (hashtable_ts_destroy(&state->enbs) != HASH_TABLE_OK) {
     OAI_FPRINTF_ERR("An error occured while destroying s1 eNB hash table");
   }
-  if (hashtable_ts_destroy(&state->mmeid2associd) != HASH_TABLE_OK) {
-    OAI_FPRINTF_ERR("An error occured while destroying assoc_id hash table");
+  if (hashtable_ts_destroy(&state->mmeid2ueid) != HASH_TABLE_OK) {
+    OAI_FPRINTF_ERR("An error occured while destroying ue_id hash table");
+  }
+  if (hashtable_ts_destroy(&state->tac2enbs) != HASH_TABLE_OK) {
+    OAI_FPRINTF_ERR("An error occured while destroying tac hash table");
   }
   free(state);
 }
 
-s1ap_state_t *s1ap_state_from_redis(void)
+// Marks everything, for a state which is not in the hashes yet
+static void s1ap_state_dirty_all(s1ap_state_t *state)
+{
+  hashtable_ts_cursor_t enb_cursor, ue_cursor;
+  hash_key_t key;
+  void *data;
+
+  hashtable_ts_cursor_init(
+    &enb_cursor, &state->enbs, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&enb_cursor, &key, &data)) {
+    enb_description_t *enb = (enb_description_t *) data;
+
+    s1ap_state_dirty_enb(state, enb);
+    hashtable_ts_cursor_init(
+      &ue_cursor, &enb->ue_coll, HASH_TABLE_CURSOR_STRIPED);
+    while (hashtable_ts_cursor_next(&ue_cursor, &key, &data)) {
+      s1ap_state_dirty_ue(state, (ue_description_t *) data);
+    }
+  }
+  hashtable_ts_cursor_init(
+    &enb_cursor, &state->mmeid2ueid, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&enb_cursor, &key, &data)) {
+    s1ap_state_dirty_mmeid((mme_ue_s1ap_id_t) key);
+  }
+}
+
+// Loads the state written as a whole, before the per eNB and per UE hashes
+static s1ap_state_t *s1ap_state_from_redis_legacy(const std::string &value)
 {
   s1ap_state_t *state;
   S1apState proto;
 
-  auto fut = client->get(S1AP_STATE_TABLE);
-  client->sync_commit();
-  auto reply = fut.get();
-
-  if (reply.is_null() || reply.is_error() || !reply.is_string()) return NULL;
-
-  if (!proto.ParseFromString(reply.as_string())) return NULL;
+  if (!proto.ParseFromString(value)) return NULL;
 
   state = s1ap_state_new();
   if (state == NULL) return NULL;
 
   proto2state(state, &proto);
 
+  // moved to the hashes by the next commit
+  s1ap_state_dirty_all(state);
+  dirty_legacy_state = true;
+
   return state;
 }
 
-void s1ap_state_to_redis(s1ap_state_t *state)
+static std::string s1ap_state_ue_field(
+  sctp_assoc_id_t assoc_id,
+  enb_ue_s1ap_id_t enb_ue_s1ap_id)
 {
-  S1apState proto;
-  std::string serialized_state;
+  return std::to_string(assoc_id) + ":" + std::to_string(enb_ue_s1ap_id);
+}
+
+s1ap_state_t *s1ap_state_from_redis(void)
+{
+  s1ap_state_t *state;
+  EnbDescription enb_proto;
+  UeDescription ue_proto;
+  enb_description_t *enb;
+  ue_description_t *ue;
+  hashtable_rc_t ht_rc;
+  std::unordered_map<mme_ue_s1ap_id_t, sctp_assoc_id_t> mmeid2associd;
 
-  state2proto(&proto, state);
+  auto enbs_fut = client->hgetall(S1AP_STATE_ENBS_TABLE);
+  auto ues_fut = client->hgetall(S1AP_STATE_UES_TABLE);
+  auto mmeids_fut = client->hgetall(S1AP_STATE_MMEID2ASSOCID_TABLE);
+  auto legacy_fut = client->get(S1AP_STATE_TABLE);
+  client->sync_commit();
+  auto enbs = enbs_fut.get();
+  auto ues = ues_fut.get();
+  auto mmeids = mmeids_fut.get();
+  auto legacy = legacy_fut.get();
 
-  if (!proto.SerializeToString(&serialized_state)) {
-    Fatal("Failed to serialize state");
+  if (!enbs.is_array() || !ues.is_array() || !mmeids.is_array()) return NULL;
+
+  // the hashes replace the whole state once they have been written
+  if (enbs.as_array().empty() && legacy.is_string()) {
+    return s1ap_state_from_redis_legacy(legacy.as_string());
   }
 
-  auto fut = client->set(S1AP_STATE_TABLE, serialized_state);
-  client->sync_commit();
-  auto reply = fut.get();
+  state = s1ap_state_new();
+  if (state == NULL) return NULL;
+
+  // replies of hgetall alternate the fields and their values
+  auto &enb_fields = enbs.as_array();
+  for (size_t i = 0; i + 1 < enb_fields.size(); i += 2) {
+    sctp_assoc_id_t associd = std::stoul(enb_fields[i].as_string());
+
+    if (!enb_proto.ParseFromString(enb_fields[i + 1].as_string())) {
+      s1ap_state_free(state);
+      return NULL;
+    }
+    enb = (enb_description_t *) malloc(sizeof(*enb));
+    AssertFatal(enb != NULL, "failed to alloc new enb_desc");
+
+    proto2enb(enb, &enb_proto);
+    ht_rc = hashtable_ts_insert(&state->enbs, (hash_key_t) associd, enb);
+    AssertFatal(ht_rc == HASH_TABLE_OK, "failed to insert enb");
+    s1ap_state_index_enb_tacs(state, enb);
+  }
+
+  auto &mmeid_fields = mmeids.as_array();
+  for (size_t i = 0; i + 1 < mmeid_fields.size(); i += 2) {
+    mmeid2associd[std::stoul(mmeid_fields[i].as_string())] =
+      std::stoul(mmeid_fields[i + 1].as_string());
+  }
+
+  /*
+   * Rebuild mmeid2ueid from the UEs of the eNB each mme_ue_s1ap_id was
+   * associated with, they carry their enb_ue_s1ap_id
+   */
+  auto &ue_fields = ues.as_array();
+  for (size_t i = 0; i + 1 < ue_fields.size(); i += 2) {
+    sctp_assoc_id_t associd = 0;
+    enb_ue_s1ap_id_t enbueid = 0;
+
+    if (
+      sscanf(ue_fields[i].as_string().c_str(), "%u:%u", &associd, &enbueid) !=
+        2 ||
+      !ue_proto.ParseFromString(ue_fields[i + 1].as_string())) {
+      s1ap_state_free(state);
+      return NULL;
+    }
+    enb = NULL;
+    hashtable_ts_get(&state->enbs, (hash_key_t) associd, (void **) &enb);
+    if (enb == NULL) {
+      // left by a failed commit, deleted by the next one
+      s1ap_state_dirty_ue_id(associd, enbueid);
+      continue;
+    }
+
+    ue = (ue_description_t *) malloc(sizeof(*ue));
+    AssertFatal(ue != NULL, "failed to alloc new ue description");
+
+    proto2ue(ue, &ue_proto);
+    ue->enb = enb; // ue's are linked to parent enb
+
+    ht_rc = hashtable_ts_insert(&enb->ue_coll, (hash_key_t) enbueid, ue);
+    AssertFatal(ht_rc == HASH_TABLE_OK, "failed to insert ue");
+
+    auto it = mmeid2associd.find(ue->mme_ue_s1ap_id);
+    if (it == mmeid2associd.end() || it->second != associd) continue;
+    ht_rc = hashtable_ts_insert(
+      &state->mmeid2ueid,
+      (hash_key_t) ue->mme_ue_s1ap_id,
+      s1ap_ue_id(associd, enbueid));
+    AssertFatal(ht_rc == HASH_TABLE_OK, "failed to insert ue_id");
+  }
 
+  state->num_enbs = (uint32_t) state->enbs.num_elements;
+
+  return state;
+}
+
+static void s1ap_state_redis_reply_cb(cpp_redis::reply &reply)
+{
   if (reply.is_error()) {
     Fatal("Failed to write to redis");
   }
 }
 
-void state2proto(S1apState *proto, s1ap_state_t *state)
+static void s1ap_state_redis_hdel(
+  const std::string &table,
+  const std::vector<std::string> &fields)
 {
-  int i;
-  hashtable_rc_t ht_rc;
-  hashtable_key_array_t *keys;
-
-  mme_ue_s1ap_id_t mmeid;
-  sctp_assoc_id_t associd;
-  enb_description_t *enb;
+  if (!fields.empty()) {
+    client->hdel(table, fields, s1ap_state_redis_reply_cb);
+  }
+}
 
+/*
+ * Pipelines the writes of the dirty keys and sends them without waiting for
+ * the replies. A failed write is fatal, as it was when the whole state was
+ * written at each put.
+ */
+void s1ap_state_to_redis(s1ap_state_t *state)
+{
   EnbDescription enb_proto;
-
-  proto->Clear();
-
-  // copy over enbs
-  auto enbs = proto->mutable_enbs();
-  keys = hashtable_ts_get_keys(&state->enbs);
-  if (!keys) {
-    OAILOG_DEBUG(LOG_S1AP, "No keys in the enb hashtable");
-  } else {
-    for (i = 0; i < keys->num_keys; i++) {
-      associd = (sctp_assoc_id_t) keys->keys[i];
-      ht_rc =
-        hashtable_ts_get(&state->enbs, (hash_key_t) associd, (void **) &enb);
-      AssertFatal(ht_rc == HASH_TABLE_OK, "associd not in enbs");
-
-      enb2proto(&enb_proto, enb);
-      (*enbs)[associd] = enb_proto;
+  UeDescription ue_proto;
+  std::string serialized;
+  std::vector<std::string> deleted;
+  enb_description_t *enb;
+  ue_description_t *ue;
+  void *ue_id;
+
+  for (auto associd : dirty_enbs) {
+    enb = NULL;
+    hashtable_ts_get(&state->enbs, (hash_key_t) associd, (void **) &enb);
+    if (enb == NULL) {
+      deleted.push_back(std::to_string(associd));
+      continue;
+    }
+    enb2proto(&enb_proto, enb);
+    if (!enb_proto.SerializeToString(&serialized)) {
+      Fatal("Failed to serialize state");
     }
-    FREE_HASHTABLE_KEY_ARRAY(keys);
-  }
-
-  // copy over mmeid2associd
-  auto mmeid2associd = proto->mutable_mmeid2associd();
-  keys = hashtable_ts_get_keys(&state->mmeid2associd);
-  if (!keys) {
-    OAILOG_DEBUG(LOG_S1AP, "No keys in mmeid2associd hashtable");
-  } else {
-    for (i = 0; i < keys->num_keys; i++) {
-      mmeid = (mme_ue_s1ap_id_t) keys->keys[i];
-      ht_rc = hashtable_ts_get(
-        &state->mmeid2associd, (hash_key_t) mmeid, (void **) &associd);
-      AssertFatal(ht_rc == HASH_TABLE_OK, "mmeid not in mmeid2associd");
-
-      (*mmeid2associd)[mmeid] = associd;
+    client->hset(
+      S1AP_STATE_ENBS_TABLE,
+      std::to_string(associd),
+      serialized,
+      s1ap_state_redis_reply_cb);
+  }
+  s1ap_state_redis_hdel(S1AP_STATE_ENBS_TABLE, deleted);
+  deleted.clear();
+
+  for (auto id : dirty_ues) {
+    sctp_assoc_id_t associd = s1ap_ue_id_assoc_id((void *) id);
+    enb_ue_s1ap_id_t enbueid = s1ap_ue_id_enb_ue_s1ap_id((void *) id);
+
+    enb = NULL;
+    ue = NULL;
+    hashtable_ts_get(&state->enbs, (hash_key_t) associd, (void **) &enb);
+    if (enb) {
+      hashtable_ts_get(&enb->ue_coll, (hash_key_t) enbueid, (void **) &ue);
+    }
+    if (ue == NULL) {
+      deleted.push_back(s1ap_state_ue_field(associd, enbueid));
+      continue;
     }
-    FREE_HASHTABLE_KEY_ARRAY(keys);
+    ue2proto(&ue_proto, ue);
+    if (!ue_proto.SerializeToString(&serialized)) {
+      Fatal("Failed to serialize state");
+    }
+    client->hset(
+      S1AP_STATE_UES_TABLE,
+      s1ap_state_ue_field(associd, enbueid),
+      serialized,
+      s1ap_state_redis_reply_cb);
   }
+  s1ap_state_redis_hdel(S1AP_STATE_UES_TABLE, deleted);
+  deleted.clear();
+
+  for (auto mmeid : dirty_mmeids) {
+    if (
+      hashtable_ts_get(&state->mmeid2ueid, (hash_key_t) mmeid, &ue_id) !=
+      HASH_TABLE_OK) {
+      deleted.push_back(std::to_string(mmeid));
+      continue;
+    }
+    client->hset(
+      S1AP_STATE_MMEID2ASSOCID_TABLE,
+      std::to_string(mmeid),
+      std::to_string(s1ap_ue_id_assoc_id(ue_id)),
+      s1ap_state_redis_reply_cb);
+  }
+  s1ap_state_redis_hdel(S1AP_STATE_MMEID2ASSOCID_TABLE, deleted);
 
-  proto->set_num_enbs(state->num_enbs);
+  if (dirty_legacy_state) {
+    client->del({S1AP_STATE_TABLE}, s1ap_state_redis_reply_cb);
+  }
+  client->commit();
+
+  dirty_enbs.clear();
+  dirty_ues.clear();
+  dirty_mmeids.clear();
+  dirty_legacy_state = false;
+
+  last_commit_ms = s1ap_state_now_ms();
+  commit_timer_expired = false;
+  if (commit_timer_id != S1AP_TIMER_INACTIVE_ID) {
+    timer_remove(commit_timer_id, NULL);
+    commit_timer_id = S1AP_TIMER_INACTIVE_ID;
+  }
 }
 
 // expects hashtables in state to be created already
@@ -356,16 +794,28 @@ void proto2state(s1ap_state_t *state, S1apState *proto)
     proto2enb(enb, &enb_proto);
     ht_rc = hashtable_ts_insert(&state->enbs, (hash_key_t) associd, enb);
     AssertFatal(ht_rc == HASH_TABLE_OK, "failed to insert enb");
+    s1ap_state_index_enb_tacs(state, enb);
   }
 
+  /*
+   * Rebuild mmeid2ueid from the UEs of the eNB each mme_ue_s1ap_id was
+   * associated with, they carry their enb_ue_s1ap_id
+   */
   auto mmeid2associd = proto->mmeid2associd();
-  for (auto const &kv : mmeid2associd) {
-    mme_ue_s1ap_id_t mmeid = (mme_ue_s1ap_id_t) kv.first;
-    sctp_assoc_id_t associd = (sctp_assoc_id_t) kv.second;
+  for (auto const &kv : enbs) {
+    sctp_assoc_id_t associd = kv.first;
 
-    ht_rc = hashtable_ts_insert(
-      &state->mmeid2associd, (hash_key_t) mmeid, (void *) (uintptr_t) associd);
-    AssertFatal(ht_rc == HASH_TABLE_OK, "failed to insert associd");
+    for (auto const &ue_kv : kv.second.ues()) {
+      mme_ue_s1ap_id_t mmeid = ue_kv.second.mme_ue_s1ap_id();
+      auto it = mmeid2associd.find(mmeid);
+
+      if (it == mmeid2associd.end() || it->second != associd) continue;
+      ht_rc = hashtable_ts_insert(
+        &state->mmeid2ueid,
+        (hash_key_t) mmeid,
+        s1ap_ue_id(associd, (enb_ue_s1ap_id_t) ue_kv.first));
+      AssertFatal(ht_rc == HASH_TABLE_OK, "failed to insert ue_id");
+    }
   }
 
   state->num_enbs = proto->num_enbs();
@@ -373,15 +823,6 @@ void proto2state(s1ap_state_t *state, S1apState *proto)
 
 void enb2proto(EnbDescription *proto, enb_description_t *enb)
 {
-  int i;
-  hashtable_rc_t ht_rc;
-  hashtable_key_array_t *keys;
-
-  enb_ue_s1ap_id_t enbueid;
-  ue_description_t *ue;
-
-  UeDescription ue_proto;
-
   proto->Clear();
 
   proto->set_enb_id(enb->enb_id);
@@ -397,25 +838,11 @@ void enb2proto(EnbDescription *proto, enb_description_t *enb)
   proto->set_next_sctp_stream(enb->next_sctp_stream);
   proto->set_instreams(enb->instreams);
   proto->set_outstreams(enb->outstreams);
-
-  // store ues
-  auto ues = proto->mutable_ues();
-  keys = hashtable_ts_get_keys(&enb->ue_coll);
-  if (!keys) {
-    OAILOG_DEBUG(LOG_S1AP, "No keys in ue_coll hashtable");
-  } else {
-    for (i = 0; i < keys->num_keys; i++) {
-      enbueid = (mme_ue_s1ap_id_t) keys->keys[i];
-      ht_rc =
-        hashtable_ts_get(&enb->ue_coll, (hash_key_t) enbueid, (void **) &ue);
-      AssertFatal(ht_rc == HASH_TABLE_OK, "enbueid not in ue_coll");
-      AssertFatal(ue->enb == enb, "tried to commit ue assigned to wrong enb");
-
-      ue2proto(&ue_proto, ue);
-      (*ues)[enbueid] = ue_proto;
-    }
-    FREE_HASHTABLE_KEY_ARRAY(keys);
+  for (uint16_t i = 0; i < enb->nb_supported_tacs; i++) {
+    proto->add_supported_tacs(enb->supported_tacs[i]);
   }
+
+  // the UEs are stored under their own keys
 }
 
 void proto2enb(enb_description_t *enb, EnbDescription *proto)
@@ -438,6 +865,10 @@ void proto2enb(enb_description_t *enb, EnbDescription *proto)
   enb->next_sctp_stream = proto->next_sctp_stream();
   enb->instreams = proto->instreams();
   enb->outstreams = proto->outstreams();
+  for (auto tac : proto->supported_tacs()) {
+    if (enb->nb_supported_tacs == S1AP_MAX_SUPPORTED_TACS) break;
+    enb->supported_tacs[enb->nb_supported_tacs++] = (tac_t) tac;
+  }
 
   // load ues
   auto ht_name = bfromcstr("s1ap_ue_coll");
@@ -489,47 +920,3 @@ void proto2ue(ue_description_t *ue, UeDescription *proto)
   ue->s1ap_ue_context_rel_timer.id = proto->s1ap_ue_context_rel_timer().id();
   ue->s1ap_ue_context_rel_timer.sec = proto->s1ap_ue_context_rel_timer().sec();
 }
-
-bool s1ap_ue_compare_by_mme_ue_id_cb(
-  __attribute__((unused)) const hash_key_t keyP,
-  void *const elementP,
-  void *parameterP,
-  void **resultP)
-{
-  mme_ue_s1ap_id_t *mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t *) parameterP;
-  ue_description_t *ue_ref = (ue_description_t *) elementP;
-  if (*mme_ue_s1ap_id_p == ue_ref->mme_ue_s1ap_id) {
-    *resultP = elementP;
-    OAILOG_TRACE(
-      LOG_S1AP,
-      "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
-      ue_ref,
-      ue_ref->mme_ue_s1ap_id);
-    return true;
-  }
-  return false;
-}
-
-bool s1ap_enb_find_ue_by_mme_ue_id_cb(
-  __attribute__((unused)) const hash_key_t keyP,
-  void *const elementP,
-  void *parameterP,
-  void **resultP)
-{
-  enb_description_t *enb_ref = (enb_description_t *) elementP;
-
-  hashtable_ts_apply_callback_on_elements(
-    (hash_table_ts_t *const) & enb_ref->ue_coll,
-    s1ap_ue_compare_by_mme_ue_id_cb,
-    parameterP,
-    resultP);
-  if (*resultP) {
-    OAILOG_TRACE(
-      LOG_S1AP,
-      "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
-      *resultP,
-      ((ue_description_t *) (*resultP))->mme_ue_s1ap_id);
-    return true;
-  }
-  return false;
-}
@@ -34,11 +34,28 @@ extern "C" {
 typedef struct s1ap_state_s {
   // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t)
   hash_table_ts_t enbs;
-  // contains sctp association id, key is mme_ue_s1ap_id
-  hash_table_ts_t mmeid2associd;
+  /*
+   * contains the sctp association id and the enb_ue_s1ap_id of a UE, key is
+   * its mme_ue_s1ap_id. Maintained with s1ap_state_associate_ue_mmeid() and
+   * s1ap_state_dissociate_ue_mmeid().
+   */
+  hash_table_ts_t mmeid2ueid;
+  /*
+   * contains the s1ap_tac_enbs_t of the eNBs serving a TAC, key is the TAC.
+   * Maintained with s1ap_state_index_enb_tacs() and
+   * s1ap_state_unindex_enb_tacs().
+   */
+  hash_table_ts_t tac2enbs;
   uint32_t num_enbs;
 } s1ap_state_t;
 
+// Associations of the eNBs serving a TAC, grown by replacing the entry
+typedef struct s1ap_tac_enbs_s {
+  uint32_t nb_enbs;
+  uint32_t size;
+  sctp_assoc_id_t assoc_ids[];
+} s1ap_tac_enbs_t;
+
 int s1ap_state_init(void);
 void s1ap_state_exit(void);
 
@@ -56,6 +73,32 @@ ue_description_t *s1ap_state_get_ue_mmeid(
   s1ap_state_t *state,
   mme_ue_s1ap_id_t mme_ue_s1ap_id);
 
+// Indexes the UE by its mme_ue_s1ap_id, replacing any UE indexed before it
+hashtable_rc_t s1ap_state_associate_ue_mmeid(
+  s1ap_state_t *state,
+  ue_description_t *ue);
+// Removes the UE from the index, if the index still refers to it
+void s1ap_state_dissociate_ue_mmeid(s1ap_state_t *state, ue_description_t *ue);
+
+/*
+ * Indexes the eNB under its supported_tacs, it has to be removed from the
+ * index before they are changed
+ */
+void s1ap_state_index_enb_tacs(s1ap_state_t *state, enb_description_t *enb);
+void s1ap_state_unindex_enb_tacs(s1ap_state_t *state, enb_description_t *enb);
+// Returns the eNBs serving the TAC, NULL if there are none
+const s1ap_tac_enbs_t *s1ap_state_get_tac_enbs(s1ap_state_t *state, tac_t tac);
+
+/*
+ * In stateless mode only the eNB and UE descriptions marked dirty since the
+ * last commit are written to redis. The accessors above mark what they return,
+ * descriptions created, removed or changed without them have to be marked.
+ */
+void s1ap_state_dirty_enb(s1ap_state_t *state, enb_description_t *enb);
+void s1ap_state_dirty_ue(s1ap_state_t *state, ue_description_t *ue);
+// Commits the dirty descriptions on the next put, ending the commit window
+void s1ap_state_commit_timer_expired(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,17 +27,21 @@
 
 #include "common_types.h"
 #include "hashtable.h"
+#include "TrackingAreaIdentity.h"
 
 // Forward declarations
 struct enb_description_s;
 
 #define S1AP_TIMER_INACTIVE_ID (-1)
 #define S1AP_UE_CONTEXT_REL_COMP_TIMER 1 // in seconds
+// maxnoofTACs, of the Supported TAs of an S1 Setup Request
+#define S1AP_MAX_SUPPORTED_TACS 256
 
 enum s1_timer_class_s {
   S1AP_INVALID_TIMER_CLASS,
   S1AP_ENB_TIMER,
-  S1AP_UE_TIMER
+  S1AP_UE_TIMER,
+  S1AP_STATE_TIMER
 };
 
 /* S1AP Timer argument */
@@ -109,6 +113,12 @@ typedef struct enb_description_s {
   uint8_t default_paging_drx; ///< Default paging DRX interval for eNB
   /*@}*/
 
+  /** Tracking areas served by the eNB, indexed in the s1ap state tac2enbs **/
+  /*@{*/
+  uint16_t nb_supported_tacs;
+  tac_t supported_tacs[S1AP_MAX_SUPPORTED_TACS];
+  /*@}*/
+
   /** UE list for this eNB **/
   /*@{*/
   uint32_t nb_ue_associated; ///< Number of NAS associated UE on this eNB
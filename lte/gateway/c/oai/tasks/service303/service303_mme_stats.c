@@ -21,21 +21,179 @@
 #define SERVICE303
 
 #include <stddef.h>
+#include <pthread.h>
 
 #include "mme_app_desc.h"
+#include "mme_app_statistics.h"
+#include "hashtable.h"
+#include "intertask_interface.h"
 #include "service303.h"
 
 static void service303_mme_statistics_read(void)
 {
   size_t label = 0;
-  set_gauge("enb_connected", mme_app_desc.nb_enb_connected, label);
-  set_gauge("ue_registered", mme_app_desc.nb_ue_attached, label);
-  set_gauge("ue_connected", mme_app_desc.nb_ue_connected, label);
+  mme_app_stats_snapshot_t stats;
+
+  mme_app_statistics_snapshot(&stats);
+  set_gauge(
+    "enb_connected", stats.current[MME_APP_STAT_ENB_CONNECTED], label);
+  set_gauge("ue_registered", stats.current[MME_APP_STAT_UE_ATTACHED], label);
+  set_gauge("ue_connected", stats.current[MME_APP_STAT_UE_CONNECTED], label);
   return;
 }
 
+/* Histogram bucket boundaries, preceded by their count */
+#define ITTI_TIME_US_BOUNDARIES                                                \
+  (size_t) 9, 10., 50., 100., 500., 1000., 5000., 10000., 50000., 100000.
+#define ITTI_QUEUE_DEPTH_BOUNDARIES                                            \
+  (size_t) 8, 1., 2., 4., 16., 64., 256., 1024., 4096.
+
+/*
+ * The ITTI and hashtable hooks run on every task thread, serialize them as the
+ * metrics registry is not thread safe
+ */
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void service303_itti_msg_latency(
+  task_id_t task_id,
+  MessagesIds message_id,
+  double latency_us)
+{
+  pthread_mutex_lock(&metrics_lock);
+  observe_histogram(
+    "itti_msg_latency_us",
+    latency_us,
+    2,
+    "task",
+    itti_get_task_name(task_id),
+    "message",
+    itti_get_message_name(message_id),
+    ITTI_TIME_US_BOUNDARIES);
+  pthread_mutex_unlock(&metrics_lock);
+}
+
+static void service303_itti_queue_depth(task_id_t task_id, uint32_t depth)
+{
+  pthread_mutex_lock(&metrics_lock);
+  observe_histogram(
+    "itti_receive_queue_depth",
+    depth,
+    1,
+    "task",
+    itti_get_task_name(task_id),
+    ITTI_QUEUE_DEPTH_BOUNDARIES);
+  pthread_mutex_unlock(&metrics_lock);
+}
+
+static void service303_itti_handler_time(
+  task_id_t task_id,
+  size_t nb_msgs,
+  double run_time_us)
+{
+  pthread_mutex_lock(&metrics_lock);
+  observe_histogram(
+    "itti_handler_time_us",
+    run_time_us / nb_msgs,
+    1,
+    "task",
+    itti_get_task_name(task_id),
+    ITTI_TIME_US_BOUNDARIES);
+  increment_counter(
+    "itti_handler_busy_us",
+    run_time_us,
+    1,
+    "task",
+    itti_get_task_name(task_id));
+  pthread_mutex_unlock(&metrics_lock);
+}
+
+static const itti_metrics_ops_t service303_itti_metrics_ops = {
+  .msg_latency = service303_itti_msg_latency,
+  .queue_depth = service303_itti_queue_depth,
+  .handler_time = service303_itti_handler_time,
+};
+
+void service303_itti_metrics_enable(bool enable)
+{
+  itti_set_metrics_ops(enable ? &service303_itti_metrics_ops : NULL);
+}
+
+static void service303_hashtable_resized(
+  const char *name,
+  hash_size_t old_size,
+  hash_size_t new_size)
+{
+  pthread_mutex_lock(&metrics_lock);
+  increment_counter(
+    "hashtable_resize",
+    1,
+    2,
+    "table",
+    name,
+    "direction",
+    (new_size > old_size) ? "grow" : "shrink");
+  set_gauge("hashtable_size", new_size, 1, "table", name);
+  pthread_mutex_unlock(&metrics_lock);
+}
+
+void service303_hashtable_metrics_enable(bool enable)
+{
+  hashtable_set_resize_callback(enable ? service303_hashtable_resized : NULL);
+}
+
+static void service303_itti_queue_depths_read(task_id_t task_id)
+{
+  uint32_t depths[ITTI_PRIORITY_LEVELS];
+
+  itti_get_queue_depths(task_id, depths);
+  for (unsigned int level = 0; level < ITTI_PRIORITY_LEVELS; level++) {
+    set_gauge(
+      "itti_queue_depth",
+      depths[level],
+      2,
+      "task",
+      itti_get_task_name(task_id),
+      "priority",
+      itti_get_priority_level_name(level));
+  }
+}
+
+static void service303_itti_counters_read(task_id_t task_id)
+{
+  itti_task_counters_t counters;
+
+  itti_get_task_counters(task_id, &counters);
+  set_gauge(
+    "itti_msgs_sent",
+    counters.msgs_sent,
+    1,
+    "task",
+    itti_get_task_name(task_id));
+  set_gauge(
+    "itti_msgs_received",
+    counters.msgs_received,
+    1,
+    "task",
+    itti_get_task_name(task_id));
+  set_gauge(
+    "itti_bytes_allocated",
+    counters.bytes_allocated,
+    1,
+    "task",
+    itti_get_task_name(task_id));
+}
+
+static void service303_itti_task_read(task_id_t task_id)
+{
+  service303_itti_queue_depths_read(task_id);
+  service303_itti_counters_read(task_id);
+}
+
 void service303_statistics_read(void)
 {
   service303_mme_statistics_read();
+  service303_itti_task_read(TASK_S1AP);
+  service303_itti_task_read(TASK_MME_APP);
+  service303_itti_task_read(TASK_NAS_MME);
   return;
 }
@@ -431,12 +431,11 @@ uint32_t pgw_handle_nw_initiated_bearer_actv_req(
 {
   OAILOG_FUNC_IN(LOG_PGW_APP);
   MessageDef *message_p = NULL;
-  uint32_t i = 0;
   uint32_t rc = RETURNok;
   hash_table_ts_t *hashtblP = NULL;
-  uint32_t num_elements = 0;
+  hashtable_ts_cursor_t cursor;
+  hash_key_t key = 0;
   s_plus_p_gw_eps_bearer_context_information_t *spgw_ctxt_p = NULL;
-  hash_node_t *node = NULL;
   itti_s5_nw_init_actv_bearer_request_t *itti_s5_actv_bearer_req = NULL;
 
   OAILOG_INFO(
@@ -475,44 +474,33 @@ uint32_t pgw_handle_nw_initiated_bearer_actv_req(
     OAILOG_FUNC_RETURN(LOG_PGW_APP, RETURNerror);
   }
 
-  //Fetch S11 MME TEID using IMSI and LBI
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
+  //Fetch S11 MME TEID using IMSI and LBI, the stripe walked is only read
+  hashtable_ts_cursor_init(&cursor, hashtblP, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &key, (void **) &spgw_ctxt_p)) {
+    if (
+      spgw_ctxt_p != NULL &&
+      !strncmp(
+        (const char *)
+          spgw_ctxt_p->sgw_eps_bearer_context_information.imsi.digit,
+        (const char *) bearer_req_p->imsi,
+        strlen((const char *) bearer_req_p->imsi)) &&
+      spgw_ctxt_p->sgw_eps_bearer_context_information.pdn_connection
+          .default_bearer == bearer_req_p->lbi) {
+      itti_s5_actv_bearer_req->mme_teid_S11 =
+        spgw_ctxt_p->sgw_eps_bearer_context_information.mme_teid_S11;
+      hashtable_ts_cursor_end(&cursor);
+      break;
     }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    while (node) {
-      num_elements++;
-      hashtable_ts_get(
-        hashtblP, (const hash_key_t) node->key, (void **) &spgw_ctxt_p);
-      if (spgw_ctxt_p != NULL) {
-        if (!strncmp(
-              (const char *)
-                spgw_ctxt_p->sgw_eps_bearer_context_information.imsi.digit,
-              (const char *) bearer_req_p->imsi,
-              strlen((const char *) bearer_req_p->imsi))) {
-          if (
-            spgw_ctxt_p->sgw_eps_bearer_context_information.pdn_connection
-              .default_bearer == bearer_req_p->lbi) {
-            itti_s5_actv_bearer_req->lbi = bearer_req_p->lbi;
-            itti_s5_actv_bearer_req->mme_teid_S11 =
-              spgw_ctxt_p->sgw_eps_bearer_context_information.mme_teid_S11;
-            break;
-          }
-        }
-      }
-      node = node->next;
-    }
-    i++;
+    spgw_ctxt_p = NULL;
   }
-  if (i >= hashtblP->size) {
+  if (spgw_ctxt_p == NULL) {
     OAILOG_ERROR(LOG_PGW_APP, "Could not find LBI/IMSI in SPGW context\n");
     //TODO-Send Rsp to PCRF with cause = REJECTED
     /*rc = send_dedicated_bearer_actv_rsp(lbi,
     REQUEST_REJECTED);*/
     OAILOG_FUNC_RETURN(LOG_PGW_APP, rc);
   }
+  itti_s5_actv_bearer_req->lbi = bearer_req_p->lbi;
   //Send S5_ACTIVATE_DEDICATED_BEARER_REQ to SGW APP
   OAILOG_INFO(
     LOG_PGW_APP,
@@ -535,14 +523,11 @@ uint32_t pgw_handle_nw_initiated_bearer_deactv_req(
   uint32_t rc = RETURNok;
   OAILOG_FUNC_IN(LOG_PGW_APP);
   MessageDef *message_p = NULL;
-  uint32_t i = 0;
-  uint32_t j = 0;
   hash_table_ts_t *hashtblP = NULL;
-  uint32_t num_elements = 0;
+  hashtable_ts_cursor_t cursor;
+  hash_key_t key = 0;
   s_plus_p_gw_eps_bearer_context_information_t *spgw_ctxt_p = NULL;
-  hash_node_t *node = NULL;
   itti_s5_nw_init_deactv_bearer_request_t *itti_s5_deactv_ded_bearer_req = NULL;
-  bool found = false;
 
   OAILOG_INFO(LOG_PGW_APP, "Received nw_initiated_deactv_bearer_req from NW\n");
   print_bearer_ids_helper(bearer_req_p->ebi, bearer_req_p->no_of_bearers);
@@ -576,35 +561,32 @@ uint32_t pgw_handle_nw_initiated_bearer_deactv_req(
   }
 
   //Check if EBI recvd == LBI to know if default bearer has to be deactivated
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size) &&
-         (!found)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      spgw_ctxt_p = node->data;
-      num_elements++;
-      if (spgw_ctxt_p != NULL) {
-        if (!strcmp(
-              (const char *)
-                spgw_ctxt_p->sgw_eps_bearer_context_information.imsi.digit,
-              (const char *) bearer_req_p->imsi)) {
-          itti_s5_deactv_ded_bearer_req->s11_mme_teid =
-            spgw_ctxt_p->sgw_eps_bearer_context_information.mme_teid_S11;
-          for (j = 0; j < bearer_req_p->no_of_bearers; j++) {
-            if (
-              bearer_req_p->ebi[j] ==
-              spgw_ctxt_p->sgw_eps_bearer_context_information.pdn_connection
-                .default_bearer) {
-              itti_s5_deactv_ded_bearer_req->delete_default_bearer = true;
-              found = true;
-              break;
-            }
-          }
-        }
+  //The stripe walked is only read, the request is sent once the walk ended
+  hashtable_ts_cursor_init(&cursor, hashtblP, HASH_TABLE_CURSOR_STRIPED);
+  while (hashtable_ts_cursor_next(&cursor, &key, (void **) &spgw_ctxt_p)) {
+    if (
+      spgw_ctxt_p == NULL ||
+      strcmp(
+        (const char *)
+          spgw_ctxt_p->sgw_eps_bearer_context_information.imsi.digit,
+        (const char *) bearer_req_p->imsi)) {
+      continue;
+    }
+    itti_s5_deactv_ded_bearer_req->s11_mme_teid =
+      spgw_ctxt_p->sgw_eps_bearer_context_information.mme_teid_S11;
+    for (uint32_t j = 0; j < bearer_req_p->no_of_bearers; j++) {
+      if (
+        bearer_req_p->ebi[j] ==
+        spgw_ctxt_p->sgw_eps_bearer_context_information.pdn_connection
+          .default_bearer) {
+        itti_s5_deactv_ded_bearer_req->delete_default_bearer = true;
+        break;
       }
     }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+    if (itti_s5_deactv_ded_bearer_req->delete_default_bearer) {
+      hashtable_ts_cursor_end(&cursor);
+      break;
+    }
   }
   OAILOG_INFO(
     LOG_PGW_APP,
@@ -63,137 +63,146 @@ static void *sgw_intertask_interface(void *args_p)
   spgw_state_t *spgw_state_p;
 
   while (1) {
-    MessageDef *received_message_p = NULL;
-    itti_receive_msg(TASK_SPGW_APP, &received_message_p);
-
-    spgw_state_p = get_spgw_state(true);
-
-    switch (ITTI_MSG_ID(received_message_p)) {
-      case GTPV1U_CREATE_TUNNEL_RESP: {
-        OAILOG_DEBUG(
-          LOG_SPGW_APP,
-          "Received teid for S1-U: %u and status: %s\n",
-          received_message_p->ittiMsg.gtpv1uCreateTunnelResp.S1u_teid,
-          received_message_p->ittiMsg.gtpv1uCreateTunnelResp.status == 0 ?
-            "Success" :
-            "Failure");
-        sgw_handle_gtpv1uCreateTunnelResp(
-          spgw_state_p, &received_message_p->ittiMsg.gtpv1uCreateTunnelResp);
-      } break;
-
-      case MESSAGE_TEST:
-        OAILOG_DEBUG(LOG_SPGW_APP, "Received MESSAGE_TEST\n");
-        break;
-
-      case S11_CREATE_BEARER_RESPONSE: {
-        sgw_handle_create_bearer_response(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s11_create_bearer_response);
-      } break;
-
-      case S11_CREATE_SESSION_REQUEST: {
-        /*
-         * We received a create session request from MME (with GTP abstraction here)
-         * * * * procedures might be:
-         * * * *      E-UTRAN Initial Attach
-         * * * *      UE requests PDN connectivity
-         */
-        sgw_handle_create_session_request(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s11_create_session_request);
-      } break;
-
-      case S11_DELETE_SESSION_REQUEST: {
-        sgw_handle_delete_session_request(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s11_delete_session_request);
-      } break;
-
-      case S11_MODIFY_BEARER_REQUEST: {
-        sgw_handle_modify_bearer_request(
-          spgw_state_p, &received_message_p->ittiMsg.s11_modify_bearer_request);
-      } break;
-
-      case S11_RELEASE_ACCESS_BEARERS_REQUEST: {
-        sgw_handle_release_access_bearers_request(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s11_release_access_bearers_request);
-      } break;
-
-      case S11_SUSPEND_NOTIFICATION: {
-        sgw_handle_suspend_notification(
-          spgw_state_p, &received_message_p->ittiMsg.s11_suspend_notification);
-      } break;
-
-      case GTPV1U_UPDATE_TUNNEL_RESP: {
-        sgw_handle_gtpv1uUpdateTunnelResp(
-          spgw_state_p, &received_message_p->ittiMsg.gtpv1uUpdateTunnelResp);
-      } break;
-
-      case SGI_CREATE_ENDPOINT_RESPONSE: {
-        sgw_handle_sgi_endpoint_created(
-          spgw_state_p,
-          &received_message_p->ittiMsg.sgi_create_end_point_response);
-      } break;
-
-      case SGI_UPDATE_ENDPOINT_RESPONSE: {
-        sgw_handle_sgi_endpoint_updated(
-          spgw_state_p,
-          &received_message_p->ittiMsg.sgi_update_end_point_response);
-      } break;
-
-      case S5_CREATE_BEARER_RESPONSE: {
-        sgw_handle_s5_create_bearer_response(
-          spgw_state_p, &received_message_p->ittiMsg.s5_create_bearer_response);
-      } break;
-
-      case S5_NW_INITIATED_ACTIVATE_BEARER_REQ: {
-        //Handle Dedicated bearer activation from PCRF
-        sgw_handle_nw_initiated_actv_bearer_req(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s5_nw_init_actv_bearer_request);
-      } break;
-
-      case S11_NW_INITIATED_ACTIVATE_BEARER_RESP: {
-        //Handle Dedicated bearer Activation Rsp from MME
-        sgw_handle_nw_initiated_actv_bearer_rsp(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s11_nw_init_actv_bearer_rsp);
-      } break;
-
-      case S5_NW_INITIATED_DEACTIVATE_BEARER_REQ: {
-        //Handle Dedicated bearer Deactivation Req from PGW
-        sgw_handle_nw_initiated_deactv_bearer_req(
-          &received_message_p->ittiMsg.s5_nw_init_deactv_bearer_request);
-      } break;
-
-      case S11_NW_INITIATED_DEACTIVATE_BEARER_RESP: {
-        //Handle Dedicated bearer deactivation Rsp from MME
-        sgw_handle_nw_initiated_deactv_bearer_rsp(
-          spgw_state_p,
-          &received_message_p->ittiMsg.s11_nw_init_deactv_bearer_rsp);
-      } break;
-
-      case TERMINATE_MESSAGE: {
-        put_spgw_state();
-        sgw_exit();
-        itti_exit_task();
-      } break;
-
-      default: {
-        OAILOG_DEBUG(
-          LOG_SPGW_APP,
-          "Unkwnon message ID %d:%s\n",
-          ITTI_MSG_ID(received_message_p),
-          ITTI_MSG_NAME(received_message_p));
-      } break;
+    MessageDef *received_messages[ITTI_RECEIVE_BATCH_SIZE];
+    size_t nb_messages;
+    nb_messages = itti_receive_msgs(
+      TASK_SPGW_APP, received_messages, ITTI_RECEIVE_BATCH_SIZE);
+
+    for (size_t i = 0; i < nb_messages; i++) {
+      MessageDef *received_message_p = received_messages[i];
+
+      spgw_state_p = get_spgw_state(true);
+
+      switch (ITTI_MSG_ID(received_message_p)) {
+        case GTPV1U_CREATE_TUNNEL_RESP: {
+          OAILOG_DEBUG(
+            LOG_SPGW_APP,
+            "Received teid for S1-U: %u and status: %s\n",
+            received_message_p->ittiMsg.gtpv1uCreateTunnelResp.S1u_teid,
+            received_message_p->ittiMsg.gtpv1uCreateTunnelResp.status == 0 ?
+              "Success" :
+              "Failure");
+          sgw_handle_gtpv1uCreateTunnelResp(
+            spgw_state_p, &received_message_p->ittiMsg.gtpv1uCreateTunnelResp);
+        } break;
+
+        case MESSAGE_TEST:
+          OAILOG_DEBUG(LOG_SPGW_APP, "Received MESSAGE_TEST\n");
+          break;
+
+        case S11_CREATE_BEARER_RESPONSE: {
+          sgw_handle_create_bearer_response(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_create_bearer_response);
+        } break;
+
+        case S11_CREATE_SESSION_REQUEST: {
+          /*
+           * We received a create session request from MME (with GTP abstraction here)
+           * * * * procedures might be:
+           * * * *      E-UTRAN Initial Attach
+           * * * *      UE requests PDN connectivity
+           */
+          sgw_handle_create_session_request(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_create_session_request);
+        } break;
+
+        case S11_DELETE_SESSION_REQUEST: {
+          sgw_handle_delete_session_request(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_delete_session_request);
+        } break;
+
+        case S11_MODIFY_BEARER_REQUEST: {
+          sgw_handle_modify_bearer_request(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_modify_bearer_request);
+        } break;
+
+        case S11_RELEASE_ACCESS_BEARERS_REQUEST: {
+          sgw_handle_release_access_bearers_request(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_release_access_bearers_request);
+        } break;
+
+        case S11_SUSPEND_NOTIFICATION: {
+          sgw_handle_suspend_notification(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_suspend_notification);
+        } break;
+
+        case GTPV1U_UPDATE_TUNNEL_RESP: {
+          sgw_handle_gtpv1uUpdateTunnelResp(
+            spgw_state_p, &received_message_p->ittiMsg.gtpv1uUpdateTunnelResp);
+        } break;
+
+        case SGI_CREATE_ENDPOINT_RESPONSE: {
+          sgw_handle_sgi_endpoint_created(
+            spgw_state_p,
+            &received_message_p->ittiMsg.sgi_create_end_point_response);
+        } break;
+
+        case SGI_UPDATE_ENDPOINT_RESPONSE: {
+          sgw_handle_sgi_endpoint_updated(
+            spgw_state_p,
+            &received_message_p->ittiMsg.sgi_update_end_point_response);
+        } break;
+
+        case S5_CREATE_BEARER_RESPONSE: {
+          sgw_handle_s5_create_bearer_response(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s5_create_bearer_response);
+        } break;
+
+        case S5_NW_INITIATED_ACTIVATE_BEARER_REQ: {
+          //Handle Dedicated bearer activation from PCRF
+          sgw_handle_nw_initiated_actv_bearer_req(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s5_nw_init_actv_bearer_request);
+        } break;
+
+        case S11_NW_INITIATED_ACTIVATE_BEARER_RESP: {
+          //Handle Dedicated bearer Activation Rsp from MME
+          sgw_handle_nw_initiated_actv_bearer_rsp(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_nw_init_actv_bearer_rsp);
+        } break;
+
+        case S5_NW_INITIATED_DEACTIVATE_BEARER_REQ: {
+          //Handle Dedicated bearer Deactivation Req from PGW
+          sgw_handle_nw_initiated_deactv_bearer_req(
+            &received_message_p->ittiMsg.s5_nw_init_deactv_bearer_request);
+        } break;
+
+        case S11_NW_INITIATED_DEACTIVATE_BEARER_RESP: {
+          //Handle Dedicated bearer deactivation Rsp from MME
+          sgw_handle_nw_initiated_deactv_bearer_rsp(
+            spgw_state_p,
+            &received_message_p->ittiMsg.s11_nw_init_deactv_bearer_rsp);
+        } break;
+
+        case TERMINATE_MESSAGE: {
+          put_spgw_state();
+          sgw_exit();
+          itti_free_msgs(&received_messages[i], nb_messages - i);
+          itti_exit_task();
+        } break;
+
+        default: {
+          OAILOG_DEBUG(
+            LOG_SPGW_APP,
+            "Unkwnon message ID %d:%s\n",
+            ITTI_MSG_ID(received_message_p),
+            ITTI_MSG_NAME(received_message_p));
+        } break;
+      }
+
+      put_spgw_state();
+
+      itti_free_msg_content(received_message_p);
+      itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
     }
-
-    put_spgw_state();
-
-    itti_free_msg_content(received_message_p);
-    itti_free(ITTI_MSG_ORIGIN_ID(received_message_p), received_message_p);
-    received_message_p = NULL;
   }
 
   return NULL;
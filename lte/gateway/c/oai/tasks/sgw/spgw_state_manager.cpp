@@ -71,13 +71,13 @@ spgw_state_t* SpgwStateManager::create_spgw_state() {
   state_p = (spgw_state_t*)calloc(1, sizeof(spgw_state_t));
 
   bstring b = bfromcstr(SGW_S11_TEID_MME_HT_NAME);
-  state_p->sgw_state.s11teid2mme =
-      hashtable_ts_create(SGW_STATE_CONTEXT_HT_MAX_SIZE, nullptr, nullptr, b);
+  state_p->sgw_state.s11teid2mme = hashtable_ts_create(
+      SGW_STATE_CONTEXT_HT_INITIAL_SIZE, nullptr, nullptr, b);
   btrunc(b, 0);
 
   bassigncstr(b, S11_BEARER_CONTEXT_INFO_HT_NAME);
   state_p->sgw_state.s11_bearer_context_information = hashtable_ts_create(
-      SGW_STATE_CONTEXT_HT_MAX_SIZE, nullptr,
+      SGW_STATE_CONTEXT_HT_INITIAL_SIZE, nullptr,
       (void (*)(void**))sgw_free_s11_bearer_context_information, b);
   bdestroy_wrapper(&b);
 
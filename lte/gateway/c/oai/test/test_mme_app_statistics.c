@@ -0,0 +1,196 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+#include <check.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "mme_app_statistics.h"
+
+#define TEST_STATS_THREADS 8
+#define TEST_STATS_ADDS 1000000
+
+static int test_stats_workers = 0;
+
+static void test_stats_worker_done(void)
+{
+  __atomic_sub_fetch(&test_stats_workers, 1, __ATOMIC_RELEASE);
+}
+
+// Adds TEST_STATS_ADDS attached UEs and removes half of them
+static void *test_stats_attach_detach(void *unused)
+{
+  for (int i = 0; i < TEST_STATS_ADDS; i++) {
+    update_mme_app_stats_attached_ue_add();
+    if (i % 2) {
+      update_mme_app_stats_attached_ue_sub();
+    }
+  }
+  test_stats_worker_done();
+  return NULL;
+}
+
+static void *test_stats_attach(void *unused)
+{
+  for (int i = 0; i < TEST_STATS_ADDS; i++) {
+    update_mme_app_stats_attached_ue_add();
+  }
+  test_stats_worker_done();
+  return NULL;
+}
+
+// Removes twice as many attached UEs as a test_stats_attach thread adds
+static void *test_stats_detach(void *unused)
+{
+  for (int i = 0; i < 2 * TEST_STATS_ADDS; i++) {
+    update_mme_app_stats_attached_ue_sub();
+  }
+  test_stats_worker_done();
+  return NULL;
+}
+
+// Snapshots while the workers run: a removal that went below zero would wrap
+// the current value far above what was ever added
+static void test_stats_run(
+  void *(*even_worker)(void *),
+  void *(*odd_worker)(void *),
+  uint32_t max_current)
+{
+  pthread_t threads[TEST_STATS_THREADS];
+  mme_app_stats_snapshot_t snapshot;
+
+  test_stats_workers = TEST_STATS_THREADS;
+  for (int t = 0; t < TEST_STATS_THREADS; t++) {
+    ck_assert_int_eq(
+      pthread_create(
+        &threads[t], NULL, (t % 2) ? odd_worker : even_worker, NULL),
+      0);
+  }
+  while (__atomic_load_n(&test_stats_workers, __ATOMIC_ACQUIRE) > 0) {
+    mme_app_statistics_snapshot(&snapshot);
+    ck_assert_uint_le(snapshot.current[MME_APP_STAT_UE_ATTACHED], max_current);
+  }
+  for (int t = 0; t < TEST_STATS_THREADS; t++) {
+    pthread_join(threads[t], NULL);
+  }
+}
+
+START_TEST(stats_concurrent_updates_test)
+{
+  mme_app_stats_snapshot_t before;
+  mme_app_stats_snapshot_t after;
+
+  mme_app_statistics_snapshot(&before);
+  test_stats_run(
+    test_stats_attach_detach,
+    test_stats_attach_detach,
+    before.current[MME_APP_STAT_UE_ATTACHED] +
+      TEST_STATS_THREADS * TEST_STATS_ADDS);
+
+  mme_app_statistics_snapshot(&after);
+  ck_assert_uint_eq(
+    after.current[MME_APP_STAT_UE_ATTACHED] -
+      before.current[MME_APP_STAT_UE_ATTACHED],
+    TEST_STATS_THREADS * TEST_STATS_ADDS / 2);
+  ck_assert_uint_eq(
+    after.added[MME_APP_STAT_UE_ATTACHED] -
+      before.added[MME_APP_STAT_UE_ATTACHED],
+    TEST_STATS_THREADS * TEST_STATS_ADDS);
+  ck_assert_uint_eq(
+    after.removed[MME_APP_STAT_UE_ATTACHED] -
+      before.removed[MME_APP_STAT_UE_ATTACHED],
+    TEST_STATS_THREADS * TEST_STATS_ADDS / 2);
+}
+END_TEST
+
+START_TEST(stats_unmatched_removals_test)
+{
+  mme_app_stats_snapshot_t before;
+  mme_app_stats_snapshot_t snapshot;
+  uint32_t current = 0;
+
+  // One removal more than there is to remove: the value stays at zero
+  mme_app_statistics_snapshot(&before);
+  current = before.current[MME_APP_STAT_S1U_BEARERS];
+  for (uint32_t i = 0; i <= current; i++) {
+    update_mme_app_stats_s1u_bearer_sub();
+  }
+  mme_app_statistics_snapshot(&snapshot);
+  ck_assert_uint_eq(snapshot.current[MME_APP_STAT_S1U_BEARERS], 0);
+  ck_assert_uint_eq(
+    snapshot.removed[MME_APP_STAT_S1U_BEARERS] -
+      before.removed[MME_APP_STAT_S1U_BEARERS],
+    current + 1);
+
+  // Half the threads remove more than the other half adds
+  current = snapshot.current[MME_APP_STAT_UE_ATTACHED];
+  test_stats_run(
+    test_stats_attach,
+    test_stats_detach,
+    current + TEST_STATS_THREADS / 2 * TEST_STATS_ADDS);
+
+  mme_app_statistics_snapshot(&snapshot);
+  if (
+    snapshot.added[MME_APP_STAT_UE_ATTACHED] >
+    snapshot.removed[MME_APP_STAT_UE_ATTACHED]) {
+    ck_assert_uint_eq(
+      snapshot.current[MME_APP_STAT_UE_ATTACHED],
+      snapshot.added[MME_APP_STAT_UE_ATTACHED] -
+        snapshot.removed[MME_APP_STAT_UE_ATTACHED]);
+  } else {
+    ck_assert_uint_eq(snapshot.current[MME_APP_STAT_UE_ATTACHED], 0);
+  }
+}
+END_TEST
+
+Suite *mme_app_statistics_suite(void)
+{
+  Suite *s;
+  TCase *tc_core;
+
+  s = suite_create("MME_APP statistics tests");
+
+  /* Core test case */
+  tc_core = tcase_create("MME_APP statistics test");
+  tcase_set_timeout(tc_core, 60);
+  tcase_add_test(tc_core, stats_concurrent_updates_test);
+  tcase_add_test(tc_core, stats_unmatched_removals_test);
+
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = mme_app_statistics_suite();
+  sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
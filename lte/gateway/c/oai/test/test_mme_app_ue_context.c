@@ -26,6 +26,7 @@
 #include "3gpp_23.003.h"
 
 #define TEST_CASE_COMMON_CONVERT_MAX 10
+#define IDLE_UE_CONTEXT_MAX_SIZE 4096
 
 START_TEST(imsi_empty_test)
 {
@@ -302,6 +303,28 @@ START_TEST(imsi_equal_test)
 }
 END_TEST
 
+START_TEST(ue_context_size_test)
+{
+  ue_mm_context_t *ue_context = calloc(1, sizeof(ue_mm_context_t));
+  size_t idle_size;
+  size_t attached_size;
+
+  /* An idle UE only carries the hot part of the context, within a page */
+  idle_size = mme_app_ue_context_size(ue_context);
+  ck_assert_uint_le(idle_size, IDLE_UE_CONTEXT_MAX_SIZE);
+
+  /* The subscription data is only held once the UE attached */
+  ue_context->apn_config_profile = calloc(1, sizeof(apn_config_profile_t));
+  ue_context->pdn_contexts[0] = calloc(1, sizeof(pdn_context_t));
+  attached_size = mme_app_ue_context_size(ue_context);
+  ck_assert_uint_ge(attached_size, idle_size + sizeof(apn_config_profile_t));
+
+  free(ue_context->pdn_contexts[0]);
+  free(ue_context->apn_config_profile);
+  free(ue_context);
+}
+END_TEST
+
 Suite *imsi_suite(void)
 {
   Suite *s;
@@ -315,6 +338,7 @@ Suite *imsi_suite(void)
   tcase_add_test(tc_core, imsi_convert_common_struct_test);
   tcase_add_test(tc_core, imsi_convert_to_uint_test);
   tcase_add_test(tc_core, imsi_equal_test);
+  tcase_add_test(tc_core, ue_context_size_test);
 
   suite_add_tcase(s, tc_core);
 